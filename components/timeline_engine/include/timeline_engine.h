@@ -0,0 +1,121 @@
+/**
+ * @file timeline_engine.h
+ * @brief Keyframe timelines for multi-step scenes.
+ *
+ * A timeline is a short array of keyframes (time, value, easing) played
+ * against the caller's frame clock. Between two keys the value follows the
+ * easing of the later key, using the same curve tables as transition_engine.
+ *
+ * Usage pattern:
+ *   1. timeline_load(&tl, keys, count, mode, now_us) validates and starts it
+ *   2. Once per frame: v = timeline_sample(&tl, now_us)
+ *   3. timeline_is_running() turns false when a one-shot has finished;
+ *      loop and ping-pong timelines run until timeline_stop()
+ *
+ * Evaluation is incremental: the timeline keeps a cursor on the current
+ * pair of keys and caches its 1/duration reciprocal, so a frame normally
+ * costs one compare, one multiply and one shift. The cursor only moves
+ * across the keys passed since the previous frame; there is no search.
+ *
+ * Modes:
+ *   ONESHOT   play once and hold the last value
+ *   LOOP      jump back to the first key after the last (repeat the first
+ *             value as the last key for a seamless loop)
+ *   PINGPONG  play forwards, then backwards over the same curves, and so on
+ *
+ * Not thread-safe: one task owns a timeline.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "transition_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMELINE_MAX_KEYS     16
+#define TIMELINE_MAX_TIME_MS  (60UL * 60 * 1000)   /* Key times fit in 32-bit us */
+
+typedef enum {
+    TIMELINE_MODE_ONESHOT = 0,
+    TIMELINE_MODE_LOOP,
+    TIMELINE_MODE_PINGPONG,
+    TIMELINE_MODE_COUNT
+} timeline_mode_t;
+
+/**
+ * @brief One keyframe (8 bytes).
+ */
+typedef struct {
+    uint32_t time_ms;   /**< Offset from the timeline start, non-decreasing */
+    uint16_t value;
+    uint8_t  easing;    /**< transition_easing_t from the previous key to this one */
+    uint8_t  reserved;
+} timeline_key_t;
+
+/**
+ * @brief Timeline state. Set up with timeline_load(); do not access fields
+ * directly.
+ */
+typedef struct {
+    timeline_key_t keys[TIMELINE_MAX_KEYS];
+    uint8_t  count;
+    uint8_t  mode;              /* timeline_mode_t */
+    uint8_t  cursor;            /* Current pair: keys[cursor] -> keys[cursor + 1] */
+    bool     running;
+    bool     reverse;           /* Ping-pong pass running backwards */
+    uint16_t value;             /* Last sampled value */
+    uint32_t span_us;           /* Time of the last key */
+    int64_t  pass_start_us;     /* Start of the current pass */
+
+    /* Cached for the current pair */
+    uint32_t seg_start_us;
+    uint32_t seg_len_us;
+    uint32_t recip;             /* 2^(16+shift) / seg_len_us */
+    uint8_t  shift;
+} timeline_t;
+
+/**
+ * @brief Copy keyframes into a timeline and start it at now_us.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG if count is 0 or above
+ *         TIMELINE_MAX_KEYS, key times decrease or exceed TIMELINE_MAX_TIME_MS,
+ *         an easing is unknown, or a looping mode has a zero-length span.
+ *         The timeline is left unchanged on error.
+ */
+esp_err_t timeline_load(timeline_t *tl, const timeline_key_t *keys, uint8_t count,
+                        timeline_mode_t mode, int64_t now_us);
+
+/**
+ * @brief Restart a loaded timeline from its first key.
+ */
+void timeline_restart(timeline_t *tl, int64_t now_us);
+
+/**
+ * @brief Stop a timeline. Its value stays at the last sample.
+ */
+void timeline_stop(timeline_t *tl);
+
+/**
+ * @brief Advance to now_us and return the value there. A stopped or
+ * finished timeline returns its last value.
+ *
+ * now_us must not go backwards between calls.
+ */
+uint16_t timeline_sample(timeline_t *tl, int64_t now_us);
+
+static inline bool timeline_is_running(const timeline_t *tl)
+{
+    return tl->running;
+}
+
+static inline uint16_t timeline_value(const timeline_t *tl)
+{
+    return tl->value;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,170 @@
+/**
+ * @file timeline_engine.c
+ * @brief Keyframe timelines with an incremental cursor.
+ *
+ * Time within a pass is t = now - pass_start (mirrored to span - t on a
+ * backwards ping-pong pass). The cursor marks the pair of keys around t; as
+ * t moves, the cursor steps one key at a time in the direction of travel,
+ * so each frame touches only the keys it passed. Entering a pair caches
+ * its start, length and reciprocal; the phase inside the pair is then
+ * (t - start) * recip >> shift, as in transition_batch.
+ */
+
+#include "timeline_engine.h"
+#include "transition_easing.h"
+#include <string.h>
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                              */
+/* ------------------------------------------------------------------ */
+
+static inline uint32_t key_us(const timeline_t *tl, int k)
+{
+    return tl->keys[k].time_ms * 1000u;
+}
+
+/* Cache the pair keys[c] -> keys[c + 1] */
+static void enter_pair(timeline_t *tl, uint8_t c)
+{
+    tl->cursor = c;
+    if (tl->count < 2) {
+        tl->seg_start_us = 0;
+        tl->seg_len_us   = 0;
+        return;
+    }
+    uint32_t start = key_us(tl, c);
+    uint32_t len   = key_us(tl, c + 1) - start;
+    tl->seg_start_us = start;
+    tl->seg_len_us   = len;
+    if (len) {
+        uint8_t shift = (uint8_t)(31 - __builtin_clz(len) + 15);
+        tl->shift = shift;
+        tl->recip = (uint32_t)((1ULL << (16 + shift)) / len);
+    }
+}
+
+/* Value at time t (us into the pass) with the cursor already on t's pair */
+static uint16_t pair_value(const timeline_t *tl, int64_t t)
+{
+    if (tl->count < 2) {
+        return tl->keys[0].value;
+    }
+
+    const timeline_key_t *k0 = &tl->keys[tl->cursor];
+    const timeline_key_t *k1 = k0 + 1;
+    int64_t into = t - (int64_t)tl->seg_start_us;
+    if (into <= 0) {
+        return k0->value;
+    }
+    if (into >= (int64_t)tl->seg_len_us) {
+        return k1->value;
+    }
+
+    int32_t  range = (int32_t)k1->value - (int32_t)k0->value;
+    uint16_t phase = (uint16_t)(((uint64_t)into * tl->recip) >> tl->shift);
+    uint16_t eased = phase;
+    if (k1->easing == TRANSITION_EASE_PERCEPTUAL && range < 0) {
+        /* Slow at the dark end: run the curve backwards on a fall */
+        eased = 65535 - transition_ease(k1->easing, 65535 - phase);
+    } else if (k1->easing != TRANSITION_EASE_LINEAR) {
+        eased = transition_ease(k1->easing, phase);
+    }
+    return (uint16_t)((int32_t)k0->value + (int32_t)(((int64_t)range * eased) >> 16));
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                           */
+/* ------------------------------------------------------------------ */
+
+esp_err_t timeline_load(timeline_t *tl, const timeline_key_t *keys, uint8_t count,
+                        timeline_mode_t mode, int64_t now_us)
+{
+    if (tl == NULL || keys == NULL || count == 0 || count > TIMELINE_MAX_KEYS ||
+        mode >= TIMELINE_MODE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < count; i++) {
+        if (keys[i].time_ms > TIMELINE_MAX_TIME_MS ||
+            keys[i].easing >= TRANSITION_EASE_COUNT ||
+            (i > 0 && keys[i].time_ms < keys[i - 1].time_ms)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (mode != TIMELINE_MODE_ONESHOT && keys[count - 1].time_ms == 0) {
+        return ESP_ERR_INVALID_ARG;     /* Would wrap every frame */
+    }
+
+    memset(tl, 0, sizeof(*tl));
+    memcpy(tl->keys, keys, count * sizeof(timeline_key_t));
+    tl->count   = count;
+    tl->mode    = (uint8_t)mode;
+    tl->span_us = key_us(tl, count - 1);
+    timeline_restart(tl, now_us);
+    return ESP_OK;
+}
+
+void timeline_restart(timeline_t *tl, int64_t now_us)
+{
+    if (tl->count == 0) {
+        return;
+    }
+    tl->pass_start_us = now_us;
+    tl->reverse       = false;
+    tl->running       = true;
+    tl->value         = tl->keys[0].value;
+    enter_pair(tl, 0);
+}
+
+void timeline_stop(timeline_t *tl)
+{
+    tl->running = false;
+}
+
+uint16_t timeline_sample(timeline_t *tl, int64_t now_us)
+{
+    if (!tl->running) {
+        return tl->value;
+    }
+
+    int64_t elapsed = now_us - tl->pass_start_us;
+    if (elapsed < 0) {
+        elapsed = 0;    /* Clock skew guard */
+    }
+
+    if (elapsed >= (int64_t)tl->span_us) {
+        if (tl->mode == TIMELINE_MODE_ONESHOT) {
+            tl->running = false;
+            tl->value   = tl->keys[tl->count - 1].value;
+            return tl->value;
+        }
+        /* Normally one pass; more only after a stall longer than the span */
+        uint64_t passes = (uint64_t)elapsed / tl->span_us;
+        tl->pass_start_us += (int64_t)(passes * tl->span_us);
+        elapsed           -= (int64_t)(passes * tl->span_us);
+        if (tl->mode == TIMELINE_MODE_PINGPONG && (passes & 1)) {
+            tl->reverse = !tl->reverse;
+        }
+        if (tl->count >= 2) {
+            enter_pair(tl, tl->reverse ? (uint8_t)(tl->count - 2) : 0);
+        }
+    }
+
+    int64_t t = tl->reverse ? (int64_t)tl->span_us - elapsed : elapsed;
+
+    /* Step across the keys passed since the last frame */
+    if (tl->count >= 2) {
+        uint8_t c = tl->cursor;
+        while (c + 2 < tl->count && t >= (int64_t)key_us(tl, c + 1)) {
+            c++;
+        }
+        while (c > 0 && t < (int64_t)key_us(tl, c)) {
+            c--;
+        }
+        if (c != tl->cursor) {
+            enter_pair(tl, c);
+        }
+    }
+
+    tl->value = pair_value(tl, t);
+    return tl->value;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file test_timeline.c
+ * @brief timeline_sample() against a brute-force key search.
+ *
+ * Random timelines (1-16 keys, with runs of equal key times so some pairs
+ * have zero length, random easing) are loaded in each mode and sampled on a
+ * rising clock with random steps: short steps that walk the cursor one key
+ * at a time, and stalls of several spans that wrap many passes at once. For
+ * every sample the reference recomputes the pass, the direction and the
+ * pair from the total time since load, with a linear search over the keys
+ * and an exact divide for the phase. The engine's value must match it
+ * within one Q16 phase step (its reciprocal rounds the phase down), and its
+ * cursor and direction must match exactly.
+ */
+
+#include "timeline_engine.h"
+#include "transition_easing.h"
+#include "test_util.h"
+
+#define MS(x)       ((int64_t)(x) * 1000)
+#define TIMELINES   300
+#define SAMPLES     600
+
+static const char *const s_mode_name[] = { "oneshot", "loop", "pingpong" };
+
+typedef struct {
+    bool     running;
+    bool     reverse;
+    int      pair;
+    uint16_t lo, hi;          /* Value at the exact phase and one step below */
+} ref_t;
+
+static uint16_t ref_pair_value(const timeline_key_t *k0, uint32_t phase)
+{
+    const timeline_key_t *k1 = k0 + 1;
+    int32_t  range = (int32_t)k1->value - (int32_t)k0->value;
+    uint16_t eased = (uint16_t)phase;
+    if (k1->easing == TRANSITION_EASE_PERCEPTUAL && range < 0) {
+        eased = 65535 - transition_ease(k1->easing, (uint16_t)(65535 - phase));
+    } else if (k1->easing != TRANSITION_EASE_LINEAR) {
+        eased = transition_ease(k1->easing, (uint16_t)phase);
+    }
+    return (uint16_t)((int32_t)k0->value + (int32_t)(((int64_t)range * eased) >> 16));
+}
+
+static ref_t reference(const timeline_key_t *keys, int count, timeline_mode_t mode,
+                       int64_t elapsed)
+{
+    ref_t r = { .running = true };
+    int64_t span = MS(keys[count - 1].time_ms);
+    int64_t t = elapsed;
+
+    if (elapsed >= span) {
+        if (mode == TIMELINE_MODE_ONESHOT) {
+            r.running = false;
+            r.lo = r.hi = keys[count - 1].value;
+            return r;
+        }
+        int64_t pass = elapsed / span;
+        t = elapsed % span;
+        if (mode == TIMELINE_MODE_PINGPONG && (pass & 1)) {
+            r.reverse = true;
+        }
+    }
+    if (r.reverse) {
+        t = span - t;
+    }
+    if (count < 2) {
+        r.lo = r.hi = keys[0].value;
+        return r;
+    }
+
+    /* The last pair starting at or before t */
+    int c = 0;
+    for (int k = 0; k < count - 1; k++) {
+        if (MS(keys[k].time_ms) <= t) {
+            c = k;
+        }
+    }
+    r.pair = c;
+
+    int64_t into = t - MS(keys[c].time_ms);
+    int64_t len  = MS(keys[c + 1].time_ms) - MS(keys[c].time_ms);
+    if (into <= 0) {
+        r.lo = r.hi = keys[c].value;
+    } else if (into >= len) {
+        r.lo = r.hi = keys[c + 1].value;
+    } else {
+        uint32_t phase = (uint32_t)((into << 16) / len);
+        r.hi = ref_pair_value(&keys[c], phase);
+        r.lo = phase ? ref_pair_value(&keys[c], phase - 1) : r.hi;
+    }
+    return r;
+}
+
+static int make_keys(timeline_key_t *keys, uint32_t *seed)
+{
+    int count = 1 + (int)(test_rand(seed) % TIMELINE_MAX_KEYS);
+    uint32_t t = test_rand(seed) % 3 ? 0 : test_rand(seed) % 500;
+    for (int i = 0; i < count; i++) {
+        /* One pair in four has zero length */
+        if (i > 0 && test_rand(seed) % 4) {
+            t += 1 + test_rand(seed) % 2000;
+        }
+        keys[i].time_ms  = t;
+        keys[i].value    = (uint16_t)test_rand(seed);
+        keys[i].easing   = (uint8_t)(test_rand(seed) % TRANSITION_EASE_COUNT);
+        keys[i].reserved = 0;
+    }
+    if (keys[count - 1].time_ms == 0) {
+        keys[count - 1].time_ms = 1;    /* Loop modes need a span */
+    }
+    return count;
+}
+
+/* One timeline, one mode: false on the first mismatch */
+static bool sweep(const timeline_key_t *keys, int count, timeline_mode_t mode,
+                  uint32_t *seed, int *stalls)
+{
+    static timeline_t tl;
+    const int64_t t0 = MS(12345);
+    int64_t span = MS(keys[count - 1].time_ms);
+    int64_t now = t0;
+
+    CHECK_EQ(timeline_load(&tl, keys, (uint8_t)count, mode, t0), ESP_OK);
+    for (int i = 0; i < SAMPLES; i++) {
+        uint32_t pick = test_rand(seed) % 32;
+        if (pick == 0) {
+            /* Stall: several spans, plus a remainder */
+            now += span * (2 + test_rand(seed) % 5) + test_rand(seed) % (span + 1);
+            (*stalls)++;
+        } else if (pick < 4 && i > 0) {
+            /* Same timestamp again */
+        } else {
+            now += 1 + test_rand(seed) % (pick < 24 ? 5000 : 200000);
+        }
+
+        uint16_t v = timeline_sample(&tl, now);
+        ref_t r = reference(keys, count, mode, now - t0);
+        bool ok = (v >= r.lo && v <= r.hi) || (v <= r.lo && v >= r.hi);
+        CHECK(ok);
+        CHECK_EQ(timeline_is_running(&tl), r.running);
+        CHECK_EQ(timeline_value(&tl), v);
+        if (r.running) {
+            CHECK_EQ(tl.reverse, r.reverse);
+            CHECK_EQ(tl.cursor, r.pair);
+            ok = ok && tl.reverse == r.reverse && tl.cursor == r.pair;
+        }
+        if (!ok) {
+            printf("  %s, %d keys, t=%lld: got %u, ref %u..%u (pair %d/%d)\n",
+                   s_mode_name[mode], count, (long long)(now - t0), v, r.lo, r.hi,
+                   tl.cursor, r.pair);
+            return false;
+        }
+        if (!r.running) {
+            break;
+        }
+    }
+    return true;
+}
+
+static void test_random(void)
+{
+    uint32_t seed = 0x7133a11u;
+    for (int m = 0; m < TIMELINE_MODE_COUNT; m++) {
+        int failed = 0, stalls = 0;
+        for (int n = 0; n < TIMELINES; n++) {
+            timeline_key_t keys[TIMELINE_MAX_KEYS];
+            int count = make_keys(keys, &seed);
+            if (!sweep(keys, count, (timeline_mode_t)m, &seed, &stalls)) {
+                failed++;
+            }
+        }
+        printf("  %-8s  %d timelines, %d stalls, %d mismatched\n",
+               s_mode_name[m], TIMELINES, stalls, failed);
+        CHECK_EQ(failed, 0);
+    }
+}
+
+/* A reverse pass walks the cursor down, hopping the zero-length pairs, and
+ * the next forward pass walks it back up */
+static void test_pingpong_cursor(void)
+{
+    static const timeline_key_t keys[] = {
+        {    0,     0, TRANSITION_EASE_LINEAR, 0 },
+        {  100, 10000, TRANSITION_EASE_LINEAR, 0 },
+        {  100, 50000, TRANSITION_EASE_LINEAR, 0 },   /* Step */
+        {  300, 60000, TRANSITION_EASE_LINEAR, 0 },
+        {  300, 20000, TRANSITION_EASE_LINEAR, 0 },   /* Step */
+        {  400, 30000, TRANSITION_EASE_LINEAR, 0 },
+    };
+    static timeline_t tl;
+    const int count = sizeof(keys) / sizeof(keys[0]);
+    CHECK_EQ(timeline_load(&tl, keys, count, TIMELINE_MODE_PINGPONG, 0), ESP_OK);
+
+    int last = 0, lowest = count, highest = 0;
+    for (int64_t now = MS(5); now <= MS(1600); now += MS(5)) {
+        timeline_sample(&tl, now);
+        ref_t r = reference(keys, count, TIMELINE_MODE_PINGPONG, now);
+        CHECK_EQ(tl.reverse, r.reverse);
+        CHECK_EQ(tl.cursor, r.pair);
+        CHECK(tl.value >= r.lo && tl.value <= r.hi);
+        /* Within a pass the cursor only moves in the direction of travel */
+        int d = (int)tl.cursor - last;
+        if ((now % MS(400)) != 0) {
+            CHECK(tl.reverse ? d <= 0 : d >= 0);
+        }
+        /* Never rests on a zero-length pair */
+        CHECK(tl.cursor != 1 && tl.cursor != 3);
+        if (tl.reverse && tl.cursor < lowest) {
+            lowest = tl.cursor;
+        }
+        if (!tl.reverse && tl.cursor > highest) {
+            highest = tl.cursor;
+        }
+        last = tl.cursor;
+    }
+    CHECK_EQ(lowest, 0);
+    CHECK_EQ(highest, count - 2);
+
+    /* Mirror times across a step land on the key after it, in both
+     * directions */
+    CHECK_EQ(timeline_load(&tl, keys, count, TIMELINE_MODE_PINGPONG, 0), ESP_OK);
+    CHECK_EQ(timeline_sample(&tl, MS(100)), 50000);
+    CHECK_EQ(timeline_sample(&tl, MS(300)), 20000);
+    CHECK_EQ(timeline_sample(&tl, MS(500)), 20000);    /* t = 300 on the way back */
+    CHECK_EQ(timeline_sample(&tl, MS(700)), 50000);    /* t = 100 */
+    CHECK_EQ(timeline_sample(&tl, MS(800)), 0);
+}
+
+/* A stall of many spans lands on the right pass and direction, and a
+ * one-shot stops on the last key */
+static void test_stall(void)
+{
+    static const timeline_key_t keys[] = {
+        {   0,     0, TRANSITION_EASE_LINEAR, 0 },
+        { 100, 65535, TRANSITION_EASE_LINEAR, 0 },
+        { 200,  1000, TRANSITION_EASE_LINEAR, 0 },
+    };
+    static timeline_t tl;
+
+    CHECK_EQ(timeline_load(&tl, keys, 3, TIMELINE_MODE_PINGPONG, 0), ESP_OK);
+    timeline_sample(&tl, MS(150));
+    CHECK(!tl.reverse);
+    CHECK_EQ(tl.cursor, 1);
+    CHECK_NEAR(timeline_sample(&tl, MS(200 * 7 + 150)), 65535 / 2, 1); /* Pass 7, t = 50 */
+    CHECK(tl.reverse);
+    CHECK_EQ(tl.cursor, 0);
+    CHECK_NEAR(timeline_sample(&tl, MS(200 * 10 + 50)), 65535 / 2, 1); /* Pass 10 */
+    CHECK(!tl.reverse);
+
+    CHECK_EQ(timeline_load(&tl, keys, 3, TIMELINE_MODE_LOOP, 0), ESP_OK);
+    CHECK_EQ(timeline_sample(&tl, MS(200 * 9 + 100)), 65535);
+    CHECK(!tl.reverse);
+    CHECK_EQ(tl.cursor, 1);
+
+    CHECK_EQ(timeline_load(&tl, keys, 3, TIMELINE_MODE_ONESHOT, 0), ESP_OK);
+    CHECK_EQ(timeline_sample(&tl, MS(200 * 9 + 100)), 1000);
+    CHECK(!timeline_is_running(&tl));
+    CHECK_EQ(timeline_sample(&tl, MS(200 * 10)), 1000);
+}
+
+static void test_load(void)
+{
+    static timeline_t tl;
+    timeline_key_t keys[2] = {
+        { 0,   100, TRANSITION_EASE_LINEAR, 0 },
+        { 0,   200, TRANSITION_EASE_LINEAR, 0 },
+    };
+
+    /* Zero span: loops are rejected, a one-shot jumps to the last key */
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_LOOP, 0), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_PINGPONG, 0), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_ONESHOT, 0), ESP_OK);
+    CHECK_EQ(timeline_sample(&tl, 0), 200);
+    CHECK(!timeline_is_running(&tl));
+
+    /* Out-of-order keys, bad easing, too many keys, bad mode */
+    keys[1].time_ms = 10;
+    keys[0].time_ms = 20;
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_ONESHOT, 0), ESP_ERR_INVALID_ARG);
+    keys[0].time_ms = 0;
+    keys[1].easing = TRANSITION_EASE_COUNT;
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_ONESHOT, 0), ESP_ERR_INVALID_ARG);
+    keys[1].easing = TRANSITION_EASE_LINEAR;
+    keys[1].time_ms = TIMELINE_MAX_TIME_MS + 1;
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_ONESHOT, 0), ESP_ERR_INVALID_ARG);
+    keys[1].time_ms = 10;
+    CHECK_EQ(timeline_load(&tl, keys, TIMELINE_MAX_KEYS + 1, TIMELINE_MODE_ONESHOT, 0),
+             ESP_ERR_INVALID_ARG);
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_COUNT, 0), ESP_ERR_INVALID_ARG);
+
+    /* Stop holds the value; restart begins a new pass */
+    CHECK_EQ(timeline_load(&tl, keys, 2, TIMELINE_MODE_LOOP, 0), ESP_OK);
+    uint16_t v = timeline_sample(&tl, MS(5));
+    CHECK_NEAR(v, 150, 1);
+    timeline_stop(&tl);
+    CHECK_EQ(timeline_sample(&tl, MS(8)), v);
+    timeline_restart(&tl, MS(8));
+    CHECK_EQ(timeline_sample(&tl, MS(8)), 100);
+}
+
+int main(void)
+{
+    RUN(test_random);
+    RUN(test_pingpong_cursor);
+    RUN(test_stall);
+    RUN(test_load);
+    return test_summary("test_timeline");
+}
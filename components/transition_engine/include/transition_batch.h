@@ -0,0 +1,174 @@
+/**
+ * @file transition_batch.h
+ * @brief Multi-channel transitions with a shared time base, laid out as
+ *        struct-of-arrays for batched evaluation.
+ *
+ * A batch holds up to TRANSITION_BATCH_MAX_ENTRIES entries (e.g. segments),
+ * each an N-channel value (e.g. level/hue/saturation/CT). All channels of an
+ * entry share one start time and one duration, so a colour change cannot
+ * drift apart between channels. The 1/duration reciprocal is computed once
+ * when the transition starts; a sample is then a multiply and a shift per
+ * entry plus one interpolation per channel, with no divides.
+ *
+ * Usage pattern:
+ *   1. transition_batch_init(&b, entries, channels)
+ *   2. transition_batch_set_channel() for curves or wrapping channels (hue)
+ *   3. transition_batch_jump() to set initial values
+ *   4. transition_batch_start(&b, i, mask, targets, ms, now_us) on changes
+ *   5. Once per frame: transition_batch_sample(&b, now_us), then read values
+ *      with transition_batch_get(), or transition_batch_get_q16() to keep
+ *      the fraction between whole steps
+ *
+ * Follow mode:
+ *   For a stream of updates (e.g. attribute steps of a Zigbee level move),
+ *   restarting a timed transition on each update gives a sawtooth velocity.
+ *   transition_batch_follow() instead puts one channel behind a critically
+ *   damped spring: it chases the latest target, keeps its velocity when the
+ *   target moves again, and settles without ringing. A channel stays in
+ *   follow mode until it is started or jumped.
+ *
+ * Not thread-safe: one task owns a batch.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "transition_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef TRANSITION_BATCH_MAX_ENTRIES
+#define TRANSITION_BATCH_MAX_ENTRIES  8
+#endif
+#define TRANSITION_BATCH_MAX_CHANNELS 4
+
+/**
+ * @brief Batch state. Initialise with transition_batch_init(); do not access
+ * fields directly.
+ */
+typedef struct {
+    uint8_t  entries;
+    uint8_t  channels;
+    uint8_t  easing[TRANSITION_BATCH_MAX_CHANNELS];   /* transition_easing_t */
+    uint16_t wrap[TRANSITION_BATCH_MAX_CHANNELS];     /* Modulus, 0 = none */
+    uint32_t active;                                  /* Bit per entry */
+
+    /* Per entry */
+    int64_t  start_us[TRANSITION_BATCH_MAX_ENTRIES];
+    uint32_t duration_us[TRANSITION_BATCH_MAX_ENTRIES];
+    uint32_t recip[TRANSITION_BATCH_MAX_ENTRIES];     /* 2^(16+shift) / duration */
+    uint8_t  shift[TRANSITION_BATCH_MAX_ENTRIES];
+
+    /* Per channel, per entry (from, range and value are Q16.16) */
+    uint32_t from[TRANSITION_BATCH_MAX_CHANNELS][TRANSITION_BATCH_MAX_ENTRIES];
+    int64_t  range[TRANSITION_BATCH_MAX_CHANNELS][TRANSITION_BATCH_MAX_ENTRIES];
+    uint16_t target[TRANSITION_BATCH_MAX_CHANNELS][TRANSITION_BATCH_MAX_ENTRIES];
+    uint32_t value[TRANSITION_BATCH_MAX_CHANNELS][TRANSITION_BATCH_MAX_ENTRIES];
+
+    /* Follow mode: per entry */
+    uint32_t following;                               /* Bit per entry */
+    uint8_t  follow_ch[TRANSITION_BATCH_MAX_ENTRIES]; /* Following channels */
+    int64_t  follow_us[TRANSITION_BATCH_MAX_ENTRIES]; /* Last step */
+    uint32_t smooth_us[TRANSITION_BATCH_MAX_ENTRIES];
+    uint32_t omega_recip[TRANSITION_BATCH_MAX_ENTRIES]; /* 2^(17+shift) / smooth_us */
+    uint8_t  omega_shift[TRANSITION_BATCH_MAX_ENTRIES];
+
+    /* Follow mode: per channel, per entry (Q8 value units) */
+    int32_t  pos[TRANSITION_BATCH_MAX_CHANNELS][TRANSITION_BATCH_MAX_ENTRIES];
+    int32_t  vel[TRANSITION_BATCH_MAX_CHANNELS][TRANSITION_BATCH_MAX_ENTRIES]; /* Velocity / omega */
+} transition_batch_t;
+
+/**
+ * @brief Clear a batch and set its dimensions. All values start at 0 with
+ * linear, non-wrapping channels.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG if a dimension exceeds the maximum
+ */
+esp_err_t transition_batch_init(transition_batch_t *b, uint8_t entries, uint8_t channels);
+
+/**
+ * @brief Configure one channel for every entry.
+ *
+ * @param easing  Curve the channel follows
+ * @param wrap    Modulus for circular values (360 for hue in degrees): the
+ *                channel takes the shorter way round and its values stay in
+ *                [0, wrap). 0 = plain interpolation.
+ */
+void transition_batch_set_channel(transition_batch_t *b, uint8_t ch,
+                                  transition_easing_t easing, uint16_t wrap);
+
+/**
+ * @brief Set one channel instantly, leaving follow mode. Other channels of a
+ * running transition are not affected.
+ */
+void transition_batch_jump(transition_batch_t *b, uint8_t idx, uint8_t ch, uint16_t value);
+
+/**
+ * @brief Start a transition of the channels in ch_mask.
+ *
+ * Every channel of the entry restarts from its value at now_us under the new
+ * start time and duration. Channels outside ch_mask keep their targets, so
+ * an unfinished change on them completes together with the new one.
+ * duration_ms 0 sets the masked channels instantly. Masked channels leave
+ * follow mode; other following channels keep following.
+ *
+ * @param targets  Indexed by channel; only entries in ch_mask are read
+ * @param now_us   Timestamp on the esp_timer_get_time() clock
+ */
+void transition_batch_start(transition_batch_t *b, uint8_t idx, uint32_t ch_mask,
+                            const uint16_t *targets, uint32_t duration_ms, int64_t now_us);
+
+/**
+ * @brief Track a moving target on one channel (follow mode).
+ *
+ * The channel follows a critically damped spring from its current value
+ * and velocity towards target. For a target moving at a steady rate the
+ * channel lags it by smooth_ms; after a step it is within 10% of the step
+ * at 2 * smooth_ms and settles without overshoot when starting at rest.
+ * All following channels of an entry share one smooth_ms (the latest).
+ * smooth_ms 0 sets the channel instantly.
+ *
+ * @param now_us  Timestamp on the esp_timer_get_time() clock
+ */
+void transition_batch_follow(transition_batch_t *b, uint8_t idx, uint8_t ch,
+                             uint16_t target, uint32_t smooth_ms, int64_t now_us);
+
+/**
+ * @brief Evaluate every active or following entry at now_us.
+ *
+ * @return true if any entry is still running or has not settled
+ */
+bool transition_batch_sample(transition_batch_t *b, int64_t now_us);
+
+/**
+ * @brief Value of a channel at the last transition_batch_sample() (or the
+ * latest jump), integer part.
+ */
+static inline uint16_t transition_batch_get(const transition_batch_t *b, uint8_t idx, uint8_t ch)
+{
+    return (uint16_t)(b->value[ch][idx] >> 16);
+}
+
+/**
+ * @brief Same as transition_batch_get() with the fraction, Q16.16. Follow
+ * mode resolves 1/256 of a step.
+ */
+static inline uint32_t transition_batch_get_q16(const transition_batch_t *b, uint8_t idx, uint8_t ch)
+{
+    return b->value[ch][idx];
+}
+
+/**
+ * @brief Returns true if the entry has a timed transition running (follow
+ * mode not included).
+ */
+static inline bool transition_batch_is_active(const transition_batch_t *b, uint8_t idx)
+{
+    return (b->active >> idx) & 1u;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+/**
+ * @file transition_easing.h
+ * @brief Easing curve evaluation, shared with components that interpolate
+ *        on their own time base (e.g. timeline_engine)
+ */
+
+#pragma once
+#include <stdint.h>
+#include "transition_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Map a linear phase through an easing curve.
+ *
+ * @param easing  transition_easing_t
+ * @param phase   Linear progress, 0-65535 (Q16)
+ * @return        Eased progress, 0-65535 (Q16); phase itself for linear
+ */
+uint16_t transition_ease(uint8_t easing, uint16_t phase);
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,11 +10,42 @@
  *   5. Read current interpolated value with transition_get_value(&t)
  *   6. Apply value to hardware at your own update rate
  *
+ * Lazy mode:
+ *   Call transition_engine_init_lazy() instead of transition_engine_init().
+ *   No timer runs; once per frame call transition_sample_all(now_us) (or
+ *   transition_sample(&t, now_us) per transition) with one timestamp, so
+ *   all values belong to the same instant. transition_get_value() then
+ *   returns the last sampled value.
+ *
+ * Cross-task reads:
+ *   transition_get_value() and transition_is_active() each read one field.
+ *   To see several fields from one instant while another task (e.g. the
+ *   timer) may be writing, use transition_read(), a lock-free snapshot.
+ *
  * Interruption handling:
  *   Calling transition_start() on an already-active transition
  *   seamlessly begins a new transition FROM the current interpolated
  *   value to the new target. No visual jumps.
  *
+ * Fractional values:
+ *   Targets are whole numbers, but the interpolated value is kept as Q16.16
+ *   (integer part in the top 16 bits). transition_get_value() returns the
+ *   integer part; transition_get_value_q16() returns the full value, e.g.
+ *   for dithering or wider outputs. An interrupted transition restarts
+ *   from the fractional value.
+ *
+ * Easing:
+ *   transition_start_ex() takes a transition_easing_t that shapes the
+ *   interpolation (ease-in/out, cubic, perceptual). Curves are fixed-point
+ *   tables, so an eased sample costs one lookup and one interpolation.
+ *   transition_start() is linear.
+ *
+ * Host build:
+ *   Outside ESP-IDF the component builds against libc (see CMakeLists.txt
+ *   and transition_port.h) for tests and benchmarks. There is no timer
+ *   there: use lazy mode, or supply one with transition_engine_set_timer().
+ *   transition_engine_set_clock() makes the clock deterministic.
+ *
  * Animation use:
  *   Animations embed their own transition_t fields and call
  *   transition_start() with custom durations. No limits on how many
@@ -24,12 +55,26 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
-#include "esp_err.h"
+#include "transition_port.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Interpolation curve for a transition.
+ */
+typedef enum {
+    TRANSITION_EASE_LINEAR = 0,   /**< Constant rate */
+    TRANSITION_EASE_IN,           /**< Quadratic, slow start */
+    TRANSITION_EASE_OUT,          /**< Quadratic, slow finish */
+    TRANSITION_EASE_IN_OUT,       /**< Quadratic, slow start and finish */
+    TRANSITION_EASE_CUBIC,        /**< Cubic in-out, steeper middle than EASE_IN_OUT */
+    TRANSITION_EASE_PERCEPTUAL,   /**< Even steps in CIE L* lightness; for brightness.
+                                       Slow near the darker end in both directions */
+    TRANSITION_EASE_COUNT
+} transition_easing_t;
+
 /**
  * @brief State for a single transition. Embed one per transitioning value.
  *
@@ -38,33 +83,89 @@ extern "C" {
  */
 typedef struct {
     bool     active;          /* True if transition in progress */
+    uint8_t  easing;          /* transition_easing_t */
+    uint16_t reg_slot;        /* Registry index + 1, 0 = not registered */
+    uint32_t recip;           /* (elapsed * recip) >> shift = step, see set_rate() */
     int64_t  start_time_us;   /* esp_timer_get_time() at transition start */
     uint32_t duration_us;     /* Total duration in microseconds */
-    uint16_t start_value;     /* Value at time transition was started */
+    uint32_t start_q16;       /* Value at time transition was started, Q16.16 */
+    uint32_t current_q16;     /* Latest interpolated value, Q16.16 (read-safe) */
     uint16_t target_value;    /* Destination value */
-    uint16_t current_value;   /* Latest interpolated value (read-safe) */
+    uint8_t  shift;
+    uint32_t seq;             /* Odd while a writer is updating the fields */
 } transition_t;
 
+/**
+ * @brief Consistent copy of a transition's state (see transition_read()).
+ */
+typedef struct {
+    bool     active;
+    uint16_t start_value;
+    uint16_t target_value;
+    uint16_t current_value;
+    uint32_t current_q16;     /* current_value with its fraction, Q16.16 */
+} transition_snapshot_t;
+
 /**
  * @brief Initialize the transition engine timer.
  *
  * Must be called once at startup before any transitions are started.
- * Starts a periodic esp_timer that updates all registered transitions.
+ * Creates a periodic esp_timer that updates all registered transitions.
+ * The timer only runs while at least one transition is active: it is
+ * started by transition_start() and stops itself once all have finished.
  *
  * @param update_rate_hz  Update rate in Hz (recommended: 200)
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED in the host build
+ *         unless a timer was set with transition_engine_set_timer()
  */
 esp_err_t transition_engine_init(uint16_t update_rate_hz);
 
+/**
+ * @brief Initialize the engine without a timer (lazy evaluation).
+ *
+ * Transitions advance only when transition_sample() is called. Use instead
+ * of transition_engine_init(), not in addition to it.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if the timer mode is running
+ */
+esp_err_t transition_engine_init_lazy(void);
+
+/**
+ * @brief Replace the clock read by transition_start(), transition_tick()
+ * and the timer.
+ *
+ * For tests and benchmarks that need repeatable timing. The clock must be
+ * monotonic and on the same time base as the now_us values passed to the
+ * sample functions. Set it before starting any transition.
+ *
+ * @param now_us  Clock in microseconds, or NULL for the default
+ *                (esp_timer_get_time(), CLOCK_MONOTONIC on the host)
+ */
+void transition_engine_set_clock(transition_clock_fn_t now_us);
+
+/**
+ * @brief Replace the periodic timer used by transition_engine_init().
+ *
+ * For tests that step the timer from a virtual clock, and for host builds,
+ * which have no timer of their own. Call before transition_engine_init();
+ * ops must stay valid while the engine runs.
+ *
+ * @param ops  Timer operations, or NULL for the default (esp_timer, none
+ *             on the host)
+ */
+void transition_engine_set_timer(const transition_timer_ops_t *ops);
+
 /**
  * @brief Register a transition_t for automatic updates.
  *
- * The engine maintains a lightweight list of registered transitions.
- * The timer callback calls transition_tick() on each registered entry.
- * Callers own the memory; the engine stores only a pointer.
+ * The engine maintains a lightweight list of registered transitions (up to
+ * 512) and tracks which of them are active. The timer callback and
+ * transition_sample_all() visit only active entries, so idle registered
+ * transitions cost nothing. Callers own the memory; the engine stores only
+ * a pointer and the transition_t must not move or be copied afterwards.
  *
  * Only needs to be called once per transition_t instance.
- * Safe to call multiple times (idempotent).
+ * Safe to call multiple times (idempotent, O(1)).
  *
  * @param t  Pointer to caller-owned transition_t
  * @return ESP_OK on success, ESP_ERR_NO_MEM if registry full
@@ -85,22 +186,72 @@ esp_err_t transition_register(transition_t *t);
  */
 void transition_start(transition_t *t, uint16_t target, uint32_t duration_ms);
 
+/**
+ * @brief Start or update a transition along an easing curve.
+ *
+ * Same as transition_start() (which is this with TRANSITION_EASE_LINEAR).
+ * An interrupted transition restarts the curve from its current value.
+ *
+ * @param t           Pointer to transition_t (caller owns)
+ * @param target      Target value (0–65535)
+ * @param duration_ms Duration in milliseconds (0 = instant)
+ * @param easing      Curve to follow
+ */
+void transition_start_ex(transition_t *t, uint16_t target, uint32_t duration_ms,
+                         transition_easing_t easing);
+
 /**
  * @brief Get the current interpolated value.
  *
- * Safe to call from any context. Returns current_value (which equals
- * target_value when no transition is active).
+ * Safe to call from any context. Returns the integer part of the current
+ * value (which equals target_value when no transition is active). In lazy
+ * mode this is the value at the last transition_sample() call.
  *
  * @param t  Pointer to transition_t
  * @return   Current interpolated value
  */
 uint16_t transition_get_value(const transition_t *t);
 
+/**
+ * @brief Get the current interpolated value with its fraction.
+ *
+ * Same as transition_get_value() but Q16.16: the integer part is in the
+ * top 16 bits. One load, safe from any context.
+ */
+uint32_t transition_get_value_q16(const transition_t *t);
+
 /**
  * @brief Returns true if a transition is currently running.
  */
 bool transition_is_active(const transition_t *t);
 
+/**
+ * @brief Take a consistent snapshot of a transition.
+ *
+ * Lock-free: retries if a write lands mid-read, which only happens while a
+ * writer is running on another core. Safe from any task.
+ *
+ * @param t    Pointer to transition_t
+ * @param out  Snapshot of active, start, target and current value
+ */
+void transition_read(const transition_t *t, transition_snapshot_t *out);
+
+/**
+ * @brief Returns true if any registered transition is running. O(1).
+ */
+bool transition_any_active(void);
+
+/**
+ * @brief Sample every active registered transition at the given time.
+ *
+ * Lazy-mode counterpart of the timer tick: costs O(active), nothing when
+ * everything is idle.
+ *
+ * @param now_us  Timestamp on the esp_timer_get_time() clock
+ * @return        true if any registered transition is still active
+ */
+bool transition_sample_all(int64_t now_us);
+
 /**
  * @brief Cancel an active transition, snapping to the current value.
  *
@@ -110,6 +261,19 @@ bool transition_is_active(const transition_t *t);
  */
 void transition_cancel(transition_t *t);
 
+/**
+ * @brief Evaluate a transition at the given time.
+ *
+ * Updates the current value (and ends the transition once now_us is past its
+ * duration) and returns it. Pass one timestamp for all transitions of a
+ * frame. Cheap for inactive transitions.
+ *
+ * @param t       Pointer to transition_t
+ * @param now_us  Timestamp on the esp_timer_get_time() clock
+ * @return        Value at now_us (integer part)
+ */
+uint16_t transition_sample(transition_t *t, int64_t now_us);
+
 /**
  * @brief Advance a single transition by one tick.
  *
@@ -0,0 +1,55 @@
+/**
+ * @file transition_port.h
+ * @brief Platform types for the transition engine.
+ *
+ * Under ESP-IDF (ESP_PLATFORM defined) this is esp_err.h. Elsewhere, i.e.
+ * the host build of this component, it defines the few esp_err_t codes the
+ * engine returns, so the engine and its users compile against libc alone.
+ *
+ * The clock and the periodic timer can be replaced at run time (see
+ * transition_engine_set_clock() and transition_engine_set_timer()), so tests
+ * can drive both from a virtual clock.
+ */
+
+#pragma once
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+#else
+typedef int esp_err_t;
+
+#define ESP_OK                 0
+#define ESP_FAIL              -1
+#define ESP_ERR_NO_MEM         0x101
+#define ESP_ERR_INVALID_ARG    0x102
+#define ESP_ERR_INVALID_STATE  0x103
+#define ESP_ERR_NOT_SUPPORTED  0x106
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Monotonic clock in microseconds (see transition_engine_set_clock())
+ */
+typedef int64_t (*transition_clock_fn_t)(void);
+
+/**
+ * @brief Periodic timer behind transition_engine_init() (see
+ * transition_engine_set_timer())
+ *
+ * The engine calls create() once, then start() when a transition begins and
+ * stop() once everything has settled. The callback must be called every
+ * period_us while started, from one task at a time.
+ */
+typedef struct {
+    esp_err_t (*create)(void (*cb)(void *), void **handle);
+    void      (*start)(void *handle, uint64_t period_us);
+    void      (*stop)(void *handle);
+} transition_timer_ops_t;
+
+#ifdef __cplusplus
+}
+#endif
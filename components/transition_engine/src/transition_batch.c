@@ -0,0 +1,388 @@
+/**
+ * @file transition_batch.c
+ * @brief Multi-channel transitions with a shared time base.
+ *
+ * Phase is computed once per entry as (elapsed * recip) >> shift, where
+ * recip = 2^(16+shift) / duration is normalised into 31 bits when the
+ * transition starts. That keeps the phase error under 2^-14 LSB of Q16 for
+ * any duration without a divide per sample. Channels are then evaluated in
+ * channel-major loops over the entries' arrays. Values are Q16.16, so a
+ * transition restarted between two whole steps carries on from the
+ * fraction it had reached.
+ *
+ * Follow mode steps a critically damped spring (omega = 2 / smooth) with
+ * its closed-form solution over the frame interval dt, so any frame rate
+ * gives the same curve. With c = value - target, u = velocity / omega and
+ * x = omega * dt:
+ *   temp = (u + c) * x
+ *   u'   = (u - temp) * e^-x
+ *   c'   = (c + temp) * e^-x
+ * e^-x is a rational approximation (one 32-bit divide per entry), and x
+ * comes from a cached reciprocal of smooth like the phase above.
+ */
+
+#include "transition_batch.h"
+#include "transition_easing.h"
+#include <string.h>
+
+_Static_assert(TRANSITION_BATCH_MAX_ENTRIES <= 32, "active mask is 32 bits");
+
+#define FOLLOW_X_MAX   (8 << 16)    /* Cap on omega * dt (Q16) after a stall */
+#define FOLLOW_SNAP    32           /* Settled below 1/8 LSB (Q8) of error and of u */
+
+/* ------------------------------------------------------------------ */
+/* Helpers                                                              */
+/* ------------------------------------------------------------------ */
+
+static inline uint16_t entry_phase(const transition_batch_t *b, int i, int64_t now_us)
+{
+    int64_t elapsed = now_us - b->start_us[i];
+    if (elapsed < 0) {
+        elapsed = 0;    /* Clock skew guard */
+    }
+    return (uint16_t)(((uint64_t)elapsed * b->recip[i]) >> b->shift[i]);
+}
+
+static inline uint32_t channel_value(const transition_batch_t *b, int ch, int i, uint16_t phase)
+{
+    int64_t range = b->range[ch][i];
+    if (range == 0) {
+        return b->from[ch][i];
+    }
+
+    uint8_t  easing = b->easing[ch];
+    uint16_t eased  = phase;
+    if (easing == TRANSITION_EASE_PERCEPTUAL && range < 0) {
+        /* Slow at the dark end: run the curve backwards on a fall */
+        eased = 65535 - transition_ease(easing, 65535 - phase);
+    } else if (easing != TRANSITION_EASE_LINEAR) {
+        eased = transition_ease(easing, phase);
+    }
+
+    int64_t v = (int64_t)b->from[ch][i] + ((range * eased) >> 16);
+    int64_t wrap = (int64_t)b->wrap[ch] << 16;
+    if (wrap) {
+        /* from is in [0, wrap) and |range| <= wrap / 2 */
+        if (v < 0) {
+            v += wrap;
+        } else if (v >= wrap) {
+            v -= wrap;
+        }
+    }
+    return (uint32_t)v;
+}
+
+static void follow_leave(transition_batch_t *b, int i, uint32_t ch_mask)
+{
+    b->follow_ch[i] &= (uint8_t)~ch_mask;
+    if (b->follow_ch[i] == 0) {
+        b->following &= ~(1u << i);
+    }
+}
+
+static void set_channel_now(transition_batch_t *b, int i, int ch, uint16_t value)
+{
+    uint16_t wrap = b->wrap[ch];
+    if (wrap) {
+        value %= wrap;
+    }
+    b->from[ch][i]   = (uint32_t)value << 16;
+    b->target[ch][i] = value;
+    b->value[ch][i]  = (uint32_t)value << 16;
+    b->range[ch][i]  = 0;
+    follow_leave(b, i, 1u << ch);
+}
+
+static void set_smooth(transition_batch_t *b, int i, uint32_t smooth_us)
+{
+    uint8_t shift = (uint8_t)(31 - __builtin_clz(smooth_us) + 14);
+    b->smooth_us[i]   = smooth_us;
+    b->omega_shift[i] = shift;
+    b->omega_recip[i] = (uint32_t)((1ULL << (17 + shift)) / smooth_us);
+}
+
+/* Offset of a from b on a channel, the short way round if it wraps (Q8) */
+static inline int32_t follow_offset(const transition_batch_t *b, int ch, int32_t a, int32_t t)
+{
+    int32_t c = a - t;
+    int32_t wrap = (int32_t)b->wrap[ch] << 8;
+    if (wrap) {
+        if (c > wrap / 2) {
+            c -= wrap;
+        } else if (c < -wrap / 2) {
+            c += wrap;
+        }
+    }
+    return c;
+}
+
+/* Advance the following channels of entry i to now_us */
+static void follow_step(transition_batch_t *b, int i, int64_t now_us)
+{
+    int64_t dt = now_us - b->follow_us[i];
+    if (dt <= 0) {
+        return;
+    }
+    b->follow_us[i] = now_us;
+
+    uint32_t x;     /* omega * dt, Q16 */
+    if (dt >= (int64_t)b->smooth_us[i] * 4) {
+        x = FOLLOW_X_MAX;
+    } else {
+        x = (uint32_t)(((uint64_t)dt * b->omega_recip[i]) >> b->omega_shift[i]);
+    }
+    /* e^-x ~ 1 / (1 + x + 0.48x^2 + 0.235x^3): within 0.2% for x <= 1 */
+    uint64_t x2  = ((uint64_t)x * x) >> 16;
+    uint64_t x3  = (x2 * x) >> 16;
+    uint32_t den = 65536 + x + (uint32_t)((x2 * 31457) >> 16) + (uint32_t)((x3 * 15401) >> 16);
+    int32_t  e   = (int32_t)(0xFFFFFFFFu / den);   /* Q16 */
+
+    for (uint32_t m = b->follow_ch[i]; m; m &= m - 1) {
+        int ch = __builtin_ctz(m);
+        int32_t t    = (int32_t)b->target[ch][i] << 8;
+        int32_t c    = follow_offset(b, ch, b->pos[ch][i], t);
+        int32_t u    = b->vel[ch][i];
+        int32_t temp = (int32_t)(((int64_t)(u + c) * x) >> 16);
+        u = (int32_t)(((int64_t)(u - temp) * e) >> 16);
+        c = (int32_t)(((int64_t)(c + temp) * e) >> 16);
+
+        if (c > -FOLLOW_SNAP && c < FOLLOW_SNAP && u > -FOLLOW_SNAP && u < FOLLOW_SNAP) {
+            /* Settled: land on the target and leave follow mode */
+            set_channel_now(b, i, ch, b->target[ch][i]);
+            continue;
+        }
+
+        int32_t p = t + c;
+        int32_t wrap = (int32_t)b->wrap[ch] << 8;
+        if (wrap) {
+            if (p < 0) {
+                p += wrap;
+            } else if (p >= wrap) {
+                p -= wrap;
+            }
+        }
+        b->pos[ch][i] = p;
+        b->vel[ch][i] = u;
+
+        /* p is in [0, wrap) when wrapping; otherwise clamp the overshoot of
+         * a 16-bit value */
+        if (p < 0) {
+            p = 0;
+        } else if (p > (65535 << 8)) {
+            p = 65535 << 8;
+        }
+        b->value[ch][i] = (uint32_t)p << 8;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Public API                                                           */
+/* ------------------------------------------------------------------ */
+
+esp_err_t transition_batch_init(transition_batch_t *b, uint8_t entries, uint8_t channels)
+{
+    if (b == NULL || entries > TRANSITION_BATCH_MAX_ENTRIES ||
+        channels > TRANSITION_BATCH_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(b, 0, sizeof(*b));
+    b->entries  = entries;
+    b->channels = channels;
+    return ESP_OK;
+}
+
+void transition_batch_set_channel(transition_batch_t *b, uint8_t ch,
+                                  transition_easing_t easing, uint16_t wrap)
+{
+    if (ch >= b->channels) {
+        return;
+    }
+    b->easing[ch] = (uint8_t)easing;
+    b->wrap[ch]   = wrap;
+}
+
+void transition_batch_jump(transition_batch_t *b, uint8_t idx, uint8_t ch, uint16_t value)
+{
+    if (idx >= b->entries || ch >= b->channels) {
+        return;
+    }
+    set_channel_now(b, idx, ch, value);
+}
+
+void transition_batch_start(transition_batch_t *b, uint8_t idx, uint32_t ch_mask,
+                            const uint16_t *targets, uint32_t duration_ms, int64_t now_us)
+{
+    if (idx >= b->entries) {
+        return;
+    }
+
+    if (duration_ms == 0) {
+        for (int ch = 0; ch < b->channels; ch++) {
+            if (ch_mask & (1u << ch)) {
+                set_channel_now(b, idx, ch, targets[ch]);
+            }
+        }
+        return;
+    }
+
+    /* Masked channels continue from the follow value they show now */
+    uint32_t followed = 0;
+    if (b->following & (1u << idx)) {
+        follow_step(b, idx, now_us);
+        followed = b->follow_ch[idx];
+        follow_leave(b, idx, ch_mask);
+    }
+    uint32_t following = b->follow_ch[idx];
+
+    /* Rebase a running transition at now so the restart has no jump. Channels
+     * that were following already hold their value at now; their from and
+     * range are not a timed fade. */
+    uint32_t bit = 1u << idx;
+    if (b->active & bit) {
+        int64_t elapsed = now_us - b->start_us[idx];
+        uint16_t phase = (elapsed >= (int64_t)b->duration_us[idx]) ? 0 : entry_phase(b, idx, now_us);
+        for (int ch = 0; ch < b->channels; ch++) {
+            if (followed & (1u << ch)) {
+                continue;
+            }
+            b->value[ch][idx] = (elapsed >= (int64_t)b->duration_us[idx])
+                              ? (uint32_t)b->target[ch][idx] << 16
+                              : channel_value(b, ch, idx, phase);
+        }
+    }
+
+    for (int ch = 0; ch < b->channels; ch++) {
+        if (following & (1u << ch)) {
+            continue;
+        }
+        uint32_t from   = b->value[ch][idx];
+        uint16_t target = (ch_mask & (1u << ch)) ? targets[ch] : b->target[ch][idx];
+        int64_t  range;
+        uint16_t wrap   = b->wrap[ch];
+        if (wrap) {
+            int64_t wrap_q16 = (int64_t)wrap << 16;
+            target %= wrap;
+            range = ((int64_t)target << 16) - from;
+            if (range > wrap_q16 / 2) {
+                range -= wrap_q16;
+            } else if (range < -(wrap_q16 / 2)) {
+                range += wrap_q16;
+            }
+        } else {
+            range = ((int64_t)target << 16) - from;
+        }
+        b->from[ch][idx]   = from;
+        b->target[ch][idx] = target;
+        b->range[ch][idx]  = range;
+    }
+
+    uint32_t duration_us = (uint32_t)((uint64_t)duration_ms * 1000ULL);
+    uint8_t  shift = (uint8_t)(31 - __builtin_clz(duration_us) + 15);
+    b->duration_us[idx] = duration_us;
+    b->shift[idx]       = shift;
+    b->recip[idx]       = (uint32_t)((1ULL << (16 + shift)) / duration_us);
+    b->start_us[idx]    = now_us;
+    b->active          |= bit;
+}
+
+void transition_batch_follow(transition_batch_t *b, uint8_t idx, uint8_t ch,
+                             uint16_t target, uint32_t smooth_ms, int64_t now_us)
+{
+    if (idx >= b->entries || ch >= b->channels) {
+        return;
+    }
+    if (smooth_ms == 0) {
+        set_channel_now(b, idx, ch, target);
+        return;
+    }
+
+    uint32_t smooth_us = (uint32_t)((uint64_t)smooth_ms * 1000ULL);
+    uint32_t bit = 1u << ch;
+
+    if (b->following & (1u << idx)) {
+        /* Bring the spring up to now before the target moves */
+        follow_step(b, idx, now_us);
+    }
+    if (!(b->following & (1u << idx))) {
+        b->follow_us[idx] = now_us;
+        set_smooth(b, idx, smooth_us);
+    } else if (b->smooth_us[idx] != smooth_us) {
+        /* Keep the real velocity: u scales with 1 / omega, i.e. with smooth */
+        for (uint32_t m = b->follow_ch[idx]; m; m &= m - 1) {
+            int c = __builtin_ctz(m);
+            b->vel[c][idx] = (int32_t)((int64_t)b->vel[c][idx] * smooth_us / b->smooth_us[idx]);
+        }
+        set_smooth(b, idx, smooth_us);
+    }
+
+    if (!(b->follow_ch[idx] & bit)) {
+        /* Enter follow mode at rest from the value on screen. An unfinished
+         * timed change on this channel is taken over from where it is. */
+        uint32_t v = b->value[ch][idx];
+        if (b->active & (1u << idx)) {
+            int64_t elapsed = now_us - b->start_us[idx];
+            v = (elapsed >= (int64_t)b->duration_us[idx])
+              ? (uint32_t)b->target[ch][idx] << 16
+              : channel_value(b, ch, idx, entry_phase(b, idx, now_us));
+        }
+        b->from[ch][idx]  = v;
+        b->range[ch][idx] = 0;
+        b->value[ch][idx] = v;
+        b->pos[ch][idx]   = (int32_t)(v >> 8);
+        b->vel[ch][idx]   = 0;
+        b->follow_ch[idx] |= (uint8_t)bit;
+        b->following      |= 1u << idx;
+    }
+
+    uint16_t wrap = b->wrap[ch];
+    b->target[ch][idx] = wrap ? (uint16_t)(target % wrap) : target;
+}
+
+bool transition_batch_sample(transition_batch_t *b, int64_t now_us)
+{
+    for (uint32_t m = b->following; m; m &= m - 1) {
+        follow_step(b, __builtin_ctz(m), now_us);
+    }
+    if (b->active == 0) {
+        return b->following != 0;
+    }
+
+    /* Pass 1: one phase per entry, finished entries set aside */
+    uint16_t phase[TRANSITION_BATCH_MAX_ENTRIES];
+    uint32_t running = 0, done = 0;
+    for (uint32_t m = b->active; m; m &= m - 1) {
+        int i = __builtin_ctz(m);
+        if (now_us - b->start_us[i] >= (int64_t)b->duration_us[i]) {
+            done |= 1u << i;
+        } else {
+            phase[i] = entry_phase(b, i, now_us);
+            running |= 1u << i;
+        }
+    }
+
+    /* Pass 2: channel-major over the running entries, following channels
+     * excepted */
+    for (int ch = 0; ch < b->channels; ch++) {
+        for (uint32_t m = running; m; m &= m - 1) {
+            int i = __builtin_ctz(m);
+            if (b->follow_ch[i] & (1u << ch)) {
+                continue;
+            }
+            b->value[ch][i] = channel_value(b, ch, i, phase[i]);
+        }
+    }
+
+    /* Finished entries land exactly on target */
+    for (uint32_t m = done; m; m &= m - 1) {
+        int i = __builtin_ctz(m);
+        for (int ch = 0; ch < b->channels; ch++) {
+            if (b->follow_ch[i] & (1u << ch)) {
+                continue;
+            }
+            b->value[ch][i] = (uint32_t)b->target[ch][i] << 16;
+        }
+    }
+    b->active &= ~done;
+
+    return b->active != 0 || b->following != 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file transition_easing.c
+ * @brief Easing curve tables for the transition engine.
+ *
+ * Each curve is a 257-entry Q16 table (phase 0..1 -> 0..65535) sampled at
+ * 256 even steps plus the end point, so evaluation is one lookup and one
+ * linear interpolation between neighbours. Generated offline; max deviation
+ * from the exact curve is under 0.01% of full scale.
+ */
+
+#include "transition_easing.h"
+#include <stddef.h>
+
+#define EASE_TABLE_BITS 8
+#define EASE_TABLE_SIZE (1 << EASE_TABLE_BITS)
+
+/* Quadratic: p^2 */
+static const uint16_t s_ease_in[EASE_TABLE_SIZE + 1] = {
+        0,     1,     4,     9,    16,    25,    36,    49,
+       64,    81,   100,   121,   144,   169,   196,   225,
+      256,   289,   324,   361,   400,   441,   484,   529,
+      576,   625,   676,   729,   784,   841,   900,   961,
+     1024,  1089,  1156,  1225,  1296,  1369,  1444,  1521,
+     1600,  1681,  1764,  1849,  1936,  2025,  2116,  2209,
+     2304,  2401,  2500,  2601,  2704,  2809,  2916,  3025,
+     3136,  3249,  3364,  3481,  3600,  3721,  3844,  3969,
+     4096,  4225,  4356,  4489,  4624,  4761,  4900,  5041,
+     5184,  5329,  5476,  5625,  5776,  5929,  6084,  6241,
+     6400,  6561,  6724,  6889,  7056,  7225,  7396,  7569,
+     7744,  7921,  8100,  8281,  8464,  8649,  8836,  9025,
+     9216,  9409,  9604,  9801, 10000, 10201, 10404, 10609,
+    10816, 11025, 11236, 11449, 11664, 11881, 12100, 12321,
+    12544, 12769, 12996, 13225, 13456, 13689, 13924, 14161,
+    14400, 14641, 14884, 15129, 15376, 15625, 15876, 16129,
+    16384, 16641, 16900, 17161, 17424, 17689, 17956, 18225,
+    18496, 18769, 19044, 19321, 19600, 19881, 20164, 20449,
+    20736, 21025, 21316, 21609, 21904, 22201, 22500, 22801,
+    23104, 23409, 23716, 24025, 24336, 24649, 24964, 25281,
+    25600, 25921, 26244, 26569, 26896, 27225, 27556, 27889,
+    28224, 28561, 28900, 29241, 29584, 29929, 30276, 30625,
+    30976, 31329, 31684, 32041, 32400, 32761, 33123, 33488,
+    33855, 34224, 34595, 34968, 35343, 35720, 36099, 36480,
+    36863, 37248, 37635, 38024, 38415, 38808, 39203, 39600,
+    39999, 40400, 40803, 41208, 41615, 42024, 42435, 42848,
+    43263, 43680, 44099, 44520, 44943, 45368, 45795, 46224,
+    46655, 47088, 47523, 47960, 48399, 48840, 49283, 49728,
+    50175, 50624, 51075, 51528, 51983, 52440, 52899, 53360,
+    53823, 54288, 54755, 55224, 55695, 56168, 56643, 57120,
+    57599, 58080, 58563, 59048, 59535, 60024, 60515, 61008,
+    61503, 62000, 62499, 63000, 63503, 64008, 64515, 65024,
+    65535,
+};
+
+/* Quadratic: 1-(1-p)^2 */
+static const uint16_t s_ease_out[EASE_TABLE_SIZE + 1] = {
+        0,   511,  1020,  1527,  2032,  2535,  3036,  3535,
+     4032,  4527,  5020,  5511,  6000,  6487,  6972,  7455,
+     7936,  8415,  8892,  9367,  9840, 10311, 10780, 11247,
+    11712, 12175, 12636, 13095, 13552, 14007, 14460, 14911,
+    15360, 15807, 16252, 16695, 17136, 17575, 18012, 18447,
+    18880, 19311, 19740, 20167, 20592, 21015, 21436, 21855,
+    22272, 22687, 23100, 23511, 23920, 24327, 24732, 25135,
+    25536, 25935, 26332, 26727, 27120, 27511, 27900, 28287,
+    28672, 29055, 29436, 29815, 30192, 30567, 30940, 31311,
+    31680, 32047, 32412, 32774, 33135, 33494, 33851, 34206,
+    34559, 34910, 35259, 35606, 35951, 36294, 36635, 36974,
+    37311, 37646, 37979, 38310, 38639, 38966, 39291, 39614,
+    39935, 40254, 40571, 40886, 41199, 41510, 41819, 42126,
+    42431, 42734, 43035, 43334, 43631, 43926, 44219, 44510,
+    44799, 45086, 45371, 45654, 45935, 46214, 46491, 46766,
+    47039, 47310, 47579, 47846, 48111, 48374, 48635, 48894,
+    49151, 49406, 49659, 49910, 50159, 50406, 50651, 50894,
+    51135, 51374, 51611, 51846, 52079, 52310, 52539, 52766,
+    52991, 53214, 53435, 53654, 53871, 54086, 54299, 54510,
+    54719, 54926, 55131, 55334, 55535, 55734, 55931, 56126,
+    56319, 56510, 56699, 56886, 57071, 57254, 57435, 57614,
+    57791, 57966, 58139, 58310, 58479, 58646, 58811, 58974,
+    59135, 59294, 59451, 59606, 59759, 59910, 60059, 60206,
+    60351, 60494, 60635, 60774, 60911, 61046, 61179, 61310,
+    61439, 61566, 61691, 61814, 61935, 62054, 62171, 62286,
+    62399, 62510, 62619, 62726, 62831, 62934, 63035, 63134,
+    63231, 63326, 63419, 63510, 63599, 63686, 63771, 63854,
+    63935, 64014, 64091, 64166, 64239, 64310, 64379, 64446,
+    64511, 64574, 64635, 64694, 64751, 64806, 64859, 64910,
+    64959, 65006, 65051, 65094, 65135, 65174, 65211, 65246,
+    65279, 65310, 65339, 65366, 65391, 65414, 65435, 65454,
+    65471, 65486, 65499, 65510, 65519, 65526, 65531, 65534,
+    65535,
+};
+
+/* Quadratic in-out */
+static const uint16_t s_ease_in_out[EASE_TABLE_SIZE + 1] = {
+        0,     2,     8,    18,    32,    50,    72,    98,
+      128,   162,   200,   242,   288,   338,   392,   450,
+      512,   578,   648,   722,   800,   882,   968,  1058,
+     1152,  1250,  1352,  1458,  1568,  1682,  1800,  1922,
+     2048,  2178,  2312,  2450,  2592,  2738,  2888,  3042,
+     3200,  3362,  3528,  3698,  3872,  4050,  4232,  4418,
+     4608,  4802,  5000,  5202,  5408,  5618,  5832,  6050,
+     6272,  6498,  6728,  6962,  7200,  7442,  7688,  7938,
+     8192,  8450,  8712,  8978,  9248,  9522,  9800, 10082,
+    10368, 10658, 10952, 11250, 11552, 11858, 12168, 12482,
+    12800, 13122, 13448, 13778, 14112, 14450, 14792, 15138,
+    15488, 15842, 16200, 16562, 16928, 17298, 17672, 18050,
+    18432, 18818, 19208, 19602, 20000, 20402, 20808, 21218,
+    21632, 22050, 22472, 22898, 23328, 23762, 24200, 24642,
+    25088, 25538, 25992, 26450, 26912, 27378, 27848, 28322,
+    28800, 29282, 29768, 30258, 30752, 31250, 31752, 32258,
+    32768, 33277, 33783, 34285, 34783, 35277, 35767, 36253,
+    36735, 37213, 37687, 38157, 38623, 39085, 39543, 39997,
+    40447, 40893, 41335, 41773, 42207, 42637, 43063, 43485,
+    43903, 44317, 44727, 45133, 45535, 45933, 46327, 46717,
+    47103, 47485, 47863, 48237, 48607, 48973, 49335, 49693,
+    50047, 50397, 50743, 51085, 51423, 51757, 52087, 52413,
+    52735, 53053, 53367, 53677, 53983, 54285, 54583, 54877,
+    55167, 55453, 55735, 56013, 56287, 56557, 56823, 57085,
+    57343, 57597, 57847, 58093, 58335, 58573, 58807, 59037,
+    59263, 59485, 59703, 59917, 60127, 60333, 60535, 60733,
+    60927, 61117, 61303, 61485, 61663, 61837, 62007, 62173,
+    62335, 62493, 62647, 62797, 62943, 63085, 63223, 63357,
+    63487, 63613, 63735, 63853, 63967, 64077, 64183, 64285,
+    64383, 64477, 64567, 64653, 64735, 64813, 64887, 64957,
+    65023, 65085, 65143, 65197, 65247, 65293, 65335, 65373,
+    65407, 65437, 65463, 65485, 65503, 65517, 65527, 65533,
+    65535,
+};
+
+/* Cubic in-out */
+static const uint16_t s_ease_cubic[EASE_TABLE_SIZE + 1] = {
+        0,     0,     0,     0,     1,     2,     3,     5,
+        8,    11,    16,    21,    27,    34,    43,    53,
+       64,    77,    91,   107,   125,   145,   166,   190,
+      216,   244,   275,   308,   343,   381,   422,   465,
+      512,   562,   614,   670,   729,   791,   857,   927,
+     1000,  1077,  1158,  1242,  1331,  1424,  1521,  1622,
+     1728,  1838,  1953,  2073,  2197,  2326,  2460,  2600,
+     2744,  2894,  3049,  3209,  3375,  3547,  3724,  3907,
+     4096,  4291,  4492,  4699,  4913,  5133,  5359,  5592,
+     5832,  6078,  6332,  6592,  6859,  7133,  7415,  7704,
+     8000,  8304,  8615,  8934,  9261,  9596,  9938, 10289,
+    10648, 11015, 11390, 11774, 12167, 12568, 12978, 13396,
+    13824, 14260, 14706, 15161, 15625, 16098, 16581, 17074,
+    17576, 18088, 18609, 19141, 19683, 20235, 20797, 21369,
+    21952, 22545, 23149, 23763, 24389, 25025, 25672, 26330,
+    27000, 27680, 28372, 29076, 29791, 30517, 31255, 32005,
+    32768, 33530, 34280, 35018, 35744, 36459, 37163, 37855,
+    38535, 39205, 39863, 40510, 41146, 41772, 42386, 42990,
+    43583, 44166, 44738, 45300, 45852, 46394, 46926, 47447,
+    47959, 48461, 48954, 49437, 49910, 50374, 50829, 51275,
+    51711, 52139, 52557, 52967, 53368, 53761, 54145, 54520,
+    54887, 55246, 55597, 55939, 56274, 56601, 56920, 57231,
+    57535, 57831, 58120, 58402, 58676, 58943, 59203, 59457,
+    59703, 59943, 60176, 60402, 60622, 60836, 61043, 61244,
+    61439, 61628, 61811, 61988, 62160, 62326, 62486, 62641,
+    62791, 62935, 63075, 63209, 63338, 63462, 63582, 63697,
+    63807, 63913, 64014, 64111, 64204, 64293, 64377, 64458,
+    64535, 64608, 64678, 64744, 64806, 64865, 64921, 64973,
+    65023, 65070, 65113, 65154, 65192, 65227, 65260, 65291,
+    65319, 65345, 65369, 65390, 65410, 65428, 65444, 65458,
+    65471, 65482, 65492, 65501, 65508, 65514, 65519, 65524,
+    65527, 65530, 65532, 65533, 65534, 65535, 65535, 65535,
+    65535,
+};
+
+/* CIE 1976 L*: luminance for lightness L* = 100p */
+static const uint16_t s_ease_perceptual[EASE_TABLE_SIZE + 1] = {
+        0,    28,    57,    85,   113,   142,   170,   198,
+      227,   255,   283,   312,   340,   368,   397,   425,
+      453,   482,   510,   538,   567,   595,   625,   655,
+      686,   718,   751,   785,   821,   857,   894,   933,
+      972,  1012,  1054,  1097,  1141,  1186,  1232,  1279,
+     1328,  1378,  1429,  1481,  1535,  1590,  1646,  1703,
+     1762,  1822,  1883,  1946,  2010,  2076,  2143,  2211,
+     2281,  2352,  2425,  2500,  2575,  2653,  2731,  2812,
+     2894,  2977,  3062,  3149,  3237,  3327,  3419,  3512,
+     3607,  3704,  3802,  3902,  4004,  4108,  4213,  4320,
+     4429,  4540,  4652,  4767,  4883,  5001,  5121,  5243,
+     5367,  5493,  5621,  5751,  5882,  6016,  6152,  6289,
+     6429,  6571,  6715,  6861,  7009,  7159,  7312,  7466,
+     7623,  7782,  7943,  8106,  8272,  8439,  8609,  8781,
+     8956,  9133,  9312,  9493,  9677,  9863, 10052, 10243,
+    10436, 10632, 10830, 11030, 11234, 11439, 11647, 11858,
+    12071, 12286, 12504, 12725, 12948, 13174, 13403, 13634,
+    13868, 14104, 14343, 14585, 14830, 15077, 15327, 15579,
+    15835, 16093, 16354, 16618, 16885, 17154, 17426, 17702,
+    17980, 18261, 18545, 18831, 19121, 19414, 19710, 20008,
+    20310, 20615, 20922, 21233, 21547, 21864, 22184, 22507,
+    22833, 23163, 23495, 23831, 24170, 24512, 24857, 25206,
+    25558, 25913, 26271, 26632, 26997, 27366, 27737, 28112,
+    28490, 28872, 29257, 29645, 30037, 30432, 30831, 31233,
+    31639, 32048, 32461, 32877, 33297, 33720, 34147, 34578,
+    35012, 35450, 35891, 36336, 36785, 37237, 37693, 38153,
+    38616, 39083, 39554, 40029, 40507, 40990, 41476, 41966,
+    42460, 42957, 43459, 43964, 44473, 44987, 45504, 46025,
+    46550, 47079, 47612, 48149, 48690, 49235, 49785, 50338,
+    50895, 51457, 52022, 52592, 53166, 53744, 54326, 54912,
+    55503, 56097, 56696, 57300, 57907, 58519, 59135, 59755,
+    60380, 61009, 61642, 62280, 62922, 63569, 64220, 64875,
+    65535,
+};
+
+static const uint16_t *const s_tables[TRANSITION_EASE_COUNT] = {
+    [TRANSITION_EASE_IN]         = s_ease_in,
+    [TRANSITION_EASE_OUT]        = s_ease_out,
+    [TRANSITION_EASE_IN_OUT]     = s_ease_in_out,
+    [TRANSITION_EASE_CUBIC]      = s_ease_cubic,
+    [TRANSITION_EASE_PERCEPTUAL] = s_ease_perceptual,
+};
+
+uint16_t transition_ease(uint8_t easing, uint16_t phase)
+{
+    const uint16_t *tab = (easing < TRANSITION_EASE_COUNT) ? s_tables[easing] : NULL;
+    if (tab == NULL) {
+        return phase;   /* Linear */
+    }
+
+    uint32_t idx  = phase >> (16 - EASE_TABLE_BITS);
+    uint32_t frac = phase & ((1u << (16 - EASE_TABLE_BITS)) - 1);
+    int32_t  a    = tab[idx];
+    int32_t  b    = tab[idx + 1];
+    return (uint16_t)(a + (((b - a) * (int32_t)frac) >> (16 - EASE_TABLE_BITS)));
+}
@@ -2,38 +2,249 @@
  * @file transition_engine.c
  * @brief Generic transition engine implementation.
  *
- * The engine maintains a static registry of transition_t pointers.
- * A periodic esp_timer fires at the configured update rate and calls
- * transition_tick() on every registered, active transition.
+ * The engine maintains a static registry of transition_t pointers and a
+ * bitmap of which registered entries are active. transition_start() sets a
+ * bit; completion and transition_cancel() clear it. A periodic esp_timer
+ * fires at the configured update rate and ticks only the set bits, so a
+ * tick costs O(active) however many transitions are registered. The timer
+ * stops itself once the set is empty and transition_start() re-arms it.
+ *
+ * Lazy mode (transition_engine_init_lazy()) creates no timer: the owner
+ * calls transition_sample() with its frame timestamp, and values are
+ * evaluated only when they are read.
+ *
+ * Concurrency: writers (start, cancel, sample) run inside one short
+ * critical section, which also covers the active-set bit, and bump t->seq
+ * to odd before and even after, so
+ * transition_read() can take a consistent snapshot without locking. A
+ * writer cannot be preempted on its core, so a reader only ever waits for a
+ * writer running on the other core.
  *
  * Memory ownership: callers embed transition_t in their own structs.
  * The registry stores only pointers — no memory is allocated here.
+ *
+ * Platform services (clock, lock, timer, logging) come from
+ * transition_platform.h, which also has the host versions. The clock and
+ * timer go through s_clock and s_timer_ops so tests can substitute them.
  */
 
 #include "transition_engine.h"
-#include "esp_timer.h"
-#include "esp_log.h"
+#include "transition_easing.h"
+#include "transition_platform.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define TRANSITION_REGISTRY_MAX 512
+#define ACTIVE_WORDS            (TRANSITION_REGISTRY_MAX / 32)
 
-#define TRANSITION_REGISTRY_MAX 64
+_Static_assert(TRANSITION_REGISTRY_MAX % 32 == 0 && ACTIVE_WORDS <= 32,
+               "active set is a two-level bitmap of 32-bit words");
 
 static const char *TAG = "transition_engine";
 
-/* Registry of caller-owned transition_t pointers */
+/* Registry of caller-owned transition_t pointers. t->reg_slot is the index
+ * plus one, so a zeroed transition_t reads as unregistered. */
 static transition_t *s_registry[TRANSITION_REGISTRY_MAX];
 static int           s_registry_count = 0;
 
-static esp_timer_handle_t s_timer = NULL;
+/* Active set: bit i of s_active[] mirrors s_registry[i]->active, and bit w
+ * of s_active_summary is set while s_active[w] is non-zero. Updated from
+ * both the caller's task and the timer task, hence atomic. */
+static atomic_uint s_active[ACTIVE_WORDS];
+static atomic_uint s_active_summary;
+
+/* Serialises writers of any transition_t (see write_begin()) */
+static port_lock_t s_write_lock = PORT_LOCK_INIT;
+
+static transition_clock_fn_t s_clock = port_clock_us;
+
+static const transition_timer_ops_t s_port_timer = {
+    .create = port_timer_create,
+    .start  = port_timer_start,
+    .stop   = port_timer_stop,
+};
+static const transition_timer_ops_t *s_timer_ops = &s_port_timer;
+
+static void              *s_timer = NULL;
+static uint64_t           s_period_us = 0;
+static atomic_bool        s_timer_running = false;
+
+/* ------------------------------------------------------------------ */
+/* Writer side of the sequence counter                                  */
+/* ------------------------------------------------------------------ */
+
+static inline void write_begin(transition_t *t)
+{
+    port_lock(&s_write_lock);
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELAXED);   /* Odd: writing */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void write_end(transition_t *t)
+{
+    __atomic_store_n(&t->seq, t->seq + 1, __ATOMIC_RELEASE);   /* Even: stable */
+    port_unlock(&s_write_lock);
+}
+
+/* Distance from start to target, Q16.16 */
+static inline int64_t span_q16(const transition_t *t)
+{
+    return ((int64_t)t->target_value << 16) - (int64_t)t->start_q16;
+}
+
+/* Precompute the per-sample step. Caller holds the write side.
+ *
+ * Every sample needs n * elapsed / duration for a fixed n: the Q16.16
+ * distance |target - start| for linear, or 65536 for the Q16 phase of an
+ * eased curve. Taking recip = ceil(n * 2^shift / duration) once here turns
+ * that into (elapsed * recip) >> shift, one 32x32->64 multiply and a shift
+ * instead of a 64-bit divide (a libgcc call on RV32) per sample. shift is
+ * chosen so recip uses all 32 bits; the result is then at most 2 (Q16.16)
+ * or 2^-14 of a phase step above the exact quotient. */
+static void set_rate(transition_t *t)
+{
+    uint32_t n = 65536;
+    if (t->easing == TRANSITION_EASE_LINEAR) {
+        int64_t span = span_q16(t);
+        n = (uint32_t)(span < 0 ? -span : span);
+    }
+    if (n == 0) {
+        t->recip = 0;
+        t->shift = 0;
+        return;
+    }
+
+    /* n < 2^nbits and duration >= 2^dbits, so recip < 2^32 */
+    unsigned nbits = 32u - (unsigned)__builtin_clz(n);
+    unsigned dbits = 31u - (unsigned)__builtin_clz(t->duration_us);
+    t->shift = (uint8_t)(dbits + 32u - nbits);
+    t->recip = (uint32_t)((((uint64_t)n << t->shift) + t->duration_us - 1) / t->duration_us);
+}
+
+/* Advance t to now_us. Caller holds the write side. Returns true if the
+ * transition finished. */
+static bool sample_locked(transition_t *t, int64_t now_us)
+{
+    int64_t elapsed = now_us - t->start_time_us;
+
+    if (elapsed < 0) {
+        /* Clock skew guard: treat as start of transition */
+        elapsed = 0;
+    }
+
+    if ((uint64_t)elapsed >= (uint64_t)t->duration_us) {
+        /* Transition complete */
+        t->current_q16 = (uint32_t)t->target_value << 16;
+        t->active      = false;
+        return true;
+    }
+
+    /* elapsed < duration_us here, so it fits 32 bits */
+    uint32_t step = (uint32_t)(((uint64_t)(uint32_t)elapsed * t->recip) >> t->shift);
+    int64_t span = span_q16(t);
+    uint32_t val;
+
+    if (t->easing == TRANSITION_EASE_LINEAR) {
+        /* step = |span| * elapsed / duration, Q16.16. Rounding up can
+         * overshoot by a unit or two at the very end; keep it inside. */
+        uint32_t dist = (uint32_t)(span < 0 ? -span : span);
+        if (step > dist) {
+            step = dist;
+        }
+        val = span < 0 ? t->start_q16 - step : t->start_q16 + step;
+    } else {
+        /* step is the Q16 phase through the curve table. The perceptual
+         * curve is slow at the dark end, so a fall runs it backwards from
+         * the target. */
+        uint16_t phase = step > 65535 ? 65535 : (uint16_t)step;
+        uint16_t eased;
+        if (t->easing == TRANSITION_EASE_PERCEPTUAL && span < 0) {
+            eased = 65535 - transition_ease(t->easing, 65535 - phase);
+        } else {
+            eased = transition_ease(t->easing, phase);
+        }
+        val = (uint32_t)((int64_t)t->start_q16 + ((span * eased) >> 16));
+    }
+
+    t->current_q16 = val;
+    return false;
+}
+
+/* ------------------------------------------------------------------ */
+/* Active set                                                           */
+/* ------------------------------------------------------------------ */
+
+static void active_set(const transition_t *t)
+{
+    if (t->reg_slot == 0) {
+        return;
+    }
+    unsigned i = t->reg_slot - 1u;
+    atomic_fetch_or(&s_active[i / 32], 1u << (i % 32));
+    atomic_fetch_or(&s_active_summary, 1u << (i / 32));
+}
+
+static void active_clear(const transition_t *t)
+{
+    if (t->reg_slot == 0) {
+        return;
+    }
+    unsigned i = t->reg_slot - 1u;
+    unsigned w = i / 32;
+    unsigned left = atomic_fetch_and(&s_active[w], ~(1u << (i % 32))) & ~(1u << (i % 32));
+    if (left == 0) {
+        /* A concurrent active_set() on this word sets its summary bit after
+         * its word bit, so either the recheck sees it or its own store lands
+         * after ours */
+        atomic_fetch_and(&s_active_summary, ~(1u << w));
+        if (atomic_load(&s_active[w]) != 0) {
+            atomic_fetch_or(&s_active_summary, 1u << w);
+        }
+    }
+}
+
+/* Sample every active registered transition. Returns true if any is still
+ * active afterwards. */
+static bool sample_active(int64_t now_us)
+{
+    unsigned words = atomic_load(&s_active_summary);
+    while (words) {
+        unsigned w = (unsigned)__builtin_ctz(words);
+        words &= words - 1;
+        unsigned bits = atomic_load(&s_active[w]);
+        while (bits) {
+            unsigned b = (unsigned)__builtin_ctz(bits);
+            bits &= bits - 1;
+            transition_sample(s_registry[w * 32 + b], now_us);
+        }
+    }
+    return atomic_load(&s_active_summary) != 0;
+}
 
 /* ------------------------------------------------------------------ */
 /* Timer callback                                                       */
 /* ------------------------------------------------------------------ */
 
+/* Start the periodic timer. Fails harmlessly (ESP_ERR_INVALID_STATE) if it
+ * is already running. */
+static void timer_start(void)
+{
+    atomic_store(&s_timer_running, true);
+    s_timer_ops->start(s_timer, s_period_us);
+}
+
 static void timer_callback(void *arg)
 {
-    for (int i = 0; i < s_registry_count; i++) {
-        transition_t *t = s_registry[i];
-        if (t != NULL && t->active) {
-            transition_tick(t);
+    (void)arg;
+    if (!sample_active(s_clock())) {
+        /* Everything settled: stop ticking. A transition_start() racing with
+         * the scan above either sees s_timer_running cleared and restarts the
+         * timer itself, or is caught by the rescan below. */
+        atomic_store(&s_timer_running, false);
+        s_timer_ops->stop(s_timer);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (transition_any_active()) {
+            timer_start();
         }
     }
 }
@@ -54,32 +265,41 @@ esp_err_t transition_engine_init(uint16_t update_rate_hz)
     }
 
     uint64_t period_us = 1000000ULL / update_rate_hz;
+    s_period_us = period_us;
 
-    const esp_timer_create_args_t timer_args = {
-        .callback        = timer_callback,
-        .arg             = NULL,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name            = "transition_engine",
-    };
-
-    esp_err_t err = esp_timer_create(&timer_args, &s_timer);
-    if (err != ESP_OK) {
-        ESP_LOGD(TAG, "esp_timer_create failed: %d", err);
-        return err;
-    }
-
-    err = esp_timer_start_periodic(s_timer, period_us);
+    esp_err_t err = s_timer_ops->create(timer_callback, &s_timer);
     if (err != ESP_OK) {
-        ESP_LOGD(TAG, "esp_timer_start_periodic failed: %d", err);
-        esp_timer_delete(s_timer);
+        ESP_LOGD(TAG, "timer create failed: %d", err);
         s_timer = NULL;
         return err;
     }
 
-    ESP_LOGD(TAG, "initialized at %u Hz (period %llu us)", update_rate_hz, period_us);
+    /* Idle until the first transition_start() */
+    ESP_LOGD(TAG, "initialized at %u Hz (period %llu us)", update_rate_hz,
+             (unsigned long long)period_us);
+    return ESP_OK;
+}
+
+esp_err_t transition_engine_init_lazy(void)
+{
+    if (s_timer != NULL) {
+        ESP_LOGD(TAG, "timer mode already initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGD(TAG, "initialized in lazy mode (no timer)");
     return ESP_OK;
 }
 
+void transition_engine_set_clock(transition_clock_fn_t now_us)
+{
+    s_clock = now_us ? now_us : port_clock_us;
+}
+
+void transition_engine_set_timer(const transition_timer_ops_t *ops)
+{
+    s_timer_ops = ops ? ops : &s_port_timer;
+}
+
 esp_err_t transition_register(transition_t *t)
 {
     if (t == NULL) {
@@ -87,11 +307,10 @@ esp_err_t transition_register(transition_t *t)
     }
 
     /* Idempotent: check if already registered */
-    for (int i = 0; i < s_registry_count; i++) {
-        if (s_registry[i] == t) {
-            ESP_LOGD(TAG, "transition %p already registered", (void *)t);
-            return ESP_OK;
-        }
+    if (t->reg_slot != 0 && t->reg_slot <= s_registry_count &&
+        s_registry[t->reg_slot - 1] == t) {
+        ESP_LOGD(TAG, "transition %p already registered", (void *)t);
+        return ESP_OK;
     }
 
     if (s_registry_count >= TRANSITION_REGISTRY_MAX) {
@@ -100,11 +319,21 @@ esp_err_t transition_register(transition_t *t)
     }
 
     s_registry[s_registry_count++] = t;
+    t->reg_slot = (uint16_t)s_registry_count;
+    if (t->active) {
+        active_set(t);
+    }
     ESP_LOGD(TAG, "registered transition %p (total: %d)", (void *)t, s_registry_count);
     return ESP_OK;
 }
 
 void transition_start(transition_t *t, uint16_t target, uint32_t duration_ms)
+{
+    transition_start_ex(t, target, duration_ms, TRANSITION_EASE_LINEAR);
+}
+
+void transition_start_ex(transition_t *t, uint16_t target, uint32_t duration_ms,
+                         transition_easing_t easing)
 {
     if (t == NULL) {
         return;
@@ -112,32 +341,55 @@ void transition_start(transition_t *t, uint16_t target, uint32_t duration_ms)
 
     /* Instant transition: skip interpolation entirely */
     if (duration_ms == 0) {
-        t->start_value   = target;
+        write_begin(t);
+        t->start_q16     = (uint32_t)target << 16;
         t->target_value  = target;
-        t->current_value = target;
+        t->current_q16   = (uint32_t)target << 16;
         t->active        = false;
+        active_clear(t);
+        write_end(t);
         ESP_LOGD(TAG, "instant transition %p -> %u", (void *)t, target);
         return;
     }
 
+    int64_t now_us = s_clock();
+    write_begin(t);
+
+    /* Bring an in-flight transition up to now first (lazy mode only updates
+     * current_q16 when sampled) */
+    if (t->active) {
+        sample_locked(t, now_us);
+    }
+
     /*
      * Capture the current interpolated position as the new start value.
      * This handles both:
-     *   - Fresh start:      current_value is 0 (zero-initialised struct), so
+     *   - Fresh start:      current_q16 is 0 (zero-initialised struct), so
      *                       the transition begins from whatever the caller
      *                       has set (or 0 by default).
-     *   - Interruption:     current_value holds the mid-flight value, so
-     *                       the new transition continues from that exact point
-     *                       with no visual jump.
+     *   - Interruption:     current_q16 holds the mid-flight value, fraction
+     *                       included, so the new transition continues from
+     *                       that exact point with no visual jump.
      */
-    t->start_value  = t->current_value;
+    t->start_q16    = t->current_q16;
     t->target_value = target;
     t->duration_us  = (uint32_t)((uint64_t)duration_ms * 1000ULL);
-    t->start_time_us = esp_timer_get_time();
+    t->easing       = (uint8_t)easing;
+    t->start_time_us = now_us;
     t->active        = true;
+    set_rate(t);
+    uint16_t from    = (uint16_t)(t->start_q16 >> 16);
+    active_set(t);
+    write_end(t);
+
+    /* Wake the timer if it stopped while everything was idle */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (s_timer != NULL && !atomic_exchange(&s_timer_running, true)) {
+        timer_start();
+    }
 
-    ESP_LOGD(TAG, "start transition %p: %u -> %u over %u ms",
-             (void *)t, t->start_value, target, duration_ms);
+    ESP_LOGD(TAG, "start transition %p: %u -> %u over %u ms (easing %d)",
+             (void *)t, from, target, duration_ms, easing);
 }
 
 uint16_t transition_get_value(const transition_t *t)
@@ -145,7 +397,15 @@ uint16_t transition_get_value(const transition_t *t)
     if (t == NULL) {
         return 0;
     }
-    return t->current_value;
+    return (uint16_t)(t->current_q16 >> 16);
+}
+
+uint32_t transition_get_value_q16(const transition_t *t)
+{
+    if (t == NULL) {
+        return 0;
+    }
+    return t->current_q16;
 }
 
 bool transition_is_active(const transition_t *t)
@@ -156,14 +416,43 @@ bool transition_is_active(const transition_t *t)
     return t->active;
 }
 
+void transition_read(const transition_t *t, transition_snapshot_t *out)
+{
+    uint32_t seq;
+    do {
+        /* Odd: a writer on the other core is mid-update, a few cycles */
+        while ((seq = __atomic_load_n(&t->seq, __ATOMIC_ACQUIRE)) & 1u) {
+        }
+        out->active        = t->active;
+        out->start_value   = (uint16_t)(t->start_q16 >> 16);
+        out->target_value  = t->target_value;
+        out->current_q16   = t->current_q16;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&t->seq, __ATOMIC_RELAXED) != seq);
+    out->current_value = (uint16_t)(out->current_q16 >> 16);
+}
+
+bool transition_any_active(void)
+{
+    return atomic_load(&s_active_summary) != 0;
+}
+
+bool transition_sample_all(int64_t now_us)
+{
+    return sample_active(now_us);
+}
+
 void transition_cancel(transition_t *t)
 {
     if (t == NULL) {
         return;
     }
     /* Freeze at current interpolated position, do not snap to target */
+    write_begin(t);
     t->active = false;
-    ESP_LOGD(TAG, "cancelled transition %p, frozen at %u", (void *)t, t->current_value);
+    active_clear(t);
+    write_end(t);
+    ESP_LOGD(TAG, "cancelled transition %p, frozen at %u", (void *)t, (unsigned)(t->current_q16 >> 16));
 }
 
 void transition_tick(transition_t *t)
@@ -171,32 +460,28 @@ void transition_tick(transition_t *t)
     if (t == NULL || !t->active) {
         return;
     }
+    transition_sample(t, s_clock());
+}
 
-    int64_t now     = esp_timer_get_time();
-    int64_t elapsed = now - t->start_time_us;
-
-    if (elapsed < 0) {
-        /* Clock skew guard: treat as start of transition */
-        elapsed = 0;
+uint16_t transition_sample(transition_t *t, int64_t now_us)
+{
+    if (t == NULL) {
+        return 0;
     }
-
-    if ((uint64_t)elapsed >= (uint64_t)t->duration_us) {
-        /* Transition complete */
-        t->current_value = t->target_value;
-        t->active        = false;
-        ESP_LOGD(TAG, "transition %p complete -> %u", (void *)t, t->target_value);
-        return;
+    if (!t->active) {
+        return (uint16_t)(t->current_q16 >> 16);
     }
 
-    /* Linear interpolation:
-     *   value = start + (range * elapsed) / duration
-     *
-     * Uses int64 for the multiply to avoid overflow when range and
-     * duration_us are both large (range up to 65535, duration up to ~4B us).
-     */
-    int32_t range = (int32_t)t->target_value - (int32_t)t->start_value;
-    int32_t val   = (int32_t)t->start_value +
-                    (int32_t)(((int64_t)range * elapsed) / (int64_t)t->duration_us);
+    write_begin(t);
+    bool done = t->active && sample_locked(t, now_us);
+    if (done) {
+        active_clear(t);
+    }
+    uint16_t val = (uint16_t)(t->current_q16 >> 16);
+    write_end(t);
 
-    t->current_value = (uint16_t)val;
+    if (done) {
+        ESP_LOGD(TAG, "transition %p complete -> %u", (void *)t, val);
+    }
+    return val;
 }
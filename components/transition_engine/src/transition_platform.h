@@ -0,0 +1,113 @@
+/**
+ * @file transition_platform.h
+ * @brief Clock, lock, timer and logging behind the transition engine.
+ *
+ * ESP-IDF: esp_timer, a FreeRTOS portMUX critical section and esp_log.
+ * Host: CLOCK_MONOTONIC, a spinlock, no logging, and no periodic timer
+ * (port_timer_create() fails). Host tests supply their own timer with
+ * transition_engine_set_timer(); otherwise only lazy mode is available.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "transition_port.h"
+
+#ifdef ESP_PLATFORM
+
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+typedef portMUX_TYPE       port_lock_t;
+
+#define PORT_LOCK_INIT  portMUX_INITIALIZER_UNLOCKED
+
+static inline int64_t port_clock_us(void)
+{
+    return esp_timer_get_time();
+}
+
+/* Critical section: the holder cannot be preempted on its core */
+static inline void port_lock(port_lock_t *l)
+{
+    portENTER_CRITICAL(l);
+}
+
+static inline void port_unlock(port_lock_t *l)
+{
+    portEXIT_CRITICAL(l);
+}
+
+static inline esp_err_t port_timer_create(void (*cb)(void *), void **out)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback        = cb,
+        .arg             = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name            = "transition_engine",
+    };
+    return esp_timer_create(&timer_args, (esp_timer_handle_t *)out);
+}
+
+static inline void port_timer_start(void *t, uint64_t period_us)
+{
+    esp_timer_start_periodic((esp_timer_handle_t)t, period_us);
+}
+
+static inline void port_timer_stop(void *t)
+{
+    esp_timer_stop((esp_timer_handle_t)t);
+}
+
+#else /* Host */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+typedef atomic_flag port_lock_t;
+
+#define PORT_LOCK_INIT  ATOMIC_FLAG_INIT
+
+/* Arguments are still type-checked, never printed */
+#define ESP_LOGD(tag, ...)  do { (void)(tag); if (0) printf(__VA_ARGS__); } while (0)
+
+static inline int64_t port_clock_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Spinlock: holders are short, but unlike a critical section they can be
+ * preempted, so host threads may spin for a time slice */
+static inline void port_lock(port_lock_t *l)
+{
+    while (atomic_flag_test_and_set_explicit(l, memory_order_acquire)) {
+    }
+}
+
+static inline void port_unlock(port_lock_t *l)
+{
+    atomic_flag_clear_explicit(l, memory_order_release);
+}
+
+static inline esp_err_t port_timer_create(void (*cb)(void *), void **out)
+{
+    (void)cb;
+    (void)out;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static inline void port_timer_start(void *t, uint64_t period_us)
+{
+    (void)t;
+    (void)period_us;
+}
+
+static inline void port_timer_stop(void *t)
+{
+    (void)t;
+}
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * @file bench_transition.c
+ * @brief Throughput of the transition engine on the host: ns per sampled
+ * transition for the registry tick, for direct transition_sample() calls
+ * on each easing curve, for the per-sample rate (reciprocal against the
+ * 64-bit divide it replaced), and ns per 8x4 batch frame.
+ *
+ * Run with an argument to scale the iteration count (default 1).
+ */
+
+#include "transition_engine.h"
+#include "transition_batch.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#define REGISTERED   512       /* TRANSITION_REGISTRY_MAX */
+#define UNREGISTERED 4096
+#define FRAME_US     5000      /* 200 Hz */
+#define HOUR_MS      (3600u * 1000u)
+
+static transition_t s_reg[REGISTERED];
+static transition_t s_free[UNREGISTERED];
+static volatile uint32_t s_sink;
+
+static void bench_tick(int scale)
+{
+    int frames = 2000 * scale;
+    for (int i = 0; i < REGISTERED; i++) {
+        transition_register(&s_reg[i]);
+    }
+
+    /* Every registered transition active and staying so */
+    for (int active = 32; active <= REGISTERED; active *= 4) {
+        for (int i = 0; i < REGISTERED; i++) {
+            transition_start(&s_reg[i], 0, 0);
+            if (i < active) {
+                transition_start(&s_reg[i], (uint16_t)(1000 + i), HOUR_MS);
+            }
+        }
+        int64_t t0 = test_now_ns();
+        for (int f = 1; f <= frames; f++) {
+            transition_sample_all((int64_t)f * FRAME_US);
+        }
+        int64_t ns = test_now_ns() - t0;
+        printf("  sample_all, %3d of %d active: %7.1f ns/frame, %5.2f ns per transition\n",
+               active, REGISTERED, (double)ns / frames, (double)ns / frames / active);
+    }
+
+    /* Idle registry */
+    for (int i = 0; i < REGISTERED; i++) {
+        transition_cancel(&s_reg[i]);
+    }
+    int64_t t0 = test_now_ns();
+    for (int f = 1; f <= frames * 10; f++) {
+        transition_sample_all((int64_t)f * FRAME_US);
+    }
+    printf("  sample_all, idle:              %7.1f ns/frame\n",
+           (double)(test_now_ns() - t0) / (frames * 10));
+}
+
+static void bench_sample(int scale)
+{
+    int frames = 200 * scale;
+    for (int i = 0; i < UNREGISTERED; i++) {
+        transition_start(&s_free[i], (uint16_t)i, HOUR_MS);
+    }
+    int64_t t0 = test_now_ns();
+    for (int f = 1; f <= frames; f++) {
+        for (int i = 0; i < UNREGISTERED; i++) {
+            s_sink += transition_sample(&s_free[i], (int64_t)f * FRAME_US);
+        }
+    }
+    int64_t ns = test_now_ns() - t0;
+    printf("  transition_sample, %d transitions: %5.2f ns per tick\n",
+           UNREGISTERED, (double)ns / frames / UNREGISTERED);
+}
+
+/* Per-sample cost of each curve over short and long durations: a table
+ * lookup and an interpolation, so it should not depend on either */
+static void bench_easing(int scale)
+{
+    static const char *const names[TRANSITION_EASE_COUNT] = {
+        "linear", "in", "out", "in-out", "cubic", "perceptual",
+    };
+    static const uint32_t durations_ms[] = { 100, 10000, HOUR_MS };
+    int frames = 50 * scale;
+    int n = UNREGISTERED / 4;
+
+    printf("  transition_sample by easing (ns per sample):\n");
+    printf("    %-10s %9s %9s %9s\n", "", "100 ms", "10 s", "1 h");
+    for (int e = 0; e < TRANSITION_EASE_COUNT; e++) {
+        printf("    %-10s", names[e]);
+        for (size_t d = 0; d < sizeof(durations_ms) / sizeof(durations_ms[0]); d++) {
+            uint32_t ms = durations_ms[d];
+            /* Spread the samples over the whole curve, rising and falling */
+            int64_t step = (int64_t)ms * 1000 / frames;
+            for (int i = 0; i < n; i++) {
+                transition_start(&s_free[i], (i & 1) ? 0 : 65535, 0);
+                transition_start_ex(&s_free[i], (i & 1) ? 65535 : 0, ms, (transition_easing_t)e);
+            }
+            int64_t t0 = test_now_ns();
+            for (int f = 0; f < frames; f++) {
+                for (int i = 0; i < n; i++) {
+                    s_sink += transition_sample(&s_free[i], f * step);
+                }
+            }
+            printf(" %9.2f", (double)(test_now_ns() - t0) / frames / n);
+        }
+        printf("\n");
+    }
+}
+
+/* The interpolation step alone: (elapsed * recip) >> shift as set_rate()
+ * prepares it, against the span * elapsed / duration it replaced. On x86-64
+ * the divide is in hardware; on RV32 it is a libgcc call, so the device
+ * gap is wider. */
+#define RATE_N 4096
+
+static void bench_rate(int scale)
+{
+    static uint32_t dist[RATE_N], dur[RATE_N], el[RATE_N], recip[RATE_N];
+    static uint8_t shift[RATE_N];
+    uint32_t seed = 0x51DEu;
+    int rounds = 500 * scale;
+
+    for (int i = 0; i < RATE_N; i++) {
+        dist[i] = (test_rand(&seed) | 1u) >> (test_rand(&seed) % 16);
+        dur[i]  = 1000u + test_rand(&seed) % 600000000u;
+        el[i]   = test_rand(&seed) % dur[i];
+        unsigned nbits = 32u - (unsigned)__builtin_clz(dist[i]);
+        unsigned dbits = 31u - (unsigned)__builtin_clz(dur[i]);
+        shift[i] = (uint8_t)(dbits + 32u - nbits);
+        recip[i] = (uint32_t)((((uint64_t)dist[i] << shift[i]) + dur[i] - 1) / dur[i]);
+    }
+
+    uint32_t sum = 0;
+    int64_t t0 = test_now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < RATE_N; i++) {
+            sum += (uint32_t)((int64_t)dist[i] * el[i] / dur[i]);
+        }
+    }
+    int64_t div_ns = test_now_ns() - t0;
+
+    t0 = test_now_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < RATE_N; i++) {
+            sum += (uint32_t)(((uint64_t)el[i] * recip[i]) >> shift[i]);
+        }
+    }
+    int64_t rcp_ns = test_now_ns() - t0;
+    s_sink += sum;
+
+    double n = (double)rounds * RATE_N;
+    printf("  rate step: divide %5.2f ns, reciprocal %5.2f ns per sample\n",
+           div_ns / n, rcp_ns / n);
+}
+
+static void bench_batch(int scale)
+{
+    static transition_batch_t b;
+    int frames = 20000 * scale;
+    uint16_t tg[TRANSITION_BATCH_MAX_CHANNELS] = {254, 300, 200, 370};
+
+    transition_batch_init(&b, TRANSITION_BATCH_MAX_ENTRIES, TRANSITION_BATCH_MAX_CHANNELS);
+    transition_batch_set_channel(&b, 0, TRANSITION_EASE_PERCEPTUAL, 0);
+    transition_batch_set_channel(&b, 1, TRANSITION_EASE_LINEAR, 360);
+    for (int i = 0; i < TRANSITION_BATCH_MAX_ENTRIES; i++) {
+        transition_batch_start(&b, (uint8_t)i, 0xF, tg, HOUR_MS, 0);
+    }
+    int64_t t0 = test_now_ns();
+    for (int f = 1; f <= frames; f++) {
+        transition_batch_sample(&b, (int64_t)f * FRAME_US);
+        s_sink += transition_batch_get(&b, 0, 0);
+    }
+    int64_t ns = test_now_ns() - t0;
+    printf("  batch %dx%d: %6.1f ns/frame, %5.2f ns per channel\n",
+           TRANSITION_BATCH_MAX_ENTRIES, TRANSITION_BATCH_MAX_CHANNELS, (double)ns / frames,
+           (double)ns / frames / (TRANSITION_BATCH_MAX_ENTRIES * TRANSITION_BATCH_MAX_CHANNELS));
+}
+
+static int64_t s_now;
+
+static int64_t virtual_clock(void)
+{
+    return s_now;
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    transition_engine_init_lazy();
+    transition_engine_set_clock(virtual_clock);
+
+    printf("=== transition_engine throughput ===\n");
+    bench_tick(scale);
+    bench_sample(scale);
+    bench_easing(scale);
+    bench_rate(scale);
+    bench_batch(scale);
+    return 0;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file test_follow.c
+ * @brief Follow mode (transition_batch_follow()) on attribute-stream traces.
+ *
+ * The traces have the shape the Zigbee stack produces during a level move:
+ * the attribute steps towards the move target at the move rate, one update
+ * per stack tick with jitter on the interval, then holds. Each trace is fed
+ * both to follow mode and to the old behaviour (a 100 ms linear fade
+ * restarted on every update), sampled at 200 Hz, and measured for
+ * overshoot, lag behind the continuous move, worst frame-to-frame change
+ * of velocity, and settling time after the stream ends.
+ */
+
+#include "transition_batch.h"
+#include "test_util.h"
+
+#define MS(x)      ((int64_t)(x) * 1000)
+#define FRAME_US   5000
+#define SMOOTH_MS  100
+#define MAX_STEPS  512
+
+typedef struct {
+    const char *name;
+    int      from, to;        /* Level move */
+    int      rate;            /* Levels per second */
+    int      interval_ms;     /* Update interval */
+    int      jitter_ms;       /* +- on each interval */
+} trace_spec_t;
+
+typedef struct {
+    int      n;
+    int64_t  t_us[MAX_STEPS];
+    uint16_t level[MAX_STEPS];
+    int64_t  end_us;          /* Time of the last update */
+} trace_t;
+
+typedef struct {
+    int      overshoot;       /* Levels outside the range of targets seen */
+    int64_t  lag_us;          /* Mean lag behind the continuous move */
+    int      max_dv;          /* Worst change of per-frame step, Q16 levels */
+    int64_t  settle_us;       /* From the last update to exactly on target */
+} metrics_t;
+
+static void make_trace(const trace_spec_t *s, trace_t *tr, uint32_t seed)
+{
+    int dir = (s->to > s->from) ? 1 : -1;
+    int64_t t = 0;
+    tr->n = 0;
+    for (;;) {
+        int64_t step = MS(s->interval_ms);
+        if (s->jitter_ms) {
+            step += MS((int)(test_rand(&seed) % (2u * s->jitter_ms + 1)) - s->jitter_ms);
+        }
+        t += step;
+        int level = s->from + dir * (int)(t * s->rate / 1000000);
+        bool last = (dir > 0) ? level >= s->to : level <= s->to;
+        tr->t_us[tr->n]  = t;
+        tr->level[tr->n] = (uint16_t)(last ? s->to : level);
+        tr->n++;
+        if (last || tr->n == MAX_STEPS) break;
+    }
+    tr->end_us = t;
+}
+
+/* Level of the continuous move at time t */
+static int32_t ideal_q16(const trace_spec_t *s, int64_t t)
+{
+    int64_t moved = t * s->rate * 65536 / 1000000;
+    int64_t span  = (int64_t)(s->to - s->from) * 65536;
+    if (moved > (span < 0 ? -span : span)) moved = span < 0 ? -span : span;
+    return (int32_t)(s->from * 65536 + (span < 0 ? -moved : moved));
+}
+
+static void run(const trace_spec_t *s, const trace_t *tr, bool follow, metrics_t *m)
+{
+    static transition_batch_t b;
+    transition_batch_init(&b, 1, 1);
+    transition_batch_jump(&b, 0, 0, (uint16_t)s->from);
+
+    int k = 0;
+    int lo = s->from, hi = s->from;
+    int64_t lag_sum = 0, lag_n = 0;
+    int32_t prev = s->from << 16, prev_dv = 0;
+    bool have_dv = false;
+    *m = (metrics_t){0};
+    m->settle_us = -1;
+
+    for (int64_t t = 0; t <= tr->end_us + MS(2000); t += FRAME_US) {
+        while (k < tr->n && tr->t_us[k] <= t) {
+            uint16_t target = tr->level[k];
+            if (follow) {
+                transition_batch_follow(&b, 0, 0, target, SMOOTH_MS, tr->t_us[k]);
+            } else {
+                transition_batch_start(&b, 0, 1, &target, SMOOTH_MS, tr->t_us[k]);
+            }
+            if (target < lo) lo = target;
+            if (target > hi) hi = target;
+            k++;
+        }
+        transition_batch_sample(&b, t);
+        int32_t v = (int32_t)transition_batch_get_q16(&b, 0, 0);
+
+        int over = 0;
+        if ((v >> 16) > hi) over = (v >> 16) - hi;
+        if (v < (lo << 16)) over = lo - (v >> 16);
+        if (over > m->overshoot) m->overshoot = over;
+
+        /* Lag: how long ago the continuous move was at v (while moving) */
+        if (t < tr->end_us) {
+            int64_t lag = 0;
+            while (lag < MS(1000)) {
+                int32_t at = ideal_q16(s, t - lag);
+                bool passed = (s->to > s->from) ? at <= v : at >= v;
+                if (passed) break;
+                lag += 1000;
+            }
+            lag_sum += lag;
+            lag_n++;
+        }
+
+        int32_t dv = v - prev;
+        if (have_dv) {
+            int ddv = dv - prev_dv;
+            if (ddv < 0) ddv = -ddv;
+            if (ddv > m->max_dv && t <= tr->end_us) m->max_dv = ddv;
+        }
+        prev = v;
+        prev_dv = dv;
+        have_dv = true;
+
+        if (m->settle_us < 0 && t >= tr->end_us && v == (s->to << 16)) {
+            m->settle_us = t - tr->end_us;
+        }
+    }
+    m->lag_us = lag_n ? lag_sum / lag_n : 0;
+}
+
+static const trace_spec_t s_traces[] = {
+    { "move up 127/s, 100+-30 ms",  0,   254, 127, 100, 30 },
+    { "move up 127/s, 150+-10 ms",  10,  254, 127, 150, 10 },
+    { "move down 254/s, 20+-5 ms",  254, 1,   254, 20,  5 },
+    { "move up 50/s, 100 ms",       20,  120, 50,  100, 0 },
+    { "step 0 -> 200",              0,   200, 100000, 10, 0 },
+};
+
+static void test_traces(void)
+{
+    printf("  %-28s %9s %9s %9s %9s\n", "", "overshoot", "lag ms", "max dv", "settle ms");
+    for (size_t i = 0; i < sizeof(s_traces) / sizeof(s_traces[0]); i++) {
+        const trace_spec_t *s = &s_traces[i];
+        trace_t tr;
+        metrics_t f, r;
+        make_trace(s, &tr, 0x1234567u + (uint32_t)i);
+        run(s, &tr, true, &f);
+        run(s, &tr, false, &r);
+        printf("  %-28s follow  %3d %9.1f %9d %9.1f\n", s->name, f.overshoot,
+               f.lag_us / 1000.0, f.max_dv, f.settle_us / 1000.0);
+        printf("  %-28s restart %3d %9.1f %9d %9.1f\n", "", r.overshoot,
+               r.lag_us / 1000.0, r.max_dv, r.settle_us / 1000.0);
+
+        CHECK_EQ(f.overshoot, 0);
+        /* Exactly on target: 1/8 LSB of a full step takes about 5 * smooth */
+        CHECK(f.settle_us >= 0 && f.settle_us <= MS(6 * SMOOTH_MS));
+        if (tr.n > 1) {
+            /* A steady move is followed SMOOTH_MS behind, within a frame
+             * or two plus the update interval */
+            CHECK(f.lag_us <= MS(SMOOTH_MS) + MS(s->interval_ms / 2 + s->jitter_ms) + 2 * FRAME_US);
+            /* Velocity keeps across updates: at least halves the worst
+             * kink of restarting a fade per update */
+            CHECK(f.max_dv * 2 <= r.max_dv);
+        }
+    }
+}
+
+/* Starting a timed fade on a channel that was following must continue
+ * from the value it shows, also while another channel's fade is running */
+static void test_start_after_follow(void)
+{
+    static transition_batch_t b;
+    uint16_t tg[2];
+    transition_batch_init(&b, 1, 2);
+    transition_batch_jump(&b, 0, 0, 0);
+    transition_batch_jump(&b, 0, 1, 0);
+
+    /* ch1 fades for 1 s, ch0 follows a step to 200 meanwhile */
+    tg[1] = 100;
+    transition_batch_start(&b, 0, 2, tg, 1000, 0);
+    transition_batch_follow(&b, 0, 0, 200, SMOOTH_MS, 0);
+    transition_batch_sample(&b, MS(300));
+    uint16_t shown = transition_batch_get(&b, 0, 0);
+    CHECK(shown > 150 && shown < 200);
+
+    tg[0] = 0;
+    transition_batch_start(&b, 0, 1, tg, 500, MS(300));
+    transition_batch_sample(&b, MS(300));
+    CHECK_NEAR(transition_batch_get(&b, 0, 0), shown, 1);
+    transition_batch_sample(&b, MS(550));
+    CHECK_NEAR(transition_batch_get(&b, 0, 0), shown / 2, 1);
+    CHECK_NEAR(transition_batch_get(&b, 0, 1), 65, 1);   /* ch1 rebased, no jump */
+
+    /* Same when the other channel's fade has finished but not been
+     * sampled yet */
+    transition_batch_jump(&b, 0, 0, 0);
+    tg[1] = 0;
+    transition_batch_start(&b, 0, 2, tg, 100, MS(1000));
+    transition_batch_follow(&b, 0, 0, 200, SMOOTH_MS, MS(1000));
+    transition_batch_sample(&b, MS(1050));
+    shown = transition_batch_get(&b, 0, 0);
+    tg[0] = 50;
+    transition_batch_start(&b, 0, 1, tg, 200, MS(1150));
+    uint16_t v = transition_batch_get(&b, 0, 0);
+    CHECK(v >= shown && v < 200);
+    transition_batch_sample(&b, MS(1150));
+    CHECK_EQ(transition_batch_get(&b, 0, 0), v);
+    CHECK_EQ(transition_batch_get(&b, 0, 1), 0);
+}
+
+int main(void)
+{
+    RUN(test_traces);
+    RUN(test_start_after_follow);
+    return test_summary("test_follow");
+}
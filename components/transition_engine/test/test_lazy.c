@@ -0,0 +1,133 @@
+/**
+ * @file test_lazy.c
+ * @brief Lazy mode (transition_engine_init_lazy()) on a virtual clock: no
+ * timer is created, values move only when sampled, and one
+ * transition_sample_all() call evaluates every transition at the same
+ * instant.
+ */
+
+#include "transition_engine.h"
+#include "test_util.h"
+
+#define MS(x)  ((int64_t)(x) * 1000)
+#define N      32
+
+static int64_t s_now;
+static int     s_timer_calls;
+
+static int64_t virtual_clock(void)
+{
+    return s_now;
+}
+
+static esp_err_t vt_create(void (*cb)(void *), void **handle)
+{
+    (void)cb;
+    (void)handle;
+    s_timer_calls++;
+    return ESP_OK;
+}
+
+static void vt_start(void *handle, uint64_t period_us)
+{
+    (void)handle;
+    (void)period_us;
+    s_timer_calls++;
+}
+
+static void vt_stop(void *handle)
+{
+    (void)handle;
+    s_timer_calls++;
+}
+
+static const transition_timer_ops_t s_vt = {
+    .create = vt_create,
+    .start  = vt_start,
+    .stop   = vt_stop,
+};
+
+static transition_t s_t[N];
+
+static void test_values_move_only_when_sampled(void)
+{
+    s_now = MS(1000);
+    transition_start(&s_t[0], 0, 0);
+    transition_start(&s_t[0], 1000, 1000);
+
+    /* The clock moves, the value does not until sampled */
+    s_now = MS(1500);
+    CHECK_EQ(transition_get_value(&s_t[0]), 0);
+    CHECK(transition_is_active(&s_t[0]));
+
+    CHECK_NEAR(transition_sample(&s_t[0], MS(1500)), 500, 1);
+    s_now = MS(1900);
+    CHECK_NEAR(transition_get_value(&s_t[0]), 500, 1);
+
+    /* transition_tick() samples at the injected clock */
+    transition_tick(&s_t[0]);
+    CHECK_NEAR(transition_get_value(&s_t[0]), 900, 1);
+
+    /* Sampling past the end lands on the target and clears the active set */
+    CHECK(!transition_sample_all(MS(2500)));
+    CHECK_EQ(transition_get_value(&s_t[0]), 1000);
+    CHECK(!transition_is_active(&s_t[0]));
+    CHECK(!transition_any_active());
+}
+
+static void test_one_instant_per_frame(void)
+{
+    /* N transitions started at different times and rates, all sampled at
+     * one frame timestamp: each equals its own closed form at that
+     * instant, whatever order they are visited in */
+    for (int i = 0; i < N; i++) {
+        s_now = MS(10000 + 7 * i);
+        transition_start(&s_t[i], 0, 0);
+        transition_start(&s_t[i], (uint16_t)(100 * (i + 1)), (uint32_t)(200 + 50 * i));
+    }
+    CHECK(transition_any_active());
+
+    for (int64_t frame = MS(10000); frame <= MS(12000); frame += 5000) {
+        s_now = frame + MS(3);      /* The clock has moved on; the frame has not */
+        bool any = transition_sample_all(frame);
+        bool expect_any = false;
+        for (int i = 0; i < N; i++) {
+            int64_t start = MS(10000 + 7 * i);
+            int64_t dur   = MS(200 + 50 * i);
+            int64_t el    = frame - start;
+            if (el < 0) el = 0;
+            int64_t want  = (el >= dur) ? 100 * (i + 1) : (int64_t)100 * (i + 1) * el / dur;
+            CHECK_NEAR(transition_get_value(&s_t[i]), want, 1);
+            if (el < dur) expect_any = true;
+        }
+        CHECK_EQ(any, expect_any);
+    }
+    CHECK(!transition_any_active());
+}
+
+static void test_idle_costs_nothing(void)
+{
+    /* Nothing active: sample_all visits nothing and leaves values alone */
+    transition_start(&s_t[1], 77, 0);
+    CHECK(!transition_sample_all(MS(20000)));
+    CHECK_EQ(transition_get_value(&s_t[1]), 77);
+    CHECK_EQ(transition_get_value(&s_t[0]), 100);
+}
+
+int main(void)
+{
+    transition_engine_set_clock(virtual_clock);
+    transition_engine_set_timer(&s_vt);
+    CHECK_EQ(transition_engine_init_lazy(), ESP_OK);
+    for (int i = 0; i < N; i++) {
+        transition_register(&s_t[i]);
+    }
+
+    RUN(test_values_move_only_when_sampled);
+    RUN(test_one_instant_per_frame);
+    RUN(test_idle_costs_nothing);
+
+    /* Lazy mode never touched a timer */
+    CHECK_EQ(s_timer_calls, 0);
+    return test_summary("test_lazy");
+}
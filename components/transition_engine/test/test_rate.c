@@ -0,0 +1,122 @@
+/**
+ * @file test_rate.c
+ * @brief transition_sample() with the precomputed reciprocal against the
+ * exact 64-bit divide it replaced, over random values, durations from
+ * 1 ms to the 4294967 ms maximum, elapsed times, and every easing.
+ *
+ * Tolerance: linear within 2 (Q16.16) of the exact quotient and never
+ * past the target; eased within one Q16 phase step of the exact phase.
+ * Run with an argument to scale the sample count (default 1).
+ */
+
+#include "transition_engine.h"
+#include "transition_easing.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#define MAX_DURATION_MS  4294967u   /* duration_us is 32 bits */
+
+static int64_t s_now;
+
+static int64_t virtual_clock(void)
+{
+    return s_now;
+}
+
+/* The divide that transition_sample() did per sample before the
+ * reciprocal, with the phase advanced by `bump` Q16 steps */
+static uint32_t exact_q16(uint16_t from, uint16_t to, uint32_t dur_us, uint32_t el_us,
+                          uint8_t easing, int bump)
+{
+    int64_t span = ((int64_t)to << 16) - ((int64_t)from << 16);
+    if (easing == TRANSITION_EASE_LINEAR) {
+        /* span * elapsed needs up to 65 bits at the longest durations */
+        return (uint32_t)(((int64_t)from << 16) + (int64_t)((__int128)span * el_us / dur_us));
+    }
+    int64_t p = ((int64_t)el_us << 16) / dur_us + bump;
+    uint16_t phase = p > 65535 ? 65535 : (uint16_t)p;
+    uint16_t eased;
+    if (easing == TRANSITION_EASE_PERCEPTUAL && span < 0) {
+        eased = 65535 - transition_ease(easing, 65535 - phase);
+    } else {
+        eased = transition_ease(easing, phase);
+    }
+    return (uint32_t)(((int64_t)from << 16) + ((span * eased) >> 16));
+}
+
+/* Random duration, spread over the decades up to the maximum */
+static uint32_t rand_duration_ms(uint32_t *seed)
+{
+    uint32_t decade = test_rand(seed) % 7;            /* 1 ms .. 1e6 ms */
+    uint32_t scale = 1;
+    for (uint32_t i = 0; i < decade; i++) scale *= 10;
+    uint64_t ms = (uint64_t)scale + test_rand(seed) % (9u * scale);
+    return ms > MAX_DURATION_MS ? MAX_DURATION_MS : (uint32_t)ms;
+}
+
+static void test_tolerance(int samples)
+{
+    static transition_t t;
+    uint32_t seed = 0xC0FFEEu;
+    long long n = 0, off[TRANSITION_EASE_COUNT] = {0};
+    int64_t worst_linear = 0;
+
+    for (int i = 0; i < samples; i++) {
+        uint8_t easing = (uint8_t)(i % TRANSITION_EASE_COUNT);
+        uint16_t from = (uint16_t)test_rand(&seed);
+        uint16_t to   = (uint16_t)test_rand(&seed);
+        uint32_t ms   = (i % 64 == 0) ? MAX_DURATION_MS : rand_duration_ms(&seed);
+        uint32_t dur  = ms * 1000u;
+
+        s_now = 0;
+        transition_start(&t, from, 0);
+        transition_start_ex(&t, to, ms, (transition_easing_t)easing);
+
+        /* Random points, plus the first and last microseconds */
+        for (int k = 0; k < 8; k++) {
+            uint32_t el = (k == 0) ? 0 : (k == 1) ? dur - 1 : test_rand(&seed) % dur;
+            transition_sample(&t, el);
+            uint32_t got = transition_get_value_q16(&t);
+            uint32_t want = exact_q16(from, to, dur, el, easing, 0);
+            n++;
+            if (got != want) off[easing]++;
+
+            if (easing == TRANSITION_EASE_LINEAR) {
+                int64_t d = (int64_t)got - (int64_t)want;
+                if (d < 0) d = -d;
+                if (d > worst_linear) worst_linear = d;
+                CHECK(d <= 2);
+                /* Rounding the rate up never overshoots the target */
+                if (to >= from) CHECK(got <= (uint32_t)to << 16);
+                else            CHECK(got >= (uint32_t)to << 16);
+            } else {
+                CHECK(got == want || got == exact_q16(from, to, dur, el, easing, 1));
+            }
+        }
+
+        /* The end lands exactly on the target */
+        transition_sample(&t, dur);
+        CHECK_EQ(transition_get_value_q16(&t), (uint32_t)to << 16);
+        CHECK(!transition_is_active(&t));
+    }
+
+    printf("  %lld samples, worst linear error %lld (Q16.16)\n", n, (long long)worst_linear);
+    printf("  differing from the exact divide:");
+    for (int e = 0; e < TRANSITION_EASE_COUNT; e++) {
+        printf(" %lld", off[e]);
+    }
+    printf(" (per easing)\n");
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    transition_engine_init_lazy();
+    transition_engine_set_clock(virtual_clock);
+
+    printf("- test_tolerance\n");
+    test_tolerance(200000 * scale);
+    return test_summary("test_rate");
+}
@@ -0,0 +1,183 @@
+/**
+ * @file test_seqlock.c
+ * @brief Stress test of transition_read() against concurrent writers.
+ *
+ * Timer mode with a virtual timer whose callback runs on its own thread,
+ * as the esp_timer task does on the device. Two caller threads restart
+ * their half of the transitions with encoded pairs: an instant jump to A,
+ * then a fade to A ^ 0xA5A5, so every consistent snapshot has
+ * target == start (after the jump) or target == start ^ 0xA5A5 (during or
+ * after the fade), with the current value between the two. Reader threads
+ * check every snapshot; a torn one mixes fields of different writes and
+ * breaks the pairing.
+ *
+ * Run with an argument to set the duration in ms (default 1000).
+ */
+
+#include "transition_engine.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define N_TRANS     16
+#define N_CALLERS   2
+#define N_READERS   2
+#define PAIR        0xA5A5u
+
+static transition_t s_t[N_TRANS];
+
+static void      (*s_cb)(void *);
+static atomic_bool s_timer_on;
+static atomic_bool s_stop;
+
+static atomic_llong s_reads;
+static atomic_llong s_torn;
+static atomic_llong s_starts;
+static atomic_llong s_ticks;
+
+static esp_err_t vt_create(void (*cb)(void *), void **handle)
+{
+    static int dummy;
+    s_cb = cb;
+    *handle = &dummy;
+    return ESP_OK;
+}
+
+static void vt_start(void *handle, uint64_t period_us)
+{
+    (void)handle;
+    (void)period_us;
+    atomic_store(&s_timer_on, true);
+}
+
+static void vt_stop(void *handle)
+{
+    (void)handle;
+    atomic_store(&s_timer_on, false);
+}
+
+static const transition_timer_ops_t s_vt = {
+    .create = vt_create,
+    .start  = vt_start,
+    .stop   = vt_stop,
+};
+
+/* The timer task: fires back to back while armed */
+static void *timer_thread(void *arg)
+{
+    (void)arg;
+    while (!atomic_load(&s_stop)) {
+        if (atomic_load(&s_timer_on)) {
+            s_cb(NULL);
+            atomic_fetch_add(&s_ticks, 1);
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *caller_thread(void *arg)
+{
+    int first = (int)(intptr_t)arg * (N_TRANS / N_CALLERS);
+    uint32_t seed = 0x9E3779B9u + (uint32_t)first;
+    long long n = 0;
+    while (!atomic_load(&s_stop)) {
+        for (int i = first; i < first + N_TRANS / N_CALLERS; i++) {
+            uint16_t a = (uint16_t)test_rand(&seed);
+            transition_start(&s_t[i], a, 0);
+            transition_start(&s_t[i], (uint16_t)(a ^ PAIR), 1 + test_rand(&seed) % 4);
+            n++;
+        }
+    }
+    atomic_fetch_add(&s_starts, n);
+    return NULL;
+}
+
+static bool consistent(const transition_snapshot_t *s)
+{
+    uint16_t lo = s->start_value, hi = s->target_value;
+    if (lo > hi) {
+        lo = s->target_value;
+        hi = s->start_value;
+    }
+    if (s->target_value != s->start_value && s->target_value != (s->start_value ^ PAIR)) {
+        return false;
+    }
+    if (s->target_value == s->start_value && s->active) {
+        return false;   /* Only instant writes leave start == target */
+    }
+    return s->current_value >= lo && s->current_value <= hi;
+}
+
+static void *reader_thread(void *arg)
+{
+    (void)arg;
+    long long reads = 0, torn = 0;
+    while (!atomic_load(&s_stop)) {
+        for (int i = 0; i < N_TRANS; i++) {
+            transition_snapshot_t s;
+            transition_read(&s_t[i], &s);
+            if (!consistent(&s)) {
+                if (torn < 5) {
+                    printf("  torn snapshot of %d: active %d start %u target %u current %u\n",
+                           i, s.active, s.start_value, s.target_value, s.current_value);
+                }
+                torn++;
+            }
+            reads++;
+        }
+    }
+    atomic_fetch_add(&s_reads, reads);
+    atomic_fetch_add(&s_torn, torn);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int run_ms = (argc > 1) ? atoi(argv[1]) : 1000;
+    if (run_ms < 1) run_ms = 1;
+
+    transition_engine_set_timer(&s_vt);
+    CHECK_EQ(transition_engine_init(200), ESP_OK);
+    for (int i = 0; i < N_TRANS; i++) {
+        CHECK_EQ(transition_register(&s_t[i]), ESP_OK);
+    }
+
+    pthread_t th[1 + N_CALLERS + N_READERS];
+    int n = 0;
+    pthread_create(&th[n++], NULL, timer_thread, NULL);
+    for (int i = 0; i < N_CALLERS; i++) {
+        pthread_create(&th[n++], NULL, caller_thread, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < N_READERS; i++) {
+        pthread_create(&th[n++], NULL, reader_thread, NULL);
+    }
+
+    struct timespec ts = { run_ms / 1000, (long)(run_ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+    atomic_store(&s_stop, true);
+    for (int i = 0; i < n; i++) {
+        pthread_join(th[i], NULL);
+    }
+
+    printf("  %d ms: %lld starts, %lld timer ticks, %lld reads, %lld torn\n", run_ms,
+           (long long)s_starts, (long long)s_ticks, (long long)s_reads, (long long)s_torn);
+    CHECK(s_starts > 0);
+    CHECK(s_ticks > 0);
+    CHECK(s_reads > 0);
+    CHECK_EQ(s_torn, 0);
+
+    /* Quiescent: every fade finishes on its paired target */
+    CHECK(!transition_sample_all(INT64_MAX / 2));
+    for (int i = 0; i < N_TRANS; i++) {
+        transition_snapshot_t s;
+        transition_read(&s_t[i], &s);
+        CHECK(!s.active);
+        CHECK_EQ(s.target_value, s.start_value ^ PAIR);
+        CHECK_EQ(s.current_value, s.target_value);
+    }
+    return test_summary("test_seqlock");
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_timer.c
+ * @brief Timer mode (transition_engine_init()) on a virtual timer: the
+ * timer arms on a start, ticks registered transitions, and disarms once
+ * they have all finished.
+ */
+
+#include "transition_engine.h"
+#include "test_util.h"
+
+#define MS(x)  ((int64_t)(x) * 1000)
+
+static int64_t  s_now;
+static void   (*s_cb)(void *);
+static bool     s_running;
+static uint64_t s_period_us;
+static int      s_starts;
+static int      s_stops;
+
+static int64_t virtual_clock(void)
+{
+    return s_now;
+}
+
+static esp_err_t vt_create(void (*cb)(void *), void **handle)
+{
+    static int dummy;
+    s_cb = cb;
+    *handle = &dummy;
+    return ESP_OK;
+}
+
+static void vt_start(void *handle, uint64_t period_us)
+{
+    (void)handle;
+    s_running = true;
+    s_period_us = period_us;
+    s_starts++;
+}
+
+static void vt_stop(void *handle)
+{
+    (void)handle;
+    s_running = false;
+    s_stops++;
+}
+
+static const transition_timer_ops_t s_vt = {
+    .create = vt_create,
+    .start  = vt_start,
+    .stop   = vt_stop,
+};
+
+/* Advance the virtual clock, firing the timer at each period while it runs */
+static void run_for(int64_t us)
+{
+    int64_t end = s_now + us;
+    while (s_running && s_now + (int64_t)s_period_us <= end) {
+        s_now += (int64_t)s_period_us;
+        s_cb(NULL);
+    }
+    s_now = end;
+}
+
+static transition_t s_a, s_b;
+
+static void test_arm_and_disarm(void)
+{
+    CHECK(!s_running);
+    CHECK_EQ(s_starts, 0);
+
+    transition_start(&s_a, 1000, 100);
+    CHECK(s_running);
+    CHECK_EQ(s_period_us, 5000);
+    CHECK_EQ(s_starts, 1);
+
+    run_for(MS(50));
+    CHECK_NEAR(transition_get_value(&s_a), 500, 1);
+
+    /* A second start while running does not re-arm */
+    transition_start(&s_b, 200, 200);
+    CHECK_EQ(s_starts, 1);
+
+    run_for(MS(60));
+    CHECK_EQ(transition_get_value(&s_a), 1000);
+    CHECK(!transition_is_active(&s_a));
+    CHECK(s_running);               /* s_b still running */
+
+    run_for(MS(200));
+    CHECK_EQ(transition_get_value(&s_b), 200);
+    CHECK(!s_running);
+    CHECK_EQ(s_stops, 1);
+    CHECK(!transition_any_active());
+
+    /* Idle: no ticks at all */
+    int64_t before = s_now;
+    run_for(MS(1000));
+    CHECK_EQ(s_now, before + MS(1000));
+    CHECK_EQ(s_starts, 1);
+}
+
+static void test_rearm_after_idle(void)
+{
+    transition_start(&s_a, 0, 50);
+    CHECK(s_running);
+    CHECK_EQ(s_starts, 2);
+    run_for(MS(25));
+    CHECK_NEAR(transition_get_value(&s_a), 500, 1);
+
+    /* Cancel of the only active transition: the next tick disarms */
+    transition_cancel(&s_a);
+    run_for(MS(5));
+    CHECK(!s_running);
+    CHECK_NEAR(transition_get_value(&s_a), 500, 1);
+
+    /* Instant starts never arm the timer */
+    transition_start(&s_a, 7, 0);
+    CHECK(!s_running);
+    CHECK_EQ(transition_get_value(&s_a), 7);
+}
+
+int main(void)
+{
+    transition_engine_set_clock(virtual_clock);
+    transition_engine_set_timer(&s_vt);
+    CHECK_EQ(transition_engine_init(200), ESP_OK);
+    CHECK_EQ(transition_engine_init_lazy(), ESP_ERR_INVALID_STATE);
+    transition_register(&s_a);
+    transition_register(&s_b);
+
+    RUN(test_arm_and_disarm);
+    RUN(test_rearm_after_idle);
+    return test_summary("test_timer");
+}
@@ -0,0 +1,219 @@
+/**
+ * @file test_transition.c
+ * @brief Deterministic tests of transition_t and transition_batch_t timing,
+ * in lazy mode on a virtual clock.
+ */
+
+#include "transition_engine.h"
+#include "transition_batch.h"
+#include "test_util.h"
+
+#define MS(x)  ((int64_t)(x) * 1000)
+
+static int64_t s_now;
+
+static int64_t virtual_clock(void)
+{
+    return s_now;
+}
+
+/* Value at a given virtual time */
+static uint16_t value_at(transition_t *t, int64_t now_us)
+{
+    s_now = now_us;
+    return transition_sample(t, now_us);
+}
+
+static void test_duration_zero(void)
+{
+    static transition_t t;
+    transition_register(&t);
+    s_now = MS(0);
+
+    transition_start(&t, 500, 0);
+    CHECK_EQ(transition_get_value(&t), 500);
+    CHECK(!transition_is_active(&t));
+    CHECK(!transition_any_active());
+
+    /* Instant change in the middle of a fade ends the fade there */
+    transition_start(&t, 1000, 1000);
+    CHECK(transition_is_active(&t));
+    value_at(&t, MS(300));
+    transition_start(&t, 42, 0);
+    CHECK_EQ(transition_get_value(&t), 42);
+    CHECK(!transition_is_active(&t));
+    CHECK_EQ(value_at(&t, MS(2000)), 42);
+    CHECK(!transition_any_active());
+}
+
+static void test_interrupt_mid_flight(void)
+{
+    static transition_t t;
+    transition_register(&t);
+    s_now = MS(10000);
+    transition_start(&t, 0, 0);
+
+    transition_start(&t, 1000, 1000);
+    CHECK_NEAR(value_at(&t, MS(10250)), 250, 1);
+    CHECK_NEAR(value_at(&t, MS(10500)), 500, 1);
+
+    /* Reverse halfway: continues from 500 with no jump */
+    transition_start(&t, 0, 1000);
+    CHECK_NEAR(transition_get_value(&t), 500, 1);
+    CHECK_NEAR(value_at(&t, MS(10500)), 500, 1);
+    CHECK_NEAR(value_at(&t, MS(11000)), 250, 1);
+
+    /* Interrupted without a sample in between: the restart brings it up
+     * to the clock first */
+    s_now = MS(11250);
+    transition_start(&t, 1000, 500);
+    CHECK_NEAR(transition_get_value(&t), 125, 1);
+    CHECK_NEAR(value_at(&t, MS(11500)), 563, 1);
+
+    /* Lands exactly on the target and goes idle */
+    CHECK_EQ(value_at(&t, MS(11750)), 1000);
+    CHECK(!transition_is_active(&t));
+    CHECK_EQ(transition_get_value_q16(&t), 1000u << 16);
+
+    /* Cancel freezes where it is */
+    transition_start(&t, 0, 1000);
+    CHECK_NEAR(value_at(&t, MS(12150)), 600, 1);
+    transition_cancel(&t);
+    CHECK(!transition_is_active(&t));
+    CHECK_NEAR(value_at(&t, MS(13000)), 600, 1);
+}
+
+static void test_clock_skew(void)
+{
+    static transition_t t;
+    transition_register(&t);
+    s_now = MS(5000);
+    transition_start(&t, 100, 0);
+    transition_start(&t, 200, 1000);
+
+    /* A sample timestamp before the start (e.g. a frame timestamp taken
+     * just before the command was applied) reads as the start */
+    CHECK_EQ(value_at(&t, MS(4990)), 100);
+    CHECK(transition_is_active(&t));
+    CHECK_EQ(value_at(&t, MS(5000) - (1LL << 40)), 100);
+    CHECK(transition_is_active(&t));
+
+    /* Time going backwards mid-flight never leaves [start, target] */
+    CHECK_NEAR(value_at(&t, MS(5600)), 160, 1);
+    uint16_t v = value_at(&t, MS(5200));
+    CHECK(v >= 100 && v <= 200);
+    CHECK(transition_is_active(&t));
+
+    /* A restart on a clock that jumped back before the start restarts
+     * from the start value, as a sample at that time would read */
+    s_now = MS(3000);
+    transition_start(&t, 0, 1000);
+    CHECK_EQ(transition_get_value(&t), 100);
+    CHECK_NEAR(value_at(&t, MS(3500)), 50, 1);
+
+    /* A huge forward jump finishes it */
+    CHECK_EQ(value_at(&t, INT64_MAX / 2), 0);
+    CHECK(!transition_is_active(&t));
+
+    /* Batch: same guard */
+    static transition_batch_t b;
+    uint16_t tg[1] = {200};
+    transition_batch_init(&b, 1, 1);
+    transition_batch_jump(&b, 0, 0, 100);
+    transition_batch_start(&b, 0, 1, tg, 1000, MS(5000));
+    transition_batch_sample(&b, MS(4000));
+    CHECK_EQ(transition_batch_get(&b, 0, 0), 100);
+    CHECK(transition_batch_is_active(&b, 0));
+    transition_batch_sample(&b, MS(5500));
+    CHECK_NEAR(transition_batch_get(&b, 0, 0), 150, 1);
+}
+
+static void test_hue_wrap(void)
+{
+    static transition_batch_t b;
+    uint16_t tg[1];
+    transition_batch_init(&b, 2, 1);
+    transition_batch_set_channel(&b, 0, TRANSITION_EASE_LINEAR, 360);
+
+    /* 350 -> 10 goes up through 0, not down through 180 */
+    transition_batch_jump(&b, 0, 0, 350);
+    tg[0] = 10;
+    transition_batch_start(&b, 0, 1, tg, 1000, 0);
+    transition_batch_sample(&b, MS(250));
+    CHECK_NEAR(transition_batch_get(&b, 0, 0), 355, 1);
+    transition_batch_sample(&b, MS(500));
+    CHECK(transition_batch_get(&b, 0, 0) == 0 || transition_batch_get(&b, 0, 0) == 359);
+    transition_batch_sample(&b, MS(750));
+    CHECK_NEAR(transition_batch_get(&b, 0, 0), 5, 1);
+
+    /* 10 -> 300 goes down through 0 */
+    transition_batch_jump(&b, 1, 0, 10);
+    tg[0] = 300;
+    transition_batch_start(&b, 1, 1, tg, 1000, 0);
+    transition_batch_sample(&b, MS(500));
+    CHECK_NEAR(transition_batch_get(&b, 1, 0), 335, 1);
+
+    /* Every value on the way stays in [0, 360) */
+    for (int64_t ms = 0; ms <= 1000; ms += 5) {
+        transition_batch_sample(&b, MS(ms));
+        CHECK(transition_batch_get(&b, 1, 0) < 360);
+    }
+    CHECK_EQ(transition_batch_get(&b, 1, 0), 300);
+    CHECK(!transition_batch_is_active(&b, 1));
+
+    /* Targets past the modulus fold in */
+    tg[0] = 370;
+    transition_batch_start(&b, 1, 1, tg, 0, MS(1000));
+    CHECK_EQ(transition_batch_get(&b, 1, 0), 10);
+}
+
+static void test_follow_converges(void)
+{
+    static transition_batch_t b;
+    transition_batch_init(&b, 1, 1);
+    transition_batch_jump(&b, 0, 0, 0);
+
+    /* Step from rest: no overshoot, within 10% at 2 * smooth, settles
+     * exactly on the target and leaves follow mode */
+    transition_batch_follow(&b, 0, 0, 200, 100, 0);
+    uint16_t max = 0;
+    int64_t settled = -1;
+    for (int64_t ms = 5; ms <= 2000; ms += 5) {
+        bool running = transition_batch_sample(&b, MS(ms));
+        uint16_t v = transition_batch_get(&b, 0, 0);
+        if (v > max) max = v;
+        if (ms == 200) CHECK(v >= 180);
+        if (!running && settled < 0) settled = ms;
+    }
+    CHECK(max <= 200);
+    CHECK(settled > 0 && settled <= 1500);
+    CHECK_EQ(transition_batch_get_q16(&b, 0, 0), 200u << 16);
+
+    /* Frame rate does not change the curve */
+    static transition_batch_t c;
+    transition_batch_init(&c, 1, 1);
+    transition_batch_jump(&c, 0, 0, 0);
+    transition_batch_follow(&c, 0, 0, 200, 100, 0);
+    transition_batch_jump(&b, 0, 0, 0);
+    transition_batch_follow(&b, 0, 0, 200, 100, 0);
+    for (int64_t ms = 1; ms <= 120; ms++) {
+        transition_batch_sample(&b, MS(ms));
+        if (ms % 20 == 0) {
+            transition_batch_sample(&c, MS(ms));
+            CHECK_NEAR(transition_batch_get(&b, 0, 0), transition_batch_get(&c, 0, 0), 1);
+        }
+    }
+}
+
+int main(void)
+{
+    transition_engine_init_lazy();
+    transition_engine_set_clock(virtual_clock);
+
+    RUN(test_duration_zero);
+    RUN(test_interrupt_mid_flight);
+    RUN(test_clock_skew);
+    RUN(test_hue_wrap);
+    RUN(test_follow_converges);
+    return test_summary("test_transition");
+}
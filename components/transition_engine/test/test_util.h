@@ -0,0 +1,68 @@
+/**
+ * @file test_util.h
+ * @brief Minimal checks for the host tests: count failures, print each one,
+ * and return non-zero from main() so CTest reports the test as failed.
+ */
+
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+static int s_checks __attribute__((unused));
+static int s_failures __attribute__((unused));
+
+#define CHECK(cond) do {                                                    \
+    s_checks++;                                                             \
+    if (!(cond)) {                                                          \
+        s_failures++;                                                       \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+    }                                                                       \
+} while (0)
+
+#define CHECK_EQ(a, b) do {                                                 \
+    long long a_ = (long long)(a), b_ = (long long)(b);                     \
+    s_checks++;                                                             \
+    if (a_ != b_) {                                                         \
+        s_failures++;                                                       \
+        printf("%s:%d: %s == %s failed: %lld != %lld\n",                   \
+               __FILE__, __LINE__, #a, #b, a_, b_);                         \
+    }                                                                       \
+} while (0)
+
+/* |a - b| <= tol */
+#define CHECK_NEAR(a, b, tol) do {                                          \
+    long long a_ = (long long)(a), b_ = (long long)(b);                     \
+    s_checks++;                                                             \
+    if (a_ - b_ > (long long)(tol) || b_ - a_ > (long long)(tol)) {         \
+        s_failures++;                                                       \
+        printf("%s:%d: %s ~ %s failed: %lld vs %lld (tol %lld)\n",         \
+               __FILE__, __LINE__, #a, #b, a_, b_, (long long)(tol));       \
+    }                                                                       \
+} while (0)
+
+#define RUN(test) do { printf("- %s\n", #test); test(); } while (0)
+
+static inline int test_summary(const char *name)
+{
+    printf("%s: %d checks, %d failed\n", name, s_checks, s_failures);
+    return s_failures ? 1 : 0;
+}
+
+/* Wall clock for benchmarks, ns */
+static inline int64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* xorshift32: repeatable random inputs */
+static inline uint32_t test_rand(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file blend_engine.h
+ * @brief Layer blend modes for compositing overlapping segments
+ *
+ * Segments are layered by number (segment 1 at the bottom). A segment in
+ * BLEND_REPLACE covers whatever is below it, as before; any other mode
+ * combines its pixels with the layers underneath, so an accent segment can
+ * brighten or tint a base segment without the geometry being split by hand.
+ * The span map (segment_spans.h) records which layers meet on each run, and
+ * the renderer composites them bottom-up with blend_run().
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Blend modes (segment_blend_t.mode)
+ *
+ * Per channel, with d the layers below and s this segment:
+ */
+typedef enum {
+    BLEND_REPLACE = 0,  /**< s (opaque: hides the layers below) */
+    BLEND_ADD,          /**< min(d + s, 255) */
+    BLEND_MAX,          /**< max(d, s) */
+    BLEND_MULTIPLY,     /**< d * s / 255 (tints; black where s is black) */
+    BLEND_ALPHA,        /**< d + (s - d) * opacity / 255 */
+    BLEND_COUNT
+} blend_mode_t;
+
+/**
+ * @brief Lower-case name of a mode ("replace", "add", ...), NULL if out of
+ * range
+ */
+const char *blend_name(uint8_t mode);
+
+/**
+ * @brief Blend n RGBW pixels of src onto dst in place
+ *
+ * A pixel is one word holding its four channel bytes in memory order, so
+ * the kernels work on all four channels at once. Integer only, no branch
+ * per pixel.
+ *
+ * @param mode     blend_mode_t; out of range leaves dst unchanged
+ * @param opacity  0-255, used by BLEND_ALPHA
+ * @param dst      n pixels, the layers below; receives the result
+ * @param src      n pixels, this layer
+ * @param n        Number of pixels
+ */
+void blend_run(uint8_t mode, uint8_t opacity, uint32_t *dst, const uint32_t *src, uint16_t n);
+
+#ifdef __cplusplus
+}
+#endif
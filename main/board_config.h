@@ -28,6 +28,7 @@ extern "C" {
 /* Per-strip LED count defaults */
 #define LED_STRIP_1_COUNT              30   /* Strip 1 default LED count */
 #define LED_STRIP_2_COUNT              0    /* Strip 2 default: disabled */
+#define LED_STRIP_MAX_COUNT            2000 /* Upper limit (long strips are SPI-streamed) */
 
 /* Segment configuration */
 #define MAX_SEGMENTS                   8    /* Maximum number of virtual segments */
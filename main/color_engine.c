@@ -7,8 +7,9 @@
  */
 
 #include "color_engine.h"
-#include "transition_engine.h"
+#if !COLOR_ENGINE_FIXED_POINT
 #include <math.h>
+#endif
 
 /* ================================================================== */
 /*  HSV to RGB Conversion                                             */
@@ -25,13 +26,20 @@ void hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_
         /* Small overshoot (e.g., 370) or normal range - just modulo */
         h %= 360;
     }
+    hsv_to_rgb_q8((uint32_t)h << 8, s, v, r, g, b);
+}
+
+void hsv_to_rgb_q8(uint32_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    h %= 360u << 8;
     if (s == 0) { *r = *g = *b = v; return; }
 
-    uint8_t region    = h / 60;
-    uint16_t remainder = (h - (region * 60)) * 6;  /* Fix overflow: max value is 354 */
+    /* As in whole degrees with both sides of each ratio scaled by 256 */
+    uint8_t  region    = (uint8_t)(h / (60u << 8));
+    uint32_t remainder = (h - region * (60u << 8)) * 6;  /* Max 354.x * 256 */
     uint8_t p = (v * (254 - s)) / 254;
-    uint8_t q = (v * (254 - ((s * remainder) / 360))) / 254;
-    uint8_t t = (v * (254 - ((s * (360 - remainder)) / 360))) / 254;
+    uint8_t q = (v * (254 - ((s * remainder) / (360u << 8)))) / 254;
+    uint8_t t = (v * (254 - ((s * ((360u << 8) - remainder)) / (360u << 8)))) / 254;
 
     switch (region) {
     case 0: *r = v; *g = t; *b = p; break;
@@ -47,6 +55,140 @@ void hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_
 /*  CIE 1931 XY Chromaticity Conversion                               */
 /* ================================================================== */
 
+#if COLOR_ENGINE_FIXED_POINT
+
+/* Integer implementation: the ESP32-H2 has no FPU, so powf() and float maths
+ * go through soft-float. Gamma is table-driven and linear light is Q16. The
+ * sRGB -> XYZ matrix is Q12 so a row fits in 32 bits. XYZ -> sRGB runs in 64
+ * bits anyway (X and Z grow as 1/y) and uses Q20: near the spectral locus R/G/B
+ * come from large X and Z terms cancelling, where Q12 rounding shows. */
+
+#define CM_Q        12
+#define CM(c)       ((int32_t)((c) * (1 << CM_Q) + ((c) < 0 ? -0.5 : 0.5)))
+#define CMI_Q       20
+#define CMI(c)      ((int64_t)((c) * (1 << CMI_Q) + ((c) < 0 ? -0.5 : 0.5)))
+
+/* sRGB code -> linear light, Q16 (1.0 = 65536, saturated at 65535) */
+static const uint16_t s_gamma_lin[256] = {
+        0,    20,    40,    60,    80,    99,   119,   139,   159,   179,   199,   219,
+      241,   264,   288,   313,   340,   367,   396,   427,   458,   491,   526,   562,
+      599,   637,   677,   718,   761,   805,   851,   898,   947,   997,  1048,  1101,
+     1156,  1212,  1270,  1330,  1391,  1453,  1517,  1583,  1651,  1720,  1791,  1863,
+     1937,  2013,  2090,  2170,  2250,  2333,  2418,  2504,  2592,  2681,  2773,  2866,
+     2961,  3058,  3157,  3258,  3360,  3464,  3570,  3678,  3788,  3900,  4014,  4129,
+     4247,  4366,  4488,  4611,  4736,  4864,  4993,  5124,  5257,  5392,  5530,  5669,
+     5810,  5953,  6099,  6246,  6395,  6547,  6701,  6856,  7014,  7174,  7336,  7500,
+     7666,  7834,  8004,  8177,  8352,  8529,  8708,  8889,  9072,  9258,  9446,  9636,
+     9828, 10022, 10219, 10418, 10619, 10822, 11028, 11236, 11446, 11658, 11873, 12090,
+    12309, 12531, 12754, 12981, 13209, 13440, 13673, 13909, 14147, 14387, 14629, 14874,
+    15122, 15372, 15624, 15878, 16135, 16394, 16656, 16920, 17187, 17456, 17727, 18001,
+    18278, 18556, 18838, 19121, 19408, 19696, 19988, 20281, 20578, 20876, 21178, 21481,
+    21788, 22096, 22408, 22722, 23038, 23357, 23679, 24003, 24329, 24659, 24991, 25325,
+    25662, 26002, 26344, 26689, 27036, 27387, 27739, 28095, 28453, 28813, 29177, 29543,
+    29911, 30283, 30657, 31033, 31413, 31795, 32180, 32567, 32957, 33350, 33746, 34144,
+    34545, 34949, 35355, 35765, 36177, 36591, 37009, 37429, 37852, 38278, 38707, 39138,
+    39572, 40009, 40449, 40892, 41337, 41786, 42237, 42691, 43147, 43607, 44069, 44534,
+    45003, 45474, 45947, 46424, 46904, 47386, 47871, 48360, 48851, 49345, 49842, 50342,
+    50844, 51350, 51859, 52370, 52884, 53402, 53922, 54445, 54972, 55501, 56033, 56568,
+    57106, 57647, 58191, 58738, 59288, 59841, 60397, 60956, 61518, 62083, 62651, 63222,
+    63796, 64373, 64953, 65535
+};
+
+/* Inverse gamma as rounding thresholds: code k is the largest k with
+ * linear >= s_gamma_inv_thresh[k] (Q16). Matches round(f(v) * 255). */
+static const uint16_t s_gamma_inv_thresh[256] = {
+        0,    10,    30,    50,    70,    90,   110,   130,   150,   170,   189,   209,
+      230,   253,   276,   301,   327,   354,   382,   412,   443,   475,   509,   544,
+      580,   618,   657,   698,   740,   783,   828,   875,   923,   972,  1023,  1075,
+     1129,  1185,  1242,  1300,  1360,  1422,  1486,  1551,  1617,  1685,  1755,  1827,
+     1900,  1975,  2052,  2130,  2210,  2292,  2376,  2461,  2548,  2637,  2727,  2820,
+     2914,  3010,  3108,  3208,  3309,  3412,  3518,  3625,  3734,  3844,  3957,  4072,
+     4188,  4307,  4427,  4550,  4674,  4800,  4929,  5059,  5191,  5325,  5461,  5600,
+     5740,  5882,  6026,  6173,  6321,  6471,  6624,  6779,  6935,  7094,  7255,  7418,
+     7583,  7750,  7920,  8091,  8265,  8440,  8618,  8798,  8981,  9165,  9352,  9541,
+     9732,  9925, 10121, 10318, 10518, 10721, 10925, 11132, 11341, 11552, 11766, 11981,
+    12200, 12420, 12643, 12868, 13095, 13325, 13557, 13791, 14028, 14267, 14508, 14752,
+    14998, 15247, 15498, 15751, 16007, 16265, 16525, 16788, 17054, 17322, 17592, 17864,
+    18140, 18417, 18697, 18980, 19265, 19552, 19842, 20135, 20430, 20727, 21027, 21330,
+    21635, 21942, 22252, 22565, 22880, 23198, 23518, 23841, 24166, 24494, 24825, 25158,
+    25494, 25832, 26173, 26517, 26863, 27212, 27563, 27917, 28274, 28633, 28995, 29360,
+    29727, 30097, 30470, 30845, 31223, 31604, 31987, 32373, 32762, 33154, 33548, 33945,
+    34345, 34747, 35152, 35560, 35971, 36384, 36800, 37219, 37641, 38065, 38493, 38923,
+    39355, 39791, 40229, 40671, 41115, 41562, 42011, 42464, 42919, 43377, 43838, 44302,
+    44769, 45238, 45711, 46186, 46664, 47145, 47629, 48116, 48605, 49098, 49593, 50092,
+    50593, 51097, 51604, 52114, 52627, 53143, 53662, 54184, 54709, 55236, 55767, 56300,
+    56837, 57377, 57919, 58465, 59013, 59564, 60119, 60676, 61237, 61800, 62367, 62936,
+    63509, 64084, 64663, 65245
+};
+
+/* Linear light (Q16) -> sRGB code: binary search over the 256 thresholds */
+static uint8_t gamma_inverse_q16(int64_t lin)
+{
+    if (lin <= 0) return 0;
+    if (lin >= 65535) return 255;
+    uint16_t v = (uint16_t)lin;
+    uint8_t k = 0;
+    for (uint8_t step = 128; step; step >>= 1) {
+        if (v >= s_gamma_inv_thresh[k + step]) k += step;
+    }
+    return k;
+}
+
+void rgb_to_xy(uint8_t r, uint8_t g, uint8_t b, uint16_t *x, uint16_t *y)
+{
+    /* Gamma correct RGB → linear RGB (Q16) */
+    uint32_t R = s_gamma_lin[r];
+    uint32_t G = s_gamma_lin[g];
+    uint32_t B = s_gamma_lin[b];
+
+    /* sRGB → XYZ conversion matrix (D65 illuminant), Q16 * Q12 fits in 32 bits */
+    uint32_t X = R * CM(0.4124564) + G * CM(0.3575761) + B * CM(0.1804375);
+    uint32_t Y = R * CM(0.2126729) + G * CM(0.7151522) + B * CM(0.0721750);
+    uint32_t Z = R * CM(0.0193339) + G * CM(0.1191920) + B * CM(0.9503041);
+
+    /* XYZ → xy chromaticity */
+    uint32_t sum = X + Y + Z;
+    if (sum == 0) {
+        /* Black - use D65 white point */
+        *x = (uint16_t)(0.31271f * 65535.0f);
+        *y = (uint16_t)(0.32902f * 65535.0f);
+    } else {
+        /* X, Y <= sum, so the result is already within [0, 65535] */
+        *x = (uint16_t)(((uint64_t)X * 65535 + sum / 2) / sum);
+        *y = (uint16_t)(((uint64_t)Y * 65535 + sum / 2) / sum);
+    }
+}
+
+void xy_to_rgb(uint16_t x, uint16_t y, uint8_t level, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    /* Calculate z from x + y + z = 1 (may be negative for out-of-gamut xy) */
+    int32_t z = 65535 - (int32_t)x - (int32_t)y;
+
+    /* Convert xy → XYZ (using brightness as Y), all Q16. Y / y is computed
+     * once; it can exceed 32 bits for tiny y, so XYZ are 64-bit. */
+    int64_t Y = (int64_t)level * 257;                      /* level / 255 in Q16 */
+    int64_t k;                                             /* Y / y_val, Q16 */
+    if (y == 0) {
+        k = Y * 100000;                                    /* y_val floored at 0.00001 */
+    } else {
+        k = ((Y << 16) + y / 2) / y;
+    }
+    int64_t X = (k * x) >> 16;
+    int64_t Z = (k * z) >> 16;
+
+    /* XYZ → sRGB conversion matrix (D65 illuminant, inverse), Q20 */
+    int64_t R = (X * CMI( 3.2404542) + Y * CMI(-1.5371385) + Z * CMI(-0.4985314)) >> CMI_Q;
+    int64_t G = (X * CMI(-0.9692660) + Y * CMI( 1.8760108) + Z * CMI( 0.0415560)) >> CMI_Q;
+    int64_t B = (X * CMI( 0.0556434) + Y * CMI(-0.2040259) + Z * CMI( 1.0572252)) >> CMI_Q;
+
+    /* Clamp to [0, 1] and apply inverse gamma correction */
+    *r = gamma_inverse_q16(R);
+    *g = gamma_inverse_q16(G);
+    *b = gamma_inverse_q16(B);
+}
+
+#else /* !COLOR_ENGINE_FIXED_POINT */
+
 /* sRGB gamma correction (linearization) */
 static float gamma_correct(uint8_t value)
 {
@@ -147,6 +289,8 @@ void xy_to_rgb(uint16_t x, uint16_t y, uint8_t level, uint8_t *r, uint8_t *g, ui
     *b = gamma_inverse(B);
 }
 
+#endif /* COLOR_ENGINE_FIXED_POINT */
+
 /* ================================================================== */
 /*  Hue Manipulation Utilities                                        */
 /* ================================================================== */
@@ -181,11 +325,3 @@ int16_t hue_shortest_arc(uint16_t current_hue, uint16_t target_hue)
 
     return target;
 }
-
-void start_hue_transition(transition_t *hue_trans, uint16_t target_hue, uint32_t duration_ms)
-{
-    uint16_t current_hue_raw = transition_get_value(hue_trans);
-    uint16_t current_hue = normalize_hue(current_hue_raw);
-    int16_t adjusted_target = hue_shortest_arc(current_hue, target_hue);
-    transition_start(hue_trans, (uint16_t)adjusted_target, duration_ms);
-}
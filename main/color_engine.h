@@ -6,14 +6,12 @@
  * - HSV to RGB conversion with wraparound handling
  * - CIE 1931 XY chromaticity conversion (RGB ↔ XY)
  * - Hue normalization and shortest arc calculation
- * - Transition utilities for smooth color changes
  */
 
 #ifndef COLOR_ENGINE_H
 #define COLOR_ENGINE_H
 
 #include <stdint.h>
-#include "transition_engine.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,10 +37,63 @@ extern "C" {
  */
 void hsv_to_rgb(uint16_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b);
 
+/**
+ * @brief Convert HSV color to RGB with hue in 1/256 degree steps
+ *
+ * Same as hsv_to_rgb() for h = degrees * 256, but a fractional hue (e.g.
+ * the Q16.16 output of a hue transition shifted down by 8) moves the
+ * result between whole degrees, where one degree at full saturation is
+ * about 4 RGB steps.
+ *
+ * @param h  Hue in 1/256 degree (0 to 360*256, larger values wrap)
+ * @param s  Saturation (0-254, Zigbee scale)
+ * @param v  Value/Brightness (0-255)
+ */
+void hsv_to_rgb_q8(uint32_t h, uint8_t s, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b);
+
+/**
+ * @brief Per-pixel HSV to RGB without division, for hue stepped by adding
+ *
+ * Each 60 degree sector is one channel ramping against the other two, so a
+ * colour is a shift, a mask and two multiplies per channel. Unlike
+ * hsv_to_rgb(), saturation runs to 255, and 254 is not quite full.
+ *
+ * @param h    Hue, 2^32 = one turn (wraps naturally)
+ * @param s    Saturation 0-255
+ * @param v    Value 0-255
+ * @param out  R, G, B
+ */
+static inline void hue_wheel_rgb(uint32_t h, uint32_t s, uint32_t v, uint8_t *out)
+{
+    uint32_t x     = (h >> 16) * 6;
+    uint32_t up    = (x >> 8) & 0xFF;
+    uint32_t down  = 255 - up;
+    uint32_t white = (255 - s) * 255;           /* Desaturation floor */
+    uint32_t r, g, b;
+    switch (x >> 16) {
+    case 0:  r = 255;  g = up;   b = 0;    break;
+    case 1:  r = down; g = 255;  b = 0;    break;
+    case 2:  r = 0;    g = 255;  b = up;   break;
+    case 3:  r = 0;    g = down; b = 255;  break;
+    case 4:  r = up;   g = 0;    b = 255;  break;
+    default: r = 255;  g = 0;    b = down; break;
+    }
+    /* (white + c * s) is 0-255*255; * v / (255*255) via * 259 >> 24 */
+    out[0] = (uint8_t)(((white + r * s) * v * 259) >> 24);
+    out[1] = (uint8_t)(((white + g * s) * v * 259) >> 24);
+    out[2] = (uint8_t)(((white + b * s) * v * 259) >> 24);
+}
+
 /* ================================================================== */
 /*  CIE 1931 XY Chromaticity Conversion                               */
 /* ================================================================== */
 
+/* 1 = integer gamma tables and Q12 matrices (no FPU on ESP32-H2),
+ * 0 = float reference using powf(). Override with -DCOLOR_ENGINE_FIXED_POINT=0. */
+#ifndef COLOR_ENGINE_FIXED_POINT
+#define COLOR_ENGINE_FIXED_POINT 1
+#endif
+
 /**
  * @brief Convert RGB to CIE 1931 XY chromaticity
  *
@@ -108,18 +159,6 @@ uint16_t normalize_hue(uint16_t hue_raw);
  */
 int16_t hue_shortest_arc(uint16_t current_hue, uint16_t target_hue);
 
-/**
- * @brief Start a hue transition with automatic shortest-arc calculation
- *
- * Always calculates shortest path around color wheel, even if current
- * transition value is wrapped from a previous arc-adjusted transition.
- *
- * @param hue_trans    Pointer to hue transition_t
- * @param target_hue   Desired target hue (0-360)
- * @param duration_ms  Transition duration in milliseconds
- */
-void start_hue_transition(transition_t *hue_trans, uint16_t target_hue, uint32_t duration_ms);
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,170 @@
+/**
+ * @file effect_engine.c
+ * @brief Per-pixel segment effects (render task only)
+ *
+ * Each kernel works out where the first requested LED sits in the pattern
+ * once per call (the only multiply-divide), then walks the run adding a
+ * constant step per LED. Brightness is applied to the segment colour as
+ * (c * (b + 1)) >> 8, so b = 255 leaves the colour unchanged.
+ */
+
+#include "effect_engine.h"
+#include "color_engine.h"
+#include <string.h>
+
+/* Phase per microsecond per unit of speed: speed 1 = 1/64 cycle/s */
+#define EFFECT_RATE       67u
+#define EFFECT_MAX_DT_US  100000
+
+#define TWINKLE_FLOOR     32      /* Background brightness, 1/8 */
+#define WEYL_STEP         0x9E3779B9u
+
+static const char *const s_names[EFFECT_COUNT] = {
+    "none", "rainbow", "chase", "twinkle", "comet", "breathe",
+};
+
+/* Per-segment animation state */
+static uint32_t s_phase[MAX_SEGMENTS];
+static int64_t  s_last_us;
+static bool     s_started;
+
+const char *effect_name(uint8_t id)
+{
+    return (id < EFFECT_COUNT) ? s_names[id] : NULL;
+}
+
+void effect_engine_advance(const segment_effect_t fx[MAX_SEGMENTS], int64_t now_us)
+{
+    int64_t dt = s_started ? now_us - s_last_us : 0;
+    if (dt < 0) dt = 0;
+    if (dt > EFFECT_MAX_DT_US) dt = EFFECT_MAX_DT_US;
+    s_last_us = now_us;
+    s_started = true;
+
+    for (int n = 0; n < MAX_SEGMENTS; n++) {
+        if (fx[n].id == EFFECT_NONE) continue;
+        s_phase[n] += fx[n].speed * EFFECT_RATE * (uint32_t)dt;
+    }
+}
+
+uint32_t effect_engine_phase(uint8_t seg)
+{
+    return (seg < MAX_SEGMENTS) ? s_phase[seg] : 0;
+}
+
+/* Triangle wave over one cycle of phase, 0 -> 255 -> 0, squared so the
+ * dark end lingers the way a fade looks on linear LEDs */
+static inline uint32_t wave(uint32_t phase)
+{
+    uint32_t p   = phase >> 23;                 /* 0-511 */
+    uint32_t tri = (p < 256) ? p : 511 - p;
+    return (tri * tri) >> 8;                    /* 0-254 */
+}
+
+static inline void put_scaled(uint8_t *out, const uint8_t *c, uint32_t b)
+{
+    b += 1;
+    out[0] = (uint8_t)((c[0] * b) >> 8);
+    out[1] = (uint8_t)((c[1] * b) >> 8);
+    out[2] = (uint8_t)((c[2] * b) >> 8);
+    out[3] = (uint8_t)((c[3] * b) >> 8);
+}
+
+bool effect_solid(const effect_frame_t *f, uint8_t rgbw[4])
+{
+    if (f->id == EFFECT_NONE && f->grad.stops && f->level > 0) return false;
+    if (f->level == 0 || f->id == EFFECT_NONE || f->id >= EFFECT_COUNT) {
+        memcpy(rgbw, f->rgbw, 4);
+        return true;
+    }
+    if (f->id == EFFECT_BREATHE) {
+        uint32_t b = 255 - ((f->intensity * (255 - wave(f->phase))) >> 8);
+        put_scaled(rgbw, f->rgbw, b);
+        return true;
+    }
+    return false;
+}
+
+/* Hue wheel, 2^32 per turn, at the segment's saturation and level */
+static void render_rainbow(const effect_frame_t *f, uint16_t offset, uint16_t n, uint8_t *out)
+{
+    uint32_t step = ((uint32_t)f->intensity << 24) / f->seg_len;
+    uint32_t h    = f->phase + step * offset;
+    uint32_t s    = (f->sat >= 254) ? 255 : f->sat;    /* 254 = full, as in hsv_to_rgb() */
+
+    for (uint16_t i = 0; i < n; i++, out += 4, h += step) {
+        hue_wheel_rgb(h, s, f->level, out);
+        out[3] = 0;
+    }
+}
+
+/* Bands of w lit and w dark LEDs, moving one period per cycle */
+static void render_chase(const effect_frame_t *f, uint16_t offset, uint16_t n, uint8_t *out)
+{
+    static const uint8_t black[4] = {0};
+    uint32_t w      = 1 + (f->intensity >> 4);
+    uint32_t period = 2 * w;
+    uint32_t shift  = (uint32_t)(((uint64_t)f->phase * period) >> 32);
+    uint32_t k      = (offset + period - shift) % period;
+
+    for (uint16_t i = 0; i < n; i++, out += 4) {
+        memcpy(out, (k < w) ? f->rgbw : black, 4);
+        if (++k == period) k = 0;
+    }
+}
+
+/* Each LED hashes its index (a Weyl sequence, so one add per LED) into
+ * whether it twinkles and where in the cycle it is */
+static void render_twinkle(const effect_frame_t *f, uint16_t offset, uint16_t n, uint8_t *out)
+{
+    uint32_t k = (uint32_t)(offset + 1) * WEYL_STEP + f->seg * 0x85EBCA6Bu;
+
+    for (uint16_t i = 0; i < n; i++, out += 4, k += WEYL_STEP) {
+        uint32_t h = k;
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+
+        uint32_t b = TWINKLE_FLOOR;
+        if ((h & 0xFF) < f->intensity) {
+            uint32_t t = wave(f->phase + (h & 0xFFFFFF00u));
+            if (t > b) b = t;
+        }
+        put_scaled(out, f->rgbw, b);
+    }
+}
+
+/* Head crosses the segment once per cycle; LEDs behind it fade linearly
+ * over the tail. d counts down one per LED, wrapping at the segment end. */
+static void render_comet(const effect_frame_t *f, uint16_t offset, uint16_t n, uint8_t *out)
+{
+    uint32_t len  = f->seg_len;
+    uint32_t head = (uint32_t)(((uint64_t)f->phase * len) >> 32);
+    uint32_t tail = 1 + ((len * f->intensity) >> 8);
+    uint32_t step = (255u << 8) / tail;         /* Q8 brightness per LED */
+    uint32_t d    = (head + len - offset) % len;
+
+    for (uint16_t i = 0; i < n; i++, out += 4) {
+        uint32_t b = (d < tail) ? 255 - ((d * step) >> 8) : 0;
+        put_scaled(out, f->rgbw, b);
+        d = (d == 0) ? len - 1 : d - 1;
+    }
+}
+
+void effect_render(const effect_frame_t *f, uint16_t offset, uint16_t n, uint8_t *out)
+{
+    uint8_t c[4];
+    if (effect_solid(f, c)) {
+        for (uint16_t i = 0; i < n; i++) memcpy(out + i * 4, c, 4);
+        return;
+    }
+
+    switch (f->id) {
+    case EFFECT_NONE:    gradient_render(&f->grad, offset, n, out); break;
+    case EFFECT_RAINBOW: render_rainbow(f, offset, n, out); break;
+    case EFFECT_CHASE:   render_chase(f, offset, n, out);   break;
+    case EFFECT_TWINKLE: render_twinkle(f, offset, n, out); break;
+    case EFFECT_COMET:   render_comet(f, offset, n, out);   break;
+    default: break;
+    }
+}
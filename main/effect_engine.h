@@ -0,0 +1,103 @@
+/**
+ * @file effect_engine.h
+ * @brief Per-pixel segment effects (render task only)
+ *
+ * An effect animates a segment's own colour along its LEDs, so scenes like
+ * a rainbow or a chase run on the device instead of being streamed over
+ * the mesh. A segment with a gradient shows it while its effect is
+ * EFFECT_NONE; any other effect runs on the segment's own colour. Each segment has an effect ID, speed and intensity
+ * (segment_effect_t); the render task advances one phase per segment each
+ * frame and asks the engine for the pixels of every span the segment owns.
+ *
+ * Kernels are integer only and step their per-pixel position by adding a
+ * constant: no division or table lookup per LED.
+ */
+
+#pragma once
+
+#include "segment_manager.h"
+#include "gradient_engine.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Segment effects (segment_effect_t.id)
+ *
+ * Meaning of intensity per effect:
+ *   RAINBOW  hue spread along the segment, 255 = one full wheel (0 = uniform)
+ *   CHASE    band width, 1 + intensity/16 LEDs lit then as many dark
+ *   TWINKLE  share of LEDs that twinkle, over a 1/8 brightness background
+ *   COMET    tail length as a share of the segment
+ *   BREATHE  depth, 255 = fades fully out
+ */
+typedef enum {
+    EFFECT_NONE = 0,    /**< Solid segment colour */
+    EFFECT_RAINBOW,     /**< Hue wheel scrolling along the segment */
+    EFFECT_CHASE,       /**< Lit bands moving along the segment */
+    EFFECT_TWINKLE,     /**< LEDs fading in and out at random offsets */
+    EFFECT_COMET,       /**< Head running along the segment with a fading tail */
+    EFFECT_BREATHE,     /**< Whole segment pulsing */
+    EFFECT_COUNT
+} effect_id_t;
+
+/**
+ * @brief One segment's inputs to an effect for the current frame
+ */
+typedef struct {
+    uint8_t  id;            /**< effect_id_t */
+    uint8_t  intensity;
+    uint8_t  seg;           /**< Segment 0-7, varies the twinkle pattern */
+    uint8_t  level;         /**< Segment brightness, power scale applied */
+    uint8_t  sat;           /**< Saturation used by RAINBOW */
+    uint8_t  rgbw[4];       /**< Segment colour (what EFFECT_NONE shows) */
+    uint16_t seg_len;       /**< Segment LED count */
+    uint32_t phase;         /**< Animation position, 2^32 = one cycle */
+    gradient_frame_t grad;  /**< Shown instead of rgbw under EFFECT_NONE if grad.stops */
+} effect_frame_t;
+
+/**
+ * @brief Lower-case name of an effect ("none", "rainbow", ...), NULL if
+ * out of range
+ */
+const char *effect_name(uint8_t id);
+
+/**
+ * @brief Advance each segment's phase to now_us by its speed.
+ *
+ * Speed 1-255 is 1/64 to ~4 cycles per second; speed 0 freezes the
+ * effect. A gap of more than 100 ms (e.g. the renderer slept) counts as
+ * 100 ms.
+ */
+void effect_engine_advance(const segment_effect_t fx[MAX_SEGMENTS], int64_t now_us);
+
+/**
+ * @brief Current phase of segment seg
+ */
+uint32_t effect_engine_phase(uint8_t seg);
+
+/**
+ * @brief Colour of an effect that is the same on every LED of the segment
+ *
+ * @return true and the colour in rgbw for EFFECT_NONE and EFFECT_BREATHE
+ *         (fill the spans with it); false for a per-pixel effect or a
+ *         gradient
+ */
+bool effect_solid(const effect_frame_t *f, uint8_t rgbw[4]);
+
+/**
+ * @brief Render LEDs [offset, offset + n) of the segment
+ *
+ * @param f       Frame inputs; f->seg_len > 0
+ * @param offset  First LED, relative to the segment start
+ * @param n       Number of LEDs
+ * @param out     n * 4 bytes, RGBW per LED
+ */
+void effect_render(const effect_frame_t *f, uint16_t offset, uint16_t n, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file frame_jitter.c
+ * @brief Lateness histogram of a fixed-deadline task, with percentiles
+ */
+
+#include "frame_jitter.h"
+
+void frame_jitter_record(frame_jitter_t *j, uint32_t late_us)
+{
+    uint32_t bin = late_us / FRAME_JITTER_BIN_US;
+    if (bin >= FRAME_JITTER_BINS) bin = FRAME_JITTER_BINS - 1;
+    j->hist[bin]++;
+    if (late_us > j->max_us) j->max_us = late_us;
+}
+
+uint32_t frame_jitter_percentile(const frame_jitter_t *j, uint32_t permille)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < FRAME_JITTER_BINS; i++) total += j->hist[i];
+    if (total == 0) return 0;
+
+    uint64_t want = (total * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (int i = 0; i < FRAME_JITTER_BINS; i++) {
+        seen += j->hist[i];
+        if (seen >= want) return (uint32_t)(i + 1) * FRAME_JITTER_BIN_US;
+    }
+    return FRAME_JITTER_BINS * FRAME_JITTER_BIN_US;
+}
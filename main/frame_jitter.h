@@ -0,0 +1,46 @@
+/**
+ * @file frame_jitter.h
+ * @brief Lateness histogram of a fixed-deadline task, with percentiles
+ *
+ * The render task records how late it woke against each frame deadline;
+ * `led perf` reports the percentiles. Fixed bins keep recording O(1) and
+ * allocation-free, so a percentile is the upper bound of the bin holding
+ * it (FRAME_JITTER_BIN_US resolution). Wakes later than the histogram
+ * range land in the last bin; the maximum is kept exactly.
+ */
+
+#ifndef FRAME_JITTER_H
+#define FRAME_JITTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_JITTER_BIN_US  50     /* Histogram resolution */
+#define FRAME_JITTER_BINS    100    /* 0..5ms */
+
+typedef struct {
+    uint32_t hist[FRAME_JITTER_BINS];
+    uint32_t max_us;
+} frame_jitter_t;
+
+/**
+ * @brief Count one wake-up that was late_us after its deadline
+ */
+void frame_jitter_record(frame_jitter_t *j, uint32_t late_us);
+
+/**
+ * @brief Lateness within which the given share of wake-ups fell
+ *
+ * @param permille  500 = p50, 990 = p99, 999 = p99.9
+ * @return Upper bound of the bin holding it, us; 0 with no samples
+ */
+uint32_t frame_jitter_percentile(const frame_jitter_t *j, uint32_t permille);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_JITTER_H
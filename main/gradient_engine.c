@@ -0,0 +1,140 @@
+/**
+ * @file gradient_engine.c
+ * @brief Multi-stop colour gradients across a segment (render task only)
+ *
+ * Between two stops a channel is an accumulator in Q16: it starts at the
+ * first stop's value plus the step times the distance already covered,
+ * and adds the step once per LED. The step is truncated towards zero, so
+ * the accumulator never passes the next stop's value. Hue accumulates in
+ * 2^32 per turn, where the wrapping difference of two hues read as signed
+ * is already the shorter way round.
+ */
+
+#include "gradient_engine.h"
+#include "color_engine.h"
+#include <stddef.h>
+
+static const char *const s_spaces[GRADIENT_SPACE_COUNT] = { "rgb", "hue" };
+
+const char *gradient_space_name(uint8_t space)
+{
+    return (space < GRADIENT_SPACE_COUNT) ? s_spaces[space] : NULL;
+}
+
+/* Degrees Q16.16 -> 2^32 per turn (2^32 / 360 = 11930464.7) */
+static uint32_t hue_turn(uint32_t hue_q16)
+{
+    return (uint32_t)(((uint64_t)hue_q16 * 11930465u) >> 16);
+}
+
+void gradient_frame_build(gradient_frame_t *g, uint8_t space, const gradient_stop_t *stops,
+                          uint8_t count, uint8_t level, uint16_t seg_len)
+{
+    g->stops = 0;
+    if (count < 2 || seg_len == 0) return;
+    if (count > GRADIENT_MAX_STOPS) count = GRADIENT_MAX_STOPS;
+
+    g->stops = count;
+    g->space = space;
+    g->level = level;
+    uint32_t last = seg_len - 1u;
+    for (int k = 0; k < count; k++) {
+        uint16_t at = (uint16_t)((stops[k].pos * last + 127) / 255);
+        if (k > 0 && at < g->at[k - 1]) at = g->at[k - 1];
+        g->at[k]  = at;
+        g->hue[k] = hue_turn(stops[k].hue_q16);
+        g->sat[k] = (stops[k].sat >= 254) ? 255 : stops[k].sat;   /* 254 = full */
+        hue_wheel_rgb(g->hue[k], g->sat[k], level, g->rgb[k]);
+    }
+}
+
+static void fill(uint8_t *out, uint32_t n, const uint8_t *rgb)
+{
+    for (uint32_t i = 0; i < n; i++, out += 4) {
+        out[0] = rgb[0];
+        out[1] = rgb[1];
+        out[2] = rgb[2];
+        out[3] = 0;
+    }
+}
+
+/* Step value in Q16 from a to b over dist LEDs, and the accumulator t
+ * LEDs in (rounded to nearest when read back with >> 16) */
+static inline int32_t q16_step(int32_t a, int32_t b, uint32_t dist)
+{
+    return ((b - a) * 65536) / (int32_t)dist;
+}
+
+static inline uint32_t q16_start(int32_t a, int32_t step, uint32_t t)
+{
+    return ((uint32_t)a << 16) + 0x8000u + (uint32_t)step * t;
+}
+
+static void run_rgb(const uint8_t *c0, const uint8_t *c1, uint32_t dist, uint32_t t,
+                    uint32_t n, uint8_t *out)
+{
+    int32_t  sr = q16_step(c0[0], c1[0], dist);
+    int32_t  sg = q16_step(c0[1], c1[1], dist);
+    int32_t  sb = q16_step(c0[2], c1[2], dist);
+    uint32_t r  = q16_start(c0[0], sr, t);
+    uint32_t g  = q16_start(c0[1], sg, t);
+    uint32_t b  = q16_start(c0[2], sb, t);
+
+    for (uint32_t i = 0; i < n; i++, out += 4) {
+        out[0] = (uint8_t)(r >> 16);
+        out[1] = (uint8_t)(g >> 16);
+        out[2] = (uint8_t)(b >> 16);
+        out[3] = 0;
+        r += (uint32_t)sr;
+        g += (uint32_t)sg;
+        b += (uint32_t)sb;
+    }
+}
+
+static void run_hue(const gradient_frame_t *g, int k, uint32_t dist, uint32_t t,
+                    uint32_t n, uint8_t *out)
+{
+    int32_t  sh = (int32_t)(g->hue[k + 1] - g->hue[k]) / (int32_t)dist;
+    int32_t  ss = q16_step(g->sat[k], g->sat[k + 1], dist);
+    uint32_t h  = g->hue[k] + (uint32_t)sh * t;
+    uint32_t s  = q16_start(g->sat[k], ss, t);
+
+    for (uint32_t i = 0; i < n; i++, out += 4) {
+        hue_wheel_rgb(h, s >> 16, g->level, out);
+        out[3] = 0;
+        h += (uint32_t)sh;
+        s += (uint32_t)ss;
+    }
+}
+
+void gradient_render(const gradient_frame_t *g, uint16_t offset, uint16_t n, uint8_t *out)
+{
+    int      last = g->stops - 1;
+    uint32_t x    = offset;
+    uint32_t end  = (uint32_t)offset + n;
+
+    /* Before the first stop */
+    if (x < g->at[0]) {
+        uint32_t run = ((end < g->at[0]) ? end : g->at[0]) - x;
+        fill(out, run, g->rgb[0]);
+        x += run;
+        out += run * 4;
+    }
+
+    /* Between stops k and k + 1; a stop's own LED starts the next run */
+    for (int k = 0; k < last && x < end; k++) {
+        uint32_t a = g->at[k], b = g->at[k + 1];
+        if (x >= b) continue;
+        uint32_t run = ((end < b) ? end : b) - x;
+        if (g->space == GRADIENT_HUE) {
+            run_hue(g, k, b - a, x - a, run, out);
+        } else {
+            run_rgb(g->rgb[k], g->rgb[k + 1], b - a, x - a, run, out);
+        }
+        x += run;
+        out += run * 4;
+    }
+
+    /* From the last stop on */
+    if (x < end) fill(out, end - x, g->rgb[last]);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file gradient_engine.h
+ * @brief Multi-stop colour gradients across a segment (render task only)
+ *
+ * A gradient gives one segment a run of colours, e.g. warm white at one
+ * end fading to cool white at the other, where it used to take several
+ * segments to fake one. Stops (segment_gradient_t) sit at positions along
+ * the segment; between two stops the colour is blended either channel by
+ * channel in RGB, or around the hue wheel, which keeps the colours in
+ * between as saturated as the stops.
+ *
+ * Each frame the renderer resolves the stops to LED offsets and colours at
+ * the segment's level (gradient_frame_build()). Rendering then steps a
+ * fixed-point accumulator per channel: one add per channel per LED, and a
+ * divide only where a run starts between two stops.
+ */
+
+#pragma once
+
+#include "segment_manager.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Interpolation between stops (segment_gradient_t.space)
+ */
+typedef enum {
+    GRADIENT_RGB = 0,   /**< Straight line between the stop colours */
+    GRADIENT_HUE,       /**< Shortest way round the hue wheel, saturation linear */
+    GRADIENT_SPACE_COUNT
+} gradient_space_t;
+
+/**
+ * @brief One stop's inputs for the frame
+ */
+typedef struct {
+    uint8_t  pos;           /**< 0-255 along the segment */
+    uint8_t  sat;           /**< 0-254 */
+    uint32_t hue_q16;       /**< Degrees, Q16.16 (a transition value) */
+} gradient_stop_t;
+
+/**
+ * @brief A segment's gradient resolved for the current frame
+ */
+typedef struct {
+    uint8_t  stops;                         /**< 0 = no gradient, else 2+ */
+    uint8_t  space;                         /**< gradient_space_t */
+    uint8_t  level;                         /**< Value for GRADIENT_HUE */
+    uint16_t at[GRADIENT_MAX_STOPS];        /**< LED offset in the segment, ascending */
+    uint32_t hue[GRADIENT_MAX_STOPS];       /**< 2^32 = one turn */
+    uint8_t  sat[GRADIENT_MAX_STOPS];       /**< 0-255 */
+    uint8_t  rgb[GRADIENT_MAX_STOPS][3];    /**< Stop colour at level */
+} gradient_frame_t;
+
+/**
+ * @brief Lower-case name of a space ("rgb", "hue"), NULL if out of range
+ */
+const char *gradient_space_name(uint8_t space);
+
+/**
+ * @brief Resolve stops for one frame
+ *
+ * Positions map 0-255 onto the first to last LED; a stop placed before the
+ * one preceding it is moved up to it. Stops on the same LED make a hard
+ * edge there, and the LED itself takes the later stop. Fewer than 2
+ * stops, or an empty segment, gives no gradient (g->stops = 0).
+ *
+ * @param stops    count entries
+ * @param count    Stops in use
+ * @param level    Segment brightness, power scale applied
+ * @param seg_len  Segment LED count
+ */
+void gradient_frame_build(gradient_frame_t *g, uint8_t space, const gradient_stop_t *stops,
+                          uint8_t count, uint8_t level, uint16_t seg_len);
+
+/**
+ * @brief Render LEDs [offset, offset + n) of the segment
+ *
+ * LEDs before the first stop take its colour, LEDs after the last stop
+ * take the last one's. W is 0.
+ *
+ * @param g       g->stops >= 2
+ * @param offset  First LED, relative to the segment start
+ * @param n       Number of LEDs
+ * @param out     n * 4 bytes, RGBW per LED
+ */
+void gradient_render(const gradient_frame_t *g, uint16_t offset, uint16_t n, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,6 +12,8 @@
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_err.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/uart.h"
@@ -26,6 +28,12 @@
 #include "preset_manager.h"
 #include "zigbee_signal_handlers.h"
 #include "led_renderer.h"
+#include "light_cmd.h"
+#include "color_engine.h"
+#include "timeline_player.h"
+#include "effect_engine.h"
+#include "blend_engine.h"
+#include "gradient_engine.h"
 
 static const char *TAG = "led_cli";
 
@@ -38,7 +46,7 @@ static void print_help(void)
     printf(
         "\nLED Controller CLI commands:\n"
         "  led help\n"
-        "  led count <strip> <n>           (strip=1|2, n=1-500, saves to NVS, reboot to apply)\n"
+        "  led count <strip> <n>           (strip=1|2, n=1-2000, saves to NVS, reboot to apply)\n"
         "  led type <strip> <sk6812|ws2812b>  (set strip LED type, saves to NVS, reboot to apply)\n"
         "  led maxcurrent <strip> <mA>     (set strip max current mA, 0=unlimited, applies now)\n"
         "  led config                      (show current configuration)\n"
@@ -53,7 +61,26 @@ static void print_help(void)
         "  led preset delete <slot>        (delete preset from slot 0-7)\n"
         "  led transition                  (show current global transition time)\n"
         "  led transition <ms>             (set global transition time in ms, 0-65535)\n"
+        "  led timeline                    (list running keyframe timelines)\n"
+        "  led timeline <1-8> <level|hue|sat|ct> <once|loop|pingpong> <ms:value[:easing]>...\n"
+        "                                  (play keyframes on a segment channel, easing 0-5)\n"
+        "  led timeline stop [1-8]         (stop timelines on one or all segments)\n"
+        "  led fx                          (show segment effects)\n"
+        "  led fx <1-8> <name> [speed] [intensity]\n"
+        "                                  (none|rainbow|chase|twinkle|comet|breathe, 0-255)\n"
+        "  led blend                       (show segment blend modes)\n"
+        "  led blend <1-8> <mode> [opacity]\n"
+        "                                  (replace|add|max|multiply|alpha, opacity 0-255)\n"
+        "  led grad                        (show segment gradients)\n"
+        "  led grad <1-8> off              (back to the solid segment colour)\n"
+        "  led grad <1-8> <rgb|hue> <pos:hue:sat> <pos:hue:sat>...\n"
+        "                                  (2-4 stops, pos 0-255, hue 0-359, sat 0-254)\n"
         "  led diag                        (show crash diagnostics)\n"
+        "  led stats                       (show LED frame sent/skipped counters)\n"
+        "  led perf [reset]                (show/reset render timing and Zigbee task load)\n"
+        "  led perf color                  (cycles per call of xy/rgb color conversion)\n"
+        "  led perf fx                     (cycles per LED of each effect and gradient)\n"
+        "  led perf blend                  (cycles per LED of each blend mode)\n"
         "  led nvs                         (NVS health check)\n"
         "  led reboot                      (restart device)\n"
         "  led repair                      (Zigbee network reset / re-pair)\n"
@@ -104,6 +131,398 @@ static void print_diag(void)
     printf("  min_free_heap:   %" PRIu32 " bytes\n", diag.min_free_heap);
 }
 
+static void print_stats(void)
+{
+    led_driver_stats_t st;
+    led_driver_get_stats(&st);
+    uint32_t total = st.frames_sent + st.frames_skipped + st.frames_busy;
+    printf("=== LED Frame Stats ===\n");
+    printf("  frames_sent:     %" PRIu32 "\n", st.frames_sent);
+    printf("  frames_skipped:  %" PRIu32 " (unchanged)\n", st.frames_skipped);
+    printf("  frames_busy:     %" PRIu32 " (DMA busy, retried next tick)\n", st.frames_busy);
+    printf("  skip_ratio:      %" PRIu32 "%%\n", total ? (uint32_t)((uint64_t)st.frames_skipped * 100 / total) : 0);
+    printf("  leds_encoded:    %" PRIu32 "\n", st.leds_encoded);
+
+    static const char *const src_names[LIGHT_CMD_SRC_COUNT] = { "zigbee", "cli" };
+    light_cmd_stats_t q;
+    light_cmd_get_stats(&q);
+    printf("=== Light Command Queue ===\n");
+    for (int i = 0; i < LIGHT_CMD_SRC_COUNT; i++) {
+        printf("  %-7s posted=%" PRIu32 " dropped=%" PRIu32 " high_water=%" PRIu32 "/%d\n",
+               src_names[i], q.src[i].posted, q.src[i].dropped, q.src[i].high_water,
+               LIGHT_CMD_QUEUE_LEN);
+    }
+    printf("  applied:         %" PRIu32 " (deduped %" PRIu32 ")\n", q.applied, q.deduped);
+
+    led_renderer_perf_t p;
+    led_renderer_get_perf(&p);
+    printf("=== Render Task ===\n");
+    printf("  stack_free:      %" PRIu32 " bytes (high-water mark)\n", p.stack_free);
+}
+
+/* Cycles per call of the xy <-> RGB conversions, over a spread of inputs */
+static void bench_color(void)
+{
+    enum { N = 1024 };
+    volatile uint8_t sink = 0;
+    uint8_t r, g, b;
+    uint16_t x, y;
+
+    esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < N; i++) {
+        xy_to_rgb((uint16_t)(i * 37 + 9000), (uint16_t)(i * 53 + 9000), 200, &r, &g, &b);
+        sink ^= r ^ g ^ b;
+    }
+    uint32_t xy_rgb = (esp_cpu_get_cycle_count() - c0) / N;
+
+    c0 = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < N; i++) {
+        rgb_to_xy((uint8_t)i, (uint8_t)(i * 7), (uint8_t)(i * 13), &x, &y);
+        sink ^= (uint8_t)(x ^ y);
+    }
+    uint32_t rgb_xy = (esp_cpu_get_cycle_count() - c0) / N;
+    (void)sink;
+
+    printf("=== Color Conversion (%s) ===\n",
+           COLOR_ENGINE_FIXED_POINT ? "fixed-point" : "float");
+    printf("  xy_to_rgb:       %" PRIu32 " cycles/call\n", xy_rgb);
+    printf("  rgb_to_xy:       %" PRIu32 " cycles/call\n", rgb_xy);
+}
+
+/* Cycles per LED of each effect over a 500 LED segment, with the time a
+ * frame of it takes against the 5 ms render period */
+static void bench_effects(void)
+{
+    enum { LEDS = 500, CHUNK = 50 };
+    static uint8_t buf[CHUNK * 4];
+    effect_frame_t f = {
+        .intensity = 128, .level = 200, .sat = 254,
+        .rgbw = {200, 80, 20, 0}, .seg_len = LEDS, .phase = 0x12345678,
+    };
+
+    printf("=== Effect Kernels (%d LEDs) ===\n", LEDS);
+    for (uint8_t id = EFFECT_NONE + 1; id < EFFECT_COUNT; id++) {
+        f.id = id;
+        int64_t t0 = esp_timer_get_time();
+        esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+        for (uint16_t off = 0; off < LEDS; off += CHUNK) {
+            effect_render(&f, off, CHUNK, buf);
+        }
+        uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        printf("  %-8s %3" PRIu32 " cycles/LED, %4" PRIu32 " us/frame (%" PRIu32 ".%" PRIu32 "%% of 5 ms)\n",
+               effect_name(id), cycles / LEDS, us, us / 50, (us % 50) / 5);
+    }
+
+    /* Gradients: warm white -> green -> cool white */
+    static const gradient_stop_t stops[3] = {
+        { .pos = 0,   .sat = 200, .hue_q16 = 30u << 16 },
+        { .pos = 128, .sat = 254, .hue_q16 = 120u << 16 },
+        { .pos = 255, .sat = 0,   .hue_q16 = 210u << 16 },
+    };
+    f.id = EFFECT_NONE;
+    for (uint8_t space = 0; space < GRADIENT_SPACE_COUNT; space++) {
+        gradient_frame_build(&f.grad, space, stops, 3, f.level, LEDS);
+        int64_t t0 = esp_timer_get_time();
+        esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+        for (uint16_t off = 0; off < LEDS; off += CHUNK) {
+            effect_render(&f, off, CHUNK, buf);
+        }
+        uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        printf("  grad %-3s %3" PRIu32 " cycles/LED, %4" PRIu32 " us/frame (%" PRIu32 ".%" PRIu32 "%% of 5 ms)\n",
+               gradient_space_name(space), cycles / LEDS, us, us / 50, (us % 50) / 5);
+    }
+}
+
+/* Cycles per LED of each blend mode over a 500 LED run, composited in
+ * 64 LED chunks (FX_CHUNK_LEDS in led_renderer.c) as the renderer does */
+static void bench_blend(void)
+{
+    enum { LEDS = 500, CHUNK = 64 };
+    static uint32_t dst[CHUNK];
+    static uint32_t src[CHUNK];
+    for (int i = 0; i < CHUNK; i++) {
+        dst[i] = (uint32_t)i * 0x25A3C1E7u;
+        src[i] = (uint32_t)i * 0x9E3779B9u + 0x0D0D0D0Du;
+    }
+
+    printf("=== Blend Kernels (%d LEDs) ===\n", LEDS);
+    for (uint8_t mode = BLEND_REPLACE; mode < BLEND_COUNT; mode++) {
+        esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+        for (uint16_t off = 0; off < LEDS; off += CHUNK) {
+            uint16_t n = (LEDS - off < CHUNK) ? LEDS - off : CHUNK;
+            blend_run(mode, 128, dst, src, n);
+        }
+        uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+        printf("  %-8s %3" PRIu32 " cycles/LED\n", blend_name(mode), cycles / LEDS);
+    }
+}
+
+static void print_effects(void)
+{
+    const segment_effect_t *fx = segment_effect_get();
+    for (int i = 0; i < MAX_SEGMENTS; i++) {
+        printf("seg%d: %-8s speed=%u intensity=%u\n", i + 1,
+               effect_name(fx[i].id) ? effect_name(fx[i].id) : "?", fx[i].speed, fx[i].intensity);
+    }
+}
+
+/* CLI task producer for the render task's command queue */
+static bool post_cli_cmd(light_cmd_type_t type, uint8_t seg, uint16_t value)
+{
+    if (!light_cmd_post(LIGHT_CMD_SRC_CLI, type, seg, value, 0)) {
+        printf("error: light command queue full\n");
+        return false;
+    }
+    led_renderer_request_update();
+    return true;
+}
+
+static const char *const s_tl_channels[SEG_CH_COUNT]   = {"level", "hue", "sat", "ct"};
+static const char *const s_tl_modes[TIMELINE_MODE_COUNT] = {"once", "loop", "pingpong"};
+
+static int find_name(const char *const *names, int count, const char *s)
+{
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], s) == 0) return i;
+    }
+    return -1;
+}
+
+static void print_timelines(void)
+{
+    timeline_track_info_t tracks[TIMELINE_PLAYER_TRACKS];
+    timeline_player_get_tracks(tracks);
+    int shown = 0;
+    for (int i = 0; i < TIMELINE_PLAYER_TRACKS; i++) {
+        if (!tracks[i].used) continue;
+        printf("seg%d %-5s %-8s keys=%u value=%u\n", tracks[i].seg + 1,
+               s_tl_channels[tracks[i].channel], s_tl_modes[tracks[i].mode],
+               tracks[i].count, tracks[i].value);
+        shown++;
+    }
+    if (shown == 0) printf("No timelines running\n");
+}
+
+static void print_gradients(void)
+{
+    const segment_gradient_t *gr = segment_gradient_get();
+    for (int i = 0; i < MAX_SEGMENTS; i++) {
+        if (gr[i].stops < 2) {
+            printf("seg%d: off\n", i + 1);
+            continue;
+        }
+        const char *space = gradient_space_name(gr[i].space);
+        printf("seg%d: %s", i + 1, space ? space : "?");
+        for (int k = 0; k < gr[i].stops; k++) {
+            printf(" %u:%u:%u", gr[i].pos[k], gr[i].hue[k], gr[i].sat[k]);
+        }
+        printf("\n");
+    }
+}
+
+/* led grad ... (tokens after "grad" are read with strtok) */
+static void cli_grad(void)
+{
+    char *seg_s = strtok(NULL, " \t\r\n");
+    if (!seg_s) { print_gradients(); return; }
+
+    int seg_num = atoi(seg_s);
+    char *space_s = strtok(NULL, " \t\r\n");
+    if (seg_num < 1 || seg_num > MAX_SEGMENTS || !space_s) {
+        printf("usage: led grad <1-8> off | led grad <1-8> <rgb|hue> <pos:hue:sat> <pos:hue:sat>...\n");
+        return;
+    }
+    uint8_t idx = (uint8_t)(seg_num - 1);
+    if (strcmp(space_s, "off") == 0) {
+        if (post_cli_cmd(LIGHT_CMD_GRAD_STOPS, idx, 0)) printf("seg%d gradient off\n", seg_num);
+        return;
+    }
+
+    int space = -1;
+    for (int i = 0; i < GRADIENT_SPACE_COUNT; i++) {
+        if (strcmp(space_s, gradient_space_name((uint8_t)i)) == 0) space = i;
+    }
+    unsigned pos[GRADIENT_MAX_STOPS], hue[GRADIENT_MAX_STOPS], sat[GRADIENT_MAX_STOPS];
+    int count = 0;
+    char *tok;
+    bool ok = (space >= 0);
+    while (ok && (tok = strtok(NULL, " \t\r\n")) != NULL) {
+        if (count == GRADIENT_MAX_STOPS ||
+            sscanf(tok, "%u:%u:%u", &pos[count], &hue[count], &sat[count]) != 3 ||
+            pos[count] > 255 || hue[count] > 359 || sat[count] > 254) {
+            ok = false;
+            break;
+        }
+        count++;
+    }
+    if (!ok || count < 2) {
+        printf("usage: led grad <1-8> <rgb|hue> <pos:hue:sat> <pos:hue:sat>... "
+               "(2-%d stops, pos 0-255, hue 0-359, sat 0-254)\n", GRADIENT_MAX_STOPS);
+        return;
+    }
+
+    /* Colours fade over the global transition time; the stop count goes
+     * last so the gradient switches on with every stop in place */
+    uint16_t ms = g_global_transition_ms;
+    if (!post_cli_cmd(LIGHT_CMD_GRAD_SPACE, idx, (uint16_t)space)) return;
+    for (int k = 0; k < count; k++) {
+        if (!post_cli_cmd(LIGHT_CMD_GRAD_POS, idx, LIGHT_CMD_GRAD_VALUE(k, pos[k])) ||
+            !light_cmd_post(LIGHT_CMD_SRC_CLI, LIGHT_CMD_GRAD_HUE, idx, LIGHT_CMD_GRAD_VALUE(k, hue[k]), ms) ||
+            !light_cmd_post(LIGHT_CMD_SRC_CLI, LIGHT_CMD_GRAD_SAT, idx, LIGHT_CMD_GRAD_VALUE(k, sat[k]), ms)) {
+            printf("error: light command queue full\n");
+            return;
+        }
+    }
+    if (post_cli_cmd(LIGHT_CMD_GRAD_STOPS, idx, (uint16_t)count)) {
+        printf("seg%d gradient %s, %d stops\n", seg_num, gradient_space_name((uint8_t)space), count);
+    }
+}
+
+static void print_blend(void)
+{
+    const segment_blend_t *bl = segment_blend_get();
+    for (int i = 0; i < MAX_SEGMENTS; i++) {
+        printf("seg%d: %-8s opacity=%u\n", i + 1,
+               blend_name(bl[i].mode) ? blend_name(bl[i].mode) : "?", bl[i].opacity);
+    }
+}
+
+/* led blend ... (tokens after "blend" are read with strtok) */
+static void cli_blend(void)
+{
+    char *seg_s = strtok(NULL, " \t\r\n");
+    if (!seg_s) { print_blend(); return; }
+
+    char *mode_s = strtok(NULL, " \t\r\n");
+    char *op_s   = strtok(NULL, " \t\r\n");
+    int seg_num = atoi(seg_s);
+    int mode = -1;
+    for (int i = 0; mode_s && i < BLEND_COUNT; i++) {
+        if (strcmp(mode_s, blend_name((uint8_t)i)) == 0) mode = i;
+    }
+    int opacity = op_s ? atoi(op_s) : -1;
+    if (seg_num < 1 || seg_num > MAX_SEGMENTS || mode < 0 || (op_s && (opacity < 0 || opacity > 255))) {
+        printf("usage: led blend <1-8> <replace|add|max|multiply|alpha> [opacity 0-255]\n");
+        return;
+    }
+
+    uint8_t idx = (uint8_t)(seg_num - 1);
+    if (op_s && !post_cli_cmd(LIGHT_CMD_BLEND_OPACITY, idx, (uint16_t)opacity)) return;
+    if (post_cli_cmd(LIGHT_CMD_BLEND, idx, (uint16_t)mode)) {
+        printf("seg%d blend=%s\n", seg_num, blend_name((uint8_t)mode));
+    }
+}
+
+/* led fx ... (tokens after "fx" are read with strtok) */
+static void cli_fx(void)
+{
+    char *seg_s = strtok(NULL, " \t\r\n");
+    if (!seg_s) { print_effects(); return; }
+
+    char *name_s  = strtok(NULL, " \t\r\n");
+    char *speed_s = strtok(NULL, " \t\r\n");
+    char *int_s   = strtok(NULL, " \t\r\n");
+    int seg_num = atoi(seg_s);
+    int id = -1;
+    for (int i = 0; name_s && i < EFFECT_COUNT; i++) {
+        if (strcmp(name_s, effect_name((uint8_t)i)) == 0) id = i;
+    }
+    int speed     = speed_s ? atoi(speed_s) : -1;
+    int intensity = int_s ? atoi(int_s) : -1;
+    if (seg_num < 1 || seg_num > MAX_SEGMENTS || id < 0 ||
+        (speed_s && (speed < 0 || speed > 255)) || (int_s && (intensity < 0 || intensity > 255))) {
+        printf("usage: led fx <1-8> <none|rainbow|chase|twinkle|comet|breathe> [speed 0-255] [intensity 0-255]\n");
+        return;
+    }
+
+    uint8_t idx = (uint8_t)(seg_num - 1);
+    if (speed_s && !post_cli_cmd(LIGHT_CMD_EFFECT_SPEED, idx, (uint16_t)speed)) return;
+    if (int_s && !post_cli_cmd(LIGHT_CMD_EFFECT_INTENSITY, idx, (uint16_t)intensity)) return;
+    if (post_cli_cmd(LIGHT_CMD_EFFECT, idx, (uint16_t)id)) {
+        printf("seg%d effect=%s\n", seg_num, effect_name((uint8_t)id));
+    }
+}
+
+/* led timeline ... (tokens after "timeline" are read with strtok) */
+static void cli_timeline(void)
+{
+    char *arg1 = strtok(NULL, " \t\r\n");
+    if (!arg1) { print_timelines(); return; }
+
+    if (strcmp(arg1, "stop") == 0) {
+        char *seg_s = strtok(NULL, " \t\r\n");
+        int seg_num = seg_s ? atoi(seg_s) : 0;
+        if (seg_s && (seg_num < 1 || seg_num > MAX_SEGMENTS)) {
+            printf("error: segment must be 1-%d\n", MAX_SEGMENTS);
+            return;
+        }
+        uint8_t seg = seg_s ? (uint8_t)(seg_num - 1) : LIGHT_CMD_ALL_SEGS;
+        if (post_cli_cmd(LIGHT_CMD_TIMELINE_STOP, seg, (1u << SEG_CH_COUNT) - 1)) {
+            printf("Timelines stopped\n");
+        }
+        return;
+    }
+
+    char *ch_s   = strtok(NULL, " \t\r\n");
+    char *mode_s = strtok(NULL, " \t\r\n");
+    int seg_num = atoi(arg1);
+    int ch      = ch_s ? find_name(s_tl_channels, SEG_CH_COUNT, ch_s) : -1;
+    int mode    = mode_s ? find_name(s_tl_modes, TIMELINE_MODE_COUNT, mode_s) : -1;
+    if (seg_num < 1 || seg_num > MAX_SEGMENTS || ch < 0 || mode < 0) {
+        printf("usage: led timeline <1-8> <level|hue|sat|ct> <once|loop|pingpong> <ms:value[:easing]>...\n");
+        return;
+    }
+
+    timeline_upload_t up = { .seg = (uint8_t)(seg_num - 1), .channel = (uint8_t)ch, .mode = (uint8_t)mode };
+    char *key_s;
+    while ((key_s = strtok(NULL, " \t\r\n")) != NULL) {
+        unsigned long t_ms = 0, value = 0, easing = 0;
+        if (up.count >= TIMELINE_MAX_KEYS ||
+            sscanf(key_s, "%lu:%lu:%lu", &t_ms, &value, &easing) < 2 ||
+            value > 65535 || easing >= TRANSITION_EASE_COUNT) {
+            printf("error: bad key '%s' (max %d keys of ms:value[:easing])\n", key_s, TIMELINE_MAX_KEYS);
+            return;
+        }
+        up.keys[up.count++] = (timeline_key_t) {
+            .time_ms = (uint32_t)t_ms, .value = (uint16_t)value, .easing = (uint8_t)easing,
+        };
+    }
+    if (up.count == 0) {
+        printf("error: at least one key required\n");
+        return;
+    }
+
+    esp_err_t err = timeline_upload_post(LIGHT_CMD_SRC_CLI, &up);
+    if (err == ESP_OK) {
+        printf("seg%d %s timeline: %u keys, %s\n", seg_num, s_tl_channels[ch], up.count, s_tl_modes[mode]);
+    } else {
+        printf("error: %s\n", esp_err_to_name(err));
+    }
+}
+
+static void print_perf(void)
+{
+    led_renderer_perf_t p;
+    led_renderer_get_perf(&p);
+    printf("=== Render Timing ===\n");
+    printf("  frames:          %" PRIu32 " (overruns %" PRIu32 ")\n", p.frames, p.overruns);
+    printf("  render_max:      %" PRIu32 " us\n", p.render_max_us);
+    printf("  jitter p50/p99/p99.9/max: %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 " us\n",
+           p.jitter_p50_us, p.jitter_p99_us, p.jitter_p999_us, p.jitter_max_us);
+    printf("  zb_poll avg/max: %" PRIu32 "/%" PRIu32 " us per tick\n",
+           p.zb_poll_avg_us, p.zb_poll_max_us);
+    printf("  zb_poll cycles:  avg %" PRIu32 ", max %" PRIu32 " (attr lookup pass: %" PRIu32 ")\n",
+           p.zb_poll_avg_cycles, p.zb_poll_max_cycles, p.zb_lookup_cycles);
+    printf("  idle:            %s (entered %" PRIu32 " times)\n",
+           p.idle ? "yes" : "no", p.idle_entries);
+    printf("  color cache:     %" PRIu32 " hits, %" PRIu32 " misses\n",
+           p.color_hits, p.color_misses);
+    printf("  per-pixel:       %" PRIu32 " LEDs last frame, max %" PRIu32 " us per frame\n",
+           p.fx_leds, p.fx_max_us);
+}
+
 static void cli_task(void *arg)
 {
     (void)arg;
@@ -161,40 +580,41 @@ static void cli_task(void *arg)
                     continue;
                 }
                 int val = atoi(val_s);
-                int idx = seg_num - 1;
-                segment_geom_t *geom = segment_geom_get();
+                uint8_t idx = (uint8_t)(seg_num - 1);
+                /* Applied (and saved) by the render task on its next frame */
                 if (strcmp(field, "start") == 0) {
                     if (val < 0 || val > 65535) { printf("error: start must be 0-65535\n"); continue; }
-                    geom[idx].start = (uint16_t)val;
-                    printf("seg%d start=%u\n", seg_num, geom[idx].start);
+                    if (post_cli_cmd(LIGHT_CMD_GEOM_START, idx, (uint16_t)val)) {
+                        printf("seg%d start=%d\n", seg_num, val);
+                    }
                 } else if (strcmp(field, "count") == 0) {
                     if (val < 0 || val > 65535) { printf("error: count must be 0-65535\n"); continue; }
-                    geom[idx].count = (uint16_t)val;
-                    printf("seg%d count=%u\n", seg_num, geom[idx].count);
+                    if (post_cli_cmd(LIGHT_CMD_GEOM_COUNT, idx, (uint16_t)val)) {
+                        printf("seg%d count=%d\n", seg_num, val);
+                    }
                 } else if (strcmp(field, "strip") == 0) {
                     if (val < 1 || val > 2) { printf("error: strip must be 1 or 2\n"); continue; }
-                    geom[idx].strip_id = (uint8_t)(val - 1);
-                    printf("seg%d strip=%u\n", seg_num, val);
+                    if (post_cli_cmd(LIGHT_CMD_GEOM_STRIP, idx, (uint16_t)(val - 1))) {
+                        printf("seg%d strip=%d\n", seg_num, val);
+                    }
                 } else {
                     printf("unknown field '%s' (start|count|strip)\n", field);
-                    continue;
                 }
-                segment_manager_save();
                 continue;
             }
 
             if (strcmp(cmd, "count") == 0) {
                 char *s = strtok(NULL, " \t\r\n");
                 char *v = strtok(NULL, " \t\r\n");
-                if (!s || !v) { printf("usage: led count <strip> <n>  (strip=1|2, n=1-500)\n"); continue; }
+                if (!s || !v) { printf("usage: led count <strip> <n>  (strip=1|2, n=1-%d)\n", LED_STRIP_MAX_COUNT); continue; }
                 int strip = atoi(s);
                 int cnt = atoi(v);
                 if (strip < 1 || strip > 2) {
                     printf("error: strip must be 1 or 2\n");
                     continue;
                 }
-                if (cnt < 0 || cnt > 500) {
-                    printf("error: count must be 0-500 (0=disable)\n");
+                if (cnt < 0 || cnt > LED_STRIP_MAX_COUNT) {
+                    printf("error: count must be 0-%d (0=disable)\n", LED_STRIP_MAX_COUNT);
                     continue;
                 }
                 esp_err_t err = config_storage_save_strip_count((uint8_t)(strip - 1), (uint16_t)cnt);
@@ -271,6 +691,24 @@ static void cli_task(void *arg)
             }
 
             if (strcmp(cmd, "diag") == 0) { print_diag(); continue; }
+            if (strcmp(cmd, "stats") == 0) { print_stats(); continue; }
+
+            if (strcmp(cmd, "perf") == 0) {
+                char *arg = strtok(NULL, " \t\r\n");
+                if (arg && strcmp(arg, "reset") == 0) {
+                    led_renderer_reset_perf();
+                    printf("Render timing counters reset\n");
+                } else if (arg && strcmp(arg, "color") == 0) {
+                    bench_color();
+                } else if (arg && strcmp(arg, "fx") == 0) {
+                    bench_effects();
+                } else if (arg && strcmp(arg, "blend") == 0) {
+                    bench_blend();
+                } else {
+                    print_perf();
+                }
+                continue;
+            }
 
             if (strcmp(cmd, "nvs") == 0) {
                 printf("=== NVS Health Check ===\n");
@@ -371,13 +809,14 @@ static void cli_task(void *arg)
                         printf("error: slot must be 0-%d\n", MAX_PRESET_SLOTS - 1);
                         continue;
                     }
-                    esp_err_t err = preset_manager_recall((uint8_t)slot);
+                    bool occupied = false;
+                    esp_err_t err = preset_manager_is_slot_occupied((uint8_t)slot, &occupied);
+                    if (err == ESP_OK && !occupied) err = ESP_ERR_NOT_FOUND;
                     if (err == ESP_OK) {
-                        printf("Preset applied from slot %d\n", slot);
-                        update_leds();
-                        schedule_save();
-                        /* Defer ZCL sync to Zigbee task to avoid critical section mismatch */
-                        schedule_zcl_sync();
+                        /* Render task recalls it, saves, and syncs ZCL */
+                        if (post_cli_cmd(LIGHT_CMD_PRESET_RECALL, 0, (uint16_t)slot)) {
+                            printf("Preset applied from slot %d\n", slot);
+                        }
                     } else if (err == ESP_ERR_NOT_FOUND) {
                         printf("Slot %d is empty\n", slot);
                     } else {
@@ -427,6 +866,11 @@ static void cli_task(void *arg)
                 continue;
             }
 
+            if (strcmp(cmd, "timeline") == 0) { cli_timeline(); continue; }
+            if (strcmp(cmd, "fx") == 0) { cli_fx(); continue; }
+            if (strcmp(cmd, "blend") == 0) { cli_blend(); continue; }
+            if (strcmp(cmd, "grad") == 0) { cli_grad(); continue; }
+
             if (strcmp(cmd, "repair") == 0) {
                 printf("Zigbee network reset (re-pair)...\n");
                 fflush(stdout);
@@ -8,7 +8,32 @@
  *   1 -> 110  (high 800 ns, low 400 ns)
  *
  * Both strips share SPI2. Before each strip transmission the MOSI GPIO is
- * switched via the GPIO matrix.
+ * switched via the GPIO matrix from the SPI pre-transaction callback, so
+ * transactions for both strips can be queued back to back.
+ *
+ * Strips up to LED_DRIVER_FULL_FRAME_MAX_LEDS have two full-frame DMA
+ * buffers. Refresh encodes into the back buffer and queues it; the front
+ * buffer may still be on the wire from the previous frame. A buffer is only
+ * reused once its transaction has been reaped.
+ *
+ * Longer strips are streamed through two small DMA chunks shared by both
+ * strips (ping-pong). When a chunk is reaped, the task encodes the next run
+ * of pixels into it and requeues it while the other chunk is on the wire,
+ * so encoding overlaps DMA; the ISR callbacks only route the pin. DMA memory
+ * is therefore constant regardless of strip length.
+ *
+ * Framebuffer: after led_driver_clear() a strip is in span mode, holding an
+ * ordered list of solid-colour runs (gaps are black). Spans are encoded by
+ * repeating the colour's 9- or 12-byte SPI pattern, so a solid segment costs
+ * one LUT lookup per channel instead of one per LED. The first per-pixel
+ * write (or a span list overflow) flattens the spans into pixel_buf and the
+ * strip stays in pixel mode until the next clear.
+ *
+ * Change tracking: each strip remembers what it last sent (the span list,
+ * or that it came from pixel_buf) and pixel writes that change a byte grow
+ * a dirty range. Refresh skips strips whose frame is identical to the last
+ * one sent. In pixel mode each SPI buffer keeps its own stale range, so only
+ * the LEDs changed since that buffer was last encoded are re-encoded.
  */
 
 #include "led_driver.h"
@@ -19,6 +44,10 @@
 #include "driver/gpio.h"
 #include "soc/spi_periph.h"
 #include "esp_rom_gpio.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "soc/gpio_sig_map.h"
+#include "freertos/FreeRTOS.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -26,25 +55,81 @@ static const char *TAG = "led_driver";
 
 #define LED_SPI_CLOCK_HZ    2500000   /* 2.5 MHz -> 400 ns per SPI bit */
 #define RESET_BYTES         40        /* 40 * 8 * 400ns = 128 us > 80 us reset */
+#define SPI_BUFS            2         /* Front (on the wire) + back (being encoded) */
+#define STREAM_CHUNK_LEDS   64        /* LEDs per streamed chunk (768 B for SK6812), multiple of 4 */
+#define STREAM_CHUNKS       2         /* Ping-pong */
+#define STREAM_CHUNK_BYTES  (STREAM_CHUNK_LEDS * 4 * 3 + RESET_BYTES)
+
+/* spi_transaction_t.user: strip index plus flags */
+#define TRANS_STRIP_MASK    0x0F
+#define TRANS_STREAM        0x10      /* Streamed chunk (refilled when reaped) */
+#define TRANS_LAST          0x20      /* Final chunk of the stream (reset appended) */
+#define TRANS_USER(strip, flags)  ((void *)(intptr_t)((strip) | (flags)))
+#define TRANS_FLAGS(t)            ((uint32_t)(intptr_t)(t)->user)
+
+#define MAX_SPANS           32        /* Solid runs per strip before falling back to pixels */
+
+/* Solid-colour run [start, end), colour in wire order (GRBW / GRB) */
+typedef struct {
+    uint16_t start;
+    uint16_t end;
+    uint8_t  color[4];
+} led_span_t;
 
 typedef struct {
     uint8_t          *pixel_buf;
-    uint8_t          *spi_buf;
+    uint8_t          *spi_buf[SPI_BUFS];
+    bool              busy[SPI_BUFS];     /* Transaction queued, not yet reaped */
+    uint8_t           back;               /* Buffer index to encode next */
     uint16_t          count;
     size_t            spi_len;
     led_strip_type_t  type;
     uint8_t           bytes_per_led;      /* 4 for SK6812, 3 for WS2812B */
     uint8_t           spi_bytes_per_led;  /* bytes_per_led * 3 */
+    bool              streamed;           /* Sent through the shared chunks */
+    bool              pixel_mode;         /* pixel_buf is authoritative, spans unused */
+    uint8_t           span_count;
+    led_span_t        spans[MAX_SPANS];   /* Ordered, non-overlapping */
+
+    /* Change tracking against the last frame sent */
+    bool              sent_valid;         /* A frame has been sent since init */
+    bool              sent_pixel_mode;    /* Last frame sent came from pixel_buf */
+    uint8_t           sent_span_count;
+    led_span_t        sent_spans[MAX_SPANS];
+    uint16_t          dirty_lo, dirty_hi; /* pixel_buf LEDs changed since last send */
+    uint16_t          stale_lo[SPI_BUFS]; /* LEDs to re-encode per SPI buffer */
+    uint16_t          stale_hi[SPI_BUFS];
 } strip_data_t;
 
+/* Progress of the strip currently being streamed */
+typedef struct {
+    const strip_data_t *strip;
+    uint8_t             strip_id;
+    uint16_t            next_led;         /* First LED not yet encoded */
+    bool                done;             /* Final chunk encoded, or stream aborted */
+    int                 pending;          /* Chunks queued, not yet reaped */
+} stream_state_t;
+
 static strip_data_t s_strips[LED_DRIVER_MAX_STRIPS];
 static spi_device_handle_t s_spi = NULL;
+static spi_transaction_t s_trans[LED_DRIVER_MAX_STRIPS][SPI_BUFS];
+static int s_queued = 0;              /* Transactions queued but not reaped */
+static led_driver_stats_t s_stats;
+
+static uint8_t *s_chunk_buf[STREAM_CHUNKS];
+static spi_transaction_t s_chunk_trans[STREAM_CHUNKS];
+static stream_state_t s_stream;
 
-/* GPIO for each strip */
-static const int s_gpio[LED_DRIVER_MAX_STRIPS] = {LED_STRIP_1_GPIO, LED_STRIP_2_GPIO};
+/* GPIO for each strip (DRAM: read from the SPI ISR callbacks) */
+static DRAM_ATTR const int s_gpio[LED_DRIVER_MAX_STRIPS] = {LED_STRIP_1_GPIO, LED_STRIP_2_GPIO};
+static DRAM_ATTR uint32_t s_mosi_signal;
 
-/* Pre-computed lookup: each LED byte value -> 3 SPI bytes */
-static uint8_t s_lut[256][3];
+/*
+ * Pre-computed lookup: each LED byte value -> 3 SPI bytes, packed in memory
+ * order (first byte on the wire in bits 0-7) so that four codes can be
+ * merged into three little-endian words.
+ */
+static uint32_t s_lut[256];
 
 static void build_lut(void)
 {
@@ -53,42 +138,440 @@ static void build_lut(void)
         for (int i = 7; i >= 0; i--) {
             bits = (bits << 3) | ((v & (1 << i)) ? 0b110u : 0b100u);
         }
-        s_lut[v][0] = (bits >> 16) & 0xFF;
-        s_lut[v][1] = (bits >> 8) & 0xFF;
-        s_lut[v][2] = bits & 0xFF;
+        s_lut[v] = ((bits >> 16) & 0xFF) | (bits & 0xFF00) | ((bits & 0xFF) << 16);
     }
 }
 
-static void encode_strip(uint8_t strip_id)
+/* Store one 3-byte code */
+static inline uint8_t *put_code(uint8_t *dst, uint32_t e)
+{
+    dst[0] = (uint8_t)e;
+    dst[1] = (uint8_t)(e >> 8);
+    dst[2] = (uint8_t)(e >> 16);
+    return dst + 3;
+}
+
+/* Four LED bytes -> 12 SPI bytes as three aligned word stores */
+static inline uint32_t *put_quad(uint32_t *w, uint32_t v)
+{
+    uint32_t e0 = s_lut[v & 0xFF];
+    uint32_t e1 = s_lut[(v >> 8) & 0xFF];
+    uint32_t e2 = s_lut[(v >> 16) & 0xFF];
+    uint32_t e3 = s_lut[v >> 24];
+    w[0] = e0 | (e1 << 24);
+    w[1] = (e1 >> 8) | (e2 << 16);
+    w[2] = (e2 >> 16) | (e3 << 8);
+    return w + 3;
+}
+
+/* SK6812: one GRBW pixel is exactly one quad */
+static uint8_t *encode_grbw(const uint8_t *src, uint16_t n, uint8_t *dst)
+{
+    const uint32_t *px = (const uint32_t *)src;
+    uint32_t *w = (uint32_t *)dst;
+    for (uint16_t i = 0; i < n; i++) {
+        w = put_quad(w, px[i]);
+    }
+    return (uint8_t *)w;
+}
+
+/* WS2812B: four GRB pixels are three quads, remainder bytewise */
+static uint8_t *encode_grb(const uint8_t *src, uint16_t n, uint8_t *dst)
+{
+    const uint32_t *in = (const uint32_t *)src;
+    uint32_t *w = (uint32_t *)dst;
+    uint16_t groups = n / 4;
+    for (uint16_t i = 0; i < groups; i++) {
+        w = put_quad(w, in[0]);
+        w = put_quad(w, in[1]);
+        w = put_quad(w, in[2]);
+        in += 3;
+    }
+
+    const uint8_t *tail = (const uint8_t *)in;
+    dst = (uint8_t *)w;
+    for (size_t i = 0; i < (size_t)(n % 4) * 3; i++) {
+        dst = put_code(dst, s_lut[tail[i]]);
+    }
+    return dst;
+}
+
+/*
+ * Encode LEDs [first, first + n) of a strip; returns the end of the output.
+ * The word kernels need 4-byte aligned input and output: pixel_buf and the
+ * DMA buffers are heap-aligned, and chunks start on multiples of 4 LEDs.
+ */
+static uint8_t *encode_leds(const strip_data_t *s, uint16_t first, uint16_t n,
+                            uint8_t *dst)
+{
+    const uint8_t *src = s->pixel_buf + (size_t)first * s->bytes_per_led;
+
+    if ((((uintptr_t)src | (uintptr_t)dst) & 3) == 0) {
+        return (s->bytes_per_led == 4) ? encode_grbw(src, n, dst)
+                                       : encode_grb(src, n, dst);
+    }
+
+    size_t len = (size_t)n * s->bytes_per_led;
+    for (size_t i = 0; i < len; i++) {
+        dst = put_code(dst, s_lut[src[i]]);
+    }
+    return dst;
+}
+
+/* Encode n LEDs of one colour: build the pattern once, then double it up */
+static uint8_t *encode_run(const uint8_t *color, uint8_t bytes_per_led, uint16_t n,
+                           uint8_t *dst)
+{
+    if (n == 0) return dst;
+
+    size_t pat = (size_t)bytes_per_led * 3;
+    for (int c = 0; c < bytes_per_led; c++) {
+        put_code(dst + c * 3, s_lut[color[c]]);
+    }
+
+    size_t total = pat * n;
+    size_t done  = pat;
+    while (done < total) {
+        size_t chunk = (done < total - done) ? done : total - done;
+        memcpy(dst + done, dst, chunk);
+        done += chunk;
+    }
+    return dst + total;
+}
+
+/* Encode a span-mode strip: spans plus black gaps */
+static uint8_t *encode_spans(const strip_data_t *s, uint8_t *dst)
+{
+    static const uint8_t black[4] = {0};
+    uint16_t pos = 0;
+
+    for (int i = 0; i < s->span_count; i++) {
+        const led_span_t *sp = &s->spans[i];
+        dst = encode_run(black, s->bytes_per_led, sp->start - pos, dst);
+        dst = encode_run(sp->color, s->bytes_per_led, sp->end - sp->start, dst);
+        pos = sp->end;
+    }
+    return encode_run(black, s->bytes_per_led, s->count - pos, dst);
+}
+
+/* Grow [*lo, *hi) to cover [a, b); an empty range has lo == hi */
+static inline void range_add(uint16_t *lo, uint16_t *hi, uint16_t a, uint16_t b)
+{
+    if (a >= b) return;
+    if (*lo >= *hi) {
+        *lo = a;
+        *hi = b;
+        return;
+    }
+    if (a < *lo) *lo = a;
+    if (b > *hi) *hi = b;
+}
+
+/*
+ * Encode a strip into one of its SPI buffers. Span frames are always
+ * encoded whole. Pixel frames re-encode only the buffer's stale range,
+ * widened to 4-LED boundaries so the word encoder stays aligned.
+ */
+static void encode_strip(uint8_t strip_id, uint8_t buf)
 {
     strip_data_t *s = &s_strips[strip_id];
-    if (!s->pixel_buf || !s->spi_buf || s->count == 0) return;
+    if (!s->pixel_buf || !s->spi_buf[buf] || s->count == 0) return;
+
+    uint8_t *base = s->spi_buf[buf];
+
+    if (!s->pixel_mode) {
+        encode_spans(s, base);
+        /* Neither buffer now matches pixel_buf */
+        for (int b = 0; b < SPI_BUFS; b++) {
+            s->stale_lo[b] = 0;
+            s->stale_hi[b] = s->count;
+        }
+        s_stats.leds_encoded += s->count;
+    } else {
+        for (int b = 0; b < SPI_BUFS; b++) {
+            range_add(&s->stale_lo[b], &s->stale_hi[b], s->dirty_lo, s->dirty_hi);
+        }
+        uint16_t lo = s->stale_lo[buf] & ~3u;
+        uint16_t hi = (s->stale_hi[buf] + 3u) & ~3u;
+        if (hi > s->count) hi = s->count;
+        if (lo < hi) {
+            encode_leds(s, lo, hi - lo, base + (size_t)lo * s->spi_bytes_per_led);
+            s_stats.leds_encoded += hi - lo;
+        }
+        s->stale_lo[buf] = s->stale_hi[buf] = 0;
+    }
+    memset(base + (size_t)s->count * s->spi_bytes_per_led, 0, RESET_BYTES);
+}
+
+/* Has the strip's frame changed since the last one sent? */
+static bool strip_changed(const strip_data_t *s)
+{
+    if (!s->sent_valid || s->pixel_mode != s->sent_pixel_mode) return true;
+    if (s->pixel_mode) return s->dirty_lo < s->dirty_hi;
+    return s->span_count != s->sent_span_count ||
+           memcmp(s->spans, s->sent_spans, s->span_count * sizeof(led_span_t)) != 0;
+}
+
+/* Record the current frame as sent */
+static void strip_mark_sent(strip_data_t *s)
+{
+    s->sent_valid      = true;
+    s->sent_pixel_mode = s->pixel_mode;
+    s->sent_span_count = s->pixel_mode ? 0 : s->span_count;
+    memcpy(s->sent_spans, s->spans, s->sent_span_count * sizeof(led_span_t));
+    s->dirty_lo = s->dirty_hi = 0;
+}
+
+/* ================================================================== */
+/*  Span framebuffer                                                  */
+/* ================================================================== */
+
+/* Write pixels [start, end) of pixel_buf, growing the dirty range only
+ * where a byte actually changes */
+static void pixels_write(strip_data_t *s, uint16_t start, uint16_t end, const uint8_t *color)
+{
+    uint8_t bpl = s->bytes_per_led;
+    uint8_t *p = s->pixel_buf + (size_t)start * bpl;
+    for (uint16_t i = start; i < end; i++, p += bpl) {
+        if (memcmp(p, color, bpl) == 0) continue;
+        memcpy(p, color, bpl);
+        range_add(&s->dirty_lo, &s->dirty_hi, i, i + 1);
+    }
+}
+
+/* Render the span list into pixel_buf (span mode is left unchanged) */
+static void spans_flatten(strip_data_t *s)
+{
+    memset(s->pixel_buf, 0, (size_t)s->count * s->bytes_per_led);
+    for (int i = 0; i < s->span_count; i++) {
+        const led_span_t *sp = &s->spans[i];
+        uint8_t *p = s->pixel_buf + (size_t)sp->start * s->bytes_per_led;
+        for (uint16_t j = sp->start; j < sp->end; j++) {
+            memcpy(p, sp->color, s->bytes_per_led);
+            p += s->bytes_per_led;
+        }
+    }
+}
+
+/* Flatten the span list into pixel_buf and switch to per-pixel mode */
+static void spans_to_pixels(strip_data_t *s)
+{
+    if (s->pixel_mode) return;
+
+    if (s->sent_valid && s->sent_pixel_mode) {
+        /* pixel_buf still holds the last frame sent: diff against it */
+        static const uint8_t black[4] = {0};
+        uint16_t pos = 0;
+        for (int i = 0; i < s->span_count; i++) {
+            const led_span_t *sp = &s->spans[i];
+            pixels_write(s, pos, sp->start, black);
+            pixels_write(s, sp->start, sp->end, sp->color);
+            pos = sp->end;
+        }
+        pixels_write(s, pos, s->count, black);
+    } else {
+        spans_flatten(s);
+        range_add(&s->dirty_lo, &s->dirty_hi, 0, s->count);
+    }
+    s->span_count = 0;
+    s->pixel_mode = true;
+}
+
+/*
+ * Paint [start, end) over the span list. Overlapped spans are trimmed or
+ * split; a run adjacent to one of the same colour is merged into it.
+ * Returns false (list unchanged) if the result needs more than MAX_SPANS.
+ */
+static bool span_insert(strip_data_t *s, uint16_t start, uint16_t end, const uint8_t *color)
+{
+    size_t bpl = s->bytes_per_led;
+
+    /* Fast path: runs filled in LED order (the renderer's span map) append */
+    led_span_t *last = s->span_count ? &s->spans[s->span_count - 1] : NULL;
+    if (last == NULL || last->end <= start) {
+        if (last && last->end == start && memcmp(last->color, color, bpl) == 0) {
+            last->end = end;
+            return true;
+        }
+        if (s->span_count >= MAX_SPANS) return false;
+        led_span_t *sp = &s->spans[s->span_count++];
+        sp->start = start;
+        sp->end   = end;
+        memcpy(sp->color, color, 4);
+        return true;
+    }
+
+    led_span_t out[MAX_SPANS];
+    int n = 0;
+    bool placed = false;
+
+#define SPAN_PUSH(a, b, col) do {                                             \
+        if (n > 0 && out[n - 1].end == (a) &&                                 \
+            memcmp(out[n - 1].color, (col), bpl) == 0) {                      \
+            out[n - 1].end = (b);                                             \
+        } else {                                                              \
+            if (n >= MAX_SPANS) return false;                                 \
+            out[n].start = (a);                                               \
+            out[n].end   = (b);                                               \
+            memcpy(out[n].color, (col), 4);                                   \
+            n++;                                                              \
+        }                                                                     \
+    } while (0)
+
+    for (int i = 0; i < s->span_count; i++) {
+        const led_span_t *o = &s->spans[i];
+        if (o->end <= start) {
+            SPAN_PUSH(o->start, o->end, o->color);
+            continue;
+        }
+        if (o->start < start) SPAN_PUSH(o->start, start, o->color);
+        if (!placed && o->end >= end) {
+            SPAN_PUSH(start, end, color);
+            placed = true;
+        }
+        if (o->end > end) {
+            uint16_t a = (o->start > end) ? o->start : end;
+            SPAN_PUSH(a, o->end, o->color);
+        }
+    }
+    if (!placed) SPAN_PUSH(start, end, color);
+
+#undef SPAN_PUSH
+
+    memcpy(s->spans, out, n * sizeof(led_span_t));
+    s->span_count = (uint8_t)n;
+    return true;
+}
 
-    const uint8_t *src = s->pixel_buf;
-    uint8_t *dst = s->spi_buf;
-    size_t n = (size_t)s->count * s->bytes_per_led;
+/*
+ * Encode the next run of the current stream into a chunk transaction.
+ * Task context only: the chunk is free (never queued, or just reaped) and
+ * the other chunk, if any, is on the wire meanwhile. Sets length 0 when
+ * the stream has nothing left.
+ */
+static void stream_fill(spi_transaction_t *t)
+{
+    stream_state_t *st = &s_stream;
+    uint8_t *buf = (uint8_t *)t->tx_buffer;
 
-    for (size_t i = 0; i < n; i++) {
-        dst[0] = s_lut[src[i]][0];
-        dst[1] = s_lut[src[i]][1];
-        dst[2] = s_lut[src[i]][2];
-        dst += 3;
+    if (st->done) {
+        t->length = 0;
+        return;
     }
-    memset(dst, 0, RESET_BYTES);
+
+    uint16_t left = st->strip->count - st->next_led;
+    uint16_t n = (left > STREAM_CHUNK_LEDS) ? STREAM_CHUNK_LEDS : left;
+    uint8_t *end = encode_leds(st->strip, st->next_led, n, buf);
+    st->next_led += n;
+
+    uint32_t flags = TRANS_STREAM;
+    if (st->next_led >= st->strip->count) {
+        memset(end, 0, RESET_BYTES);
+        end += RESET_BYTES;
+        st->done = true;
+        flags |= TRANS_LAST;
+    }
+    t->length = (size_t)(end - buf) * 8;
+    t->user   = TRANS_USER(st->strip_id, flags);
+}
+
+/* SPI pre-transaction callback (ISR): route MOSI to this strip's GPIO */
+static void IRAM_ATTR mosi_connect(spi_transaction_t *t)
+{
+    int strip = TRANS_FLAGS(t) & TRANS_STRIP_MASK;
+    esp_rom_gpio_connect_out_signal(s_gpio[strip], s_mosi_signal, false, false);
+}
+
+/* SPI post-transaction callback (ISR): hand the pin back to the GPIO
+ * output register (held low for LED reset) once the strip is complete.
+ * Between the chunks of a stream the pin stays with SPI. */
+static void IRAM_ATTR mosi_idle(spi_transaction_t *t)
+{
+    uint32_t flags = TRANS_FLAGS(t);
+    int strip = flags & TRANS_STRIP_MASK;
+
+    if ((flags & TRANS_STREAM) && !(flags & TRANS_LAST)) return;
+    esp_rom_gpio_connect_out_signal(s_gpio[strip], SIG_GPIO_OUT_IDX, false, false);
 }
 
-static void mosi_connect(int gpio_num)
+/* Encode the next run of the stream into a free chunk and queue it */
+static esp_err_t stream_queue(spi_transaction_t *t)
 {
-    gpio_set_direction(gpio_num, GPIO_MODE_OUTPUT);
-    esp_rom_gpio_connect_out_signal(gpio_num,
-        spi_periph_signal[SPI2_HOST].spid_out, false, false);
+    stream_fill(t);
+    if (t->length == 0) return ESP_OK;
+    esp_err_t err = spi_device_queue_trans(s_spi, t, portMAX_DELAY);
+    if (err != ESP_OK) return err;
+    s_stream.pending++;
+    s_queued++;
+    return ESP_OK;
 }
 
-static void mosi_idle(int gpio_num)
+/* Collect one finished transaction: release a frame buffer, or refill and
+ * requeue a streamed chunk */
+static esp_err_t reap_one(TickType_t wait)
 {
-    /* Disconnect from SPI peripheral, drive low for LED reset */
-    gpio_set_direction(gpio_num, GPIO_MODE_OUTPUT);
-    gpio_set_level(gpio_num, 0);
+    spi_transaction_t *t;
+    esp_err_t err = spi_device_get_trans_result(s_spi, &t, wait);
+    if (err != ESP_OK) return err;
+    s_queued--;
+
+    uint32_t flags = TRANS_FLAGS(t);
+    if (flags & TRANS_STREAM) {
+        s_stream.pending--;
+        return stream_queue(t);
+    }
+
+    int strip = flags & TRANS_STRIP_MASK;
+    int buf   = (t == &s_trans[strip][0]) ? 0 : 1;
+    s_strips[strip].busy[buf] = false;
+    return ESP_OK;
+}
+
+/* Collect finished transactions until the queue is empty or wait expires */
+static esp_err_t reap_transactions(TickType_t wait)
+{
+    while (s_queued > 0) {
+        esp_err_t err = reap_one(wait);
+        if (err != ESP_OK) return err;
+    }
+    return ESP_OK;
+}
+
+/*
+ * Stream a long strip through the ping-pong chunks. Each chunk is queued as
+ * soon as it is encoded, so the second is encoded while the first is on the
+ * wire, and every later one while its predecessor is. Blocks until the last
+ * chunk is reaped, so the chunks are free again on return, also on error.
+ */
+static esp_err_t stream_strip(uint8_t strip_id)
+{
+    /* The chunk encoder only reads pixel_buf. Stay in span mode so the next
+     * frame is still compared by span list. */
+    if (!s_strips[strip_id].pixel_mode) spans_flatten(&s_strips[strip_id]);
+
+    s_stream.strip    = &s_strips[strip_id];
+    s_stream.strip_id = strip_id;
+    s_stream.next_led = 0;
+    s_stream.done     = false;
+    s_stream.pending  = 0;
+
+    esp_err_t err = ESP_OK;
+    for (int c = 0; c < STREAM_CHUNKS && err == ESP_OK; c++) {
+        err = stream_queue(&s_chunk_trans[c]);
+    }
+    while (err == ESP_OK && s_stream.pending > 0) {
+        err = reap_one(pdMS_TO_TICKS(100));
+    }
+
+    if (err != ESP_OK) {
+        /* Stop refilling and reap what is still queued: the chunks and
+         * s_stream must not be reused while the driver holds them */
+        s_stream.done = true;
+        while (s_stream.pending > 0 && reap_one(portMAX_DELAY) == ESP_OK) {
+        }
+    }
+    s_stream.strip = NULL;
+    return err;
 }
 
 /* ---------- Public API ---------- */
@@ -101,13 +584,27 @@ esp_err_t led_driver_init(uint16_t count0, uint16_t count1,
     uint16_t counts[LED_DRIVER_MAX_STRIPS] = {count0, count1};
     led_strip_type_t types[LED_DRIVER_MAX_STRIPS] = {type0, type1};
 
+    /* Size the DMA descriptor chain for the longest transaction (default is
+     * 4092 B): a full frame, or a stream chunk for long strips */
+    size_t max_len = 0;
+    bool any_streamed = false;
+    for (int i = 0; i < LED_DRIVER_MAX_STRIPS; i++) {
+        size_t bpl = (types[i] == LED_STRIP_TYPE_WS2812B) ? 3 : 4;
+        size_t len = (size_t)counts[i] * bpl * 3 + RESET_BYTES;
+        if (counts[i] > LED_DRIVER_FULL_FRAME_MAX_LEDS) {
+            any_streamed = true;
+            len = STREAM_CHUNK_BYTES;
+        }
+        if (counts[i] > 0 && len > max_len) max_len = len;
+    }
+
     spi_bus_config_t bus = {
         .mosi_io_num   = LED_STRIP_1_GPIO,
         .miso_io_num   = -1,
         .sclk_io_num   = -1,
         .quadhd_io_num = -1,
         .quadwp_io_num = -1,
-        .max_transfer_sz = 0,
+        .max_transfer_sz = (int)max_len,
     };
     ESP_RETURN_ON_ERROR(spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO),
                         TAG, "SPI bus init failed");
@@ -116,34 +613,69 @@ esp_err_t led_driver_init(uint16_t count0, uint16_t count1,
         .clock_speed_hz = LED_SPI_CLOCK_HZ,
         .mode           = 0,
         .spics_io_num   = -1,
-        .queue_size     = 1,
+        .queue_size     = LED_DRIVER_MAX_STRIPS * SPI_BUFS + STREAM_CHUNKS,
         .flags          = SPI_DEVICE_NO_DUMMY,
+        .pre_cb         = mosi_connect,
+        .post_cb        = mosi_idle,
     };
     ESP_RETURN_ON_ERROR(spi_bus_add_device(SPI2_HOST, &dev, &s_spi),
                         TAG, "SPI add device failed");
 
+    /* The bus init routed MOSI to strip 0; park both pins low until a
+     * transaction claims them. */
+    s_mosi_signal = spi_periph_signal[SPI2_HOST].spid_out;
+    for (int i = 0; i < LED_DRIVER_MAX_STRIPS; i++) {
+        gpio_set_direction(s_gpio[i], GPIO_MODE_OUTPUT);
+        gpio_set_level(s_gpio[i], 0);
+        esp_rom_gpio_connect_out_signal(s_gpio[i], SIG_GPIO_OUT_IDX, false, false);
+    }
+
     for (int i = 0; i < LED_DRIVER_MAX_STRIPS; i++) {
         s_strips[i].count = counts[i];
         s_strips[i].type  = types[i];
         s_strips[i].bytes_per_led     = (types[i] == LED_STRIP_TYPE_WS2812B) ? 3 : 4;
         s_strips[i].spi_bytes_per_led = s_strips[i].bytes_per_led * 3;
 
-        if (counts[i] == 0) {
-            gpio_set_direction(s_gpio[i], GPIO_MODE_OUTPUT);
-            gpio_set_level(s_gpio[i], 0);
-            continue;
-        }
+        if (counts[i] == 0) continue;
 
         size_t pix_sz = (size_t)counts[i] * s_strips[i].bytes_per_led;
         size_t spi_sz = (size_t)counts[i] * s_strips[i].spi_bytes_per_led + RESET_BYTES;
         s_strips[i].spi_len = spi_sz;
+        for (int b = 0; b < SPI_BUFS; b++) {
+            s_strips[i].stale_hi[b] = counts[i];
+        }
 
         s_strips[i].pixel_buf = calloc(1, pix_sz);
-        s_strips[i].spi_buf   = heap_caps_calloc(1, spi_sz, MALLOC_CAP_DMA);
-        if (!s_strips[i].pixel_buf || !s_strips[i].spi_buf) {
+        if (!s_strips[i].pixel_buf) {
             ESP_LOGE(TAG, "No memory for strip %d", i);
             return ESP_ERR_NO_MEM;
         }
+
+        if (counts[i] > LED_DRIVER_FULL_FRAME_MAX_LEDS) {
+            s_strips[i].streamed = true;
+            continue;
+        }
+        for (int b = 0; b < SPI_BUFS; b++) {
+            s_strips[i].spi_buf[b] = heap_caps_calloc(1, spi_sz, MALLOC_CAP_DMA);
+            if (!s_strips[i].spi_buf[b]) {
+                ESP_LOGE(TAG, "No DMA memory for strip %d", i);
+                return ESP_ERR_NO_MEM;
+            }
+            s_trans[i][b].length    = spi_sz * 8;
+            s_trans[i][b].tx_buffer = s_strips[i].spi_buf[b];
+            s_trans[i][b].user      = TRANS_USER(i, 0);
+        }
+    }
+
+    if (any_streamed) {
+        for (int c = 0; c < STREAM_CHUNKS; c++) {
+            s_chunk_buf[c] = heap_caps_calloc(1, STREAM_CHUNK_BYTES, MALLOC_CAP_DMA);
+            if (!s_chunk_buf[c]) {
+                ESP_LOGE(TAG, "No DMA memory for stream chunks");
+                return ESP_ERR_NO_MEM;
+            }
+            s_chunk_trans[c].tx_buffer = s_chunk_buf[c];
+        }
     }
 
     ESP_LOGI(TAG, "LED driver ready: strip0=%u@GPIO%d(%s) strip1=%u@GPIO%d(%s)",
@@ -159,19 +691,56 @@ esp_err_t led_driver_set_pixel(uint8_t strip, uint16_t idx,
     strip_data_t *s = &s_strips[strip];
     if (!s->pixel_buf || idx >= s->count) return ESP_ERR_INVALID_ARG;
 
-    uint8_t *p = s->pixel_buf + (size_t)idx * s->bytes_per_led;
-    if (s->type == LED_STRIP_TYPE_WS2812B) {
-        /* WS2812B: GRB (3 bytes, no white channel) */
-        p[0] = g;
-        p[1] = r;
-        p[2] = b;
-    } else {
-        /* SK6812: GRBW (4 bytes) */
-        p[0] = g;
-        p[1] = r;
-        p[2] = b;
-        p[3] = w;
+    spans_to_pixels(s);
+
+    /* GRBW for SK6812; WS2812B uses the first 3 bytes (GRB, no white) */
+    uint8_t color[4] = {g, r, b, w};
+    pixels_write(s, idx, idx + 1, color);
+    return ESP_OK;
+}
+
+esp_err_t led_driver_fill_range(uint8_t strip, uint16_t start, uint16_t count,
+                                 uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    if (strip >= LED_DRIVER_MAX_STRIPS) return ESP_ERR_INVALID_ARG;
+    strip_data_t *s = &s_strips[strip];
+    if (!s->pixel_buf || start >= s->count) return ESP_ERR_INVALID_ARG;
+
+    uint16_t end = (count > s->count - start) ? s->count : start + count;
+    if (end == start) return ESP_OK;
+
+    /* Wire order; w is dropped for WS2812B (3 bytes/LED) so spans compare equal */
+    uint8_t color[4] = {g, r, b, (s->bytes_per_led == 4) ? w : 0};
+
+    if (!s->pixel_mode && span_insert(s, start, end, color)) return ESP_OK;
+
+    spans_to_pixels(s);
+    pixels_write(s, start, end, color);
+    return ESP_OK;
+}
+
+esp_err_t led_driver_write_pixels(uint8_t strip, uint16_t start, uint16_t count,
+                                  const uint8_t *rgbw)
+{
+    if (strip >= LED_DRIVER_MAX_STRIPS || !rgbw) return ESP_ERR_INVALID_ARG;
+    strip_data_t *s = &s_strips[strip];
+    if (!s->pixel_buf || start >= s->count) return ESP_ERR_INVALID_ARG;
+
+    uint16_t end = (count > s->count - start) ? s->count : start + count;
+    spans_to_pixels(s);
+
+    /* Reorder to the wire, compare, and widen the dirty range once */
+    uint8_t bpl = s->bytes_per_led;
+    uint8_t *p = s->pixel_buf + (size_t)start * bpl;
+    uint16_t lo = end, hi = start;
+    for (uint16_t i = start; i < end; i++, p += bpl, rgbw += 4) {
+        uint8_t color[4] = {rgbw[1], rgbw[0], rgbw[2], rgbw[3]};
+        if (memcmp(p, color, bpl) == 0) continue;
+        memcpy(p, color, bpl);
+        if (i < lo) lo = i;
+        hi = i + 1;
     }
+    range_add(&s->dirty_lo, &s->dirty_hi, lo, hi);
     return ESP_OK;
 }
 
@@ -179,34 +748,101 @@ esp_err_t led_driver_clear(uint8_t strip)
 {
     if (strip >= LED_DRIVER_MAX_STRIPS) return ESP_ERR_INVALID_ARG;
     strip_data_t *s = &s_strips[strip];
-    if (s->pixel_buf && s->count > 0) {
-        memset(s->pixel_buf, 0, (size_t)s->count * s->bytes_per_led);
-    }
+
+    /* Empty span list == all black; pixel_buf is rebuilt if needed */
+    s->span_count = 0;
+    s->pixel_mode = false;
     return ESP_OK;
 }
 
-esp_err_t led_driver_refresh(void)
+bool led_driver_ready(void)
+{
+    if (!s_spi) return false;
+    reap_transactions(0);
+    for (int i = 0; i < LED_DRIVER_MAX_STRIPS; i++) {
+        strip_data_t *s = &s_strips[i];
+        if (s->count > 0 && s->busy[s->back]) return false;
+    }
+    return true;
+}
+
+esp_err_t led_driver_refresh_async(void)
 {
+    if (!s_spi) return ESP_ERR_INVALID_STATE;
+    reap_transactions(0);
+
+    bool changed[LED_DRIVER_MAX_STRIPS];
+    bool any = false;
     for (int i = 0; i < LED_DRIVER_MAX_STRIPS; i++) {
         strip_data_t *s = &s_strips[i];
-        if (s->count == 0 || !s->spi_buf) continue;
+        changed[i] = (s->count > 0) && strip_changed(s);
+        if (changed[i] && !s->streamed && s->busy[s->back]) {
+            s_stats.frames_busy++;
+            return ESP_ERR_NOT_FINISHED;
+        }
+        any |= changed[i];
+    }
+    if (!any) {
+        s_stats.frames_skipped++;
+        return ESP_OK;
+    }
 
-        encode_strip(i);
-        mosi_connect(s_gpio[i]);
+    /* Strip 1 is encoded while strip 0's DMA is already running */
+    for (int i = 0; i < LED_DRIVER_MAX_STRIPS; i++) {
+        strip_data_t *s = &s_strips[i];
+        if (!changed[i]) continue;
+
+        if (s->streamed) {
+            /* Runs to completion: no full buffer to hold the frame */
+            esp_err_t err = stream_strip(i);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "SPI stream failed strip %d: %s", i, esp_err_to_name(err));
+                continue;
+            }
+            s_stats.leds_encoded += s->count;
+            strip_mark_sent(s);
+            continue;
+        }
 
-        spi_transaction_t t = {
-            .length    = s->spi_len * 8,
-            .tx_buffer = s->spi_buf,
-        };
-        esp_err_t err = spi_device_transmit(s_spi, &t);
+        uint8_t b = s->back;
+        encode_strip(i, b);
+        esp_err_t err = spi_device_queue_trans(s_spi, &s_trans[i][b], 0);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "SPI transmit failed strip %d: %s", i, esp_err_to_name(err));
+            ESP_LOGE(TAG, "SPI queue failed strip %d: %s", i, esp_err_to_name(err));
+            continue;
         }
-        mosi_idle(s_gpio[i]);
+        s->busy[b] = true;
+        s->back    = b ^ 1;
+        s_queued++;
+        strip_mark_sent(s);
     }
+    s_stats.frames_sent++;
     return ESP_OK;
 }
 
+esp_err_t led_driver_wait_done(uint32_t timeout_ms)
+{
+    if (!s_spi) return ESP_OK;
+    return reap_transactions(pdMS_TO_TICKS(timeout_ms));
+}
+
+esp_err_t led_driver_refresh(void)
+{
+    if (!s_spi) return ESP_ERR_INVALID_STATE;
+
+    /* Both buffers of a strip may be queued; release one before encoding */
+    if (led_driver_ready() == false) {
+        ESP_RETURN_ON_ERROR(led_driver_wait_done(100), TAG, "SPI timeout");
+    }
+    ESP_RETURN_ON_ERROR(led_driver_refresh_async(), TAG, "SPI queue busy");
+    return led_driver_wait_done(100);
+}
+
+void led_driver_get_stats(led_driver_stats_t *out)
+{
+    *out = s_stats;
+}
+
 uint16_t led_driver_get_count(uint8_t strip)
 {
     if (strip >= LED_DRIVER_MAX_STRIPS) return 0;
@@ -9,12 +9,31 @@
  * Timing: 2.5 MHz SPI, 3 SPI bits per LED bit:
  *   0 -> 100  (high 400 ns, low 800 ns)
  *   1 -> 110  (high 800 ns, low 400 ns)
+ *
+ * Refresh modes:
+ *   led_driver_refresh()       — blocking, returns once both strips are sent
+ *   led_driver_refresh_async() — encodes into a back buffer, queues the DMA
+ *                                transactions and returns immediately
+ *
+ * Each strip owns two SPI buffers, so frame N+1 (or strip 1) is encoded while
+ * the DMA for frame N (or strip 0) is still on the wire. The MOSI GPIO switch
+ * happens in the SPI pre/post transaction callbacks.
+ *
+ * Strips longer than LED_DRIVER_FULL_FRAME_MAX_LEDS are streamed instead:
+ * two small DMA chunks take turns, each re-encoded by the calling task as
+ * soon as it has been sent while the other is on the wire, so DMA memory
+ * stays constant however long the strip is. A streamed strip is sent
+ * synchronously within the refresh call.
+ *
+ * Refresh only transmits strips whose content changed since the last frame
+ * sent, and re-encodes only the changed LEDs where it can.
  */
 
 #ifndef LED_DRIVER_H
 #define LED_DRIVER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -23,6 +42,10 @@ extern "C" {
 
 #define LED_DRIVER_MAX_STRIPS  2
 
+/* Longest strip given full double-buffered SPI frames (2 x 6 KB for SK6812);
+ * longer strips use the constant-memory streaming path. */
+#define LED_DRIVER_FULL_FRAME_MAX_LEDS  512
+
 /**
  * @brief LED strip type
  */
@@ -31,6 +54,16 @@ typedef enum {
     LED_STRIP_TYPE_WS2812B = 1,  /**< WS2812B RGB  (3 bytes/LED, GRB order)  */
 } led_strip_type_t;
 
+/**
+ * @brief Frame counters since boot (see `led stats`)
+ */
+typedef struct {
+    uint32_t frames_sent;     /**< Refreshes that transmitted at least one strip */
+    uint32_t frames_skipped;  /**< Refreshes with no change on any strip */
+    uint32_t frames_busy;     /**< Changed frames dropped while the DMA was busy */
+    uint32_t leds_encoded;    /**< LEDs run through the SPI encoder */
+} led_driver_stats_t;
+
 /**
  * @brief Initialize LED driver and SPI bus
  *
@@ -44,20 +77,92 @@ esp_err_t led_driver_init(uint16_t count0, uint16_t count1,
 
 /**
  * @brief Set an RGBW pixel in the buffer for a specific strip
+ *
+ * Per-pixel writes switch the strip out of span mode until the next
+ * led_driver_clear(); prefer led_driver_fill_range() for solid runs.
  */
 esp_err_t led_driver_set_pixel(uint8_t strip, uint16_t idx,
                                 uint8_t r, uint8_t g, uint8_t b, uint8_t w);
 
 /**
- * @brief Clear (zero) the pixel buffer for a specific strip (no transmit)
+ * @brief Fill a run of pixels with one RGBW colour
+ *
+ * Solid runs are kept as spans and encoded by repeating the colour's SPI
+ * pattern. Later fills overwrite earlier ones where they overlap. The range
+ * is clipped to the strip length.
+ *
+ * @param strip  Strip index
+ * @param start  First LED
+ * @param count  Number of LEDs
+ */
+esp_err_t led_driver_fill_range(uint8_t strip, uint16_t start, uint16_t count,
+                                 uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
+/**
+ * @brief Write a run of pixels from an RGBW array
+ *
+ * For per-pixel content such as effects. Switches the strip out of span
+ * mode until the next led_driver_clear(), like led_driver_set_pixel(), but
+ * converts and compares the whole run in one pass. The range is clipped to
+ * the strip length.
+ *
+ * @param strip  Strip index
+ * @param start  First LED
+ * @param count  Number of LEDs
+ * @param rgbw   count * 4 bytes, R G B W per LED (W ignored on WS2812B)
+ */
+esp_err_t led_driver_write_pixels(uint8_t strip, uint16_t start, uint16_t count,
+                                  const uint8_t *rgbw);
+
+/**
+ * @brief Clear a strip to black (no transmit)
+ *
+ * Resets the strip to span mode with an empty span list.
  */
 esp_err_t led_driver_clear(uint8_t strip);
 
 /**
  * @brief Transmit both strip buffers via SPI (time-multiplexed)
+ *
+ * Blocking: waits for any in-flight asynchronous frame, sends the current
+ * pixel buffers and returns once the DMA has completed.
  */
 esp_err_t led_driver_refresh(void);
 
+/**
+ * @brief Queue both strip buffers for transmission and return immediately
+ *
+ * The pixel buffers are encoded into each strip's back SPI buffer before
+ * returning, so the caller may modify pixels again straight away. Strips
+ * identical to the last frame sent are skipped without encoding.
+ *
+ * @return ESP_OK if the frame was queued (or nothing had changed),
+ *         ESP_ERR_NOT_FINISHED if a changed strip's back buffer is still in
+ *         use by the DMA (frame not queued — retry on the next render tick)
+ */
+esp_err_t led_driver_refresh_async(void);
+
+/**
+ * @brief Check whether a new frame can be queued without blocking
+ *
+ * Reaps completed SPI transactions. Returns true when every active strip's
+ * back buffer is free, i.e. led_driver_refresh_async() will accept a frame.
+ */
+bool led_driver_ready(void);
+
+/**
+ * @brief Wait until all queued frames have been transmitted
+ *
+ * @param timeout_ms  Maximum time to wait per outstanding transaction
+ * @return ESP_OK when idle, ESP_ERR_TIMEOUT if the DMA did not complete
+ */
+esp_err_t led_driver_wait_done(uint32_t timeout_ms);
+
+/**
+ * @brief Copy the frame counters
+ */
+void led_driver_get_stats(led_driver_stats_t *out);
+
 /**
  * @brief Get the LED count for a specific strip
  */
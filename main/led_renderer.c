@@ -1,39 +1,147 @@
 /**
  * @file led_renderer.c
  * @brief LED render loop, ZCL polling, and state synchronization
+ *
+ * Two halves:
+ *   - ZCL poll (Zigbee task, 5ms scheduler alarm): snapshots attributes the
+ *     SDK updates internally through cached store pointers and posts the
+ *     changes. No LED work is done here.
+ *   - Render task (own FreeRTOS task, fixed 5ms deadline): composes the frame
+ *     from segment state and queues it to the LED driver. It is the only
+ *     caller of led_driver after boot. Once no command, transition or
+ *     pending frame is left it blocks until led_renderer_request_update(),
+ *     and the ZCL poll drops to ZCL_POLL_IDLE_MS.
+ *
+ * Segment state and geometry are owned by the render task. The Zigbee and
+ * CLI tasks only read them; changes arrive as light_cmd_t commands, which
+ * the render task applies at the start of each frame before composing it.
  */
 
 #include "led_renderer.h"
+#include "light_cmd.h"
 #include "segment_manager.h"
+#include "preset_manager.h"
 #include "color_engine.h"
 #include "led_driver.h"
 #include "transition_engine.h"
+#include "timeline_player.h"
+#include "segment_spans.h"
+#include "frame_jitter.h"
+#include "effect_engine.h"
+#include "blend_engine.h"
+#include "gradient_engine.h"
 #include "config_storage.h"
 #include "zigbee_init.h"
 
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
+#include "esp_cpu.h"
 #include "esp_zigbee_core.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <string.h>
 
 static const char *TAG = "led_renderer";
 
+#define RENDER_PERIOD_MS      5
+#define RENDER_PERIOD_US      (RENDER_PERIOD_MS * 1000)
+#define RENDER_TASK_STACK     4096
+#define RENDER_TASK_PRIORITY  6     /* Above zb_main (5); sleeps while DMA runs */
+#define ZCL_POLL_PERIOD_MS    5
+#define ZCL_POLL_IDLE_MS      25    /* While the scene is static */
+#define ZCL_POLL_HOLD_US      (1000 * 1000)  /* Stay at full rate after a change */
+#define HEAP_ATTR_PERIOD_US   (60LL * 1000 * 1000)
+
+#define FX_CHUNK_LEDS         64    /* Effect pixels rendered per driver write */
+
 /* Per-strip power scale: 0-255, applied as brightness multiplier */
 static uint8_t s_power_scale[LED_DRIVER_MAX_STRIPS] = {255, 255};
 
-/* Last raw ZCL values seen by the render loop per segment + EP9 "all" master.
- * Updated ONLY by the render loop — never by callbacks.
+/* Segment geometry resolved into non-overlapping runs per strip (render
+ * task). Rebuilt on the first frame after a geometry change, or a segment
+ * switching between replace and a blending mode. */
+static segment_span_list_t s_spans[MAX_STRIPS];
+static uint32_t            s_spans_visible;   /* Segments that are a layer of a run */
+static uint32_t            s_spans_opaque;    /* Segments in BLEND_REPLACE at build */
+static bool                s_spans_stale = true;
+
+/* Effect and composited pixels on their way to the driver, and the layer
+ * being blended onto them (render task). One RGBW pixel per word. */
+static uint32_t s_fx_buf[FX_CHUNK_LEDS];
+static uint32_t s_layer_buf[FX_CHUNK_LEDS];
+
+/* Inputs of every visible segment for the frame being composed */
+typedef struct {
+    effect_frame_t fx[MAX_SEGMENTS];
+    uint8_t        rgbw[MAX_SEGMENTS][4];   /* Colour of a solid segment */
+    uint32_t       solid;                   /* Bit per segment with one colour */
+} layer_frame_t;
+
+/* ZCL attributes polled per endpoint: EP1-EP8 segments + EP9 "all" master */
+#define ZCL_POLL_EPS          (MAX_SEGMENTS + 1)
+
+/* Attribute store pointers, resolved once on the first poll. The SDK keeps
+ * attribute data in static storage once endpoints are registered, so the
+ * pointers stay valid and each tick reads values without a lookup. */
+typedef struct {
+    const uint8_t  *mode;
+    const uint8_t  *level;      /* NULL for EP9: level arrives via callback */
+    const uint16_t *enh_hue;
+    const uint8_t  *sat;
+    const uint16_t *ct;
+} zcl_attr_ptrs_t;
+
+/* Compact per-endpoint snapshot. Only the fields the current color mode uses
+ * are read (HS in mode 0, CT in mode 2); the rest carry the last seen value,
+ * so an unchanged endpoint always compares equal. */
+typedef struct {
+    uint16_t enh_hue;
+    uint16_t ct;
+    uint8_t  level;
+    uint8_t  sat;
+    uint8_t  mode;
+    uint8_t  reserved;
+} zcl_snap_t;
+
+static zcl_attr_ptrs_t s_zcl_ptrs[ZCL_POLL_EPS];
+static bool            s_zcl_ptrs_ready = false;
+static uint32_t        s_zcl_lookup_cycles = 0;  /* Cost of one full lookup pass */
+
+/* Last raw ZCL values seen by the poll per segment + EP9 "all" master.
+ * Updated ONLY by the poll — never by callbacks.
  * This makes change detection immune to the SDK firing SET_ATTR_VALUE_CB_ID
  * for one group endpoint but not the other, which would pre-set state[n].hue
- * and cause the render loop to silently skip the update for that segment.
+ * and cause the poll to silently skip the update for that segment.
  * Index [MAX_SEGMENTS] tracks EP9 ("all segments" master). */
-static uint16_t s_last_enh_hue[MAX_SEGMENTS + 1] = {0};
-static uint8_t  s_last_sat[MAX_SEGMENTS + 1]     = {0};
-static uint16_t s_last_ct[MAX_SEGMENTS + 1]      = {0};
+static zcl_snap_t s_zcl_seen[ZCL_POLL_EPS];
 
 /* Globals set by main.cpp after NVS load */
 extern uint16_t g_strip_max_current[2];
 
+static TaskHandle_t s_render_task = NULL;
+static volatile bool s_render_idle = false;   /* Render task asleep, scene static */
+static int64_t s_poll_last_change_us = 0;     /* Zigbee task only */
+
+/* Timing counters (see `led perf`). Written by the task they measure. */
+static struct {
+    uint32_t frames;
+    uint32_t overruns;
+    uint32_t render_max_us;
+    frame_jitter_t jitter;      /* Render task wake-up lateness */
+    uint32_t polls;
+    uint32_t poll_max_us;
+    uint64_t poll_total_us;
+    uint32_t poll_max_cycles;
+    uint64_t poll_total_cycles;
+    uint32_t idle_entries;
+    uint32_t color_hits;        /* Segment colours reused from the cache */
+    uint32_t color_misses;      /* Segment colours converted */
+    uint32_t fx_max_us;         /* Per-pixel effect and blend rendering in one frame */
+    uint32_t fx_leds;           /* LEDs rendered per pixel in the last frame */
+} s_perf;
+
 /* ================================================================== */
 /*  Configuration Save Timer                                          */
 /* ================================================================== */
@@ -64,9 +172,11 @@ void schedule_save(void)
  *
  * SMOOTHING FILTER: 100ms provides smooth interpolation between SDK updates.
  * When HA sends a timed transition, the Zigbee SDK interpolates values internally
- * and updates attributes at discrete intervals. The firmware transition engine acts
- * as a smoothing filter, creating smooth 200Hz interpolation between SDK updates.
- * 100ms is fast enough to feel instant while eliminating visible stepping.
+ * and updates attributes at discrete intervals. The ZCL poll posts each step with
+ * LIGHT_CMD_FLAG_FOLLOW, so the segment tracks the stream through a critically
+ * damped filter (transition_batch_follow) that lags a steady move by this long
+ * and keeps its velocity across steps, instead of restarting a linear fade on
+ * every step. Other commands use it as a plain fade duration.
  */
 uint16_t g_global_transition_ms = 100;
 
@@ -86,7 +196,10 @@ void led_renderer_set_global_transition_ms(uint16_t ms)
 
 void sync_zcl_from_state(void)
 {
-    segment_light_t *state = segment_state_get();
+    segment_light_t  *state = segment_state_get();
+    segment_effect_t *fx    = segment_effect_get();
+    segment_blend_t  *blend = segment_blend_get();
+    segment_gradient_t *grad = segment_gradient_get();
 
     for (int n = 0; n < MAX_SEGMENTS; n++) {
         uint8_t ep = (uint8_t)(ZB_SEGMENT_EP_BASE + n);
@@ -122,6 +235,32 @@ void sync_zcl_from_state(void)
         esp_zb_zcl_set_attribute_val(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
             ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID,
             &state[n].color_temp, false);
+
+        /* Sync effect */
+        esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_EFFECT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ZB_ATTR_EFFECT_ID, &fx[n].id, false);
+        esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_EFFECT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ZB_ATTR_EFFECT_SPEED, &fx[n].speed, false);
+        esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_EFFECT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ZB_ATTR_EFFECT_INTENSITY, &fx[n].intensity, false);
+        esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_EFFECT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ZB_ATTR_EFFECT_BLEND, &blend[n].mode, false);
+        esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_EFFECT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ZB_ATTR_EFFECT_OPACITY, &blend[n].opacity, false);
+
+        /* Sync gradient */
+        esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_GRADIENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ZB_ATTR_GRADIENT_STOPS, &grad[n].stops, false);
+        esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_GRADIENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+            ZB_ATTR_GRADIENT_SPACE, &grad[n].space, false);
+        for (int k = 0; k < GRADIENT_MAX_STOPS; k++) {
+            esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_GRADIENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                ZB_ATTR_GRADIENT_HUE_BASE + k, &grad[n].hue[k], false);
+            esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_GRADIENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                ZB_ATTR_GRADIENT_SAT_BASE + k, &grad[n].sat[k], false);
+            esp_zb_zcl_set_attribute_val(ep, ZB_CLUSTER_GRADIENT, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                ZB_ATTR_GRADIENT_POS_BASE + k, &grad[n].pos[k], false);
+        }
     }
 
     /* Force physical min/max mireds on every endpoint (EP1-EP8 + EP9).
@@ -145,16 +284,14 @@ void sync_zcl_from_state(void)
     ESP_LOGI(TAG, "ZCL attribute store synced from saved state");
 }
 
-static void sync_zcl_deferred_cb(uint8_t param)
-{
-    (void)param;
-    ESP_LOGI(TAG, "Deferred ZCL sync after preset recall");
-    sync_zcl_from_state();
-}
+/* Set from any task; the ZCL poll consumes it in the Zigbee task, which
+ * is the only place the SDK allows attribute writes and alarms without
+ * taking the Zigbee lock. */
+static atomic_bool s_zcl_sync_pending = false;
 
 void schedule_zcl_sync(void)
 {
-    esp_zb_scheduler_alarm(sync_zcl_deferred_cb, 0, 100);
+    atomic_store(&s_zcl_sync_pending, true);
 }
 
 /* ================================================================== */
@@ -179,244 +316,901 @@ void led_renderer_recalc_power_scale(void)
         ESP_LOGI(TAG, "Strip%d power scale: %u/255 (max=%umA, count=%u, %umA/LED)",
                  i, s_power_scale[i], max_cur, count, per_led_ma);
     }
+    /* Re-render with the new scale even if the scene is idle */
+    led_renderer_request_update();
 }
 
 /* ================================================================== */
 /*  LED Rendering                                                     */
 /* ================================================================== */
 
-void update_leds(void)
-{
-    segment_geom_t  *geom  = segment_geom_get();
-    segment_light_t *state = segment_state_get();
+/* Everything a segment's colour depends on. Inputs the colour mode does
+ * not use are left zero, so e.g. a hue change on a CT segment still hits. */
+typedef struct {
+    uint32_t level_q16;
+    uint32_t hue_q8;        /* 1/256 degree */
+    uint16_t ct;
+    uint8_t  sat;
+    uint8_t  on;
+    uint8_t  color_mode;
+    uint8_t  power_scale;
+    uint8_t  strip_type;
+    uint8_t  valid;
+} color_key_t;
 
-    /* Clear both strip buffers */
-    led_driver_clear(0);
-    led_driver_clear(1);
+/* Last colour computed per segment and the inputs it came from (render task) */
+typedef struct {
+    color_key_t key;
+    uint8_t     rgbw[4];
+    uint8_t     level;      /* Brightness after power scale */
+} color_entry_t;
 
-    /* Render segments in order (1 first = base layer, 8 last = top overlay) */
-    for (int n = 0; n < MAX_SEGMENTS; n++) {
-        if (geom[n].count == 0) continue;
+static color_entry_t s_color_cache[MAX_SEGMENTS];
 
-        uint8_t r = 0, g = 0, b = 0, w = 0;
+static void segment_color_key(int n, color_key_t *key)
+{
+    const segment_light_t    *st    = &segment_state_get()[n];
+    const transition_batch_t *trans = segment_trans_get();
+    uint8_t strip = segment_geom_get()[n].strip_id;
 
-        uint8_t strip = geom[n].strip_id;
+    memset(key, 0, sizeof(*key));
+    key->valid = 1;
+    if (!st->on) return;
 
-        if (state[n].on) {
-            /* Read interpolated values from transition engine */
-            uint8_t  level = (uint8_t)transition_get_value(&state[n].level_trans);
-            uint16_t hue   = transition_get_value(&state[n].hue_trans);
-            uint8_t  sat   = (uint8_t)transition_get_value(&state[n].sat_trans);
-            uint16_t ct    = transition_get_value(&state[n].ct_trans);
+    /* Interpolated values, sampled at the frame time. Level and hue keep
+     * their fractions (Q16.16) until they are reduced to 8 bits */
+    key->on          = 1;
+    key->color_mode  = st->color_mode;
+    key->level_q16   = transition_batch_get_q16(trans, n, SEG_CH_LEVEL);
+    key->power_scale = s_power_scale[strip];
+    if (st->color_mode == 2) {
+        key->ct         = transition_batch_get(trans, n, SEG_CH_CT);
+        key->strip_type = (uint8_t)led_driver_get_type(strip);
+    } else {
+        key->hue_q8 = transition_batch_get_q16(trans, n, SEG_CH_HUE) >> 8;
+        key->sat    = (uint8_t)transition_batch_get(trans, n, SEG_CH_SAT);
+    }
+}
 
-            /* Apply power scale (worst-case brightness limiting) */
-            uint8_t sc = s_power_scale[strip];
-            if (sc < 255) {
-                level = (uint8_t)(((uint16_t)level * sc) / 255);
-            }
+/* Colour and power-scaled brightness from a key. Black when off. */
+static void key_to_color(const color_key_t *key, color_entry_t *out)
+{
+    uint8_t r = 0, g = 0, b = 0, w = 0;
+    uint8_t level = 0;
 
-            if (state[n].color_mode == 2) {
-                if (led_driver_get_type(strip) == LED_STRIP_TYPE_WS2812B) {
-                    /* WS2812B: approximate warm white via desaturated orange.
-                     * CT range: 153 mir (6500K, cool) to 500 mir (2000K, warm).
-                     * Cool end -> sat=0 (pure white). Warm end -> sat~215 (~84%, amber tint).
-                     * Hue fixed at 28° (orange/amber). Smooth, perceptually convincing.
-                     * Z2M presets: coolest=153, cool=250, neutral=370, warm=454, warmest=500. */
-                    uint16_t ct_cool = 153, ct_warm = 500;
-                    uint16_t ct_clamped = (ct < ct_cool) ? ct_cool : (ct > ct_warm) ? ct_warm : ct;
-                    uint8_t t   = (uint8_t)(((uint32_t)(ct_clamped - ct_cool) * 255) / (ct_warm - ct_cool));
-                    uint8_t ww_sat = (uint8_t)(((uint32_t)t * 215) / 255);
-                    hsv_to_rgb(28, ww_sat, level, &r, &g, &b);
-                } else {
-                    /* SK6812: drive White channel with brightness */
-                    w = level;
-                }
+    if (key->on) {
+        level = (uint8_t)(key->level_q16 >> 16);
+
+        /* Apply power scale (worst-case brightness limiting) */
+        uint8_t sc = key->power_scale;
+        if (sc < 255) {
+            level = (uint8_t)((((key->level_q16 >> 8) * sc) / 255) >> 8);
+        }
+
+        if (key->color_mode == 2) {
+            if (key->strip_type == LED_STRIP_TYPE_WS2812B) {
+                /* WS2812B: approximate warm white via desaturated orange.
+                 * CT range: 153 mir (6500K, cool) to 500 mir (2000K, warm).
+                 * Cool end -> sat=0 (pure white). Warm end -> sat~215 (~84%, amber tint).
+                 * Hue fixed at 28° (orange/amber). Smooth, perceptually convincing.
+                 * Z2M presets: coolest=153, cool=250, neutral=370, warm=454, warmest=500. */
+                uint16_t ct = key->ct;
+                uint16_t ct_cool = 153, ct_warm = 500;
+                uint16_t ct_clamped = (ct < ct_cool) ? ct_cool : (ct > ct_warm) ? ct_warm : ct;
+                uint8_t t   = (uint8_t)(((uint32_t)(ct_clamped - ct_cool) * 255) / (ct_warm - ct_cool));
+                uint8_t ww_sat = (uint8_t)(((uint32_t)t * 215) / 255);
+                hsv_to_rgb(28, ww_sat, level, &r, &g, &b);
             } else {
-                /* Enhanced Hue mode: convert HSV to RGB */
-                hsv_to_rgb(hue, sat, level, &r, &g, &b);
+                /* SK6812: drive White channel with brightness */
+                w = level;
             }
+        } else {
+            /* Enhanced Hue mode: convert HSV to RGB */
+            hsv_to_rgb_q8(key->hue_q8, key->sat, level, &r, &g, &b);
         }
+    }
 
-        uint16_t strip_len = led_driver_get_count(strip);
-        uint16_t end = geom[n].start + geom[n].count;
-        if (end > strip_len) end = strip_len;
-        for (uint16_t i = geom[n].start; i < end; i++) {
-            led_driver_set_pixel(strip, i, r, g, b, w);
+    out->rgbw[0] = r;
+    out->rgbw[1] = g;
+    out->rgbw[2] = b;
+    out->rgbw[3] = w;
+    out->level   = level;
+}
+
+/* Colour of segment n at the frame time. Converted only when one of its
+ * inputs changed since the last frame; a static or hidden-then-shown
+ * segment reuses the cached result. */
+static const color_entry_t *segment_color(int n)
+{
+    color_key_t key;
+    segment_color_key(n, &key);
+
+    if (memcmp(&key, &s_color_cache[n].key, sizeof(key)) == 0) {
+        s_perf.color_hits++;
+    } else {
+        key_to_color(&key, &s_color_cache[n]);
+        s_color_cache[n].key = key;
+        s_perf.color_misses++;
+    }
+    return &s_color_cache[n];
+}
+
+/* Effect inputs of segment n for this frame */
+static void segment_effect_frame(int n, effect_frame_t *f)
+{
+    const segment_effect_t *fx = &segment_effect_get()[n];
+    const color_entry_t    *c  = segment_color(n);
+
+    *f = (effect_frame_t) {
+        .id        = fx->id,
+        .intensity = fx->intensity,
+        .seg       = (uint8_t)n,
+        .level     = c->level,
+        /* A rainbow on a CT segment runs at full saturation */
+        .sat       = (c->key.color_mode == 2) ? 254 : c->key.sat,
+        .seg_len   = segment_geom_get()[n].count,
+        .phase     = effect_engine_phase((uint8_t)n),
+    };
+    memcpy(f->rgbw, c->rgbw, 4);
+
+    /* Gradient stops at their transition values; only shown without an
+     * effect (see effect_engine.h) */
+    const segment_gradient_t *gr = &segment_gradient_get()[n];
+    if (gr->stops >= 2 && fx->id == EFFECT_NONE && c->level > 0) {
+        const transition_batch_t *gt = segment_grad_trans_get();
+        gradient_stop_t stops[GRADIENT_MAX_STOPS];
+        for (int k = 0; k < gr->stops; k++) {
+            stops[k] = (gradient_stop_t) {
+                .pos     = gr->pos[k],
+                .sat     = (uint8_t)transition_batch_get(&gt[GRAD_TRANS_SAT], n, k),
+                .hue_q16 = transition_batch_get_q16(&gt[GRAD_TRANS_HUE], n, k),
+            };
         }
+        gradient_frame_build(&f->grad, gr->space, stops, gr->stops, c->level, f->seg_len);
+    }
+}
+
+/* Per-pixel effect over one span, through s_fx_buf a chunk at a time.
+ * Returns the number of LEDs rendered. */
+static uint16_t render_effect_span(uint8_t strip, const segment_span_t *sp,
+                                   const effect_frame_t *f, uint16_t seg_start)
+{
+    uint16_t len = led_driver_get_count(strip);
+    if (sp->start >= len) return 0;
+    uint16_t count  = (sp->count > len - sp->start) ? len - sp->start : sp->count;
+    uint16_t offset = sp->start - seg_start;
+
+    for (uint16_t done = 0; done < count; ) {
+        uint16_t n = count - done;
+        if (n > FX_CHUNK_LEDS) n = FX_CHUNK_LEDS;
+        effect_render(f, offset + done, n, (uint8_t *)s_fx_buf);
+        led_driver_write_pixels(strip, sp->start + done, n, (const uint8_t *)s_fx_buf);
+        done += n;
     }
+    return count;
+}
 
-    led_driver_refresh();
+/* Pixels [pos, pos + n) of the strip as segment seg alone would show them */
+static void layer_pixels(const layer_frame_t *lf, int seg, uint16_t pos, uint16_t n, uint32_t *out)
+{
+    if (lf->solid & (1u << seg)) {
+        uint32_t px;
+        memcpy(&px, lf->rgbw[seg], 4);
+        for (uint16_t i = 0; i < n; i++) out[i] = px;
+    } else {
+        effect_render(&lf->fx[seg], pos - segment_geom_get()[seg].start, n, (uint8_t *)out);
+    }
+}
+
+/* Composite the layers of sp over [pos, pos + n) into out, bottom-up. The
+ * bottom layer is copied if it is opaque; otherwise everything blends onto
+ * black. */
+static void composite(const layer_frame_t *lf, const segment_span_t *sp,
+                      uint16_t pos, uint16_t n, uint32_t *out)
+{
+    const segment_blend_t *blend = segment_blend_get();
+    uint32_t m = sp->layers;
+    int base = __builtin_ctz(m);
+
+    if (s_spans_opaque & (1u << base)) {
+        layer_pixels(lf, base, pos, n, out);
+        m &= m - 1;
+    } else {
+        memset(out, 0, (size_t)n * sizeof(out[0]));
+    }
+    for (; m; m &= m - 1) {
+        int k = __builtin_ctz(m);
+        layer_pixels(lf, k, pos, n, s_layer_buf);
+        blend_run(blend[k].mode, blend[k].opacity, out, s_layer_buf, n);
+    }
+}
+
+/* A run with more than one layer, or one blending onto black. If every
+ * layer is solid the result is too: composite one pixel and fill. Returns
+ * the number of LEDs composited per pixel. */
+static uint16_t render_blend_span(uint8_t strip, const segment_span_t *sp,
+                                  const layer_frame_t *lf)
+{
+    if ((sp->layers & ~lf->solid) == 0) {
+        uint32_t px;
+        uint8_t c[4];
+        composite(lf, sp, sp->start, 1, &px);
+        memcpy(c, &px, 4);
+        led_driver_fill_range(strip, sp->start, sp->count, c[0], c[1], c[2], c[3]);
+        return 0;
+    }
+
+    uint16_t len = led_driver_get_count(strip);
+    if (sp->start >= len) return 0;
+    uint16_t count = (sp->count > len - sp->start) ? len - sp->start : sp->count;
+
+    for (uint16_t done = 0; done < count; ) {
+        uint16_t n = count - done;
+        if (n > FX_CHUNK_LEDS) n = FX_CHUNK_LEDS;
+        composite(lf, sp, sp->start + done, n, s_fx_buf);
+        led_driver_write_pixels(strip, sp->start + done, n, (const uint8_t *)s_fx_buf);
+        done += n;
+    }
+    return count;
+}
+
+/* Bit per segment that hides the segments below it */
+static uint32_t opaque_segments(void)
+{
+    const segment_blend_t *blend = segment_blend_get();
+    uint32_t opaque = 0;
+    for (int n = 0; n < MAX_SEGMENTS; n++) {
+        if (blend[n].mode == BLEND_REPLACE) opaque |= 1u << n;
+    }
+    return opaque;
+}
+
+/* Write the segments into the strip buffers (segment 1 = base layer, 8 =
+ * top) and queue the frame. Overlaps were resolved when the span map was
+ * built, so each covered LED run is written once, in LED order; hidden
+ * segments are not evaluated. A run with one opaque layer is filled with
+ * that segment's colour, or rendered pixel by pixel if it has a per-pixel
+ * effect. Runs where blending segments meet are composited, as a single
+ * colour when all their layers are solid.
+ * Render task only: the driver is not shared with other tasks.
+ * Sets *effects if a visible effect is moving.
+ * Returns true if the frame could not be queued and must be retried. */
+static bool update_leds(bool *effects)
+{
+    if (s_spans_stale) {
+        s_spans_opaque  = opaque_segments();
+        s_spans_visible = segment_spans_build(segment_geom_get(), s_spans_opaque, s_spans);
+        s_spans_stale   = false;
+    }
+
+    const segment_effect_t *fx   = segment_effect_get();
+    const segment_geom_t   *geom = segment_geom_get();
+    /* Static: eight effect frames with their gradients are too large for
+     * the render task's stack */
+    static layer_frame_t lf;
+    lf.solid = 0;
+    *effects = false;
+    for (uint32_t m = s_spans_visible; m; m &= m - 1) {
+        int n = __builtin_ctz(m);
+        segment_effect_frame(n, &lf.fx[n]);
+        if (effect_solid(&lf.fx[n], lf.rgbw[n])) lf.solid |= 1u << n;
+        if (fx[n].id != EFFECT_NONE && fx[n].speed > 0 && lf.fx[n].level > 0) *effects = true;
+    }
+
+    int64_t fx_start = esp_timer_get_time();
+    uint32_t fx_leds = 0;
+    for (int strip = 0; strip < MAX_STRIPS; strip++) {
+        const segment_span_list_t *list = &s_spans[strip];
+        led_driver_clear(strip);
+        for (int i = 0; i < list->count; i++) {
+            const segment_span_t *sp = &list->spans[i];
+            uint32_t top = 1u << sp->seg;
+            if (sp->layers != (top & s_spans_opaque)) {
+                fx_leds += render_blend_span(strip, sp, &lf);
+            } else if (lf.solid & top) {
+                const uint8_t *c = lf.rgbw[sp->seg];
+                /* Clipped to the strip by the driver */
+                led_driver_fill_range(strip, sp->start, sp->count, c[0], c[1], c[2], c[3]);
+            } else {
+                fx_leds += render_effect_span(strip, sp, &lf.fx[sp->seg], geom[sp->seg].start);
+            }
+        }
+    }
+    s_perf.fx_leds = fx_leds;
+    if (fx_leds) {
+        uint32_t took = (uint32_t)(esp_timer_get_time() - fx_start);
+        if (took > s_perf.fx_max_us) s_perf.fx_max_us = took;
+    }
+
+    /* Non-blocking: if the previous frame is still on the wire this frame is
+     * skipped, and the next render tick sends the latest pixel state. */
+    return led_driver_refresh_async() == ESP_ERR_NOT_FINISHED;
 }
 
 void restore_leds_cb(uint8_t param)
 {
     (void)param;
-    update_leds();
+    led_renderer_request_update();
+}
+
+void led_renderer_request_update(void)
+{
+    if (s_render_task) {
+        xTaskNotifyGive(s_render_task);
+    }
 }
 
 /* ================================================================== */
-/*  LED Render Loop (200Hz via scheduler alarm)                       */
+/*  Command Application (render task)                                 */
 /* ================================================================== */
 
-static void led_render_cb(uint8_t param)
+/* Fade one channel of segment n; the segment's other channels join the new
+ * time base */
+static void seg_fade(int n, segment_channel_t ch, uint16_t target, uint32_t ms, int64_t now_us)
+{
+    uint16_t targets[SEG_CH_COUNT] = {0};
+    targets[ch] = target;
+    transition_batch_start(segment_trans_get(), n, 1u << ch, targets, ms, now_us);
+}
+
+/* Fade gradient stop k of segment n to target (hue or saturation batch) */
+static void grad_fade(int n, segment_grad_trans_t b, uint8_t k, uint16_t target,
+                      uint32_t ms, int64_t now_us)
+{
+    uint16_t targets[GRADIENT_MAX_STOPS] = {0};
+    targets[k] = target;
+    transition_batch_start(&segment_grad_trans_get()[b], n, 1u << k, targets, ms, now_us);
+}
+
+/* Move one channel of segment n to a command's value. Steps of an attribute
+ * stream go through the follow filter, which keeps its velocity from one
+ * step to the next; one-off changes fade. */
+static void seg_move(int n, segment_channel_t ch, const light_cmd_t *c, int64_t now_us)
+{
+    if (c->flags & LIGHT_CMD_FLAG_FOLLOW) {
+        transition_batch_follow(segment_trans_get(), n, ch, c->value, c->transition_ms, now_us);
+    } else {
+        seg_fade(n, ch, c->value, c->transition_ms, now_us);
+    }
+}
+
+/* Segment channels a command sets directly (0 for none) */
+static uint32_t cmd_channel_mask(uint8_t type)
+{
+    switch (type) {
+    case LIGHT_CMD_ON_OFF:
+    case LIGHT_CMD_LEVEL:       return 1u << SEG_CH_LEVEL;
+    case LIGHT_CMD_HUE:         return 1u << SEG_CH_HUE;
+    case LIGHT_CMD_SATURATION:  return 1u << SEG_CH_SAT;
+    case LIGHT_CMD_COLOR_TEMP:  return 1u << SEG_CH_CT;
+    default:                    return 0;
+    }
+}
+
+/* Apply one command to one segment. Returns false if it matched the current
+ * state, so repeated polls of an unchanged attribute cost nothing. */
+static bool apply_seg_cmd(const light_cmd_t *c, int n, int64_t now_us)
+{
+    segment_light_t *st = &segment_state_get()[n];
+    segment_geom_t  *gm = &segment_geom_get()[n];
+    segment_effect_t *fx = &segment_effect_get()[n];
+    segment_blend_t  *bl = &segment_blend_get()[n];
+    segment_gradient_t *gr = &segment_gradient_get()[n];
+    uint8_t  stop = LIGHT_CMD_GRAD_STOP(c->value);
+    uint16_t v  = c->value;
+    uint16_t ms = c->transition_ms;
+
+    /* A direct command takes the channel over from its timeline. The
+     * timeline's value is kept in state first, so the comparisons below
+     * are against what is on the strip. */
+    uint32_t ch_mask = cmd_channel_mask(c->type);
+    if (ch_mask) timeline_player_stop((uint8_t)n, ch_mask);
+
+    switch (c->type) {
+    case LIGHT_CMD_ON_OFF: {
+        bool on = (v != 0);
+        if (st->on == on) return false;
+        st->on = on;
+        if (on) {
+            /* Turning ON: start from 0 (dark) and fade to target level */
+            transition_batch_jump(segment_trans_get(), n, SEG_CH_LEVEL, 0);
+            seg_fade(n, SEG_CH_LEVEL, st->level, ms, now_us);
+        } else {
+            /* Turning OFF: fade from current level to 0 */
+            seg_fade(n, SEG_CH_LEVEL, 0, ms, now_us);
+        }
+        return true;
+    }
+    case LIGHT_CMD_LEVEL:
+        if (st->level == v) return false;
+        st->level = (uint8_t)v;
+        seg_move(n, SEG_CH_LEVEL, c, now_us);
+        return true;
+    case LIGHT_CMD_HUE:
+        if (st->hue == v && st->color_mode == 0) return false;
+        st->hue = v;
+        st->color_mode = 0;
+        seg_move(n, SEG_CH_HUE, c, now_us);         /* Shortest arc */
+        return true;
+    case LIGHT_CMD_SATURATION:
+        if (st->saturation == v) return false;
+        st->saturation = (uint8_t)v;
+        seg_move(n, SEG_CH_SAT, c, now_us);
+        return true;
+    case LIGHT_CMD_COLOR_TEMP:
+        if (st->color_temp == v && st->color_mode == 2) return false;
+        st->color_temp = v;
+        st->color_mode = 2;
+        seg_move(n, SEG_CH_CT, c, now_us);
+        return true;
+    case LIGHT_CMD_COLOR_MODE:
+        if (st->color_mode == v) return false;
+        st->color_mode = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_STARTUP_ON_OFF:
+        if (st->startup_on_off == v) return false;
+        st->startup_on_off = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_GEOM_START:
+        if (gm->start == v) return false;
+        gm->start = v;
+        s_spans_stale = true;
+        return true;
+    case LIGHT_CMD_GEOM_COUNT:
+        if (gm->count == v) return false;
+        gm->count = v;
+        s_spans_stale = true;
+        return true;
+    case LIGHT_CMD_GEOM_STRIP:
+        if (gm->strip_id == v) return false;
+        gm->strip_id = (uint8_t)v;
+        s_spans_stale = true;
+        return true;
+    case LIGHT_CMD_TIMELINE_STOP:
+        if (!timeline_player_stop((uint8_t)n, v)) return false;
+        schedule_zcl_sync();
+        return true;
+    case LIGHT_CMD_EFFECT:
+        if (v >= EFFECT_COUNT || fx->id == v) return false;
+        fx->id = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_EFFECT_SPEED:
+        if (v > UINT8_MAX || fx->speed == v) return false;
+        fx->speed = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_EFFECT_INTENSITY:
+        if (v > UINT8_MAX || fx->intensity == v) return false;
+        fx->intensity = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_BLEND:
+        if (v >= BLEND_COUNT || bl->mode == v) return false;
+        /* Which layers show through changes with replace vs the rest */
+        if ((bl->mode == BLEND_REPLACE) != (v == BLEND_REPLACE)) s_spans_stale = true;
+        bl->mode = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_BLEND_OPACITY:
+        if (v > UINT8_MAX || bl->opacity == v) return false;
+        bl->opacity = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_GRAD_STOPS:
+        if (v == 1 || v > GRADIENT_MAX_STOPS || gr->stops == v) return false;
+        gr->stops = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_GRAD_SPACE:
+        if (v >= GRADIENT_SPACE_COUNT || gr->space == v) return false;
+        gr->space = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_GRAD_POS:
+        v = LIGHT_CMD_GRAD_ARG(c->value);
+        if (stop >= GRADIENT_MAX_STOPS || v > UINT8_MAX || gr->pos[stop] == v) return false;
+        gr->pos[stop] = (uint8_t)v;
+        return true;
+    case LIGHT_CMD_GRAD_HUE:
+        v = LIGHT_CMD_GRAD_ARG(c->value);
+        if (stop >= GRADIENT_MAX_STOPS || v >= 360 || gr->hue[stop] == v) return false;
+        gr->hue[stop] = v;
+        grad_fade(n, GRAD_TRANS_HUE, stop, v, ms, now_us);     /* Shortest arc */
+        return true;
+    case LIGHT_CMD_GRAD_SAT:
+        v = LIGHT_CMD_GRAD_ARG(c->value);
+        if (stop >= GRADIENT_MAX_STOPS || v > 254 || gr->sat[stop] == v) return false;
+        gr->sat[stop] = (uint8_t)v;
+        grad_fade(n, GRAD_TRANS_SAT, stop, v, ms, now_us);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool apply_preset_recall(uint8_t slot, int64_t now_us)
 {
-    /* Poll attributes (SDK handles some commands internally, no callbacks) */
+    /* The preset replaces every channel: end all timelines before it loads */
+    timeline_player_stop(LIGHT_CMD_ALL_SEGS, (1u << SEG_CH_COUNT) - 1);
+
+    esp_err_t err = preset_manager_recall(slot);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Preset slot %u recall failed: %s", slot, esp_err_to_name(err));
+        return false;
+    }
+
+    /* Start transitions from current values to new preset values: hue and
+     * saturation switch instantly, level and CT fade together */
     segment_light_t *state = segment_state_get();
-    for (int n = 0; n < MAX_SEGMENTS; n++) {
-        uint8_t ep = (uint8_t)(ZB_SEGMENT_EP_BASE + n);
+    transition_batch_t *trans = segment_trans_get();
+    for (int i = 0; i < MAX_SEGMENTS; i++) {
+        uint16_t targets[SEG_CH_COUNT] = {
+            [SEG_CH_LEVEL] = state[i].level,
+            [SEG_CH_HUE]   = state[i].hue,
+            [SEG_CH_SAT]   = state[i].saturation,
+            [SEG_CH_CT]    = state[i].color_temp,
+        };
+        transition_batch_start(trans, i, (1u << SEG_CH_HUE) | (1u << SEG_CH_SAT),
+                               targets, 0, now_us);
+        transition_batch_start(trans, i, (1u << SEG_CH_LEVEL) | (1u << SEG_CH_CT),
+                               targets, g_global_transition_ms, now_us);
+    }
+    /* Defer ZCL sync to the Zigbee task */
+    schedule_zcl_sync();
+    return true;
+}
+
+static bool apply_timeline_load(uint8_t slot, int64_t now_us)
+{
+    timeline_upload_t up;
+    if (!timeline_upload_take(slot, &up)) return false;
+    bool changed = timeline_player_load(&up, now_us);
+    /* On/off and color mode may have changed: defer ZCL sync to the Zigbee task */
+    if (changed) schedule_zcl_sync();
+    return changed;
+}
+
+/* Drain every queued command into segment state, then persist once. Fades
+ * start at now_us, the frame time. Returns true if any command changed
+ * state. */
+static bool apply_light_cmds(int64_t now_us)
+{
+    light_cmd_t c;
+    bool dirty = false;
 
-        /* Read color mode to decide what to poll */
-        esp_zb_zcl_attr_t *attr_mode = esp_zb_zcl_get_attribute(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
-            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID);
-        uint8_t zcl_mode = (attr_mode && attr_mode->data_p) ? *(uint8_t *)attr_mode->data_p : 0;
-
-        /* Read brightness (level) - applies to all modes */
-        esp_zb_zcl_attr_t *attr_level = esp_zb_zcl_get_attribute(ep, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
-            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID);
-        if (attr_level && attr_level->data_p) {
-            uint8_t new_level = *(uint8_t *)attr_level->data_p;
-            if (new_level != state[n].level) {
-                state[n].level = new_level;
-                transition_start(&state[n].level_trans, new_level, g_global_transition_ms);
+    while (light_cmd_pop(&c)) {
+        bool changed = false;
+        if (c.type == LIGHT_CMD_PRESET_RECALL) {
+            changed = apply_preset_recall((uint8_t)c.value, now_us);
+        } else if (c.type == LIGHT_CMD_TIMELINE_LOAD) {
+            changed = apply_timeline_load((uint8_t)c.value, now_us);
+        } else if (c.seg == LIGHT_CMD_ALL_SEGS) {
+            for (int n = 0; n < MAX_SEGMENTS; n++) {
+                changed |= apply_seg_cmd(&c, n, now_us);
             }
+        } else if (c.seg < MAX_SEGMENTS) {
+            changed = apply_seg_cmd(&c, c.seg, now_us);
         }
+        light_cmd_note_applied(changed);
+        dirty |= changed;
+    }
 
-        /* Always sync color_mode from ZCL — prevents mode getting stuck when
-         * a group command changes the mode without changing the value */
-        state[n].color_mode = zcl_mode;
-
-        /* Poll Enhanced Hue in color mode (0), CT in white mode (2) */
-        if (zcl_mode == 0) {
-            /* Read enhanced hue (16-bit, 0-65535 maps to 0-360°) */
-            esp_zb_zcl_attr_t *attr_hue = esp_zb_zcl_get_attribute(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
-                ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID);
-            if (attr_hue && attr_hue->data_p) {
-                uint16_t enh_hue = *(uint16_t *)attr_hue->data_p;
-                if (enh_hue != s_last_enh_hue[n]) {
-                    s_last_enh_hue[n] = enh_hue;
-                    state[n].hue = (uint16_t)((uint32_t)enh_hue * 360 / 65535);
-                    transition_start(&state[n].hue_trans, state[n].hue, 0);
-                }
-            }
+    if (dirty) schedule_save();
+    return dirty;
+}
 
-            /* Read saturation */
-            esp_zb_zcl_attr_t *attr_sat = esp_zb_zcl_get_attribute(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
-                ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID);
-            if (attr_sat && attr_sat->data_p) {
-                uint8_t new_sat = *(uint8_t *)attr_sat->data_p;
-                if (new_sat != s_last_sat[n]) {
-                    s_last_sat[n] = new_sat;
-                    state[n].saturation = new_sat;
-                    transition_start(&state[n].sat_trans, new_sat, 0);
-                }
-            }
-        } else if (zcl_mode == 2) {
-            /* CT (white) mode - poll color temperature */
-            esp_zb_zcl_attr_t *attr_ct = esp_zb_zcl_get_attribute(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
-                ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID);
-            if (attr_ct && attr_ct->data_p) {
-                uint16_t new_ct = *(uint16_t *)attr_ct->data_p;
-                if (new_ct != s_last_ct[n]) {
-                    s_last_ct[n] = new_ct;
-                    state[n].color_temp = new_ct;
-                    transition_start(&state[n].ct_trans, new_ct, g_global_transition_ms);
-                }
-            }
+/* ================================================================== */
+/*  Render Task (200Hz, fixed deadline, sleeps when idle)             */
+/* ================================================================== */
+
+static void render_task(void *arg)
+{
+    (void)arg;
+    TickType_t last_wake = xTaskGetTickCount();
+    int64_t deadline_us = esp_timer_get_time() + RENDER_PERIOD_US;
+    bool busy = true;   /* Always render the first frame */
+
+    while (1) {
+        int64_t now;
+        if (busy) {
+            vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(RENDER_PERIOD_MS));
+
+            now = esp_timer_get_time();
+            int64_t late = now - deadline_us;
+            frame_jitter_record(&s_perf.jitter, late > 0 ? (uint32_t)late : 0);
+            deadline_us += RENDER_PERIOD_US;
+
+            /* Change requests are coalesced into this frame */
+            ulTaskNotifyTake(pdTRUE, 0);
+        } else {
+            /* Scene is static: sleep until a command or update request
+             * arrives, then render straight away and resume the cadence */
+            s_render_idle = true;
+            s_perf.idle_entries++;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            s_render_idle = false;
+
+            now = esp_timer_get_time();
+            last_wake   = xTaskGetTickCount();
+            deadline_us = now + RENDER_PERIOD_US;
+        }
+
+        bool changed = apply_light_cmds(now);
+        /* All transitions start and are evaluated at this frame's timestamp;
+         * one that ends here is rendered with its final value and then goes
+         * quiet. The segment and gradient batches are one loop each.
+         * Timelines sample last so their values override the batch on the
+         * channels they drive. */
+        bool animating = transition_batch_sample(segment_trans_get(), now);
+        transition_batch_t *grad_trans = segment_grad_trans_get();
+        animating |= transition_batch_sample(&grad_trans[GRAD_TRANS_HUE], now);
+        animating |= transition_batch_sample(&grad_trans[GRAD_TRANS_SAT], now);
+        bool settled = false;
+        animating |= timeline_player_sample(now, &settled);
+        if (settled) {
+            /* A one-shot timeline left its last value in segment state */
+            schedule_save();
+            schedule_zcl_sync();
+        }
+        effect_engine_advance(segment_effect_get(), now);
+        bool effects = false;
+        bool pending = update_leds(&effects);
+        busy = changed || animating || effects || pending;
+
+        uint32_t took = (uint32_t)(esp_timer_get_time() - now);
+        if (took > s_perf.render_max_us) s_perf.render_max_us = took;
+        s_perf.frames++;
+
+        /* A long frame (e.g. a streamed strip) must not be followed by a
+         * burst of catch-up frames: restart the cadence from now */
+        if (esp_timer_get_time() >= deadline_us) {
+            s_perf.overruns++;
+            last_wake   = xTaskGetTickCount();
+            deadline_us = esp_timer_get_time() + RENDER_PERIOD_US;
         }
     }
+}
 
-    /* EP9 "all segments" master — poll HS/CT and propagate to all active segments.
-     * On/off and level are handled via SET_ATTR_VALUE_CB_ID in zigbee_attr_handler.c. */
-    {
-        uint8_t ep_all = ZB_ALL_EP;
-
-        esp_zb_zcl_attr_t *attr_mode_all = esp_zb_zcl_get_attribute(ep_all,
-            ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-            ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID);
-        uint8_t zcl_mode_all = (attr_mode_all && attr_mode_all->data_p)
-                               ? *(uint8_t *)attr_mode_all->data_p : 0;
-
-        if (zcl_mode_all == 0) {
-            esp_zb_zcl_attr_t *attr_hue = esp_zb_zcl_get_attribute(ep_all,
-                ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID);
-            if (attr_hue && attr_hue->data_p) {
-                uint16_t enh_hue = *(uint16_t *)attr_hue->data_p;
-                if (enh_hue != s_last_enh_hue[MAX_SEGMENTS]) {
-                    s_last_enh_hue[MAX_SEGMENTS] = enh_hue;
-                    uint16_t hue = (uint16_t)((uint32_t)enh_hue * 360 / 65535);
-                    uint8_t mode0 = 0;
-                    for (int i = 0; i < MAX_SEGMENTS; i++) {
-                        state[i].hue = hue;
-                        state[i].color_mode = 0;
-                        transition_start(&state[i].hue_trans, hue, 0);
-                        /* Sync segment EP ZCL color_mode so render loop doesn't
-                         * revert back to CT on next tick. */
-                        uint8_t ep_i = (uint8_t)(ZB_SEGMENT_EP_BASE + i);
-                        esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
-                            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                            ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, &mode0, false);
-                    }
-                }
-            }
+void led_renderer_get_perf(led_renderer_perf_t *out)
+{
+    /* Snapshot: the render task keeps recording */
+    frame_jitter_t jitter = s_perf.jitter;
 
-            esp_zb_zcl_attr_t *attr_sat = esp_zb_zcl_get_attribute(ep_all,
-                ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID);
-            if (attr_sat && attr_sat->data_p) {
-                uint8_t new_sat = *(uint8_t *)attr_sat->data_p;
-                if (new_sat != s_last_sat[MAX_SEGMENTS]) {
-                    s_last_sat[MAX_SEGMENTS] = new_sat;
-                    for (int i = 0; i < MAX_SEGMENTS; i++) {
-                        state[i].saturation = new_sat;
-                        transition_start(&state[i].sat_trans, new_sat, 0);
-                    }
-                }
-            }
-        } else if (zcl_mode_all == 2) {
-            esp_zb_zcl_attr_t *attr_ct = esp_zb_zcl_get_attribute(ep_all,
-                ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID);
-            if (attr_ct && attr_ct->data_p) {
-                uint16_t new_ct = *(uint16_t *)attr_ct->data_p;
-                if (new_ct != s_last_ct[MAX_SEGMENTS]) {
-                    s_last_ct[MAX_SEGMENTS] = new_ct;
-                    uint8_t mode2 = 2;
-                    for (int i = 0; i < MAX_SEGMENTS; i++) {
-                        state[i].color_temp = new_ct;
-                        state[i].color_mode = 2;
-                        transition_start(&state[i].ct_trans, new_ct, g_global_transition_ms);
-                        /* Sync segment EP ZCL stores so the per-segment render loop
-                         * polling doesn't revert color_mode back to HS next tick. */
-                        uint8_t ep_i = (uint8_t)(ZB_SEGMENT_EP_BASE + i);
-                        esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
-                            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                            ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, &mode2, false);
-                        esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
-                            ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
-                            ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID, &new_ct, false);
-                    }
-                }
+    out->frames         = s_perf.frames;
+    out->overruns       = s_perf.overruns;
+    out->render_max_us  = s_perf.render_max_us;
+    out->jitter_p50_us  = frame_jitter_percentile(&jitter, 500);
+    out->jitter_p99_us  = frame_jitter_percentile(&jitter, 990);
+    out->jitter_p999_us = frame_jitter_percentile(&jitter, 999);
+    out->jitter_max_us  = jitter.max_us;
+    out->zb_poll_max_us = s_perf.poll_max_us;
+    out->zb_poll_avg_us = s_perf.polls ? (uint32_t)(s_perf.poll_total_us / s_perf.polls) : 0;
+    out->zb_poll_max_cycles = s_perf.poll_max_cycles;
+    out->zb_poll_avg_cycles = s_perf.polls ? (uint32_t)(s_perf.poll_total_cycles / s_perf.polls) : 0;
+    out->zb_lookup_cycles   = s_zcl_lookup_cycles;
+    out->idle_entries       = s_perf.idle_entries;
+    out->color_hits         = s_perf.color_hits;
+    out->color_misses       = s_perf.color_misses;
+    out->fx_max_us          = s_perf.fx_max_us;
+    out->fx_leds            = s_perf.fx_leds;
+    out->stack_free         = s_render_task ? (uint32_t)uxTaskGetStackHighWaterMark(s_render_task) : 0;
+    out->idle               = s_render_idle;
+}
+
+void led_renderer_reset_perf(void)
+{
+    memset(&s_perf, 0, sizeof(s_perf));
+}
+
+/* ================================================================== */
+/*  ZCL Poll Loop (200Hz via scheduler alarm, Zigbee task)            */
+/* ================================================================== */
+
+/* Zigbee task producer. The s_zcl_seen shadows only advance once a post is
+ * accepted, so a change dropped on a full ring is posted again next poll. */
+static bool post_poll_cmd(light_cmd_type_t type, int seg, uint16_t value, uint16_t ms)
+{
+    if (!light_cmd_post_ex(LIGHT_CMD_SRC_ZIGBEE, type, (uint8_t)seg, value, ms,
+                           LIGHT_CMD_FLAG_FOLLOW)) return false;
+    led_renderer_request_update();
+    return true;
+}
+
+static const void *zcl_attr_data(uint8_t ep, uint16_t cluster, uint16_t attr_id)
+{
+    esp_zb_zcl_attr_t *attr = esp_zb_zcl_get_attribute(ep, cluster,
+        ESP_ZB_ZCL_CLUSTER_SERVER_ROLE, attr_id);
+    return attr ? attr->data_p : NULL;
+}
+
+/* One lookup pass over every polled attribute. Before pointers were cached
+ * the poll did this (~30 lookups) every tick; its cost is kept for `led perf`. */
+static void resolve_zcl_attrs(void)
+{
+    const segment_light_t *state = segment_state_get();
+    esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+
+    for (int n = 0; n < ZCL_POLL_EPS; n++) {
+        uint8_t ep = (uint8_t)(ZB_SEGMENT_EP_BASE + n);
+        zcl_attr_ptrs_t *p = &s_zcl_ptrs[n];
+        p->mode    = zcl_attr_data(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
+                                   ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID);
+        p->level   = (n < MAX_SEGMENTS)
+                   ? zcl_attr_data(ep, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                                   ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID)
+                   : NULL;
+        p->enh_hue = zcl_attr_data(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
+                                   ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID);
+        p->sat     = zcl_attr_data(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
+                                   ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID);
+        p->ct      = zcl_attr_data(ep, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
+                                   ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID);
+    }
+    s_zcl_lookup_cycles = esp_cpu_get_cycle_count() - c0;
+
+    /* Level is compared against segment state on the first poll; the mode
+     * sentinel forces the ZCL color mode into segment state once. */
+    memset(s_zcl_seen, 0, sizeof(s_zcl_seen));
+    for (int n = 0; n < ZCL_POLL_EPS; n++) {
+        s_zcl_seen[n].level = (n < MAX_SEGMENTS) ? state[n].level : 0;
+        s_zcl_seen[n].mode  = (n < MAX_SEGMENTS) ? 0xFF : 0;
+    }
+    s_zcl_ptrs_ready = true;
+}
+
+static void read_zcl_snap(const zcl_attr_ptrs_t *p, const zcl_snap_t *seen, zcl_snap_t *out)
+{
+    *out = *seen;
+    out->mode = p->mode ? *p->mode : 0;
+    if (p->level) out->level = *p->level;
+    if (out->mode == 0) {
+        if (p->enh_hue) out->enh_hue = *p->enh_hue;
+        if (p->sat)     out->sat     = *p->sat;
+    } else if (out->mode == 2) {
+        if (p->ct)      out->ct      = *p->ct;
+    }
+}
+
+/* Segment endpoint changed: post what differs from the last accepted value */
+static void poll_segment_changes(int n, const zcl_snap_t *cur)
+{
+    zcl_snap_t *seen = &s_zcl_seen[n];
+
+    /* Brightness (level) - applies to all modes */
+    if (cur->level != seen->level &&
+        post_poll_cmd(LIGHT_CMD_LEVEL, n, cur->level, g_global_transition_ms)) {
+        seen->level = cur->level;
+    }
+
+    /* Sync color_mode from ZCL — prevents mode getting stuck when a group
+     * command changes the mode without changing the value */
+    if (cur->mode != seen->mode &&
+        post_poll_cmd(LIGHT_CMD_COLOR_MODE, n, cur->mode, 0)) {
+        seen->mode = cur->mode;
+    }
+
+    /* Enhanced Hue in color mode (0), CT in white mode (2) */
+    if (cur->enh_hue != seen->enh_hue &&
+        post_poll_cmd(LIGHT_CMD_HUE, n, (uint16_t)((uint32_t)cur->enh_hue * 360 / 65535), 0)) {
+        seen->enh_hue = cur->enh_hue;
+    }
+    if (cur->sat != seen->sat &&
+        post_poll_cmd(LIGHT_CMD_SATURATION, n, cur->sat, 0)) {
+        seen->sat = cur->sat;
+    }
+    if (cur->ct != seen->ct &&
+        post_poll_cmd(LIGHT_CMD_COLOR_TEMP, n, cur->ct, g_global_transition_ms)) {
+        seen->ct = cur->ct;
+    }
+}
+
+/* EP9 "all segments" master changed: propagate HS/CT to all segments.
+ * On/off and level are handled via SET_ATTR_VALUE_CB_ID in zigbee_attr_handler.c. */
+static void poll_all_changes(const zcl_snap_t *cur)
+{
+    zcl_snap_t *seen = &s_zcl_seen[MAX_SEGMENTS];
+    seen->mode = cur->mode;
+
+    if (cur->enh_hue != seen->enh_hue &&
+        post_poll_cmd(LIGHT_CMD_HUE, LIGHT_CMD_ALL_SEGS,
+                      (uint16_t)((uint32_t)cur->enh_hue * 360 / 65535), 0)) {
+        seen->enh_hue = cur->enh_hue;
+        uint8_t mode0 = 0;
+        for (int i = 0; i < MAX_SEGMENTS; i++) {
+            /* Sync segment EP ZCL color_mode so the poll doesn't
+             * revert back to CT on next tick. */
+            uint8_t ep_i = (uint8_t)(ZB_SEGMENT_EP_BASE + i);
+            esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
+                ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, &mode0, false);
+        }
+    }
+
+    if (cur->sat != seen->sat &&
+        post_poll_cmd(LIGHT_CMD_SATURATION, LIGHT_CMD_ALL_SEGS, cur->sat, 0)) {
+        seen->sat = cur->sat;
+    }
+
+    if (cur->ct != seen->ct &&
+        post_poll_cmd(LIGHT_CMD_COLOR_TEMP, LIGHT_CMD_ALL_SEGS, cur->ct,
+                      g_global_transition_ms)) {
+        seen->ct = cur->ct;
+        uint16_t new_ct = cur->ct;
+        uint8_t mode2 = 2;
+        for (int i = 0; i < MAX_SEGMENTS; i++) {
+            /* Sync segment EP ZCL stores so the per-segment polling
+             * doesn't revert color_mode back to HS next tick. */
+            uint8_t ep_i = (uint8_t)(ZB_SEGMENT_EP_BASE + i);
+            esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
+                ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, &mode2, false);
+            esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
+                ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
+                ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID, &new_ct, false);
+        }
+    }
+}
+
+static void zcl_poll_cb(uint8_t param)
+{
+    int64_t t0 = esp_timer_get_time();
+    esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+
+    if (!s_zcl_ptrs_ready) resolve_zcl_attrs();
+
+    if (atomic_exchange(&s_zcl_sync_pending, false)) {
+        ESP_LOGI(TAG, "Deferred ZCL sync");
+        sync_zcl_from_state();
+    }
+
+    /* Snapshot attributes the SDK updates internally (no callbacks), then
+     * compare against the last accepted values in one pass. State is only
+     * read here; changes are posted to the render task. */
+    zcl_snap_t cur[ZCL_POLL_EPS];
+    for (int n = 0; n < ZCL_POLL_EPS; n++) {
+        read_zcl_snap(&s_zcl_ptrs[n], &s_zcl_seen[n], &cur[n]);
+    }
+    if (memcmp(cur, s_zcl_seen, sizeof(cur)) != 0) {
+        s_poll_last_change_us = t0;
+        for (int n = 0; n < MAX_SEGMENTS; n++) {
+            if (memcmp(&cur[n], &s_zcl_seen[n], sizeof(zcl_snap_t)) != 0) {
+                poll_segment_changes(n, &cur[n]);
             }
         }
+        if (memcmp(&cur[MAX_SEGMENTS], &s_zcl_seen[MAX_SEGMENTS], sizeof(zcl_snap_t)) != 0) {
+            poll_all_changes(&cur[MAX_SEGMENTS]);
+        }
     }
 
-    /* Update min_free_heap ZCL attr every ~60s (12000 * 5ms = 60s) */
-    static uint16_t s_heap_tick = 0;
-    if (++s_heap_tick >= 12000) {
-        s_heap_tick = 0;
+    /* Update min_free_heap ZCL attr every ~60s */
+    static int64_t s_heap_next_us = 0;
+    if (t0 >= s_heap_next_us) {
+        s_heap_next_us = t0 + HEAP_ATTR_PERIOD_US;
         uint32_t heap = esp_get_minimum_free_heap_size();
         esp_zb_zcl_set_attribute_val(ZB_SEGMENT_EP_BASE,
             ZB_CLUSTER_DEVICE_CONFIG, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
             ZB_ATTR_MIN_FREE_HEAP, &heap, false);
     }
 
-    update_leds();
-    esp_zb_scheduler_alarm(led_render_cb, 0, 5);
+    /* Time spent in the Zigbee task this tick */
+    uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+    uint32_t took = (uint32_t)(esp_timer_get_time() - t0);
+    if (took > s_perf.poll_max_us) s_perf.poll_max_us = took;
+    if (cycles > s_perf.poll_max_cycles) s_perf.poll_max_cycles = cycles;
+    s_perf.poll_total_us += took;
+    s_perf.poll_total_cycles += cycles;
+    s_perf.polls++;
+
+    /* Full rate while anything moves (SDK-driven level/color moves update
+     * the attributes step by step); slow housekeeping rate once settled */
+    bool settled = s_render_idle && (t0 - s_poll_last_change_us) >= ZCL_POLL_HOLD_US;
+    esp_zb_scheduler_alarm(zcl_poll_cb, 0, settled ? ZCL_POLL_IDLE_MS : ZCL_POLL_PERIOD_MS);
 }
 
 void led_renderer_start(void)
 {
-    ESP_LOGI(TAG, "Starting LED render/poll loop at 200Hz");
-    esp_zb_scheduler_alarm(led_render_cb, 0, 5);
+    ESP_LOGI(TAG, "Starting LED render task and ZCL poll loop at 200Hz");
+    if (s_render_task == NULL) {
+        BaseType_t ok = xTaskCreate(render_task, "led_render", RENDER_TASK_STACK, NULL,
+                                    RENDER_TASK_PRIORITY, &s_render_task);
+        if (ok != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create render task");
+            s_render_task = NULL;
+        }
+    }
+    esp_zb_scheduler_alarm(zcl_poll_cb, 0, ZCL_POLL_PERIOD_MS);
 }
@@ -5,12 +5,44 @@
  * Handles the 200Hz render/poll loop for segment state and physical LED updates.
  * Polls Zigbee ZCL attributes for HS/CT color changes (SDK handles internally).
  * Manages ZCL attribute store synchronization after state changes.
+ *
+ * Rendering runs in a dedicated FreeRTOS task on a fixed 5ms deadline; the
+ * Zigbee task only polls attributes and posts state changes.
  */
 
 #ifndef LED_RENDERER_H
 #define LED_RENDERER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Render loop timing (see `led perf`)
+ *
+ * Jitter is how late the render task woke relative to its frame deadline;
+ * percentiles are histogram bin upper bounds (50 us resolution).
+ */
+typedef struct {
+    uint32_t frames;          /**< Frames rendered */
+    uint32_t overruns;        /**< Frames that ran past the next deadline */
+    uint32_t render_max_us;   /**< Longest frame compose + queue */
+    uint32_t jitter_p50_us;
+    uint32_t jitter_p99_us;
+    uint32_t jitter_p999_us;
+    uint32_t jitter_max_us;
+    uint32_t zb_poll_max_us;  /**< Longest ZCL poll tick in the Zigbee task */
+    uint32_t zb_poll_avg_us;
+    uint32_t zb_poll_max_cycles;
+    uint32_t zb_poll_avg_cycles;
+    uint32_t zb_lookup_cycles;  /**< One esp_zb_zcl_get_attribute() pass over all polled attrs */
+    uint32_t idle_entries;      /**< Times the render task went to sleep on a static scene */
+    uint32_t color_hits;        /**< Segment colours reused: inputs unchanged since last frame */
+    uint32_t color_misses;      /**< Segment colours converted from HSV/CT */
+    uint32_t fx_max_us;         /**< Longest per-pixel pass (effects, blending) in one frame */
+    uint32_t fx_leds;           /**< LEDs rendered per pixel last frame */
+    uint32_t stack_free;        /**< Render task stack never used so far, bytes */
+    bool     idle;              /**< Render task currently asleep */
+} led_renderer_perf_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,10 +77,11 @@ void led_renderer_set_global_transition_ms(uint16_t ms);
 void schedule_save(void);
 
 /**
- * @brief Schedule ZCL attribute store sync from in-memory state (100ms deferred)
+ * @brief Schedule ZCL attribute store sync from in-memory state
  *
- * Used after preset recall to avoid Zigbee stack assertion from immediate sync.
- * Defers sync operation to Zigbee task context via scheduler alarm.
+ * Used after preset recall, timeline end and similar changes made outside
+ * the Zigbee task (render task, CLI). Only sets a flag: the next ZCL poll
+ * tick runs sync_zcl_from_state() in the Zigbee task. Safe from any task.
  */
 void schedule_zcl_sync(void);
 
@@ -62,13 +95,13 @@ void schedule_zcl_sync(void);
 void sync_zcl_from_state(void);
 
 /**
- * @brief Update physical LEDs from current segment state and transition values
+ * @brief Notify the render task that segment state or geometry changed
  *
- * Renders all segments to LED strip buffers (segment 1 = base layer, 8 = top).
- * Reads interpolated values from transition engine for smooth animations.
- * Called at 200Hz by render loop.
+ * Safe from any task. Requests are coalesced into the next frame; the
+ * frame itself is composed and sent by the render task. Also wakes the
+ * render task when it is asleep on a static scene.
  */
-void update_leds(void);
+void led_renderer_request_update(void);
 
 /**
  * @brief Deferred LED update callback for scheduler alarm
@@ -91,14 +124,26 @@ void restore_leds_cb(uint8_t param);
 void led_renderer_recalc_power_scale(void);
 
 /**
- * @brief Start 200Hz LED render/poll loop
+ * @brief Start 200Hz LED render task and ZCL poll loop
  *
- * Starts continuous 5ms scheduler alarm for segment polling and LED rendering.
- * Polls ZCL attributes for HS/CT changes (SDK handles commands internally).
- * Must be called after Zigbee network join.
+ * Creates the render task (5ms frame deadline while anything changes, asleep
+ * otherwise) and starts the scheduler alarm that polls ZCL attributes for
+ * HS/CT changes (SDK handles commands internally): every 5ms while active,
+ * every 25ms once the scene has settled. Must be called from the Zigbee task
+ * after stack init.
  */
 void led_renderer_start(void);
 
+/**
+ * @brief Copy render loop timing counters
+ */
+void led_renderer_get_perf(led_renderer_perf_t *out);
+
+/**
+ * @brief Reset render loop timing counters
+ */
+void led_renderer_reset_perf(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,96 @@
+/**
+ * @file light_cmd.c
+ * @brief Lock-free SPSC command rings (one per producer task)
+ *
+ * head is written only by the producer and tail only by the consumer. The
+ * producer publishes an entry with a release store of head; the consumer
+ * frees it with a release store of tail. Indices run free and are masked on
+ * access, so head - tail is the fill level.
+ */
+
+#include "light_cmd.h"
+#include <stdatomic.h>
+#include <string.h>
+
+_Static_assert((LIGHT_CMD_QUEUE_LEN & (LIGHT_CMD_QUEUE_LEN - 1)) == 0,
+               "LIGHT_CMD_QUEUE_LEN must be a power of 2");
+
+typedef struct {
+    light_cmd_t           buf[LIGHT_CMD_QUEUE_LEN];
+    atomic_uint           head;     /* Next slot to write (producer) */
+    atomic_uint           tail;     /* Next slot to read (consumer) */
+    light_cmd_src_stats_t stats;    /* Producer-owned */
+} cmd_ring_t;
+
+static cmd_ring_t s_rings[LIGHT_CMD_SRC_COUNT];
+
+/* Consumer-owned */
+static uint32_t s_applied;
+static uint32_t s_deduped;
+
+bool light_cmd_post(light_cmd_src_t src, light_cmd_type_t type, uint8_t seg,
+                    uint16_t value, uint16_t transition_ms)
+{
+    return light_cmd_post_ex(src, type, seg, value, transition_ms, 0);
+}
+
+bool light_cmd_post_ex(light_cmd_src_t src, light_cmd_type_t type, uint8_t seg,
+                       uint16_t value, uint16_t transition_ms, uint8_t flags)
+{
+    if (src >= LIGHT_CMD_SRC_COUNT) return false;
+    cmd_ring_t *r = &s_rings[src];
+
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    unsigned used = head - tail;
+    if (used >= LIGHT_CMD_QUEUE_LEN) {
+        r->stats.dropped++;
+        return false;
+    }
+
+    light_cmd_t *c = &r->buf[head & (LIGHT_CMD_QUEUE_LEN - 1)];
+    c->type          = (uint8_t)type;
+    c->seg           = seg;
+    c->value         = value;
+    c->transition_ms = transition_ms;
+    c->flags         = flags;
+    c->reserved      = 0;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+
+    r->stats.posted++;
+    if (used + 1 > r->stats.high_water) r->stats.high_water = used + 1;
+    return true;
+}
+
+bool light_cmd_pop(light_cmd_t *out)
+{
+    for (int i = 0; i < LIGHT_CMD_SRC_COUNT; i++) {
+        cmd_ring_t *r = &s_rings[i];
+        unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (head == tail) continue;
+
+        *out = r->buf[tail & (LIGHT_CMD_QUEUE_LEN - 1)];
+        atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+void light_cmd_note_applied(bool changed)
+{
+    if (changed) {
+        s_applied++;
+    } else {
+        s_deduped++;
+    }
+}
+
+void light_cmd_get_stats(light_cmd_stats_t *out)
+{
+    for (int i = 0; i < LIGHT_CMD_SRC_COUNT; i++) {
+        out->src[i] = s_rings[i].stats;
+    }
+    out->applied = s_applied;
+    out->deduped = s_deduped;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file light_cmd.h
+ * @brief Typed light commands from Zigbee/CLI to the render task
+ *
+ * Segment state (segment_light_t, segment_geom_t and their transitions) is
+ * owned by the render task. Other tasks never write it; they post commands
+ * here and the render task applies them at the start of the next frame.
+ *
+ * Each producer task has its own single-producer/single-consumer ring, so
+ * posting and draining are lock-free. A full ring drops the new command and
+ * counts it as an overflow.
+ */
+
+#ifndef LIGHT_CMD_H
+#define LIGHT_CMD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIGHT_CMD_QUEUE_LEN  128          /* Entries per producer (power of 2) */
+#define LIGHT_CMD_ALL_SEGS   0xFF         /* seg value: apply to every segment */
+
+/* Gradient stop commands carry the stop index in the top 4 bits of value */
+#define LIGHT_CMD_GRAD_VALUE(stop, v)  ((uint16_t)(((stop) << 12) | ((v) & 0x0FFF)))
+#define LIGHT_CMD_GRAD_STOP(value)     ((uint8_t)((value) >> 12))
+#define LIGHT_CMD_GRAD_ARG(value)      ((uint16_t)((value) & 0x0FFF))
+
+/* flags */
+#define LIGHT_CMD_FLAG_FOLLOW  0x01       /* One step of an attribute stream: follow it
+                                             with transition_ms of smoothing */
+
+/**
+ * @brief Producer of a command (one ring each)
+ */
+typedef enum {
+    LIGHT_CMD_SRC_ZIGBEE = 0,   /**< Zigbee task: attribute handlers and ZCL poll */
+    LIGHT_CMD_SRC_CLI    = 1,   /**< CLI task */
+    LIGHT_CMD_SRC_COUNT
+} light_cmd_src_t;
+
+typedef enum {
+    LIGHT_CMD_ON_OFF,           /**< value: 0/1, fades level over transition_ms */
+    LIGHT_CMD_LEVEL,            /**< value: 0-254 */
+    LIGHT_CMD_HUE,              /**< value: 0-360 degrees, shortest arc */
+    LIGHT_CMD_SATURATION,       /**< value: 0-254 */
+    LIGHT_CMD_COLOR_TEMP,       /**< value: mireds, switches to CT mode */
+    LIGHT_CMD_COLOR_MODE,       /**< value: 0=Enhanced Hue, 2=CT */
+    LIGHT_CMD_STARTUP_ON_OFF,   /**< value: ZCL StartUpOnOff */
+    LIGHT_CMD_GEOM_START,       /**< value: first LED index */
+    LIGHT_CMD_GEOM_COUNT,       /**< value: LED count, 0 = disabled */
+    LIGHT_CMD_GEOM_STRIP,       /**< value: strip index 0/1 */
+    LIGHT_CMD_PRESET_RECALL,    /**< value: preset slot 0-7 (seg ignored) */
+    LIGHT_CMD_TIMELINE_LOAD,    /**< value: timeline upload slot (seg ignored) */
+    LIGHT_CMD_TIMELINE_STOP,    /**< value: channel mask, bit per segment_channel_t */
+    LIGHT_CMD_EFFECT,           /**< value: effect_id_t */
+    LIGHT_CMD_EFFECT_SPEED,     /**< value: 0-255 */
+    LIGHT_CMD_EFFECT_INTENSITY, /**< value: 0-255 */
+    LIGHT_CMD_BLEND,            /**< value: blend_mode_t */
+    LIGHT_CMD_BLEND_OPACITY,    /**< value: 0-255 */
+    LIGHT_CMD_GRAD_STOPS,       /**< value: 0 = off, 2-GRADIENT_MAX_STOPS */
+    LIGHT_CMD_GRAD_SPACE,       /**< value: gradient_space_t */
+    LIGHT_CMD_GRAD_POS,         /**< value: LIGHT_CMD_GRAD_VALUE(stop, 0-255) */
+    LIGHT_CMD_GRAD_HUE,         /**< value: LIGHT_CMD_GRAD_VALUE(stop, 0-359), fades */
+    LIGHT_CMD_GRAD_SAT,         /**< value: LIGHT_CMD_GRAD_VALUE(stop, 0-254), fades */
+} light_cmd_type_t;
+
+/**
+ * @brief One light command (8 bytes)
+ */
+typedef struct {
+    uint8_t  type;              /**< light_cmd_type_t */
+    uint8_t  seg;               /**< Segment index 0-7 or LIGHT_CMD_ALL_SEGS */
+    uint16_t value;
+    uint16_t transition_ms;     /**< Fade duration, 0 = instant */
+    uint8_t  flags;             /**< LIGHT_CMD_FLAG_* */
+    uint8_t  reserved;
+} light_cmd_t;
+
+/**
+ * @brief Per-producer queue counters
+ */
+typedef struct {
+    uint32_t posted;            /**< Commands accepted */
+    uint32_t dropped;           /**< Commands lost to a full ring */
+    uint32_t high_water;        /**< Most entries seen queued at once */
+} light_cmd_src_stats_t;
+
+/**
+ * @brief Queue counters (see `led stats`)
+ */
+typedef struct {
+    light_cmd_src_stats_t src[LIGHT_CMD_SRC_COUNT];
+    uint32_t applied;           /**< Commands that changed state */
+    uint32_t deduped;           /**< Commands that matched state already */
+} light_cmd_stats_t;
+
+/**
+ * @brief Post a command from the given producer's task
+ *
+ * Never blocks. Each light_cmd_src_t must only be used from one task.
+ *
+ * @return true if queued, false if the ring was full (command dropped)
+ */
+bool light_cmd_post(light_cmd_src_t src, light_cmd_type_t type, uint8_t seg,
+                    uint16_t value, uint16_t transition_ms);
+
+/**
+ * @brief light_cmd_post() with LIGHT_CMD_FLAG_* flags
+ */
+bool light_cmd_post_ex(light_cmd_src_t src, light_cmd_type_t type, uint8_t seg,
+                       uint16_t value, uint16_t transition_ms, uint8_t flags);
+
+/**
+ * @brief Take the next queued command (render task only)
+ *
+ * Producers are drained in order: all Zigbee commands, then CLI. Within a
+ * producer, commands come out in the order they were posted.
+ *
+ * @return true if a command was written to *out
+ */
+bool light_cmd_pop(light_cmd_t *out);
+
+/**
+ * @brief Record the outcome of an applied command (render task only)
+ */
+void light_cmd_note_applied(bool changed);
+
+/**
+ * @brief Copy queue counters
+ */
+void light_cmd_get_stats(light_cmd_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIGHT_CMD_H */
@@ -10,7 +10,7 @@
 #include "preset_manager.h"
 #include "segment_manager.h"
 #include "led_renderer.h"
-#include "transition_engine.h"
+#include "light_cmd.h"
 #include "zigbee_init.h"
 #include "esp_zigbee_core.h"
 #include "esp_log.h"
@@ -18,10 +18,6 @@
 
 static const char *TAG = "preset_handler";
 
-/* Forward declarations for internal helpers */
-extern void schedule_zcl_sync(void);
-extern uint16_t g_global_transition_ms;
-
 /* Transient storage for save_name (for next save_slot operation) */
 static char s_pending_save_name[PRESET_NAME_MAX + 1] = {0};
 
@@ -75,22 +71,19 @@ esp_err_t handle_recall_slot_write(uint8_t slot)
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Recall preset */
-    esp_err_t err = preset_manager_recall(slot);
+    /* Recall preset: the render task loads it and starts the transitions */
+    bool occupied = false;
+    esp_err_t err = preset_manager_is_slot_occupied(slot, &occupied);
+    if (err == ESP_OK && !occupied) err = ESP_ERR_NOT_FOUND;
     if (err == ESP_OK) {
-        ESP_LOGI(TAG, "Recalled preset from slot %d", slot);
-        /* Start transitions from current engine values to new preset values */
-        segment_light_t *state = segment_state_get();
-        for (int i = 0; i < MAX_SEGMENTS; i++) {
-            transition_start(&state[i].level_trans, state[i].level, g_global_transition_ms);
-            transition_start(&state[i].hue_trans, state[i].hue, 0);  /* Instant - hue wraparound disabled */
-            transition_start(&state[i].sat_trans, state[i].saturation, 0);  /* Instant saturation change */
-            transition_start(&state[i].ct_trans, state[i].color_temp, g_global_transition_ms);
+        if (light_cmd_post(LIGHT_CMD_SRC_ZIGBEE, LIGHT_CMD_PRESET_RECALL, 0, slot, 0)) {
+            ESP_LOGI(TAG, "Recalling preset from slot %d", slot);
+            led_renderer_request_update();
+            update_preset_zcl_attrs();
+        } else {
+            ESP_LOGW(TAG, "Light command queue full, recall of slot %d dropped", slot);
+            err = ESP_ERR_NO_MEM;
         }
-        schedule_save();
-        update_preset_zcl_attrs();
-        /* Defer ZCL sync to avoid stack assertion */
-        schedule_zcl_sync();
     } else if (err == ESP_ERR_NOT_FOUND) {
         ESP_LOGW(TAG, "Slot %d is empty, cannot recall", slot);
     } else {
@@ -190,22 +183,15 @@ esp_err_t handle_deprecated_preset_write(uint16_t attr_id, const void *value)
     name[name_len] = '\0';
 
     if (attr_id == ZB_ATTR_RECALL_PRESET) {
-        if (preset_manager_recall_by_name(name)) {
-            ESP_LOGI(TAG, "Recalled preset '%s' (deprecated API)", name);
-            /* Start transitions to new preset values */
-            segment_light_t *state = segment_state_get();
-            for (int i = 0; i < MAX_SEGMENTS; i++) {
-                transition_start(&state[i].level_trans, state[i].level, g_global_transition_ms);
-                transition_start(&state[i].hue_trans, state[i].hue, 0);  /* Instant - hue wraparound disabled */
-                transition_start(&state[i].sat_trans, state[i].saturation, 0);  /* Instant saturation change */
-                transition_start(&state[i].ct_trans, state[i].color_temp, g_global_transition_ms);
-            }
-            schedule_save();
+        int slot = preset_manager_find_slot(name);
+        if (slot < 0) {
+            ESP_LOGW(TAG, "Preset '%s' not found", name);
+        } else if (light_cmd_post(LIGHT_CMD_SRC_ZIGBEE, LIGHT_CMD_PRESET_RECALL, 0, (uint16_t)slot, 0)) {
+            ESP_LOGI(TAG, "Recalling preset '%s' (deprecated API)", name);
+            led_renderer_request_update();
             update_preset_zcl_attrs();
-            /* Defer ZCL sync to avoid stack assertion */
-            schedule_zcl_sync();
         } else {
-            ESP_LOGW(TAG, "Preset '%s' not found", name);
+            ESP_LOGW(TAG, "Light command queue full, recall of '%s' dropped", name);
         }
     } else if (attr_id == ZB_ATTR_SAVE_PRESET) {
         if (preset_manager_save_by_name(name)) {
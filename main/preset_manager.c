@@ -3,11 +3,16 @@
  * @brief Manage slot-based presets for segment states
  *
  * NVS storage (namespace "led_cfg"):
- *   "prst_0" through "prst_7": blob, each 129 bytes
+ *   "prst_0" through "prst_7": blob, each 98 bytes
  *     - 1 byte:  name length (0-16)
  *     - 16 bytes: name (UTF-8, no null terminator)
- *     - 112 bytes: 8 × segment_light_t (14 bytes each)
- *   "prst_version": u8, version flag (2 = slot-based)
+ *     - 1 byte:  padding
+ *     - 80 bytes: 8 × segment_light_nvs_t (10 bytes each)
+ *   "prst_version": u8, version flag (3 = persisted fields only)
+ *
+ * Version 2 stored raw segment_light_t, transition_t state included (1176
+ * bytes). Those blobs are converted on load and rewritten in the current
+ * format.
  */
 
 #include "preset_manager.h"
@@ -16,27 +21,89 @@
 #include "nvs.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 static const char *TAG = "preset";
 
 #define NVS_NAMESPACE     "led_cfg"
 #define NVS_VERSION_KEY   "prst_version"
 #define PRESET_VERSION_V2 2
-#define PRESET_BLOB_SIZE  (1 + PRESET_NAME_MAX + MAX_SEGMENTS * sizeof(segment_light_t))
+#define PRESET_VERSION_V3 3
+
+/* Version 2 blob layout (RV32 segment_light_t with four transition_t) */
+#define PRESET_V2_BLOB_SIZE   1176
+#define PRESET_V2_SEG_OFFSET  24
+#define PRESET_V2_SEG_SIZE    144
 
 typedef struct {
     uint8_t name_length;
     char name[PRESET_NAME_MAX];
-    segment_light_t segments[MAX_SEGMENTS];
+    segment_light_nvs_t segments[MAX_SEGMENTS];
 } preset_slot_t;
 
+_Static_assert(sizeof(preset_slot_t) != PRESET_V2_BLOB_SIZE,
+               "preset blob sizes must differ to tell formats apart");
+
 static preset_slot_t s_slots[MAX_PRESET_SLOTS];
+static uint8_t       s_v2_slots;   /* Bit per slot loaded from a version 2 blob */
 
 static const char *s_nvs_keys[MAX_PRESET_SLOTS] = {
     "prst_0", "prst_1", "prst_2", "prst_3",
     "prst_4", "prst_5", "prst_6", "prst_7"
 };
 
+/**
+ * @brief Unpack one segment from a version 2 blob (fixed field offsets)
+ */
+static void unpack_v2_segment(const uint8_t *p, segment_light_nvs_t *out)
+{
+    out->on             = p[0] != 0;
+    out->level          = p[1];
+    out->hue            = (uint16_t)(p[2] | (p[3] << 8));
+    out->saturation     = p[4];
+    out->color_mode     = p[5];
+    out->color_temp     = (uint16_t)(p[6] | (p[7] << 8));
+    out->startup_on_off = p[8];
+}
+
+/**
+ * @brief Read one preset blob into s_slots[i], converting version 2 blobs
+ * @return true if a blob of a known format was read
+ */
+static bool load_slot(nvs_handle_t h, int i)
+{
+    size_t sz = 0;
+    if (nvs_get_blob(h, s_nvs_keys[i], NULL, &sz) != ESP_OK) {
+        return false;
+    }
+
+    if (sz == sizeof(preset_slot_t)) {
+        return nvs_get_blob(h, s_nvs_keys[i], &s_slots[i], &sz) == ESP_OK;
+    }
+
+    if (sz != PRESET_V2_BLOB_SIZE) {
+        ESP_LOGW(TAG, "Slot %d: unrecognized format (sz=%zu), ignoring", i, sz);
+        return false;
+    }
+
+    uint8_t *buf = malloc(PRESET_V2_BLOB_SIZE);
+    if (!buf) {
+        return false;
+    }
+    bool ok = (nvs_get_blob(h, s_nvs_keys[i], buf, &sz) == ESP_OK);
+    if (ok) {
+        s_slots[i].name_length = buf[0];
+        memcpy(s_slots[i].name, &buf[1], PRESET_NAME_MAX);
+        for (int n = 0; n < MAX_SEGMENTS; n++) {
+            unpack_v2_segment(buf + PRESET_V2_SEG_OFFSET + n * PRESET_V2_SEG_SIZE,
+                              &s_slots[i].segments[n]);
+        }
+        s_v2_slots |= (uint8_t)(1u << i);
+    }
+    free(buf);
+    return ok;
+}
+
 /**
  * @brief Migrate legacy name-based presets to slot-based with default names
  */
@@ -47,9 +114,7 @@ static esp_err_t migrate_legacy_presets(nvs_handle_t h)
     /* Check if any legacy presets exist */
     int migrated_count = 0;
     for (int i = 0; i < MAX_PRESET_SLOTS; i++) {
-        size_t sz = sizeof(preset_slot_t);
-        esp_err_t err = nvs_get_blob(h, s_nvs_keys[i], &s_slots[i], &sz);
-        if (err == ESP_OK && sz == sizeof(preset_slot_t)) {
+        if (load_slot(h, i)) {
             if (s_slots[i].name_length > 0 && s_slots[i].name_length <= PRESET_NAME_MAX) {
                 ESP_LOGI(TAG, "  Slot %d: preserved existing preset '%.*s'", i,
                          s_slots[i].name_length, s_slots[i].name);
@@ -95,9 +160,32 @@ esp_err_t preset_manager_init(void)
             nvs_close(h);
             return err;
         }
+    } else {
+        /* Version 2 or later, load slots directly */
+        for (int i = 0; i < MAX_PRESET_SLOTS; i++) {
+            if (load_slot(h, i)) {
+                if (s_slots[i].name_length > 0 && s_slots[i].name_length <= PRESET_NAME_MAX) {
+                    ESP_LOGI(TAG, "Loaded slot %d: %.*s%s", i,
+                             s_slots[i].name_length, s_slots[i].name,
+                             (s_v2_slots & (1u << i)) ? " (converted from v2)" : "");
+                } else {
+                    memset(&s_slots[i], 0, sizeof(preset_slot_t));
+                }
+            }
+        }
+    }
 
-        /* Set version flag */
-        err = nvs_set_u8(h, NVS_VERSION_KEY, PRESET_VERSION_V2);
+    if (version < PRESET_VERSION_V3) {
+        /* Rewrite converted slots in the current format, then the flag */
+        err = ESP_OK;
+        for (int i = 0; i < MAX_PRESET_SLOTS && err == ESP_OK; i++) {
+            if ((s_v2_slots & (1u << i)) && s_slots[i].name_length > 0) {
+                err = nvs_set_blob(h, s_nvs_keys[i], &s_slots[i], sizeof(preset_slot_t));
+            }
+        }
+        if (err == ESP_OK) {
+            err = nvs_set_u8(h, NVS_VERSION_KEY, PRESET_VERSION_V3);
+        }
         if (err == ESP_OK) {
             err = nvs_commit(h);
         }
@@ -106,24 +194,10 @@ esp_err_t preset_manager_init(void)
             nvs_close(h);
             return err;
         }
-    } else {
-        /* Version 2, load slots directly */
-        for (int i = 0; i < MAX_PRESET_SLOTS; i++) {
-            size_t sz = sizeof(preset_slot_t);
-            err = nvs_get_blob(h, s_nvs_keys[i], &s_slots[i], &sz);
-            if (err == ESP_OK && sz == sizeof(preset_slot_t)) {
-                if (s_slots[i].name_length > 0 && s_slots[i].name_length <= PRESET_NAME_MAX) {
-                    ESP_LOGI(TAG, "Loaded slot %d: %.*s", i,
-                             s_slots[i].name_length, s_slots[i].name);
-                } else {
-                    memset(&s_slots[i], 0, sizeof(preset_slot_t));
-                }
-            }
-        }
     }
 
     nvs_close(h);
-    ESP_LOGI(TAG, "Preset manager initialized (version %d)", PRESET_VERSION_V2);
+    ESP_LOGI(TAG, "Preset manager initialized (version %d)", PRESET_VERSION_V3);
     return ESP_OK;
 }
 
@@ -159,7 +233,16 @@ esp_err_t preset_manager_save(uint8_t slot, const char *name)
     s_slots[slot].name_length = (uint8_t)len;
     memcpy(s_slots[slot].name, preset_name, len);
     memset(s_slots[slot].name + len, 0, PRESET_NAME_MAX - len); /* Zero-pad unused bytes */
-    memcpy(s_slots[slot].segments, states, sizeof(segment_light_t) * MAX_SEGMENTS);
+    for (int i = 0; i < MAX_SEGMENTS; i++) {
+        segment_light_nvs_t *dst = &s_slots[slot].segments[i];
+        dst->on             = states[i].on;
+        dst->level          = states[i].level;
+        dst->hue            = states[i].hue;
+        dst->saturation     = states[i].saturation;
+        dst->color_mode     = states[i].color_mode;
+        dst->color_temp     = states[i].color_temp;
+        dst->startup_on_off = states[i].startup_on_off;
+    }
 
     /* Write to NVS */
     nvs_handle_t h;
@@ -205,11 +288,17 @@ esp_err_t preset_manager_recall(uint8_t slot)
         return ESP_FAIL;
     }
 
-    /* Copy stored states to segment manager (preserve startup_on_off) */
+    /* Copy stored fields to segment manager. startup_on_off and the running
+     * transitions are left alone; the caller starts transitions to the new
+     * values. */
     for (int i = 0; i < MAX_SEGMENTS; i++) {
-        uint8_t saved_startup = states[i].startup_on_off;
-        memcpy(&states[i], &s_slots[slot].segments[i], sizeof(segment_light_t));
-        states[i].startup_on_off = saved_startup;
+        const segment_light_nvs_t *src = &s_slots[slot].segments[i];
+        states[i].on         = src->on;
+        states[i].level      = src->level;
+        states[i].hue        = src->hue;
+        states[i].saturation = src->saturation;
+        states[i].color_mode = src->color_mode;
+        states[i].color_temp = src->color_temp;
     }
 
     ESP_LOGI(TAG, "Recalled preset '%.*s' from slot %d",
@@ -349,7 +438,7 @@ const char *preset_manager_get_active(void)
  * @param name Preset name to search for
  * @return Slot index (0-7) or -1 if not found
  */
-static int find_slot_by_name(const char *name)
+int preset_manager_find_slot(const char *name)
 {
     if (!name || name[0] == '\0') return -1;
 
@@ -372,7 +461,7 @@ static int find_slot_by_name(const char *name)
  */
 bool preset_manager_recall_by_name(const char *name)
 {
-    int slot = find_slot_by_name(name);
+    int slot = preset_manager_find_slot(name);
     if (slot < 0) {
         return false;
     }
@@ -387,7 +476,7 @@ bool preset_manager_recall_by_name(const char *name)
 bool preset_manager_save_by_name(const char *name)
 {
     /* Try to find existing slot with this name */
-    int slot = find_slot_by_name(name);
+    int slot = preset_manager_find_slot(name);
 
     /* If not found, find first empty slot */
     if (slot < 0) {
@@ -414,7 +503,7 @@ bool preset_manager_save_by_name(const char *name)
  */
 bool preset_manager_delete_by_name(const char *name)
 {
-    int slot = find_slot_by_name(name);
+    int slot = preset_manager_find_slot(name);
     if (slot < 0) {
         return false;
     }
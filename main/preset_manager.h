@@ -3,7 +3,7 @@
  * @brief Manage slot-based presets for segment states
  *
  * Saves/recalls all 8 segment states as slot-based presets. 8 preset slots (0-7).
- * Each preset stores name + 8 segment_light_t structs in NVS.
+ * Each preset stores name + 8 segment_light_nvs_t structs (persisted fields only) in NVS.
  */
 
 #ifndef PRESET_MANAGER_H
@@ -89,6 +89,13 @@ int preset_manager_count(void);
  */
 const char *preset_manager_get_active(void);
 
+/**
+ * @brief Find slot by name (compatibility bridge)
+ * @param name Preset name
+ * @return Slot index (0-7) or -1 if not found
+ */
+int preset_manager_find_slot(const char *name);
+
 /**
  * @brief Recall preset by name (compatibility bridge)
  * @param name Preset name
@@ -26,7 +26,6 @@
  * USAGE EXAMPLES:
  * - In project code:
  *     gpio_set_direction(defaults::LED_STRIP_1_GPIO, GPIO_MODE_OUTPUT);
- *     transition_engine_init(defaults::TRANSITION_ENGINE_UPDATE_RATE_HZ);
  *
  * - Passing to shared components:
  *     BoardLed led(defaults::BOARD_LED_GPIO);
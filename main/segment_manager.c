@@ -7,32 +7,27 @@
 #include "esp_log.h"
 #include "nvs.h"
 #include <string.h>
+#include <stddef.h>
 
 static const char *TAG = "seg_mgr";
 
 #define NVS_NAMESPACE   "led_cfg"
 #define NVS_KEY_GEOM    "seg_geom"
 #define NVS_KEY_STATE   "seg_state"
+#define NVS_KEY_FX      "seg_fx"
+#define NVS_KEY_BLEND   "seg_blend"
+#define NVS_KEY_GRAD    "seg_grad"
 
 static segment_geom_t  s_geom[MAX_SEGMENTS];
 static segment_light_t s_state[MAX_SEGMENTS];
+static segment_effect_t s_fx[MAX_SEGMENTS];
+static segment_blend_t s_blend[MAX_SEGMENTS];
+static segment_gradient_t s_grad[MAX_SEGMENTS];
+static transition_batch_t s_trans;
+static transition_batch_t s_grad_trans[GRAD_TRANS_COUNT];
 
-/**
- * @brief On-disk representation of segment_light_t (fields only, no runtime transition state).
- *
- * The in-memory segment_light_t embeds transition_t fields which must NOT be
- * persisted.  All NVS blobs use this smaller struct so that the on-disk size
- * remains stable across firmware upgrades that change transition_t internals.
- */
-typedef struct {
-    bool     on;
-    uint8_t  level;
-    uint16_t hue;
-    uint8_t  saturation;
-    uint8_t  color_mode;
-    uint16_t color_temp;
-    uint8_t  startup_on_off;
-} segment_light_nvs_t;
+_Static_assert(MAX_SEGMENTS <= TRANSITION_BATCH_MAX_ENTRIES, "one batch entry per segment");
+_Static_assert(GRADIENT_MAX_STOPS <= TRANSITION_BATCH_MAX_CHANNELS, "one batch channel per stop");
 
 void segment_manager_init(uint16_t default_count)
 {
@@ -48,6 +43,13 @@ void segment_manager_init(uint16_t default_count)
         s_state[i].level = 128;
         s_state[i].color_temp = 250;     /* ~4000K neutral */
         s_state[i].startup_on_off = DEFAULT_STARTUP_ON_OFF;
+        s_fx[i] = (segment_effect_t) { .id = 0, .speed = 128, .intensity = 128 };
+        s_blend[i] = (segment_blend_t) { .mode = 0, .opacity = 255 };
+        /* Off, with warm -> cool white ready to be switched on */
+        s_grad[i] = (segment_gradient_t) {
+            .stops = 0, .space = 0,
+            .pos = {0, 85, 170, 255}, .sat = {200, 100, 50, 0}, .hue = {30, 30, 210, 210},
+        };
     }
 }
 
@@ -61,21 +63,61 @@ segment_light_t *segment_state_get(void)
     return s_state;
 }
 
+segment_effect_t *segment_effect_get(void)
+{
+    return s_fx;
+}
+
+segment_blend_t *segment_blend_get(void)
+{
+    return s_blend;
+}
+
+segment_gradient_t *segment_gradient_get(void)
+{
+    return s_grad;
+}
+
+transition_batch_t *segment_trans_get(void)
+{
+    return &s_trans;
+}
+
+transition_batch_t *segment_grad_trans_get(void)
+{
+    return s_grad_trans;
+}
+
 /**
- * @brief Initialise transition current_values from the in-memory state.
+ * @brief Initialise the transition batch from the in-memory state.
  *
- * Must be called after segment_manager_load() so that the transition engine
- * starts from the correct value rather than 0.  Does NOT call
- * transition_register() — that is done in zigbee_handlers.c after the
- * transition engine itself has been initialised.
+ * Must be called after segment_manager_load() so that fades start from the
+ * correct value rather than 0.
  */
 void segment_manager_init_transitions(void)
 {
+    transition_batch_init(&s_trans, MAX_SEGMENTS, SEG_CH_COUNT);
+    /* LEDs are linear in light output; fade level in even steps of lightness */
+    transition_batch_set_channel(&s_trans, SEG_CH_LEVEL, TRANSITION_EASE_PERCEPTUAL, 0);
+    transition_batch_set_channel(&s_trans, SEG_CH_HUE, TRANSITION_EASE_LINEAR, 360);
+
     for (int i = 0; i < MAX_SEGMENTS; i++) {
-        s_state[i].level_trans.current_value = s_state[i].level;
-        s_state[i].hue_trans.current_value   = s_state[i].hue;
-        s_state[i].sat_trans.current_value   = s_state[i].saturation;
-        s_state[i].ct_trans.current_value    = s_state[i].color_temp;
+        transition_batch_jump(&s_trans, i, SEG_CH_LEVEL, s_state[i].level);
+        transition_batch_jump(&s_trans, i, SEG_CH_HUE,   s_state[i].hue);
+        transition_batch_jump(&s_trans, i, SEG_CH_SAT,   s_state[i].saturation);
+        transition_batch_jump(&s_trans, i, SEG_CH_CT,    s_state[i].color_temp);
+    }
+
+    transition_batch_init(&s_grad_trans[GRAD_TRANS_HUE], MAX_SEGMENTS, GRADIENT_MAX_STOPS);
+    transition_batch_init(&s_grad_trans[GRAD_TRANS_SAT], MAX_SEGMENTS, GRADIENT_MAX_STOPS);
+    for (int k = 0; k < GRADIENT_MAX_STOPS; k++) {
+        transition_batch_set_channel(&s_grad_trans[GRAD_TRANS_HUE], k, TRANSITION_EASE_LINEAR, 360);
+    }
+    for (int i = 0; i < MAX_SEGMENTS; i++) {
+        for (int k = 0; k < GRADIENT_MAX_STOPS; k++) {
+            transition_batch_jump(&s_grad_trans[GRAD_TRANS_HUE], i, k, s_grad[i].hue[k]);
+            transition_batch_jump(&s_grad_trans[GRAD_TRANS_SAT], i, k, s_grad[i].sat[k]);
+        }
     }
 }
 
@@ -134,7 +176,7 @@ void segment_manager_load(void)
             uint8_t *p = (uint8_t *)nvs_state;
             for (int i = 0; i < MAX_SEGMENTS; i++) {
                 memcpy(&s_state[i], p + i * SEGMENT_STATE_V1_SIZE,
-                       SEGMENT_STATE_V1_SIZE);
+                       offsetof(segment_light_t, startup_on_off));
                 s_state[i].startup_on_off = DEFAULT_STARTUP_ON_OFF;
             }
             ESP_LOGI(TAG, "Segment state migrated (v1 -> v2)");
@@ -145,6 +187,54 @@ void segment_manager_load(void)
         ESP_LOGW(TAG, "seg_state load error: %s", esp_err_to_name(err));
     }
 
+    /* Effects: absent on builds before effects existed (all solid) */
+    segment_effect_t fx_tmp[MAX_SEGMENTS];
+    sz = sizeof(fx_tmp);
+    err = nvs_get_blob(h, NVS_KEY_FX, fx_tmp, &sz);
+    if (err == ESP_OK) {
+        if (sz == sizeof(s_fx)) {
+            memcpy(s_fx, fx_tmp, sizeof(s_fx));
+            ESP_LOGI(TAG, "Segment effects loaded");
+        } else {
+            ESP_LOGW(TAG, "Segment effect format changed (stored=%zu expected=%zu), using defaults",
+                     sz, sizeof(s_fx));
+        }
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "seg_fx load error: %s", esp_err_to_name(err));
+    }
+
+    /* Blend modes: absent on builds before blending existed (all replace) */
+    segment_blend_t blend_tmp[MAX_SEGMENTS];
+    sz = sizeof(blend_tmp);
+    err = nvs_get_blob(h, NVS_KEY_BLEND, blend_tmp, &sz);
+    if (err == ESP_OK) {
+        if (sz == sizeof(s_blend)) {
+            memcpy(s_blend, blend_tmp, sizeof(s_blend));
+            ESP_LOGI(TAG, "Segment blend modes loaded");
+        } else {
+            ESP_LOGW(TAG, "Segment blend format changed (stored=%zu expected=%zu), using defaults",
+                     sz, sizeof(s_blend));
+        }
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "seg_blend load error: %s", esp_err_to_name(err));
+    }
+
+    /* Gradients: absent on builds before gradients existed (all off) */
+    segment_gradient_t grad_tmp[MAX_SEGMENTS];
+    sz = sizeof(grad_tmp);
+    err = nvs_get_blob(h, NVS_KEY_GRAD, grad_tmp, &sz);
+    if (err == ESP_OK) {
+        if (sz == sizeof(s_grad)) {
+            memcpy(s_grad, grad_tmp, sizeof(s_grad));
+            ESP_LOGI(TAG, "Segment gradients loaded");
+        } else {
+            ESP_LOGW(TAG, "Segment gradient format changed (stored=%zu expected=%zu), using defaults",
+                     sz, sizeof(s_grad));
+        }
+    } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "seg_grad load error: %s", esp_err_to_name(err));
+    }
+
     nvs_close(h);
 }
 
@@ -178,6 +268,21 @@ void segment_manager_save(void)
         ESP_LOGE(TAG, "seg_state save failed: %s", esp_err_to_name(err));
     }
 
+    err = nvs_set_blob(h, NVS_KEY_FX, s_fx, sizeof(s_fx));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "seg_fx save failed: %s", esp_err_to_name(err));
+    }
+
+    err = nvs_set_blob(h, NVS_KEY_BLEND, s_blend, sizeof(s_blend));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "seg_blend save failed: %s", esp_err_to_name(err));
+    }
+
+    err = nvs_set_blob(h, NVS_KEY_GRAD, s_grad, sizeof(s_grad));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "seg_grad save failed: %s", esp_err_to_name(err));
+    }
+
     err = nvs_commit(h);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "NVS commit failed: %s", esp_err_to_name(err));
@@ -13,7 +13,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "board_config.h"
-#include "transition_engine.h"
+#include "transition_batch.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,13 +46,93 @@ typedef struct {
     uint8_t  color_mode;     /* 0=Enhanced Hue, 2=CT */
     uint16_t color_temp;     /* Color temperature in mireds (CT mode) */
     uint8_t  startup_on_off; /* Power-on behavior (ZCL StartUpOnOff) */
-    /* Transition engine instances (not persisted — runtime only) */
-    transition_t level_trans; /* brightness 0-254 */
-    transition_t hue_trans;   /* enhanced hue 0-360 degrees */
-    transition_t sat_trans;   /* saturation 0-254 */
-    transition_t ct_trans;    /* color temp in mireds */
 } segment_light_t;
 
+/**
+ * @brief Pixel effect of a single segment (persisted as "seg_fx" blob)
+ *
+ * id is an effect_id_t (effect_engine.h); 0 shows the solid segment colour.
+ * The effect animates the segment's current colour and brightness.
+ */
+typedef struct {
+    uint8_t id;
+    uint8_t speed;           /* 0 = frozen, 1-255 = 1/64 to ~4 cycles/s */
+    uint8_t intensity;       /* Effect specific, see effect_id_t */
+} segment_effect_t;
+
+/**
+ * @brief How a segment combines with the segments below it (persisted as
+ * "seg_blend" blob)
+ *
+ * mode is a blend_mode_t (blend_engine.h); 0 (replace) covers them.
+ */
+typedef struct {
+    uint8_t mode;
+    uint8_t opacity;         /* 0-255, used by alpha */
+} segment_blend_t;
+
+/* Gradient stops per segment: one transition channel each */
+#define GRADIENT_MAX_STOPS  4
+
+/**
+ * @brief Colour gradient across a segment (persisted as "seg_grad" blob)
+ *
+ * With stops >= 2 the segment shows the stop colours blended along its
+ * LEDs instead of its own hue/saturation; its level and on/off still
+ * apply. space is a gradient_space_t (gradient_engine.h). Stop hue and
+ * saturation animate through segment_grad_trans_get().
+ */
+typedef struct {
+    uint8_t  stops;                      /* 0 = off, 2-GRADIENT_MAX_STOPS */
+    uint8_t  space;                      /* 0 = RGB, 1 = hue */
+    uint8_t  pos[GRADIENT_MAX_STOPS];    /* 0-255 along the segment */
+    uint8_t  sat[GRADIENT_MAX_STOPS];    /* 0-254 */
+    uint16_t hue[GRADIENT_MAX_STOPS];    /* 0-359 degrees */
+} segment_gradient_t;
+
+/**
+ * @brief Gradient transition batches (segment_grad_trans_get())
+ *
+ * In both batches entry n is segment n and channel k is stop k, so all
+ * stops of a segment share one start time and duration.
+ */
+typedef enum {
+    GRAD_TRANS_HUE = 0,     /* degrees 0-359, shortest arc */
+    GRAD_TRANS_SAT,         /* 0-254 */
+    GRAD_TRANS_COUNT
+} segment_grad_trans_t;
+
+/**
+ * @brief Channels of the segment transition batch (segment_trans_get())
+ *
+ * Entry n of the batch is segment n. All four channels of a segment share
+ * one start time and duration.
+ */
+typedef enum {
+    SEG_CH_LEVEL = 0,   /* brightness 0-254, perceptual easing */
+    SEG_CH_HUE,         /* enhanced hue 0-359 degrees, shortest arc */
+    SEG_CH_SAT,         /* saturation 0-254 */
+    SEG_CH_CT,          /* color temp in mireds */
+    SEG_CH_COUNT
+} segment_channel_t;
+
+/**
+ * @brief On-disk representation of segment_light_t.
+ *
+ * All NVS blobs ("seg_state" and presets) use this struct rather than
+ * segment_light_t, so that the on-disk layout stays stable if runtime-only
+ * fields are added to the in-memory state.
+ */
+typedef struct {
+    bool     on;
+    uint8_t  level;
+    uint16_t hue;
+    uint8_t  saturation;
+    uint8_t  color_mode;
+    uint16_t color_temp;
+    uint8_t  startup_on_off;
+} segment_light_nvs_t;
+
 /**
  * @brief Initialise segment manager with defaults
  *
@@ -62,14 +142,18 @@ typedef struct {
 void segment_manager_init(uint16_t default_count);
 
 /**
- * @brief Initialise transition current_values from the NVS-loaded state.
+ * @brief Initialise the segment transition batch from the NVS-loaded state.
  *
- * Call after segment_manager_load() and before registering transitions with
- * the transition engine.  Sets each transition's current_value to match the
- * persisted state so the engine starts from the correct value (not 0).
+ * Call after segment_manager_load(). Configures the channels and sets each
+ * value to the persisted state so fades start from the correct value (not 0).
  */
 void segment_manager_init_transitions(void);
 
+/**
+ * @brief Get the segment transition batch (owned by the render task)
+ */
+transition_batch_t *segment_trans_get(void);
+
 /**
  * @brief Get pointer to geometry array (MAX_SEGMENTS entries)
  */
@@ -80,6 +164,26 @@ segment_geom_t *segment_geom_get(void);
  */
 segment_light_t *segment_state_get(void);
 
+/**
+ * @brief Get pointer to effect array (MAX_SEGMENTS entries)
+ */
+segment_effect_t *segment_effect_get(void);
+
+/**
+ * @brief Get pointer to blend mode array (MAX_SEGMENTS entries)
+ */
+segment_blend_t *segment_blend_get(void);
+
+/**
+ * @brief Get pointer to gradient array (MAX_SEGMENTS entries)
+ */
+segment_gradient_t *segment_gradient_get(void);
+
+/**
+ * @brief Get the gradient stop transitions (GRAD_TRANS_COUNT batches)
+ */
+transition_batch_t *segment_grad_trans_get(void);
+
 /**
  * @brief Load segment state from NVS (call after config_storage_init)
  */
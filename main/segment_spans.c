@@ -0,0 +1,90 @@
+/**
+ * @file segment_spans.c
+ * @brief Segment geometry flattened into non-overlapping spans per strip
+ *
+ * The segment edges on a strip cut it into elementary intervals, and each
+ * interval takes the highest-numbered segment covering it: exactly what
+ * painting the segments in order would leave there. Below a blending
+ * segment the covering segments are collected down to the first opaque
+ * one, which is what shows through. At most 16 edges and
+ * 8 segments per strip, so this runs in a few microseconds, and only when
+ * the geometry changes.
+ */
+
+#include "segment_spans.h"
+#include <string.h>
+
+_Static_assert(MAX_SEGMENTS <= 8, "segment_span_t.layers is a byte");
+
+/* End of a segment, clipped to the uint16_t LED index range */
+static uint16_t seg_end(const segment_geom_t *g)
+{
+    uint32_t end = (uint32_t)g->start + g->count;
+    return end > UINT16_MAX ? UINT16_MAX : (uint16_t)end;
+}
+
+static bool covers(const segment_geom_t *g, uint8_t strip, uint16_t a)
+{
+    return g->count != 0 && g->strip_id == strip &&
+           g->start <= a && a < seg_end(g);
+}
+
+static void build_strip(const segment_geom_t *geom, uint32_t opaque, uint8_t strip,
+                        segment_span_list_t *out, uint32_t *visible)
+{
+    uint16_t edges[2 * MAX_SEGMENTS];
+    int n_edges = 0;
+
+    /* Sorted, unique edges of the segments on this strip */
+    for (int n = 0; n < MAX_SEGMENTS; n++) {
+        if (geom[n].count == 0 || geom[n].strip_id != strip) continue;
+        uint16_t pts[2] = { geom[n].start, seg_end(&geom[n]) };
+        for (int p = 0; p < 2; p++) {
+            int i = n_edges;
+            while (i > 0 && edges[i - 1] > pts[p]) i--;
+            if (i > 0 && edges[i - 1] == pts[p]) continue;
+            memmove(&edges[i + 1], &edges[i], (n_edges - i) * sizeof(edges[0]));
+            edges[i] = pts[p];
+            n_edges++;
+        }
+    }
+
+    out->count = 0;
+    for (int k = 0; k + 1 < n_edges; k++) {
+        uint16_t a = edges[k];
+        uint16_t b = edges[k + 1];
+
+        /* Segments covering [a, b) from the top down to the first opaque
+         * one; none = gap */
+        int top = -1;
+        uint32_t layers = 0;
+        for (int n = MAX_SEGMENTS - 1; n >= 0; n--) {
+            if (!covers(&geom[n], strip, a)) continue;
+            if (top < 0) top = n;
+            layers |= 1u << n;
+            if (opaque & (1u << n)) break;
+        }
+        if (top < 0) continue;
+
+        segment_span_t *last = out->count ? &out->spans[out->count - 1] : NULL;
+        if (last && last->layers == layers && last->start + last->count == a) {
+            last->count += b - a;
+        } else {
+            out->spans[out->count++] = (segment_span_t) {
+                .start = a, .count = b - a, .seg = (uint8_t)top,
+                .layers = (uint8_t)layers,
+            };
+        }
+        *visible |= layers;
+    }
+}
+
+uint32_t segment_spans_build(const segment_geom_t *geom, uint32_t opaque,
+                             segment_span_list_t *out)
+{
+    uint32_t visible = 0;
+    for (uint8_t s = 0; s < MAX_STRIPS; s++) {
+        build_strip(geom, opaque, s, &out[s], &visible);
+    }
+    return visible;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file segment_spans.h
+ * @brief Segment geometry flattened into non-overlapping spans per strip
+ *
+ * Segments may overlap; a higher segment number is drawn on top. Instead
+ * of painting every segment in order each frame, the renderer resolves the
+ * geometry once into an ordered list of runs per strip, each owned by the
+ * topmost segment covering it, and fills each run once per frame. Pixels
+ * covered by no segment are not in the list (black).
+ *
+ * A segment that blends (blend_engine.h) lets the segments below it show
+ * through, so its runs also list those layers down to the first opaque
+ * one. With every segment opaque each run has a single layer.
+ */
+
+#pragma once
+
+#include "segment_manager.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* n intervals split the line into at most 2n - 1 covered runs */
+#define SEGMENT_SPANS_MAX  (2 * MAX_SEGMENTS - 1)
+
+typedef struct {
+    uint16_t start;
+    uint16_t count;
+    uint8_t  seg;       /**< Owning (topmost) segment 0-7 */
+    uint8_t  layers;    /**< Bit per segment composited here, seg included */
+} segment_span_t;
+
+typedef struct {
+    uint8_t        count;
+    segment_span_t spans[SEGMENT_SPANS_MAX];   /**< Ascending, non-overlapping */
+} segment_span_list_t;
+
+/**
+ * @brief Resolve segment geometry into one span list per strip
+ *
+ * Disabled segments (count 0) and segments on an unknown strip are
+ * ignored. Runs are not clipped to the strip length (the LED driver does
+ * that). Adjacent runs with the same layers are merged.
+ *
+ * @param geom    MAX_SEGMENTS entries
+ * @param opaque  Bit per segment that hides what is below it (BLEND_REPLACE)
+ * @param out     MAX_STRIPS lists
+ * @return Bit per segment that is a layer of at least one span (is visible)
+ */
+uint32_t segment_spans_build(const segment_geom_t *geom, uint32_t opaque,
+                             segment_span_list_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,182 @@
+/**
+ * @file timeline_handler.c
+ * @brief Timeline ZCL integration implementation
+ *
+ * Bridges Zigbee ZCL cluster 0xFC03 to the render task's timeline player.
+ * Uploads are too large for a light_cmd_t, so they travel through a small
+ * pool of slots: the producer claims a free slot, fills it and posts its
+ * index; the render task copies it out and releases it.
+ */
+
+#include "timeline_handler.h"
+#include "segment_manager.h"
+#include "led_renderer.h"
+#include "light_cmd.h"
+#include "board_config.h"
+#include "zigbee_init.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <string.h>
+
+static const char *TAG = "timeline_handler";
+
+static timeline_upload_t s_uploads[TIMELINE_UPLOAD_SLOTS];
+static atomic_bool       s_upload_full[TIMELINE_UPLOAD_SLOTS];
+
+/* Target of the next keyframes write (Zigbee task) */
+static uint8_t s_zb_seg     = 0;
+static uint8_t s_zb_channel = SEG_CH_LEVEL;
+static uint8_t s_zb_mode    = TIMELINE_MODE_ONESHOT;
+
+/* ================================================================== */
+/*  Upload Slots                                                       */
+/* ================================================================== */
+
+/* Keep key values inside the channel's range */
+static uint16_t clamp_key_value(uint8_t channel, uint16_t v)
+{
+    switch (channel) {
+    case SEG_CH_LEVEL:
+    case SEG_CH_SAT:
+        return v > 254 ? 254 : v;
+    case SEG_CH_HUE:
+        return v > 359 ? 359 : v;
+    case SEG_CH_CT:
+        if (v < COLOR_TEMP_MIN_MIREDS) return COLOR_TEMP_MIN_MIREDS;
+        if (v > COLOR_TEMP_MAX_MIREDS) return COLOR_TEMP_MAX_MIREDS;
+        return v;
+    default:
+        return v;
+    }
+}
+
+esp_err_t timeline_upload_post(light_cmd_src_t src, const timeline_upload_t *up)
+{
+    if (up->seg >= MAX_SEGMENTS || up->channel >= SEG_CH_COUNT ||
+        up->mode >= TIMELINE_MODE_COUNT || up->count > TIMELINE_MAX_KEYS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (uint8_t slot = 0; slot < TIMELINE_UPLOAD_SLOTS; slot++) {
+        /* Claim first, then fill: the render task only reads a slot after
+         * the command naming it has been posted */
+        bool expected = false;
+        if (!atomic_compare_exchange_strong(&s_upload_full[slot], &expected, true)) continue;
+        timeline_upload_t *dst = &s_uploads[slot];
+        *dst = *up;
+        for (int i = 0; i < dst->count; i++) {
+            dst->keys[i].value = clamp_key_value(dst->channel, dst->keys[i].value);
+        }
+
+        if (!light_cmd_post(src, LIGHT_CMD_TIMELINE_LOAD, up->seg, slot, 0)) {
+            atomic_store_explicit(&s_upload_full[slot], false, memory_order_release);
+            return ESP_ERR_NO_MEM;
+        }
+        led_renderer_request_update();
+        return ESP_OK;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+bool timeline_upload_take(uint8_t slot, timeline_upload_t *out)
+{
+    if (slot >= TIMELINE_UPLOAD_SLOTS ||
+        !atomic_load_explicit(&s_upload_full[slot], memory_order_acquire)) {
+        return false;
+    }
+    *out = s_uploads[slot];
+    atomic_store_explicit(&s_upload_full[slot], false, memory_order_release);
+    return true;
+}
+
+/* ================================================================== */
+/*  ZCL Attribute Writes                                               */
+/* ================================================================== */
+
+/* Parse a keyframes OctetString: length byte, then 7 bytes per key (LE) */
+static esp_err_t parse_keyframes(const uint8_t *oct, timeline_upload_t *up)
+{
+    uint8_t len = oct[0];
+    if (len % TIMELINE_KEY_WIRE_SIZE != 0 ||
+        len / TIMELINE_KEY_WIRE_SIZE > TIMELINE_MAX_KEYS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t *p = &oct[1];
+    up->count = len / TIMELINE_KEY_WIRE_SIZE;
+    for (int i = 0; i < up->count; i++, p += TIMELINE_KEY_WIRE_SIZE) {
+        timeline_key_t *k = &up->keys[i];
+        k->time_ms  = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                      ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        k->value    = (uint16_t)(p[4] | (p[5] << 8));
+        k->easing   = p[6];
+        k->reserved = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t handle_timeline_attr_write(uint16_t attr_id, const void *value)
+{
+    uint8_t u8 = *(const uint8_t *)value;
+
+    switch (attr_id) {
+    case ZB_ATTR_TIMELINE_SEGMENT:
+        if (u8 >= MAX_SEGMENTS) {
+            ESP_LOGE(TAG, "Invalid timeline segment %d (must be 0-7)", u8);
+            return ESP_ERR_INVALID_ARG;
+        }
+        s_zb_seg = u8;
+        return ESP_OK;
+
+    case ZB_ATTR_TIMELINE_CHANNEL:
+        if (u8 >= SEG_CH_COUNT) {
+            ESP_LOGE(TAG, "Invalid timeline channel %d (must be 0-3)", u8);
+            return ESP_ERR_INVALID_ARG;
+        }
+        s_zb_channel = u8;
+        return ESP_OK;
+
+    case ZB_ATTR_TIMELINE_MODE:
+        if (u8 >= TIMELINE_MODE_COUNT) {
+            ESP_LOGE(TAG, "Invalid timeline mode %d (must be 0-2)", u8);
+            return ESP_ERR_INVALID_ARG;
+        }
+        s_zb_mode = u8;
+        return ESP_OK;
+
+    case ZB_ATTR_TIMELINE_KEYFRAMES: {
+        timeline_upload_t up = {
+            .seg = s_zb_seg, .channel = s_zb_channel, .mode = s_zb_mode,
+        };
+        esp_err_t err = parse_keyframes((const uint8_t *)value, &up);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Malformed keyframes (%d bytes)", *(const uint8_t *)value);
+            return err;
+        }
+        err = timeline_upload_post(LIGHT_CMD_SRC_ZIGBEE, &up);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "Timeline upload: seg %d ch %d mode %d, %d keys",
+                     up.seg, up.channel, up.mode, up.count);
+        } else {
+            ESP_LOGW(TAG, "Timeline upload dropped: %s", esp_err_to_name(err));
+        }
+        return err;
+    }
+
+    case ZB_ATTR_TIMELINE_STOP:
+        if (u8 >= MAX_SEGMENTS && u8 != LIGHT_CMD_ALL_SEGS) {
+            ESP_LOGE(TAG, "Invalid timeline stop %d (must be 0-7 or 0xFF)", u8);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (!light_cmd_post(LIGHT_CMD_SRC_ZIGBEE, LIGHT_CMD_TIMELINE_STOP, u8,
+                            (1u << SEG_CH_COUNT) - 1, 0)) {
+            ESP_LOGW(TAG, "Light command queue full, timeline stop dropped");
+            return ESP_ERR_NO_MEM;
+        }
+        led_renderer_request_update();
+        return ESP_OK;
+
+    default:
+        return ESP_OK;
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * @file timeline_handler.h
+ * @brief Timeline ZCL integration - bridge between Zigbee and timeline_player
+ *
+ * Handles attribute writes on cluster 0xFC03. A keyframes write is parsed
+ * in the Zigbee task into an upload slot and handed to the render task with
+ * LIGHT_CMD_TIMELINE_LOAD; the render task copies it out and frees the slot.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "timeline_engine.h"
+#include "light_cmd.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMELINE_UPLOAD_SLOTS   2
+#define TIMELINE_KEY_WIRE_SIZE  7   /* time_ms u32, value u16, easing u8 (LE) */
+
+/**
+ * @brief One keyframe upload for a segment channel
+ */
+typedef struct {
+    uint8_t        seg;         /**< Segment 0-7 */
+    uint8_t        channel;     /**< segment_channel_t */
+    uint8_t        mode;        /**< timeline_mode_t */
+    uint8_t        count;       /**< 0 = stop the channel's timeline */
+    timeline_key_t keys[TIMELINE_MAX_KEYS];
+} timeline_upload_t;
+
+/**
+ * @brief Handle a write to a timeline cluster attribute (Zigbee task)
+ *
+ * segment, channel and mode are latched for the next keyframes write.
+ * ZCL OctetString format for keyframes: first byte is length, followed by
+ * TIMELINE_KEY_WIRE_SIZE bytes per key.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a malformed value,
+ *         ESP_ERR_NO_MEM if no upload slot or queue entry is free
+ */
+esp_err_t handle_timeline_attr_write(uint16_t attr_id, const void *value);
+
+/**
+ * @brief Queue an upload for the render task (Zigbee or CLI task)
+ *
+ * Key values are clamped to the channel's range. count 0 stops the
+ * channel's timeline.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for an out-of-range field,
+ *         ESP_ERR_NO_MEM if no upload slot or queue entry is free
+ */
+esp_err_t timeline_upload_post(light_cmd_src_t src, const timeline_upload_t *up);
+
+/**
+ * @brief Copy an upload out of its slot and free the slot (render task)
+ *
+ * @return false if the slot holds no upload
+ */
+bool timeline_upload_take(uint8_t slot, timeline_upload_t *out);
+
+#ifdef __cplusplus
+}
+#endif
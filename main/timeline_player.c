@@ -0,0 +1,136 @@
+/**
+ * @file timeline_player.c
+ * @brief Keyframe timeline playback on segment channels (render task only)
+ */
+
+#include "timeline_player.h"
+#include "segment_manager.h"
+#include "light_cmd.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "timeline_player";
+
+typedef struct {
+    timeline_t tl;
+    bool       used;
+    uint8_t    seg;
+    uint8_t    channel;     /* segment_channel_t */
+} track_t;
+
+static track_t s_tracks[TIMELINE_PLAYER_TRACKS];
+
+/* Keep the value a track was showing as the segment's state */
+static void commit_track(const track_t *t)
+{
+    segment_light_t *st = &segment_state_get()[t->seg];
+    uint16_t v = timeline_value(&t->tl);
+
+    switch (t->channel) {
+    case SEG_CH_LEVEL: st->level      = (uint8_t)v; break;
+    case SEG_CH_HUE:   st->hue        = v;          break;
+    case SEG_CH_SAT:   st->saturation = (uint8_t)v; break;
+    case SEG_CH_CT:    st->color_temp = v;          break;
+    default: break;
+    }
+}
+
+static track_t *find_track(uint8_t seg, uint8_t channel)
+{
+    track_t *free_slot = NULL;
+    for (int i = 0; i < TIMELINE_PLAYER_TRACKS; i++) {
+        track_t *t = &s_tracks[i];
+        if (t->used && t->seg == seg && t->channel == channel) return t;
+        if (!t->used && free_slot == NULL) free_slot = t;
+    }
+    return free_slot;
+}
+
+bool timeline_player_load(const timeline_upload_t *up, int64_t now_us)
+{
+    if (up->seg >= MAX_SEGMENTS || up->channel >= SEG_CH_COUNT) return false;
+    if (up->count == 0) return timeline_player_stop(up->seg, 1u << up->channel);
+
+    track_t *t = find_track(up->seg, up->channel);
+    if (t == NULL) {
+        ESP_LOGW(TAG, "No free track for seg %d ch %d", up->seg, up->channel);
+        return false;
+    }
+
+    esp_err_t err = timeline_load(&t->tl, up->keys, up->count,
+                                  (timeline_mode_t)up->mode, now_us);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rejected timeline for seg %d ch %d: %s",
+                 up->seg, up->channel, esp_err_to_name(err));
+        return false;
+    }
+    t->used    = true;
+    t->seg     = up->seg;
+    t->channel = up->channel;
+
+    /* The channel only shows if the segment is on and in the matching mode */
+    segment_light_t *st = &segment_state_get()[up->seg];
+    bool changed = false;
+    if (up->channel == SEG_CH_LEVEL && !st->on) {
+        st->on  = true;
+        changed = true;
+    } else if ((up->channel == SEG_CH_HUE || up->channel == SEG_CH_SAT) && st->color_mode != 0) {
+        st->color_mode = 0;
+        changed = true;
+    } else if (up->channel == SEG_CH_CT && st->color_mode != 2) {
+        st->color_mode = 2;
+        changed = true;
+    }
+    return changed;
+}
+
+bool timeline_player_stop(uint8_t seg, uint32_t ch_mask)
+{
+    bool stopped = false;
+    for (int i = 0; i < TIMELINE_PLAYER_TRACKS; i++) {
+        track_t *t = &s_tracks[i];
+        if (!t->used || !(ch_mask & (1u << t->channel))) continue;
+        if (seg != LIGHT_CMD_ALL_SEGS && t->seg != seg) continue;
+        commit_track(t);
+        t->used = false;
+        stopped = true;
+    }
+    return stopped;
+}
+
+bool timeline_player_sample(int64_t now_us, bool *finished)
+{
+    transition_batch_t *trans = segment_trans_get();
+    bool running = false;
+
+    for (int i = 0; i < TIMELINE_PLAYER_TRACKS; i++) {
+        track_t *t = &s_tracks[i];
+        if (!t->used) continue;
+
+        uint16_t v = timeline_sample(&t->tl, now_us);
+        transition_batch_jump(trans, t->seg, t->channel, v);
+        if (timeline_is_running(&t->tl)) {
+            running = true;
+        } else {
+            commit_track(t);
+            t->used   = false;
+            *finished = true;
+        }
+    }
+    return running;
+}
+
+void timeline_player_get_tracks(timeline_track_info_t out[TIMELINE_PLAYER_TRACKS])
+{
+    for (int i = 0; i < TIMELINE_PLAYER_TRACKS; i++) {
+        const track_t *t = &s_tracks[i];
+        out[i] = (timeline_track_info_t) {
+            .used    = t->used,
+            .seg     = t->seg,
+            .channel = t->channel,
+            .mode    = t->tl.mode,
+            .count   = t->tl.count,
+            .value   = timeline_value(&t->tl),
+        };
+    }
+}
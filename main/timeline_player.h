@@ -0,0 +1,71 @@
+/**
+ * @file timeline_player.h
+ * @brief Plays keyframe timelines onto segment channels (render task only)
+ *
+ * Each track binds one timeline to one segment channel. Once per frame the
+ * render task samples the running tracks at the frame time and writes the
+ * values into the segment transition batch, so they are rendered exactly
+ * like a transition. When a track ends (one-shot finished, stopped, or
+ * overridden by a direct command on its channel) its value is written into
+ * segment state, which is then what gets saved and reported over ZCL.
+ */
+
+#pragma once
+
+#include "timeline_handler.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMELINE_PLAYER_TRACKS  8
+
+/**
+ * @brief Snapshot of one track (see `led timeline`)
+ */
+typedef struct {
+    bool     used;
+    uint8_t  seg;
+    uint8_t  channel;
+    uint8_t  mode;
+    uint8_t  count;
+    uint16_t value;
+} timeline_track_info_t;
+
+/**
+ * @brief Start an upload on its segment channel, replacing any track there.
+ * A level track turns the segment on; a hue/saturation or CT track switches
+ * the segment's color mode. An upload with no keys stops the channel.
+ *
+ * @return true if segment state changed
+ */
+bool timeline_player_load(const timeline_upload_t *up, int64_t now_us);
+
+/**
+ * @brief End the tracks of segment seg on the channels in ch_mask, keeping
+ * their current values in segment state.
+ *
+ * @return true if a track was stopped
+ */
+bool timeline_player_stop(uint8_t seg, uint32_t ch_mask);
+
+/**
+ * @brief Advance every running track to now_us and write its value into
+ * the segment transition batch.
+ *
+ * @param[out] finished  Set true if a one-shot track ended this frame
+ * @return true if any track is still running
+ */
+bool timeline_player_sample(int64_t now_us, bool *finished);
+
+/**
+ * @brief Copy out the track table. Fields may be a frame stale when called
+ * from another task.
+ */
+void timeline_player_get_tracks(timeline_track_info_t out[TIMELINE_PLAYER_TRACKS]);
+
+#ifdef __cplusplus
+}
+#endif
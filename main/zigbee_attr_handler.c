@@ -8,11 +8,14 @@
 
 #include "zigbee_attr_handler.h"
 #include "preset_handler.h"
+#include "timeline_handler.h"
+#include "effect_engine.h"
+#include "blend_engine.h"
+#include "gradient_engine.h"
 #include "led_renderer.h"
+#include "light_cmd.h"
 #include "segment_manager.h"
 #include "config_storage.h"
-#include "color_engine.h"
-#include "transition_engine.h"
 #include "zigbee_init.h"
 #include "preset_manager.h"
 #include "board_config.h"
@@ -22,6 +25,16 @@
 
 static const char *TAG = "zigbee_attr";
 
+/* Segment state belongs to the render task: hand it the change */
+static void post_light_cmd(light_cmd_type_t type, uint8_t seg, uint16_t value, uint16_t ms)
+{
+    if (!light_cmd_post(LIGHT_CMD_SRC_ZIGBEE, type, seg, value, ms)) {
+        ESP_LOGW(TAG, "Light command queue full, dropped type=%d seg=%u", type, seg);
+        return;
+    }
+    led_renderer_request_update();
+}
+
 /**
  * @brief Handle ZCL attribute write
  *
@@ -30,6 +43,9 @@ static const char *TAG = "zigbee_attr";
  * - Device config cluster (0xFC00): Strip counts, global transition time
  * - Segment geometry cluster (0xFC01): Segment start/count/strip assignments
  * - Preset config cluster (0xFC02): Preset recall/save/delete operations
+ * - Timeline cluster (0xFC03): Keyframe uploads and stops
+ * - Effect cluster (0xFC04, EP1-EP8): Effect, speed, intensity and blend mode per segment
+ * - Gradient cluster (0xFC05, EP1-EP8): Gradient stops per segment
  * - Segment endpoints (EP1-EP8): On/off, level, color control attributes
  */
 static esp_err_t handle_set_attr_value(const esp_zb_zcl_set_attr_value_message_t *message)
@@ -99,7 +115,7 @@ static esp_err_t handle_set_attr_value(const esp_zb_zcl_set_attr_value_message_t
 
         /* Strip count (requires reboot) */
         uint16_t new_count = *(uint16_t *)value;
-        if (new_count >= 1 && new_count <= 500) {
+        if (new_count >= 1 && new_count <= LED_STRIP_MAX_COUNT) {
             uint8_t strip = (attr_id == ZB_ATTR_STRIP2_COUNT) ? 1 : 0;
             ESP_LOGI(TAG, "Strip%d count -> %u (saving, reboot in 1s)", strip, new_count);
             config_storage_save_strip_count(strip, new_count);
@@ -114,20 +130,20 @@ static esp_err_t handle_set_attr_value(const esp_zb_zcl_set_attr_value_message_t
             int offset  = attr_id - ZB_ATTR_SEG_BASE;
             int seg_idx = offset / ZB_SEG_ATTRS_PER_SEG;
             int field   = offset % ZB_SEG_ATTRS_PER_SEG;
-            segment_geom_t *geom = segment_geom_get();
             if (field == 0) {
-                geom[seg_idx].start = *(uint16_t *)value;
-                ESP_LOGI(TAG, "Seg%d start -> %u", seg_idx + 1, geom[seg_idx].start);
+                uint16_t start = *(uint16_t *)value;
+                ESP_LOGI(TAG, "Seg%d start -> %u", seg_idx + 1, start);
+                post_light_cmd(LIGHT_CMD_GEOM_START, (uint8_t)seg_idx, start, 0);
             } else if (field == 1) {
-                geom[seg_idx].count = *(uint16_t *)value;
-                ESP_LOGI(TAG, "Seg%d count -> %u", seg_idx + 1, geom[seg_idx].count);
+                uint16_t count = *(uint16_t *)value;
+                ESP_LOGI(TAG, "Seg%d count -> %u", seg_idx + 1, count);
+                post_light_cmd(LIGHT_CMD_GEOM_COUNT, (uint8_t)seg_idx, count, 0);
             } else {
                 uint8_t v = *(uint8_t *)value;
-                geom[seg_idx].strip_id = (v >= 2) ? 1 : 0;
-                ESP_LOGI(TAG, "Seg%d strip -> %u", seg_idx + 1, geom[seg_idx].strip_id);
+                uint8_t strip_id = (v >= 2) ? 1 : 0;
+                ESP_LOGI(TAG, "Seg%d strip -> %u", seg_idx + 1, strip_id);
+                post_light_cmd(LIGHT_CMD_GEOM_STRIP, (uint8_t)seg_idx, strip_id, 0);
             }
-            segment_manager_save();
-            update_leds();
         }
         return ESP_OK;
     }
@@ -158,79 +174,122 @@ static esp_err_t handle_set_attr_value(const esp_zb_zcl_set_attr_value_message_t
         return ESP_OK;
     }
 
+    /* Custom cluster: keyframe timelines (EP1 only) */
+    if (cluster == ZB_CLUSTER_TIMELINE) {
+        handle_timeline_attr_write(attr_id, value);
+        return ESP_OK;
+    }
+
+    /* Custom cluster: segment effect (EP1-EP8) */
+    if (cluster == ZB_CLUSTER_EFFECT) {
+        if (endpoint < ZB_SEGMENT_EP_BASE || endpoint >= ZB_SEGMENT_EP_BASE + MAX_SEGMENTS) return ESP_OK;
+        uint8_t seg = (uint8_t)(endpoint - ZB_SEGMENT_EP_BASE);
+        uint8_t v   = *(uint8_t *)value;
+        if (attr_id == ZB_ATTR_EFFECT_ID) {
+            if (v >= EFFECT_COUNT) {
+                ESP_LOGW(TAG, "Invalid effect %u (0-%d)", v, EFFECT_COUNT - 1);
+                return ESP_OK;
+            }
+            ESP_LOGI(TAG, "Seg%d effect -> %s", seg + 1, effect_name(v));
+            post_light_cmd(LIGHT_CMD_EFFECT, seg, v, 0);
+        } else if (attr_id == ZB_ATTR_EFFECT_SPEED) {
+            post_light_cmd(LIGHT_CMD_EFFECT_SPEED, seg, v, 0);
+        } else if (attr_id == ZB_ATTR_EFFECT_INTENSITY) {
+            post_light_cmd(LIGHT_CMD_EFFECT_INTENSITY, seg, v, 0);
+        } else if (attr_id == ZB_ATTR_EFFECT_BLEND) {
+            if (v >= BLEND_COUNT) {
+                ESP_LOGW(TAG, "Invalid blend mode %u (0-%d)", v, BLEND_COUNT - 1);
+                return ESP_OK;
+            }
+            ESP_LOGI(TAG, "Seg%d blend -> %s", seg + 1, blend_name(v));
+            post_light_cmd(LIGHT_CMD_BLEND, seg, v, 0);
+        } else if (attr_id == ZB_ATTR_EFFECT_OPACITY) {
+            post_light_cmd(LIGHT_CMD_BLEND_OPACITY, seg, v, 0);
+        }
+        return ESP_OK;
+    }
+
+    /* Custom cluster: segment gradient (EP1-EP8) */
+    if (cluster == ZB_CLUSTER_GRADIENT) {
+        if (endpoint < ZB_SEGMENT_EP_BASE || endpoint >= ZB_SEGMENT_EP_BASE + MAX_SEGMENTS) return ESP_OK;
+        uint8_t seg = (uint8_t)(endpoint - ZB_SEGMENT_EP_BASE);
+        uint8_t k   = (uint8_t)(attr_id & 0x000F);
+        if (attr_id == ZB_ATTR_GRADIENT_STOPS) {
+            uint8_t v = *(uint8_t *)value;
+            if (v == 1 || v > GRADIENT_MAX_STOPS) {
+                ESP_LOGW(TAG, "Invalid gradient stop count %u (0 or 2-%d)", v, GRADIENT_MAX_STOPS);
+                return ESP_OK;
+            }
+            ESP_LOGI(TAG, "Seg%d gradient -> %u stops", seg + 1, v);
+            post_light_cmd(LIGHT_CMD_GRAD_STOPS, seg, v, 0);
+        } else if (attr_id == ZB_ATTR_GRADIENT_SPACE) {
+            uint8_t v = *(uint8_t *)value;
+            if (v >= GRADIENT_SPACE_COUNT) {
+                ESP_LOGW(TAG, "Invalid gradient space %u (0-%d)", v, GRADIENT_SPACE_COUNT - 1);
+                return ESP_OK;
+            }
+            post_light_cmd(LIGHT_CMD_GRAD_SPACE, seg, v, 0);
+        } else if (k < GRADIENT_MAX_STOPS && attr_id - k == ZB_ATTR_GRADIENT_HUE_BASE) {
+            uint16_t hue = *(uint16_t *)value;
+            if (hue >= 360) {
+                ESP_LOGW(TAG, "Invalid gradient hue %u (0-359)", hue);
+                return ESP_OK;
+            }
+            post_light_cmd(LIGHT_CMD_GRAD_HUE, seg, LIGHT_CMD_GRAD_VALUE(k, hue), g_global_transition_ms);
+        } else if (k < GRADIENT_MAX_STOPS && attr_id - k == ZB_ATTR_GRADIENT_SAT_BASE) {
+            uint8_t sat = *(uint8_t *)value;
+            post_light_cmd(LIGHT_CMD_GRAD_SAT, seg, LIGHT_CMD_GRAD_VALUE(k, sat > 254 ? 254 : sat),
+                           g_global_transition_ms);
+        } else if (k < GRADIENT_MAX_STOPS && attr_id - k == ZB_ATTR_GRADIENT_POS_BASE) {
+            post_light_cmd(LIGHT_CMD_GRAD_POS, seg, LIGHT_CMD_GRAD_VALUE(k, *(uint8_t *)value), 0);
+        }
+        return ESP_OK;
+    }
+
     /* EP9 "all segments" master — on/off, level, and CT writes propagate to all segments.
-     * HS color is handled by polling in led_render_cb (SDK delivers no callback for it). */
+     * HS color is handled by polling in zcl_poll_cb (SDK delivers no callback for it). */
     if (endpoint == ZB_ALL_EP) {
-        segment_light_t *state = segment_state_get();
+        uint16_t ms = led_renderer_get_global_transition_ms();
 
         if (cluster == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF) {
             if (attr_id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID) {
                 bool new_on = *(bool *)value;
                 ESP_LOGI(TAG, "All segs on/off -> %s", new_on ? "ON" : "OFF");
-                for (int i = 0; i < MAX_SEGMENTS; i++) {
-                    bool was_on = state[i].on;
-                    state[i].on = new_on;
-                    if (new_on && !was_on) {
-                        transition_start(&state[i].level_trans, 0, 0);
-                        transition_start(&state[i].level_trans, state[i].level,
-                                         led_renderer_get_global_transition_ms());
-                    } else if (!new_on && was_on) {
-                        transition_start(&state[i].level_trans, 0,
-                                         led_renderer_get_global_transition_ms());
-                    }
-                }
-                update_leds();
-                schedule_save();
+                post_light_cmd(LIGHT_CMD_ON_OFF, LIGHT_CMD_ALL_SEGS, new_on, ms);
             }
         } else if (cluster == ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL) {
             if (attr_id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID) {
                 uint8_t new_level = *(uint8_t *)value;
                 ESP_LOGI(TAG, "All segs level -> %d", new_level);
+                post_light_cmd(LIGHT_CMD_LEVEL, LIGHT_CMD_ALL_SEGS, new_level, ms);
+                /* Sync segment EP ZCL stores so the render loop level poll
+                 * doesn't revert the level back to the old value next tick. */
                 for (int i = 0; i < MAX_SEGMENTS; i++) {
-                    state[i].level = new_level;
-                    transition_start(&state[i].level_trans, new_level,
-                                     led_renderer_get_global_transition_ms());
-                    /* Sync segment EP ZCL stores so the render loop level poll
-                     * doesn't revert the level back to the old value next tick. */
                     uint8_t ep_i = (uint8_t)(ZB_SEGMENT_EP_BASE + i);
                     esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
                         ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
                         ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID, &new_level, false);
                 }
-                update_leds();
-                schedule_save();
             }
         } else if (cluster == ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL) {
             switch (attr_id) {
             case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID: {
                 uint16_t enh_hue = *(uint16_t *)value;
                 uint16_t hue = (uint16_t)((uint32_t)enh_hue * 360 / 65535);
-                for (int i = 0; i < MAX_SEGMENTS; i++) {
-                    state[i].hue = hue;
-                    state[i].color_mode = 0;
-                    start_hue_transition(&state[i].hue_trans, hue,
-                                         led_renderer_get_global_transition_ms());
-                }
+                post_light_cmd(LIGHT_CMD_HUE, LIGHT_CMD_ALL_SEGS, hue, ms);
                 break;
             }
             case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID: {
                 uint8_t new_sat = *(uint8_t *)value;
-                for (int i = 0; i < MAX_SEGMENTS; i++) {
-                    state[i].saturation = new_sat;
-                    transition_start(&state[i].sat_trans, new_sat,
-                                     led_renderer_get_global_transition_ms());
-                }
+                post_light_cmd(LIGHT_CMD_SATURATION, LIGHT_CMD_ALL_SEGS, new_sat, ms);
                 break;
             }
             case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID: {
                 uint16_t new_ct = *(uint16_t *)value;
                 ESP_LOGI(TAG, "All segs CT -> %u mireds", new_ct);
+                post_light_cmd(LIGHT_CMD_COLOR_TEMP, LIGHT_CMD_ALL_SEGS, new_ct, ms);
                 uint8_t mode2 = 2;
                 for (int i = 0; i < MAX_SEGMENTS; i++) {
-                    state[i].color_temp = new_ct;
-                    state[i].color_mode = 2;
-                    transition_start(&state[i].ct_trans, new_ct,
-                                     led_renderer_get_global_transition_ms());
                     /* Sync segment EP ZCL stores so the render loop's unconditional
                      * color_mode read doesn't revert the mode back to HS next tick. */
                     uint8_t ep_i = (uint8_t)(ZB_SEGMENT_EP_BASE + i);
@@ -241,20 +300,17 @@ static esp_err_t handle_set_attr_value(const esp_zb_zcl_set_attr_value_message_t
                         ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
                         ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID, &new_ct, false);
                 }
-                update_leds();
-                schedule_save();
                 break;
             }
             case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID: {
                 uint8_t new_mode = *(uint8_t *)value;
+                post_light_cmd(LIGHT_CMD_COLOR_MODE, LIGHT_CMD_ALL_SEGS, new_mode, 0);
                 for (int i = 0; i < MAX_SEGMENTS; i++) {
-                    state[i].color_mode = new_mode;
                     uint8_t ep_i = (uint8_t)(ZB_SEGMENT_EP_BASE + i);
                     esp_zb_zcl_set_attribute_val(ep_i, ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL,
                         ESP_ZB_ZCL_CLUSTER_SERVER_ROLE,
                         ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID, &new_mode, false);
                 }
-                update_leds();
                 break;
             }
             default:
@@ -266,72 +322,53 @@ static esp_err_t handle_set_attr_value(const esp_zb_zcl_set_attr_value_message_t
 
     /* Segment light endpoints (EP1-EP8) */
     if (endpoint >= ZB_SEGMENT_EP_BASE && endpoint < ZB_SEGMENT_EP_BASE + MAX_SEGMENTS) {
-        int seg = endpoint - ZB_SEGMENT_EP_BASE;
-        segment_light_t *state = segment_state_get();
-        bool needs_update = false;
+        uint8_t seg = (uint8_t)(endpoint - ZB_SEGMENT_EP_BASE);
+        uint16_t ms = led_renderer_get_global_transition_ms();
 
         if (cluster == ESP_ZB_ZCL_CLUSTER_ID_ON_OFF) {
             if (attr_id == ESP_ZB_ZCL_ATTR_ON_OFF_ON_OFF_ID) {
                 bool new_on = *(bool *)value;
-                bool was_on = state[seg].on;
-                state[seg].on = new_on;
-                ESP_LOGI(TAG, "Seg%d on/off -> %s", seg + 1, state[seg].on ? "ON" : "OFF");
-
-                if (new_on && !was_on) {
-                    /* Turning ON: Start from 0 (dark) and fade to target level */
-                    transition_start(&state[seg].level_trans, 0, 0);  /* Instant to 0 */
-                    transition_start(&state[seg].level_trans, state[seg].level, led_renderer_get_global_transition_ms());
-                } else if (!new_on && was_on) {
-                    /* Turning OFF: Fade from current level to 0 */
-                    transition_start(&state[seg].level_trans, 0, led_renderer_get_global_transition_ms());
-                }
-                needs_update = true;
+                ESP_LOGI(TAG, "Seg%d on/off -> %s", seg + 1, new_on ? "ON" : "OFF");
+                /* ON fades up from 0 to the segment level, OFF fades to 0 */
+                post_light_cmd(LIGHT_CMD_ON_OFF, seg, new_on, ms);
             } else if (attr_id == ESP_ZB_ZCL_ATTR_ON_OFF_START_UP_ON_OFF) {
-                state[seg].startup_on_off = *(uint8_t *)value;
-                ESP_LOGI(TAG, "Seg%d startup_on_off -> 0x%02X", seg + 1, state[seg].startup_on_off);
-                schedule_save();
+                uint8_t startup = *(uint8_t *)value;
+                ESP_LOGI(TAG, "Seg%d startup_on_off -> 0x%02X", seg + 1, startup);
+                post_light_cmd(LIGHT_CMD_STARTUP_ON_OFF, seg, startup, 0);
             }
         } else if (cluster == ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL) {
             if (attr_id == ESP_ZB_ZCL_ATTR_LEVEL_CONTROL_CURRENT_LEVEL_ID) {
-                state[seg].level = *(uint8_t *)value;
-                ESP_LOGI(TAG, "Seg%d level -> %d", seg + 1, state[seg].level);
-                /* Start transition to new level with global duration */
-                transition_start(&state[seg].level_trans, state[seg].level, led_renderer_get_global_transition_ms());
-                needs_update = true;
+                uint8_t level = *(uint8_t *)value;
+                ESP_LOGI(TAG, "Seg%d level -> %d", seg + 1, level);
+                post_light_cmd(LIGHT_CMD_LEVEL, seg, level, ms);
             }
         } else if (cluster == ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL) {
             switch (attr_id) {
             case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_ENHANCED_CURRENT_HUE_ID: {
                 uint16_t enh_hue = *(uint16_t *)value;
-                state[seg].hue = (uint16_t)((uint32_t)enh_hue * 360 / 65535);
-                state[seg].color_mode = 0;
                 /* Smooth hue transition with shortest-arc calculation */
-                start_hue_transition(&state[seg].hue_trans, state[seg].hue, led_renderer_get_global_transition_ms());
+                post_light_cmd(LIGHT_CMD_HUE, seg, (uint16_t)((uint32_t)enh_hue * 360 / 65535), ms);
                 break;
             }
             case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_CURRENT_SATURATION_ID:
-                state[seg].saturation = *(uint8_t *)value;
-                /* Smooth saturation transition */
-                transition_start(&state[seg].sat_trans, state[seg].saturation, led_renderer_get_global_transition_ms());
+                post_light_cmd(LIGHT_CMD_SATURATION, seg, *(uint8_t *)value, ms);
                 break;
-            case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID:
-                state[seg].color_temp = *(uint16_t *)value;
-                state[seg].color_mode = 2;
-                ESP_LOGI(TAG, "Seg%d CT -> %u mireds", seg + 1, state[seg].color_temp);
-                transition_start(&state[seg].ct_trans, state[seg].color_temp, led_renderer_get_global_transition_ms());
-                needs_update = true;
+            case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_TEMPERATURE_ID: {
+                uint16_t ct = *(uint16_t *)value;
+                ESP_LOGI(TAG, "Seg%d CT -> %u mireds", seg + 1, ct);
+                post_light_cmd(LIGHT_CMD_COLOR_TEMP, seg, ct, ms);
                 break;
-            case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID:
-                state[seg].color_mode = *(uint8_t *)value;
-                ESP_LOGI(TAG, "Seg%d color_mode -> %d", seg + 1, state[seg].color_mode);
-                needs_update = true;
+            }
+            case ESP_ZB_ZCL_ATTR_COLOR_CONTROL_COLOR_MODE_ID: {
+                uint8_t mode = *(uint8_t *)value;
+                ESP_LOGI(TAG, "Seg%d color_mode -> %d", seg + 1, mode);
+                post_light_cmd(LIGHT_CMD_COLOR_MODE, seg, mode, 0);
                 break;
+            }
             default:
                 break;
             }
         }
-
-        if (needs_update) { update_leds(); schedule_save(); }
     }
 
     return ESP_OK;
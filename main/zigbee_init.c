@@ -6,7 +6,9 @@
  * Each endpoint represents one virtual segment of the LED strip.
  * Color mode HS/XY → RGB channels; CT mode → White channel.
  * EP1 also hosts custom clusters for device config (0xFC00) and
- * segment geometry (0xFC01: start+count per segment).
+ * segment geometry (0xFC01: start+count per segment). EP1-EP8 each host
+ * their segment's effect and blend cluster (0xFC04) and gradient cluster
+ * (0xFC05).
  */
 
 #include "zigbee_init.h"
@@ -16,6 +18,7 @@
 #include "board_config.h"
 #include "segment_manager.h"
 #include "preset_manager.h"
+#include "timeline_handler.h"
 #include "version.h"
 #include "crash_diag.h"
 #include "esp_log.h"
@@ -48,6 +51,13 @@ static uint8_t s_save_slot_attr = 0xFF;              /* 0xFF = no pending action
 static uint8_t s_delete_slot_attr = 0xFF;            /* 0xFF = no pending action */
 static uint8_t s_save_name_attr[17] = {0};           /* CharString for next save */
 
+/* Static buffers for timeline cluster attributes */
+static uint8_t s_tl_segment_attr = 0;
+static uint8_t s_tl_channel_attr = 0;                /* 0=level */
+static uint8_t s_tl_mode_attr = 0;                   /* 0=one-shot */
+static uint8_t s_tl_keyframes_attr[1 + TIMELINE_MAX_KEYS * TIMELINE_KEY_WIRE_SIZE] = {0};
+static uint8_t s_tl_stop_attr = 0xFF;
+
 /**
  * @brief Create color control attribute list with HS, XY, and CT capabilities
  */
@@ -132,6 +142,41 @@ static esp_zb_cluster_list_t *create_segment_clusters(int seg_idx)
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_level_cluster(cl, level, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
     ESP_ERROR_CHECK(esp_zb_cluster_list_add_color_control_cluster(cl, color, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
 
+    /* 0xFC04: Segment effect and blend mode — on every segment endpoint, not EP9 */
+    if (seg_idx < MAX_SEGMENTS) {
+        segment_effect_t *fx = &segment_effect_get()[seg_idx];
+        segment_blend_t *blend = &segment_blend_get()[seg_idx];
+        esp_zb_attribute_list_t *fx_cfg = esp_zb_zcl_attr_list_create(ZB_CLUSTER_EFFECT);
+        esp_zb_custom_cluster_add_custom_attr(fx_cfg, ZB_ATTR_EFFECT_ID,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &fx->id);
+        esp_zb_custom_cluster_add_custom_attr(fx_cfg, ZB_ATTR_EFFECT_SPEED,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &fx->speed);
+        esp_zb_custom_cluster_add_custom_attr(fx_cfg, ZB_ATTR_EFFECT_INTENSITY,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &fx->intensity);
+        esp_zb_custom_cluster_add_custom_attr(fx_cfg, ZB_ATTR_EFFECT_BLEND,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &blend->mode);
+        esp_zb_custom_cluster_add_custom_attr(fx_cfg, ZB_ATTR_EFFECT_OPACITY,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &blend->opacity);
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(cl, fx_cfg, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+
+        /* 0xFC05: Segment gradient */
+        segment_gradient_t *gr = &segment_gradient_get()[seg_idx];
+        esp_zb_attribute_list_t *gr_cfg = esp_zb_zcl_attr_list_create(ZB_CLUSTER_GRADIENT);
+        esp_zb_custom_cluster_add_custom_attr(gr_cfg, ZB_ATTR_GRADIENT_STOPS,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &gr->stops);
+        esp_zb_custom_cluster_add_custom_attr(gr_cfg, ZB_ATTR_GRADIENT_SPACE,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &gr->space);
+        for (int k = 0; k < GRADIENT_MAX_STOPS; k++) {
+            esp_zb_custom_cluster_add_custom_attr(gr_cfg, ZB_ATTR_GRADIENT_HUE_BASE + k,
+                ESP_ZB_ZCL_ATTR_TYPE_U16, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &gr->hue[k]);
+            esp_zb_custom_cluster_add_custom_attr(gr_cfg, ZB_ATTR_GRADIENT_SAT_BASE + k,
+                ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &gr->sat[k]);
+            esp_zb_custom_cluster_add_custom_attr(gr_cfg, ZB_ATTR_GRADIENT_POS_BASE + k,
+                ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &gr->pos[k]);
+        }
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(cl, gr_cfg, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+    }
+
     /* Custom clusters on EP1 only */
     if (seg_idx == 0) {
         /* 0xFC00: Device config — per-strip LED counts and global transition time */
@@ -270,6 +315,20 @@ static esp_zb_cluster_list_t *create_segment_clusters(int seg_idx)
 
         ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(cl, preset_cfg, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
 
+        /* 0xFC03: Keyframe timelines — upload and stop per segment channel */
+        esp_zb_attribute_list_t *tl_cfg = esp_zb_zcl_attr_list_create(ZB_CLUSTER_TIMELINE);
+        esp_zb_custom_cluster_add_custom_attr(tl_cfg, ZB_ATTR_TIMELINE_SEGMENT,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &s_tl_segment_attr);
+        esp_zb_custom_cluster_add_custom_attr(tl_cfg, ZB_ATTR_TIMELINE_CHANNEL,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &s_tl_channel_attr);
+        esp_zb_custom_cluster_add_custom_attr(tl_cfg, ZB_ATTR_TIMELINE_MODE,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &s_tl_mode_attr);
+        esp_zb_custom_cluster_add_custom_attr(tl_cfg, ZB_ATTR_TIMELINE_KEYFRAMES,
+            ESP_ZB_ZCL_ATTR_TYPE_OCTET_STRING, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, s_tl_keyframes_attr);
+        esp_zb_custom_cluster_add_custom_attr(tl_cfg, ZB_ATTR_TIMELINE_STOP,
+            ESP_ZB_ZCL_ATTR_TYPE_U8, ESP_ZB_ZCL_ATTR_ACCESS_READ_WRITE, &s_tl_stop_attr);
+        ESP_ERROR_CHECK(esp_zb_cluster_list_add_custom_cluster(cl, tl_cfg, ESP_ZB_ZCL_CLUSTER_SERVER_ROLE));
+
         /* Add OTA cluster to primary endpoint (EP1) */
         zigbee_ota_config_t ota_cfg = ZIGBEE_OTA_CONFIG_DEFAULT();
         ota_cfg.manufacturer_code = 0x131B;  /* Espressif */
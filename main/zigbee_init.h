@@ -4,7 +4,9 @@
  *
  * Device: 8 x Extended Color Light endpoints (EP1-EP8, one per segment).
  * Color mode HS/XY = RGB channels; CT mode = White channel.
- * Segment 1 (EP1) also hosts the device and segment config custom clusters.
+ * Segment 1 (EP1) also hosts the device, segment, preset and timeline custom clusters.
+ * Every segment endpoint hosts its own effect and blend cluster and its
+ * gradient cluster.
  */
 
 #ifndef ZIGBEE_INIT_H
@@ -86,6 +88,56 @@ extern "C" {
 #define ZB_ATTR_DELETE_SLOT             0x0022
 #define ZB_ATTR_SAVE_NAME               0x0023
 
+/**
+ * @brief Custom cluster 0xFC03: Keyframe timelines
+ *   0x0000: segment    (U8, RW) — target segment 0-7 of the next keyframes write
+ *   0x0001: channel    (U8, RW) — 0=level, 1=hue, 2=saturation, 3=color temp
+ *   0x0002: mode       (U8, RW) — 0=one-shot, 1=loop, 2=ping-pong
+ *   0x0003: keyframes  (OctetString, RW) — 7 bytes per key, little-endian:
+ *                      time_ms (U32), value (U16), easing (U8); up to 16 keys.
+ *                      Writing starts the timeline; empty stops the channel.
+ *   0x0004: stop       (U8, RW) — write segment 0-7 (0xFF = all) to stop its timelines
+ */
+#define ZB_CLUSTER_TIMELINE             0xFC03
+#define ZB_ATTR_TIMELINE_SEGMENT        0x0000
+#define ZB_ATTR_TIMELINE_CHANNEL        0x0001
+#define ZB_ATTR_TIMELINE_MODE           0x0002
+#define ZB_ATTR_TIMELINE_KEYFRAMES      0x0003
+#define ZB_ATTR_TIMELINE_STOP           0x0004
+
+/**
+ * @brief Custom cluster 0xFC04: Segment effect and blend mode (EP1-EP8, one per segment)
+ *   0x0000: effect     (U8, RW) — effect_id_t: 0=none, 1=rainbow, 2=chase,
+ *                                 3=twinkle, 4=comet, 5=breathe
+ *   0x0001: speed      (U8, RW) — 0=frozen, 1-255 = 1/64 to ~4 cycles/s
+ *   0x0002: intensity  (U8, RW) — effect specific (see effect_engine.h)
+ *   0x0003: blend      (U8, RW) — blend_mode_t over the segments below:
+ *                                 0=replace, 1=add, 2=max, 3=multiply, 4=alpha
+ *   0x0004: opacity    (U8, RW) — 0-255, alpha blend only
+ */
+#define ZB_CLUSTER_EFFECT               0xFC04
+#define ZB_ATTR_EFFECT_ID               0x0000
+#define ZB_ATTR_EFFECT_SPEED            0x0001
+#define ZB_ATTR_EFFECT_INTENSITY        0x0002
+#define ZB_ATTR_EFFECT_BLEND            0x0003
+#define ZB_ATTR_EFFECT_OPACITY          0x0004
+
+/**
+ * @brief Custom cluster 0xFC05: Segment gradient (EP1-EP8, one per segment)
+ *   0x0000: stops      (U8, RW) — 0=off (solid colour), 2-4 stops in use
+ *   0x0001: space      (U8, RW) — gradient_space_t: 0=RGB, 1=hue wheel
+ *   0x0010+k: stop k hue        (U16, RW) — 0-359 degrees, fades
+ *   0x0020+k: stop k saturation (U8, RW)  — 0-254, fades
+ *   0x0030+k: stop k position   (U8, RW)  — 0-255 along the segment
+ * Hue and saturation changes fade over the global transition time.
+ */
+#define ZB_CLUSTER_GRADIENT             0xFC05
+#define ZB_ATTR_GRADIENT_STOPS          0x0000
+#define ZB_ATTR_GRADIENT_SPACE          0x0001
+#define ZB_ATTR_GRADIENT_HUE_BASE       0x0010
+#define ZB_ATTR_GRADIENT_SAT_BASE       0x0020
+#define ZB_ATTR_GRADIENT_POS_BASE       0x0030
+
 /**
  * @brief Initialize Zigbee stack and create device
  */
@@ -28,10 +28,6 @@ extern void board_led_set_state_pairing(void);
 extern void board_led_set_state_joined(void);
 extern void board_led_set_state_error(void);
 
-/* LED driver functions */
-extern void led_driver_clear(uint8_t strip);
-extern void led_driver_refresh(void);
-
 bool s_network_joined = false;
 
 /* ================================================================== */
@@ -135,9 +131,6 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct)
         ESP_LOGW(TAG, "Left Zigbee network");
         board_led_set_state_not_joined();
         s_network_joined = false;
-        led_driver_clear(0);
-        led_driver_clear(1);
-        led_driver_refresh();
         esp_zb_scheduler_alarm(steering_retry_cb, ESP_ZB_BDB_NETWORK_STEERING, 1000);
         break;
 
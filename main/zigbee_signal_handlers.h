@@ -38,9 +38,9 @@ void zigbee_full_factory_reset(void);
 /**
  * @brief Schedule deferred ZCL sync from Zigbee task context
  *
- * Uses esp_zb_scheduler_alarm to defer sync_zcl_from_state() execution
- * to Zigbee task, avoiding critical section mismatch when called from
- * non-Zigbee tasks (e.g., CLI)
+ * Flags sync_zcl_from_state() for the next ZCL poll tick, which runs in
+ * the Zigbee task, avoiding critical section mismatch when called from
+ * non-Zigbee tasks (e.g., render task, CLI). See led_renderer.c.
  */
 void schedule_zcl_sync(void);
 
@@ -0,0 +1,139 @@
+/**
+ * @file bench_blend.c
+ * @brief Cost of the blend modes, and of replace frames before and after
+ * blending was added to the renderer.
+ *
+ *  - ns per LED of blend_run() in every mode, over 500 LEDs in the
+ *    renderer's 64-LED chunks, next to replace;
+ *  - an all-replace frame (8 overlapping solid segments on two 500-LED
+ *    strips) through the renderer's span dispatch as it was before
+ *    blending and as it is now, which adds one compare per run. Spans are
+ *    filled through the real led_driver.
+ *
+ * Run with an argument to scale the iteration count (default 1).
+ */
+
+#include "blend_engine.h"
+#include "led_driver.h"
+#include "segment_spans.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#define LEDS        500
+#define CHUNK_LEDS  64      /* FX_CHUNK_LEDS in led_renderer.c */
+
+#define CLOBBER(p)  __asm__ volatile("" : : "r"(p) : "memory")
+
+static uint32_t s_dst[CHUNK_LEDS], s_src[CHUNK_LEDS];
+
+static double bench_mode(uint8_t mode, int iters)
+{
+    int64_t t0 = test_now_ns();
+    for (int r = 0; r < iters; r++) {
+        for (int done = 0; done < LEDS; done += CHUNK_LEDS) {
+            uint16_t n = (LEDS - done < CHUNK_LEDS) ? LEDS - done : CHUNK_LEDS;
+            blend_run(mode, 128, s_dst, s_src, n);
+            CLOBBER(s_dst);
+        }
+    }
+    return (double)(test_now_ns() - t0) / iters / LEDS;
+}
+
+/* Stands in for render_effect_span() and render_blend_span(), which an
+ * all-replace frame of solid segments never reaches */
+__attribute__((noinline)) static void other_span(uint8_t strip, const segment_span_t *sp)
+{
+    (void)strip;
+    CLOBBER(sp);
+}
+
+static segment_span_list_t s_spans[MAX_STRIPS];
+static uint8_t s_rgbw[MAX_SEGMENTS][4];
+static volatile uint32_t s_solid = 0xFF, s_opaque = 0xFF;
+
+/* update_leds() before blend modes */
+static void frame_before(void)
+{
+    uint32_t solid = s_solid;
+    for (uint8_t strip = 0; strip < MAX_STRIPS; strip++) {
+        const segment_span_list_t *list = &s_spans[strip];
+        led_driver_clear(strip);
+        for (int i = 0; i < list->count; i++) {
+            const segment_span_t *sp = &list->spans[i];
+            if (solid & (1u << sp->seg)) {
+                const uint8_t *c = s_rgbw[sp->seg];
+                led_driver_fill_range(strip, sp->start, sp->count, c[0], c[1], c[2], c[3]);
+            } else {
+                other_span(strip, sp);
+            }
+        }
+    }
+}
+
+/* update_leds() now */
+static void frame_after(void)
+{
+    uint32_t solid = s_solid, opaque = s_opaque;
+    for (uint8_t strip = 0; strip < MAX_STRIPS; strip++) {
+        const segment_span_list_t *list = &s_spans[strip];
+        led_driver_clear(strip);
+        for (int i = 0; i < list->count; i++) {
+            const segment_span_t *sp = &list->spans[i];
+            uint32_t top = 1u << sp->seg;
+            if (sp->layers != (top & opaque)) {
+                other_span(strip, sp);
+            } else if (solid & top) {
+                const uint8_t *c = s_rgbw[sp->seg];
+                led_driver_fill_range(strip, sp->start, sp->count, c[0], c[1], c[2], c[3]);
+            } else {
+                other_span(strip, sp);
+            }
+        }
+    }
+}
+
+static double bench_frame(void (*frame)(void), int iters)
+{
+    int64_t t0 = test_now_ns();
+    for (int r = 0; r < iters; r++) frame();
+    return (double)(test_now_ns() - t0) / iters;
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    uint32_t seed = 24;
+    for (int i = 0; i < CHUNK_LEDS; i++) {
+        s_dst[i] = test_rand(&seed);
+        s_src[i] = test_rand(&seed);
+    }
+
+    printf("=== blend_run(), %d LEDs in %d-LED chunks ===\n", LEDS, CHUNK_LEDS);
+    printf("  %-9s %8s %10s\n", "mode", "ns/LED", "x replace");
+    double replace = bench_mode(BLEND_REPLACE, 100000 * scale);
+    for (uint8_t m = 0; m < BLEND_COUNT; m++) {
+        double ns = (m == BLEND_REPLACE) ? replace : bench_mode(m, 100000 * scale);
+        printf("  %-9s %8.2f %10.1f\n", blend_name(m), ns, ns / replace);
+    }
+
+    /* Segments 1-8 alternate strips, each overlapping the next */
+    segment_geom_t geom[MAX_SEGMENTS];
+    for (int n = 0; n < MAX_SEGMENTS; n++) {
+        geom[n] = (segment_geom_t){ .start = (uint16_t)((n >> 1) * 125), .count = 140,
+                                    .strip_id = (uint8_t)(n & 1) };
+        for (int c = 0; c < 4; c++) s_rgbw[n][c] = (uint8_t)(n * 30 + c);
+    }
+    segment_spans_build(geom, 0xFF, s_spans);
+    led_driver_init(LEDS, LEDS, LED_STRIP_TYPE_SK6812, LED_STRIP_TYPE_SK6812);
+
+    printf("=== all-replace frame, 8 solid segments on 2 x %d LEDs, ns ===\n", LEDS);
+    printf("  %9s %9s\n", "before", "after");
+    for (int pass = 0; pass < 3; pass++) {
+        double before = bench_frame(frame_before, 200000 * scale);
+        double after  = bench_frame(frame_after, 200000 * scale);
+        printf("  %9.0f %9.0f\n", before, after);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file bench_color_engine.c
+ * @brief ns per call of the fixed-point rgb_to_xy()/xy_to_rgb() against the
+ * float reference (color_float.c), and TSC ticks per call on x86.
+ *
+ * The host has an FPU, so this understates the gap on the ESP32-H2, where
+ * the float path runs in soft-float; `led perf color` gives the device's
+ * cycles per call. Run with an argument to scale the call count (default 1).
+ */
+
+#include "color_engine.h"
+#include "color_float.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+typedef void (*xy_to_rgb_fn)(uint16_t, uint16_t, uint8_t, uint8_t *, uint8_t *, uint8_t *);
+typedef void (*rgb_to_xy_fn)(uint8_t, uint8_t, uint8_t, uint16_t *, uint16_t *);
+
+static volatile uint32_t s_sink;
+
+static uint64_t ticks(void)
+{
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void report(const char *name, int64_t ns, uint64_t tsc, int n)
+{
+    printf("  %-22s %7.1f ns", name, (double)ns / n);
+    if (HAVE_TSC) printf(" %8.1f ticks", (double)tsc / n);
+    printf("\n");
+}
+
+static void bench_xy_to_rgb(const char *name, xy_to_rgb_fn fn, int n)
+{
+    uint8_t r, g, b;
+    int64_t t0 = test_now_ns();
+    uint64_t c0 = ticks();
+    for (int i = 0; i < n; i++) {
+        fn((uint16_t)(i * 37), (uint16_t)(i * 91 + 1000), 200, &r, &g, &b);
+        s_sink += r + g + b;
+    }
+    uint64_t c1 = ticks();
+    report(name, test_now_ns() - t0, c1 - c0, n);
+}
+
+static void bench_rgb_to_xy(const char *name, rgb_to_xy_fn fn, int n)
+{
+    uint16_t x, y;
+    int64_t t0 = test_now_ns();
+    uint64_t c0 = ticks();
+    for (int i = 0; i < n; i++) {
+        fn((uint8_t)i, (uint8_t)(i >> 8), (uint8_t)(i >> 16), &x, &y);
+        s_sink += x + y;
+    }
+    uint64_t c1 = ticks();
+    report(name, test_now_ns() - t0, c1 - c0, n);
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+    int n = 2000000 * scale;
+
+    printf("=== colour conversion, per call ===\n");
+    bench_xy_to_rgb("xy_to_rgb fixed", xy_to_rgb, n);
+    bench_xy_to_rgb("xy_to_rgb float", fl_xy_to_rgb, n);
+    bench_rgb_to_xy("rgb_to_xy fixed", rgb_to_xy, n);
+    bench_rgb_to_xy("rgb_to_xy float", fl_rgb_to_xy, n);
+    return 0;
+}
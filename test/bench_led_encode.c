@@ -0,0 +1,89 @@
+/**
+ * @file bench_led_encode.c
+ * @brief ns per LED of the SPI encoder: the word-at-a-time kernels in
+ * led_driver.c against the bytewise [256][3] table encoder they replaced,
+ * for 30, 300 and 2000 LED strips of each type, and for solid runs.
+ *
+ * Run with an argument to scale the iteration count (default 1).
+ */
+
+#include "../main/led_driver.c"
+#include "test_util.h"
+
+static uint8_t s_ref_lut[256][3];
+
+static void build_ref_lut(void)
+{
+    for (int v = 0; v < 256; v++) {
+        s_ref_lut[v][0] = (uint8_t)s_lut[v];
+        s_ref_lut[v][1] = (uint8_t)(s_lut[v] >> 8);
+        s_ref_lut[v][2] = (uint8_t)(s_lut[v] >> 16);
+    }
+}
+
+/* The previous encoder */
+static uint8_t *ref_encode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    for (size_t i = 0; i < len; i++) {
+        dst[0] = s_ref_lut[src[i]][0];
+        dst[1] = s_ref_lut[src[i]][1];
+        dst[2] = s_ref_lut[src[i]][2];
+        dst += 3;
+    }
+    return dst;
+}
+
+#define MAX_LEDS  2000
+
+static uint32_t s_px[MAX_LEDS];
+static uint32_t s_out[MAX_LEDS * 3];
+
+/* Keep the encoded buffer live across iterations */
+#define CLOBBER(p)  __asm__ volatile("" : : "r"(p) : "memory")
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+    static const uint16_t counts[] = { 30, 300, 2000 };
+    uint32_t seed = 1;
+
+    build_lut();
+    build_ref_lut();
+    for (int i = 0; i < MAX_LEDS; i++) s_px[i] = test_rand(&seed);
+
+    printf("=== SPI encoder, ns per LED ===\n");
+    printf("  %-8s %5s %9s %9s %9s\n", "", "LEDs", "bytewise", "word", "run");
+    for (uint8_t bpl = 3; bpl <= 4; bpl++) {
+        strip_data_t s = { .pixel_buf = (uint8_t *)s_px, .bytes_per_led = bpl };
+        for (size_t k = 0; k < sizeof(counts) / sizeof(counts[0]); k++) {
+            uint16_t n = counts[k];
+            int iters = 2000000 / n * scale;
+
+            int64_t t0 = test_now_ns();
+            for (int r = 0; r < iters; r++) {
+                ref_encode((const uint8_t *)s_px, (size_t)n * bpl, (uint8_t *)s_out);
+                CLOBBER(s_out);
+            }
+            double ref = (double)(test_now_ns() - t0) / iters / n;
+
+            t0 = test_now_ns();
+            for (int r = 0; r < iters; r++) {
+                encode_leds(&s, 0, n, (uint8_t *)s_out);
+                CLOBBER(s_out);
+            }
+            double word = (double)(test_now_ns() - t0) / iters / n;
+
+            t0 = test_now_ns();
+            for (int r = 0; r < iters; r++) {
+                encode_run((const uint8_t *)s_px, bpl, n, (uint8_t *)s_out);
+                CLOBBER(s_out);
+            }
+            double run = (double)(test_now_ns() - t0) / iters / n;
+
+            printf("  %-8s %5u %9.2f %9.2f %9.2f\n", bpl == 4 ? "SK6812" : "WS2812B", n,
+                   ref, word, run);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+/**
+ * @file color_float.c
+ * @brief The float reference build of color_engine.c, linked next to the
+ * fixed-point build with its public functions renamed fl_*.
+ */
+
+#define COLOR_ENGINE_FIXED_POINT 0
+#define hsv_to_rgb         fl_hsv_to_rgb
+#define hsv_to_rgb_q8      fl_hsv_to_rgb_q8
+#define rgb_to_xy          fl_rgb_to_xy
+#define xy_to_rgb          fl_xy_to_rgb
+#define zcl_hue_to_degrees fl_zcl_hue_to_degrees
+#define normalize_hue      fl_normalize_hue
+#define hue_shortest_arc   fl_hue_shortest_arc
+
+#include "../main/color_engine.c"
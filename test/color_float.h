@@ -0,0 +1,10 @@
+/**
+ * @file color_float.h
+ * @brief The float reference conversions from color_float.c.
+ */
+
+#pragma once
+#include <stdint.h>
+
+void fl_rgb_to_xy(uint8_t r, uint8_t g, uint8_t b, uint16_t *x, uint16_t *y);
+void fl_xy_to_rgb(uint16_t x, uint16_t y, uint8_t level, uint8_t *r, uint8_t *g, uint8_t *b);
@@ -0,0 +1,165 @@
+/**
+ * @file fake_spi.c
+ * @brief In-memory SPI bus, GPIO matrix and pins (see fake_spi.h).
+ */
+
+#include "fake_spi.h"
+#include "driver/gpio.h"
+#include "esp_rom_gpio.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/spi_periph.h"
+#include <string.h>
+
+#define QUEUE_MAX   16
+#define MOSI_SIGNAL 99
+
+const spi_signal_conn_t spi_periph_signal[] = { { 0 }, { .spid_out = MOSI_SIGNAL } };
+
+void (*fake_spi_on_queue)(const spi_transaction_t *t, int ahead);
+
+static transaction_cb_t    s_pre, s_post;
+static int                 s_queue_size;
+static spi_transaction_t  *s_queue[QUEUE_MAX];
+static int                 s_head, s_count;
+static int                 s_fail_in = -1;
+static int                 s_cb_writes;
+static int                 s_completed;
+
+static int                 s_route = -1;           /* GPIO carrying MOSI */
+static int                 s_wire_gpio[FAKE_SPI_WIRES];
+static uint8_t             s_wire[FAKE_SPI_WIRES][FAKE_SPI_WIRE_MAX];
+static size_t              s_wire_len[FAKE_SPI_WIRES];
+static int                 s_wires;
+static uint8_t             s_copy[FAKE_SPI_WIRE_MAX];
+
+static int wire_index(int gpio)
+{
+    for (int i = 0; i < s_wires; i++) {
+        if (s_wire_gpio[i] == gpio) return i;
+    }
+    if (s_wires == FAKE_SPI_WIRES) return -1;
+    s_wire_gpio[s_wires] = gpio;
+    return s_wires++;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus, int dma_chan)
+{
+    (void)host;
+    (void)bus;
+    (void)dma_chan;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev,
+                             spi_device_handle_t *handle)
+{
+    static int dummy;
+    (void)host;
+    s_pre  = dev->pre_cb;
+    s_post = dev->post_cb;
+    s_queue_size = dev->queue_size < QUEUE_MAX ? dev->queue_size : QUEUE_MAX;
+    s_head = s_count = 0;
+    *handle = (spi_device_handle_t)&dummy;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *t,
+                                 TickType_t wait)
+{
+    (void)handle;
+    (void)wait;
+    if (s_count == s_queue_size) return ESP_ERR_TIMEOUT;
+    if (fake_spi_on_queue) fake_spi_on_queue(t, s_count);
+    s_queue[(s_head + s_count++) % QUEUE_MAX] = t;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **out,
+                                      TickType_t wait)
+{
+    (void)handle;
+    (void)wait;
+    if (s_fail_in >= 0 && s_fail_in-- == 0) return ESP_ERR_TIMEOUT;
+    if (s_count == 0) return ESP_ERR_TIMEOUT;
+
+    spi_transaction_t *t = s_queue[s_head];
+    s_head = (s_head + 1) % QUEUE_MAX;
+    s_count--;
+
+    size_t len = t->length / 8;
+    if (s_pre) s_pre(t);
+    int w = wire_index(s_route);
+    if (w >= 0 && s_wire_len[w] + len <= FAKE_SPI_WIRE_MAX) {
+        memcpy(s_wire[w] + s_wire_len[w], t->tx_buffer, len);
+        s_wire_len[w] += len;
+    }
+    memcpy(s_copy, t->tx_buffer, len);
+    if (s_post) s_post(t);
+    if (memcmp(s_copy, t->tx_buffer, len) != 0) s_cb_writes++;
+
+    s_completed++;
+    *out = t;
+    return ESP_OK;
+}
+
+void esp_rom_gpio_connect_out_signal(uint32_t gpio, uint32_t signal, bool out_inv, bool oen_inv)
+{
+    (void)out_inv;
+    (void)oen_inv;
+    if (signal == MOSI_SIGNAL) {
+        s_route = (int)gpio;
+    } else if (signal == SIG_GPIO_OUT_IDX && (int)gpio == s_route) {
+        s_route = -1;
+    }
+}
+
+esp_err_t gpio_set_direction(int gpio, gpio_mode_t mode)
+{
+    (void)gpio;
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(int gpio, uint32_t level)
+{
+    (void)gpio;
+    (void)level;
+    return ESP_OK;
+}
+
+const uint8_t *fake_spi_wire(int gpio, size_t *len)
+{
+    int w = wire_index(gpio);
+    *len = (w >= 0) ? s_wire_len[w] : 0;
+    return (w >= 0) ? s_wire[w] : NULL;
+}
+
+void fake_spi_clear_wires(void)
+{
+    memset(s_wire_len, 0, sizeof(s_wire_len));
+}
+
+int fake_spi_queued(void)
+{
+    return s_count;
+}
+
+const spi_transaction_t *fake_spi_peek(int i)
+{
+    return (i < s_count) ? s_queue[(s_head + i) % QUEUE_MAX] : NULL;
+}
+
+void fake_spi_fail_completion(int n)
+{
+    s_fail_in = n;
+}
+
+int fake_spi_callback_writes(void)
+{
+    return s_cb_writes;
+}
+
+int fake_spi_completed(void)
+{
+    return s_completed;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file fake_spi.h
+ * @brief In-memory SPI bus for host tests of led_driver.c.
+ *
+ * Transactions queue in order and complete one per
+ * spi_device_get_trans_result() call. Each runs the device's pre callback,
+ * appends its bytes to the wire of whichever GPIO the pre callback routed
+ * MOSI to, and runs the post callback. A completion can be made to time
+ * out instead, and a hook sees each transaction as it is queued.
+ */
+
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/spi_master.h"
+
+#define FAKE_SPI_WIRES     2
+#define FAKE_SPI_WIRE_MAX  (2000 * 4 * 3 + 64)
+
+/* Bytes sent on a GPIO since the last fake_spi_clear_wires() */
+const uint8_t *fake_spi_wire(int gpio, size_t *len);
+void fake_spi_clear_wires(void);
+
+/* Transactions queued and not yet completed, and the i-th of them */
+int fake_spi_queued(void);
+const spi_transaction_t *fake_spi_peek(int i);
+
+/* The n-th next completion (0 = the next one) times out instead */
+void fake_spi_fail_completion(int n);
+
+/* Post callbacks that changed the buffer of the transaction just sent */
+int fake_spi_callback_writes(void);
+
+/* Called for each transaction as it is queued, with the number already
+ * queued ahead of it */
+extern void (*fake_spi_on_queue)(const spi_transaction_t *t, int ahead);
+
+/* Total transactions completed */
+int fake_spi_completed(void);
@@ -0,0 +1,9 @@
+/* Host stub: provided by the test's fake bus (see fake_spi.c) */
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum { GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+
+esp_err_t gpio_set_direction(int gpio, gpio_mode_t mode);
+esp_err_t gpio_set_level(int gpio, uint32_t level);
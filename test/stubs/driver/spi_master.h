@@ -0,0 +1,50 @@
+/* Host stub: the spi_master subset main/ uses, implemented by fake_spi.c */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum { SPI1_HOST, SPI2_HOST } spi_host_device_t;
+
+#define SPI_DMA_CH_AUTO      3
+#define SPI_DEVICE_NO_DUMMY  (1 << 6)
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t *trans);
+
+struct spi_transaction_t {
+    uint32_t    flags;
+    size_t      length;       /* Bits */
+    void       *user;
+    const void *tx_buffer;
+};
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+} spi_bus_config_t;
+
+typedef struct {
+    uint8_t          mode;
+    int              clock_speed_hz;
+    int              spics_io_num;
+    uint32_t         flags;
+    int              queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+typedef struct spi_device_t *spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *bus, int dma_chan);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *dev,
+                             spi_device_handle_t *handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans,
+                                 TickType_t wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans,
+                                      TickType_t wait);
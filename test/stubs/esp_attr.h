@@ -0,0 +1,4 @@
+/* Host stub: no IRAM/DRAM placement */
+#pragma once
+#define IRAM_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,9 @@
+/* Host stub */
+#pragma once
+#include "esp_err.h"
+
+#define ESP_RETURN_ON_ERROR(x, tag, ...) do {                               \
+    esp_err_t e_ = (x);                                                     \
+    (void)(tag);                                                            \
+    if (e_ != ESP_OK) return e_;                                            \
+} while (0)
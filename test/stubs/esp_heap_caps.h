@@ -0,0 +1,13 @@
+/* Host stub: DMA-capable memory is plain heap */
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
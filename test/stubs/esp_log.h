@@ -0,0 +1,9 @@
+/* Host stub: arguments are still type-checked, never printed */
+#pragma once
+#include <stdio.h>
+
+#define ESP_LOG_STUB_(tag, ...)  do { (void)(tag); if (0) printf(__VA_ARGS__); } while (0)
+#define ESP_LOGE(tag, ...)       ESP_LOG_STUB_(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...)       ESP_LOG_STUB_(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...)       ESP_LOG_STUB_(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...)       ESP_LOG_STUB_(tag, __VA_ARGS__)
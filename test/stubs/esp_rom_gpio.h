@@ -0,0 +1,6 @@
+/* Host stub: provided by the test's fake bus (see fake_spi.c) */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+void esp_rom_gpio_connect_out_signal(uint32_t gpio, uint32_t signal, bool out_inv, bool oen_inv);
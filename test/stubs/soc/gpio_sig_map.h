@@ -0,0 +1,3 @@
+/* Host stub */
+#pragma once
+#define SIG_GPIO_OUT_IDX  128
@@ -0,0 +1,99 @@
+/**
+ * @file test_color_engine.c
+ * @brief The fixed-point rgb_to_xy()/xy_to_rgb() against the float
+ * reference (color_float.c):
+ *  - xy_to_rgb over the full xy grid, every 16th code on each axis, at
+ *    six levels: within 1 in 8-bit units on every channel;
+ *  - rgb_to_xy over all 16.7M colours: within 96/65535 (0.37 8-bit units)
+ *    on x and y;
+ *  - black maps to the D65 white point in both.
+ *
+ * Run with an argument to refine the xy grid (1 = step 16, 2 = step 8,
+ * and so on).
+ */
+
+#include "color_engine.h"
+#include "color_float.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+#define XY_MAX_ERR   1     /* 8-bit units */
+#define RGB_MAX_ERR  96    /* 1/65535 */
+
+static void test_xy_to_rgb(int step)
+{
+    static const uint8_t levels[] = { 255, 200, 128, 64, 16, 1 };
+    long long points = 0, differ = 0;
+    int worst = 0;
+
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        int worst_level = 0;
+        for (int x = 0; x < 65536; x += step) {
+            for (int y = 0; y < 65536; y += step) {
+                uint8_t a[3], b[3];
+                xy_to_rgb((uint16_t)x, (uint16_t)y, levels[l], &a[0], &a[1], &a[2]);
+                fl_xy_to_rgb((uint16_t)x, (uint16_t)y, levels[l], &b[0], &b[1], &b[2]);
+                for (int c = 0; c < 3; c++) {
+                    int e = abs(a[c] - b[c]);
+                    if (e > worst_level) worst_level = e;
+                    if (e) differ++;
+                }
+                points++;
+            }
+        }
+        CHECK(worst_level <= XY_MAX_ERR);
+        if (worst_level > worst) worst = worst_level;
+    }
+    printf("  %lld points, max error %d (8-bit units), %lld channels differ\n", points, worst,
+           differ);
+}
+
+static void test_rgb_to_xy(void)
+{
+    long long differ = 0;
+    int worst = 0;
+
+    for (int r = 0; r < 256; r++) {
+        for (int g = 0; g < 256; g++) {
+            for (int b = 0; b < 256; b++) {
+                uint16_t x1, y1, x2, y2;
+                rgb_to_xy((uint8_t)r, (uint8_t)g, (uint8_t)b, &x1, &y1);
+                fl_rgb_to_xy((uint8_t)r, (uint8_t)g, (uint8_t)b, &x2, &y2);
+                int e = abs(x1 - x2);
+                if (abs(y1 - y2) > e) e = abs(y1 - y2);
+                if (e > worst) worst = e;
+                if (e) differ++;
+            }
+        }
+    }
+    CHECK(worst <= RGB_MAX_ERR);
+    printf("  16.7M colours, max error %d/65535 (%.2f 8-bit units), %lld differ\n", worst,
+           worst / 257.0, differ);
+}
+
+static void test_black(void)
+{
+    uint16_t x1, y1, x2, y2;
+    rgb_to_xy(0, 0, 0, &x1, &y1);
+    fl_rgb_to_xy(0, 0, 0, &x2, &y2);
+    CHECK_EQ(x1, x2);
+    CHECK_EQ(y1, y2);
+
+    uint8_t r, g, b;
+    xy_to_rgb(x1, y1, 0, &r, &g, &b);
+    CHECK(r == 0 && g == 0 && b == 0);
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+    int step = 16 / scale;
+    if (step < 1) step = 1;
+
+    printf("- test_xy_to_rgb\n");
+    test_xy_to_rgb(step);
+    RUN(test_rgb_to_xy);
+    RUN(test_black);
+    return test_summary("test_color_engine");
+}
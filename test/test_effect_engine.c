@@ -0,0 +1,153 @@
+/**
+ * @file test_effect_engine.c
+ * @brief effect_render() chunked as the renderer calls it.
+ *
+ * The renderer asks for a span's pixels FX_CHUNK_LEDS at a time from an
+ * offset that may fall anywhere in the segment (a higher segment can cover
+ * its start), so each kernel must work out its position in the pattern from
+ * the offset alone. Random frames for every effect (random segment length
+ * up to 3000 LEDs, phase, intensity, level and colour) are rendered whole
+ * and then chunk by chunk from a random offset; the two must match byte
+ * for byte. Every LED must also stay within the base colour: channel by
+ * channel at or below the segment colour for the effects that dim it, and
+ * at or below the level with W off for the rainbow. Where effect_solid()
+ * reports a single colour, every LED must show it.
+ *
+ * Run with an argument to scale the frame count (default 1).
+ */
+
+#include "effect_engine.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FX_CHUNK_LEDS  64       /* As led_renderer.c */
+#define MAX_LEN        3000
+
+static uint8_t s_whole[MAX_LEN * 4];
+static uint8_t s_chunk[MAX_LEN * 4];
+
+static void random_frame(effect_frame_t *f, uint8_t id, uint32_t *seed, int n)
+{
+    memset(f, 0, sizeof(*f));
+    f->id        = id;
+    f->intensity = (uint8_t)test_rand(seed);
+    f->seg       = (uint8_t)(test_rand(seed) % MAX_SEGMENTS);
+    f->level     = (uint8_t)test_rand(seed);
+    f->sat       = (uint8_t)(test_rand(seed) % 255);
+    for (int c = 0; c < 4; c++) f->rgbw[c] = (uint8_t)test_rand(seed);
+    f->seg_len   = (uint16_t)(1 + test_rand(seed) % ((n % 2) ? MAX_LEN : 100));
+    f->phase     = test_rand(seed);
+
+    /* Extremes the kernels special-case */
+    switch (n % 8) {
+    case 0: f->intensity = 0;   break;
+    case 1: f->intensity = 255; break;
+    case 2: f->level = 255;     break;
+    case 3: f->phase = 0;       break;
+    default: break;
+    }
+    if (id == EFFECT_NONE && n % 2) {
+        gradient_stop_t st[2] = {
+            { 0,   (uint8_t)(test_rand(seed) % 255), test_rand(seed) % (360u << 16) },
+            { 255, (uint8_t)(test_rand(seed) % 255), test_rand(seed) % (360u << 16) },
+        };
+        gradient_frame_build(&f->grad, (uint8_t)(test_rand(seed) % GRADIENT_SPACE_COUNT),
+                             st, 2, f->level, f->seg_len);
+    }
+}
+
+/* Highest channel value the effect may show, per channel */
+static void ceiling(const effect_frame_t *f, uint8_t top[4])
+{
+    if (f->id == EFFECT_RAINBOW && f->level > 0) {
+        top[0] = top[1] = top[2] = f->level;
+        top[3] = 0;
+    } else if (f->id == EFFECT_NONE && f->grad.stops && f->level > 0) {
+        memset(top, 255, 4);    /* The gradient's own test covers it */
+    } else {
+        memcpy(top, f->rgbw, 4);
+    }
+}
+
+static void test_random(int count)
+{
+    uint32_t seed = 0x3ff3c7u;
+
+    for (uint8_t id = 0; id < EFFECT_COUNT; id++) {
+        int chunk_bad = 0, over = 0, solid_bad = 0, lit = 0;
+        for (int n = 0; n < count; n++) {
+            effect_frame_t f;
+            random_frame(&f, id, &seed, n);
+            uint32_t len = f.seg_len;
+
+            effect_render(&f, 0, (uint16_t)len, s_whole);
+
+            uint32_t first = test_rand(&seed) % len;
+            for (uint32_t x = first; x < len; x += FX_CHUNK_LEDS) {
+                uint32_t run = (len - x < FX_CHUNK_LEDS) ? len - x : FX_CHUNK_LEDS;
+                effect_render(&f, (uint16_t)x, (uint16_t)run, s_chunk + x * 4);
+            }
+            if (memcmp(s_whole + first * 4, s_chunk + first * 4, (len - first) * 4)) {
+                chunk_bad++;
+            }
+
+            uint8_t top[4], solid[4];
+            ceiling(&f, top);
+            bool is_solid = effect_solid(&f, solid);
+            bool any = false;
+            for (uint32_t i = 0; i < len; i++) {
+                const uint8_t *px = s_whole + i * 4;
+                for (int c = 0; c < 4; c++) {
+                    if (px[c] > top[c]) over++;
+                    if (px[c]) any = true;
+                }
+                if (is_solid && memcmp(px, solid, 4)) solid_bad++;
+            }
+            lit += any;
+        }
+        printf("  %-8s %d frames (%d lit): %d chunked mismatches, %d over the base "
+               "colour, %d off the solid colour\n",
+               effect_name(id), count, lit, chunk_bad, over, solid_bad);
+        CHECK(lit > count / 2);
+        CHECK_EQ(chunk_bad, 0);
+        CHECK_EQ(over, 0);
+        CHECK_EQ(solid_bad, 0);
+    }
+}
+
+/* Full brightness leaves the colour as it is: a chase band, a comet head
+ * and a breathe peak show the segment colour exactly */
+static void test_full_scale(void)
+{
+    effect_frame_t f = {
+        .intensity = 64, .level = 200, .rgbw = { 255, 128, 7, 90 }, .seg_len = 100,
+    };
+
+    f.id = EFFECT_CHASE;
+    effect_render(&f, 0, 100, s_whole);
+    CHECK(memcmp(s_whole, f.rgbw, 4) == 0);             /* Band 0-4 at phase 0 */
+    CHECK_EQ(s_whole[5 * 4], 0);
+
+    f.id = EFFECT_COMET;
+    effect_render(&f, 0, 100, s_whole);
+    CHECK(memcmp(s_whole, f.rgbw, 4) == 0);             /* Head at 0 */
+    CHECK(s_whole[99 * 4] < f.rgbw[0]);                 /* Tail wraps behind it */
+
+    f.id    = EFFECT_BREATHE;
+    f.phase = 0x80000000u;                              /* Peak of the wave */
+    uint8_t c[4];
+    CHECK(effect_solid(&f, c));
+    CHECK(memcmp(c, f.rgbw, 4) == 0);
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    RUN(test_full_scale);
+    printf("- test_random\n");
+    test_random(4000 * scale);
+    return test_summary("test_effect_engine");
+}
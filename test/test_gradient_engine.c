@@ -0,0 +1,192 @@
+/**
+ * @file test_gradient_engine.c
+ * @brief gradient_render() against a per-pixel divide.
+ *
+ * Random gradients (2-4 stops, some on the same LED, both spaces, random
+ * level, segments of 1-3000 LEDs) are rendered whole and then the way the
+ * renderer walks a span: from an offset that may fall anywhere in the
+ * segment, FX_CHUNK_LEDS at a time. The chunks must match the whole render
+ * byte for byte, each stop's own LED must show exactly the stop colour (the
+ * later stop where two share an LED), and every LED must be within 1 LSB
+ * of a reference that divides per pixel: the rounded mix of the two stop
+ * colours in RGB, and in hue the exact fraction of the signed (shorter way
+ * round) hue difference with a rounded saturation, through the same
+ * hue_wheel_rgb().
+ *
+ * Run with an argument to scale the gradient count (default 1).
+ */
+
+#include "gradient_engine.h"
+#include "color_engine.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FX_CHUNK_LEDS  64       /* As led_renderer.c */
+#define MAX_LEN        3000
+
+static uint8_t s_whole[MAX_LEN * 4];
+static uint8_t s_chunk[MAX_LEN * 4];
+
+/* Stop pair k with at[k] <= i < at[k + 1], or -1 outside the stops */
+static int pair_at(const gradient_frame_t *g, uint32_t i)
+{
+    for (int k = 0; k < g->stops - 1; k++) {
+        if (g->at[k] <= i && i < g->at[k + 1]) return k;
+    }
+    return -1;
+}
+
+static void reference(const gradient_frame_t *g, uint32_t i, uint8_t *out)
+{
+    int last = g->stops - 1;
+    int k = pair_at(g, i);
+    if (k < 0) {
+        memcpy(out, (i < g->at[0]) ? g->rgb[0] : g->rgb[last], 3);
+        return;
+    }
+
+    int64_t d = g->at[k + 1] - g->at[k], t = i - g->at[k];
+    if (g->space == GRADIENT_HUE) {
+        int64_t  dh = (int32_t)(g->hue[k + 1] - g->hue[k]);
+        uint32_t h  = g->hue[k] + (uint32_t)(dh * t / d);
+        uint32_t s  = (uint32_t)((g->sat[k] * (d - t) + g->sat[k + 1] * t + d / 2) / d);
+        hue_wheel_rgb(h, s, g->level, out);
+    } else {
+        for (int c = 0; c < 3; c++) {
+            out[c] = (uint8_t)((g->rgb[k][c] * (d - t) + g->rgb[k + 1][c] * t + d / 2) / d);
+        }
+    }
+}
+
+static void random_frame(gradient_frame_t *g, uint32_t *seed, int n)
+{
+    gradient_stop_t st[GRADIENT_MAX_STOPS];
+    uint8_t count = (uint8_t)(2 + test_rand(seed) % (GRADIENT_MAX_STOPS - 1));
+    uint16_t len = (uint16_t)(1 + test_rand(seed) % ((n % 2) ? MAX_LEN : 40));
+
+    for (int k = 0; k < count; k++) {
+        st[k].pos     = (uint8_t)test_rand(seed);
+        st[k].sat     = (uint8_t)(test_rand(seed) % 255);
+        st[k].hue_q16 = test_rand(seed) % (360u << 16);
+    }
+    if (n % 3 == 0) {
+        for (int k = 0; k < count; k++) st[k].pos = (uint8_t)(k * 255 / (count - 1));
+    } else if (n % 3 == 1) {
+        st[1].pos = st[0].pos;      /* Hard edge */
+    }
+    gradient_frame_build(g, (n % 4 < 2) ? GRADIENT_RGB : GRADIENT_HUE, st, count,
+                         (uint8_t)test_rand(seed), len);
+}
+
+static void test_random(int count)
+{
+    uint32_t seed = 0x6a4d1e5u;
+    int chunk_bad = 0, stop_bad = 0, worst[GRADIENT_SPACE_COUNT] = { 0 };
+    long edges = 0;
+
+    for (int n = 0; n < count; n++) {
+        gradient_frame_t g;
+        random_frame(&g, &seed, n);
+        uint32_t len = g.at[g.stops - 1] + 1 + test_rand(&seed) % 8;
+        if (len > MAX_LEN) len = MAX_LEN;
+
+        gradient_render(&g, 0, (uint16_t)len, s_whole);
+
+        /* A span from anywhere in the segment, a chunk at a time */
+        uint32_t first = test_rand(&seed) % len;
+        for (uint32_t x = first; x < len; x += FX_CHUNK_LEDS) {
+            uint32_t run = (len - x < FX_CHUNK_LEDS) ? len - x : FX_CHUNK_LEDS;
+            gradient_render(&g, (uint16_t)x, (uint16_t)run, s_chunk + x * 4);
+        }
+        if (memcmp(s_whole + first * 4, s_chunk + first * 4, (len - first) * 4)) {
+            chunk_bad++;
+        }
+
+        for (int k = 0; k < g.stops; k++) {
+            if (k < g.stops - 1 && g.at[k + 1] == g.at[k]) {
+                edges++;
+                continue;       /* The later stop owns the LED */
+            }
+            const uint8_t *px = s_whole + g.at[k] * 4;
+            if (memcmp(px, g.rgb[k], 3) || px[3] != 0) stop_bad++;
+        }
+
+        for (uint32_t i = 0; i < len; i++) {
+            uint8_t ref[3];
+            reference(&g, i, ref);
+            for (int c = 0; c < 3; c++) {
+                int e = abs((int)ref[c] - (int)s_whole[i * 4 + c]);
+                if (e > worst[g.space]) worst[g.space] = e;
+            }
+        }
+    }
+    printf("  %d gradients, %ld shared stops: %d chunked mismatches, %d wrong stop "
+           "colours, max error rgb %d hue %d\n",
+           count, edges, chunk_bad, stop_bad, worst[GRADIENT_RGB], worst[GRADIENT_HUE]);
+    CHECK(edges > 0);
+    CHECK_EQ(chunk_bad, 0);
+    CHECK_EQ(stop_bad, 0);
+    CHECK(worst[GRADIENT_RGB] <= 1);
+    CHECK(worst[GRADIENT_HUE] <= 1);
+}
+
+/* 350 -> 10 degrees runs through red, not round through cyan, and back */
+static void test_shortest_arc(void)
+{
+    const gradient_stop_t up[2]   = { { 0, 254, 350u << 16 }, { 255, 254, 10u << 16 } };
+    const gradient_stop_t down[2] = { { 0, 254, 10u << 16 },  { 255, 254, 350u << 16 } };
+    const gradient_stop_t *sets[2] = { up, down };
+
+    for (int d = 0; d < 2; d++) {
+        gradient_frame_t g;
+        gradient_frame_build(&g, GRADIENT_HUE, sets[d], 2, 255, 201);
+        gradient_render(&g, 0, 201, s_whole);
+        for (uint32_t i = 0; i < 201; i++) {
+            const uint8_t *px = s_whole + i * 4;
+            CHECK(px[0] == 255 && px[1] <= 43 && px[2] <= 43);    /* Within 10 degrees of red */
+        }
+        const uint8_t *mid = s_whole + 100 * 4;
+        CHECK(mid[0] == 255 && mid[1] <= 1 && mid[2] <= 1);
+    }
+}
+
+/* Stops on the same LED: a hard edge, the LED itself taking the later stop */
+static void test_hard_edge(void)
+{
+    const gradient_stop_t st[4] = {
+        {   0, 254,   0u << 16 },
+        { 128, 254, 120u << 16 },
+        { 128, 254, 240u << 16 },
+        { 255, 254,   0u << 16 },
+    };
+    for (int sp = 0; sp < GRADIENT_SPACE_COUNT; sp++) {
+        gradient_frame_t g;
+        gradient_frame_build(&g, (uint8_t)sp, st, 4, 255, 101);
+        CHECK_EQ(g.at[1], 50);
+        CHECK_EQ(g.at[2], 50);
+        gradient_render(&g, 0, 101, s_whole);
+        CHECK(memcmp(s_whole + 50 * 4, g.rgb[2], 3) == 0);
+        for (uint32_t i = 0; i < 101; i++) {
+            uint8_t ref[3];
+            reference(&g, i, ref);
+            for (int c = 0; c < 3; c++) CHECK_NEAR(s_whole[i * 4 + c], ref[c], 1);
+        }
+        /* Chunk boundary on the edge itself */
+        gradient_render(&g, 50, 51, s_chunk + 50 * 4);
+        gradient_render(&g, 0, 50, s_chunk);
+        CHECK(memcmp(s_whole, s_chunk, 101 * 4) == 0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    RUN(test_shortest_arc);
+    RUN(test_hard_edge);
+    printf("- test_random\n");
+    test_random(20000 * scale);
+    return test_summary("test_gradient_engine");
+}
@@ -0,0 +1,254 @@
+/**
+ * @file test_led_driver.c
+ * @brief led_driver.c on a fake SPI bus: what reaches each strip's pin.
+ *
+ * The driver source is included so the tests can reach encode_strip() and
+ * the stream state. Covered:
+ *  - random span and pixel frames on a full-frame and a streamed strip,
+ *    decoded from the wire and compared with the pixels written;
+ *  - a streamed strip's wire bytes equal encode_strip() of the same frame
+ *    into one full buffer, for both strip types, span and pixel frames,
+ *    and lengths that end mid-chunk;
+ *  - every chunk after a stream's first is encoded while its predecessor
+ *    is still queued, and the ISR callbacks never write a chunk;
+ *  - a stream that times out mid-frame reaps its queued chunks before
+ *    returning, and the next frame goes out whole.
+ */
+
+#include "../main/led_driver.c"
+#include "fake_spi.h"
+#include "test_util.h"
+
+#define MAX_LEDS  LED_STRIP_MAX_COUNT
+
+static const int s_pins[LED_DRIVER_MAX_STRIPS] = { LED_STRIP_1_GPIO, LED_STRIP_2_GPIO };
+
+/* What each strip should show, wire order */
+static uint8_t s_ref[LED_DRIVER_MAX_STRIPS][MAX_LEDS * 4];
+
+/* Re-initialise the driver from scratch for a strip configuration */
+static void setup(uint16_t c0, led_strip_type_t t0, uint16_t c1, led_strip_type_t t1)
+{
+    memset(s_strips, 0, sizeof(s_strips));
+    memset(&s_stream, 0, sizeof(s_stream));
+    s_queued = 0;
+    memset(s_ref, 0, sizeof(s_ref));
+    CHECK_EQ(led_driver_init(c0, c1, t0, t1), ESP_OK);
+}
+
+static void ref_fill(int s, int start, int n, uint8_t r, uint8_t g, uint8_t b, uint8_t w)
+{
+    int bpl = s_strips[s].bytes_per_led;
+    uint8_t col[4] = { g, r, b, (bpl == 4) ? w : 0 };
+    for (int i = start; i < start + n && i < s_strips[s].count; i++) {
+        memcpy(s_ref[s] + i * bpl, col, bpl);
+    }
+}
+
+/* Decode wire bytes back to LED bytes; false if the encoding or the reset
+ * tail is malformed */
+static bool decode(const uint8_t *w, size_t len, uint8_t *out, size_t *n)
+{
+    *n = 0;
+    if (len < RESET_BYTES) return false;
+    for (size_t i = len - RESET_BYTES; i < len; i++) {
+        if (w[i] != 0) return false;
+    }
+    len -= RESET_BYTES;
+    if (len % 3) return false;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t bits = ((uint32_t)w[i] << 16) | ((uint32_t)w[i + 1] << 8) | w[i + 2];
+        uint8_t v = 0;
+        for (int b = 7; b >= 0; b--) {
+            uint32_t tri = (bits >> (b * 3)) & 7;
+            if (tri != 6 && tri != 4) return false;
+            v = (uint8_t)((v << 1) | (tri == 6));
+        }
+        out[(*n)++] = v;
+    }
+    return true;
+}
+
+/* Refresh and check that each strip that was sent shows s_ref */
+static void refresh_and_check(void)
+{
+    static uint8_t out[MAX_LEDS * 4];
+    fake_spi_clear_wires();
+    CHECK_EQ(led_driver_refresh(), ESP_OK);
+    for (int s = 0; s < LED_DRIVER_MAX_STRIPS; s++) {
+        size_t len, n;
+        const uint8_t *w = fake_spi_wire(s_pins[s], &len);
+        if (len == 0) continue;
+        size_t want = (size_t)s_strips[s].count * s_strips[s].bytes_per_led;
+        CHECK(decode(w, len, out, &n));
+        CHECK_EQ(n, want);
+        CHECK(memcmp(out, s_ref[s], want) == 0);
+    }
+}
+
+/* Random frames: spans, with pixel writes on some frames */
+static void random_frames(int frames, uint32_t seed)
+{
+    for (int f = 0; f < frames; f++) {
+        bool pixels = test_rand(&seed) & 1;
+        for (int s = 0; s < LED_DRIVER_MAX_STRIPS; s++) {
+            led_driver_clear(s);
+            memset(s_ref[s], 0, sizeof(s_ref[s]));
+        }
+        int ops = test_rand(&seed) % 40;
+        for (int k = 0; k < ops; k++) {
+            int s = test_rand(&seed) % LED_DRIVER_MAX_STRIPS;
+            int cnt = s_strips[s].count;
+            if (cnt == 0) continue;
+            uint8_t r = (uint8_t)(test_rand(&seed) % 4 * 60), g = (uint8_t)(test_rand(&seed) % 3 * 80);
+            uint8_t b = (uint8_t)(test_rand(&seed) % 2 * 200), w = (uint8_t)(test_rand(&seed) % 2 * 30);
+            if (pixels && test_rand(&seed) % 4 == 0) {
+                int i = test_rand(&seed) % cnt;
+                led_driver_set_pixel(s, i, r, g, b, w);
+                ref_fill(s, i, 1, r, g, b, w);
+            } else {
+                int start = test_rand(&seed) % cnt;
+                int n = test_rand(&seed) % (cnt / 2 + 2);
+                led_driver_fill_range(s, start, n, r, g, b, w);
+                ref_fill(s, start, n, r, g, b, w);
+            }
+        }
+        refresh_and_check();
+    }
+}
+
+static void test_random_frames(void)
+{
+    setup(300, LED_STRIP_TYPE_SK6812, 2000, LED_STRIP_TYPE_SK6812);
+    random_frames(300, 1);
+    setup(1999, LED_STRIP_TYPE_WS2812B, 512, LED_STRIP_TYPE_WS2812B);
+    random_frames(300, 2);
+}
+
+/* A streamed strip's wire bytes against encode_strip() of the same frame */
+static void check_stream_vs_encode_strip(int s)
+{
+    strip_data_t *st = &s_strips[s];
+    size_t len;
+    const uint8_t *w = fake_spi_wire(s_pins[s], &len);
+    CHECK_EQ(len, st->spi_len);
+
+    /* Encode the whole frame the full-frame way, from the same state */
+    uint8_t *full = calloc(1, st->spi_len);
+    st->spi_buf[0] = full;
+    st->stale_lo[0] = 0;
+    st->stale_hi[0] = st->count;
+    st->dirty_lo = st->dirty_hi = 0;
+    encode_strip((uint8_t)s, 0);
+    st->spi_buf[0] = NULL;
+    CHECK(len == st->spi_len && memcmp(w, full, len) == 0);
+    free(full);
+}
+
+static void test_stream_matches_encode_strip(void)
+{
+    static const struct { uint16_t count; led_strip_type_t type; } cfg[] = {
+        { 2000, LED_STRIP_TYPE_SK6812 },
+        { 513,  LED_STRIP_TYPE_SK6812 },
+        { 1001, LED_STRIP_TYPE_WS2812B },
+        { 640,  LED_STRIP_TYPE_WS2812B },
+    };
+    uint32_t seed = 7;
+    for (size_t c = 0; c < sizeof(cfg) / sizeof(cfg[0]); c++) {
+        setup(cfg[c].count, cfg[c].type, 0, LED_STRIP_TYPE_SK6812);
+        CHECK(s_strips[0].streamed);
+
+        /* Span frame */
+        led_driver_clear(0);
+        led_driver_fill_range(0, 10, 100, 255, 0, 0, 0);
+        led_driver_fill_range(0, cfg[c].count - 70, 70, 1, 2, 3, 4);
+        fake_spi_clear_wires();
+        CHECK_EQ(led_driver_refresh(), ESP_OK);
+        CHECK(!s_strips[0].pixel_mode);
+        check_stream_vs_encode_strip(0);
+
+        /* Pixel frame */
+        for (int i = 0; i < cfg[c].count; i++) {
+            uint32_t v = test_rand(&seed);
+            led_driver_set_pixel(0, i, (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16),
+                                 (uint8_t)(v >> 24));
+        }
+        fake_spi_clear_wires();
+        CHECK_EQ(led_driver_refresh(), ESP_OK);
+        CHECK(s_strips[0].pixel_mode);
+        check_stream_vs_encode_strip(0);
+    }
+}
+
+/* Chunks queued in a stream, and how many were queued ahead of each */
+static int s_chunks, s_chunks_alone;
+
+static void on_queue(const spi_transaction_t *t, int ahead)
+{
+    if (!(TRANS_FLAGS(t) & TRANS_STREAM)) return;
+    /* The first chunk of a stream has nothing ahead of it */
+    if (s_stream.next_led > STREAM_CHUNK_LEDS && ahead == 0) s_chunks_alone++;
+    s_chunks++;
+}
+
+static void test_stream_overlaps_dma(void)
+{
+    setup(2000, LED_STRIP_TYPE_SK6812, 300, LED_STRIP_TYPE_SK6812);
+    fake_spi_on_queue = on_queue;
+    int writes = fake_spi_callback_writes();
+    s_chunks = s_chunks_alone = 0;
+
+    random_frames(50, 3);
+
+    fake_spi_on_queue = NULL;
+    CHECK(s_chunks >= 50 * (2000 / STREAM_CHUNK_LEDS));
+    CHECK_EQ(s_chunks_alone, 0);
+    CHECK_EQ(fake_spi_callback_writes(), writes);
+}
+
+static void test_stream_error_drains(void)
+{
+    setup(300, LED_STRIP_TYPE_SK6812, 2000, LED_STRIP_TYPE_SK6812);
+
+    /* Fail a completion partway through strip 1's stream: strip 0's frame
+     * is completion 0, the stream's chunks follow */
+    for (int fail = 1; fail < 12; fail += 5) {
+        led_driver_clear(0);
+        led_driver_clear(1);
+        memset(s_ref, 0, sizeof(s_ref));
+        led_driver_fill_range(1, 0, 2000, 10, 20, 30, (uint8_t)fail);
+        ref_fill(1, 0, 2000, 10, 20, 30, (uint8_t)fail);
+        led_driver_fill_range(0, 0, 300, 1, 1, 1, (uint8_t)fail);
+        ref_fill(0, 0, 300, 1, 1, 1, (uint8_t)fail);
+
+        fake_spi_clear_wires();
+        fake_spi_fail_completion(fail);
+        led_driver_refresh_async();
+
+        /* Nothing of the stream is left with the driver */
+        CHECK_EQ(s_stream.pending, 0);
+        CHECK(s_stream.strip == NULL);
+        for (int i = 0; i < fake_spi_queued(); i++) {
+            CHECK(!(TRANS_FLAGS(fake_spi_peek(i)) & TRANS_STREAM));
+        }
+        CHECK_EQ(led_driver_wait_done(100), ESP_OK);
+        CHECK_EQ(fake_spi_queued(), 0);
+        CHECK_EQ(s_queued, 0);
+
+        /* The aborted strip was not marked sent: the next refresh sends it */
+        CHECK(strip_changed(&s_strips[1]));
+        refresh_and_check();
+        size_t len;
+        fake_spi_wire(s_pins[1], &len);
+        CHECK_EQ(len, s_strips[1].spi_len);
+    }
+}
+
+int main(void)
+{
+    RUN(test_random_frames);
+    RUN(test_stream_matches_encode_strip);
+    RUN(test_stream_overlaps_dma);
+    RUN(test_stream_error_drains);
+    return test_summary("test_led_driver");
+}
@@ -0,0 +1,119 @@
+/**
+ * @file test_led_encode.c
+ * @brief The word-at-a-time SPI encoders in led_driver.c against the
+ * bytewise encoder they replaced (three loads from a [256][3] table per
+ * colour byte), bit for bit over random buffers.
+ *
+ * Covers both strip types, every LED count up to 70 plus long strips,
+ * aligned input (the word kernels) and misaligned input (the bytewise
+ * fallback), LED ranges starting on 4-LED boundaries as encode_strip()
+ * and the stream chunks use them, and solid runs (encode_run()).
+ */
+
+#include "../main/led_driver.c"
+#include "test_util.h"
+
+/* The previous encoder: 0 -> 100, 1 -> 110, MSB first on the wire */
+static uint8_t s_ref_lut[256][3];
+
+static void build_ref_lut(void)
+{
+    for (int v = 0; v < 256; v++) {
+        uint32_t bits = 0;
+        for (int i = 7; i >= 0; i--) {
+            bits = (bits << 3) | ((v & (1 << i)) ? 0b110u : 0b100u);
+        }
+        s_ref_lut[v][0] = (uint8_t)(bits >> 16);
+        s_ref_lut[v][1] = (uint8_t)(bits >> 8);
+        s_ref_lut[v][2] = (uint8_t)bits;
+    }
+}
+
+static uint8_t *ref_encode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    for (size_t i = 0; i < len; i++) {
+        dst[0] = s_ref_lut[src[i]][0];
+        dst[1] = s_ref_lut[src[i]][1];
+        dst[2] = s_ref_lut[src[i]][2];
+        dst += 3;
+    }
+    return dst;
+}
+
+#define MAX_LEDS  2000
+
+static uint32_t s_px[MAX_LEDS + 4];                     /* uint32_t: aligned */
+static uint32_t s_out[(MAX_LEDS * 12 + 16) / 4];
+static uint8_t  s_want[MAX_LEDS * 12 + 16];
+
+/* Encode LEDs [first, first + n) from src and compare; the byte past the
+ * end must be left alone */
+static void check_range(uint8_t bpl, const uint8_t *src, uint16_t first, uint16_t n,
+                        uint8_t *dst)
+{
+    strip_data_t s = { .pixel_buf = (uint8_t *)src, .bytes_per_led = bpl };
+    size_t len = (size_t)n * bpl * 3;
+    dst[len] = 0xA5;
+    uint8_t *end = encode_leds(&s, first, n, dst);
+    ref_encode(src + (size_t)first * bpl, (size_t)n * bpl, s_want);
+    CHECK_EQ(end - dst, len);
+    CHECK(memcmp(dst, s_want, len) == 0);
+    CHECK_EQ(dst[len], 0xA5);
+}
+
+static void test_random_buffers(void)
+{
+    uint32_t seed = 0xBADC0DEu;
+    for (uint8_t bpl = 3; bpl <= 4; bpl++) {
+        for (int round = 0; round < 20; round++) {
+            uint8_t *px = (uint8_t *)s_px;
+            for (size_t i = 0; i < sizeof(s_px); i++) px[i] = (uint8_t)test_rand(&seed);
+
+            for (uint16_t n = 0; n <= 70; n++) {
+                check_range(bpl, px, 0, n, (uint8_t *)s_out);          /* Word kernels */
+                check_range(bpl, px + 1, 0, n, (uint8_t *)s_out);      /* Bytewise */
+                check_range(bpl, px, 0, n, (uint8_t *)s_out + 2);
+            }
+            check_range(bpl, px, 0, 30, (uint8_t *)s_out);
+            check_range(bpl, px, 0, 300, (uint8_t *)s_out);
+            check_range(bpl, px, 0, MAX_LEDS, (uint8_t *)s_out);
+
+            /* Ranges as encode_strip() and the stream chunks pass them */
+            for (int k = 0; k < 20; k++) {
+                uint16_t first = (uint16_t)(test_rand(&seed) % (MAX_LEDS / 4) * 4);
+                uint16_t n = (uint16_t)(test_rand(&seed) % (MAX_LEDS - first + 1));
+                check_range(bpl, px, first, n, (uint8_t *)s_out + (size_t)first * bpl * 3);
+            }
+        }
+    }
+}
+
+static void test_runs(void)
+{
+    uint32_t seed = 99;
+    for (uint8_t bpl = 3; bpl <= 4; bpl++) {
+        for (int k = 0; k < 200; k++) {
+            uint8_t color[4];
+            for (int c = 0; c < 4; c++) color[c] = (uint8_t)test_rand(&seed);
+            uint16_t n = (uint16_t)((k < 70) ? (uint32_t)k : test_rand(&seed) % (MAX_LEDS + 1));
+
+            uint8_t *dst = (uint8_t *)s_out;
+            size_t len = (size_t)n * bpl * 3;
+            dst[len] = 0xA5;
+            CHECK_EQ(encode_run(color, bpl, n, dst) - dst, len);
+            uint8_t *w = s_want;
+            for (uint16_t i = 0; i < n; i++) w = ref_encode(color, bpl, w);
+            CHECK(memcmp(dst, s_want, len) == 0);
+            CHECK_EQ(dst[len], 0xA5);
+        }
+    }
+}
+
+int main(void)
+{
+    build_lut();
+    build_ref_lut();
+    RUN(test_random_buffers);
+    RUN(test_runs);
+    return test_summary("test_led_encode");
+}
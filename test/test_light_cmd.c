@@ -0,0 +1,196 @@
+/**
+ * @file test_light_cmd.c
+ * @brief Stress test of the light_cmd rings: one thread per producer
+ * (Zigbee and CLI) against a consumer thread, as the render task drains
+ * them.
+ *
+ * Every command carries its producer's sequence number spread over value
+ * and transition_ms, with a check byte in flags, so the consumer can tell
+ * a lost, duplicated, reordered or torn entry. Two phases:
+ *  - lossless: producers retry on a full ring; every command arrives once,
+ *    in order;
+ *  - overflow: producers post in bursts without retrying and the consumer
+ *    drains more slowly, also in bursts. posted + dropped accounts for
+ *    every attempt, every posted command arrives once and in order, and
+ *    the high-water mark is the ring size. Zigbee drains first, so the
+ *    CLI ring is mostly left full.
+ *
+ * Run with an argument to scale the command count (default 1).
+ */
+
+#include "light_cmd.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define SRCS  LIGHT_CMD_SRC_COUNT
+
+static uint32_t    s_count;          /* Commands (lossless) or attempts per producer */
+static bool        s_retry;
+static atomic_int  s_producers_done;
+
+static uint8_t check_byte(uint32_t seq, int src)
+{
+    return (uint8_t)((seq * 0x9Du) ^ (seq >> 8) ^ (seq >> 24) ^ (uint32_t)src);
+}
+
+static void *producer(void *arg)
+{
+    int src = (int)(intptr_t)arg;
+    for (uint32_t seq = 0; seq < s_count; seq++) {
+        if (!s_retry && seq % 32 == 31) {
+            /* Bursts, as attribute reports arrive: the ring fills and drains */
+            struct timespec ts = { 0, 10000 };
+            nanosleep(&ts, NULL);
+        }
+        for (;;) {
+            bool ok = light_cmd_post_ex((light_cmd_src_t)src, (light_cmd_type_t)(seq % 23),
+                                        (uint8_t)src, (uint16_t)seq, (uint16_t)(seq >> 16),
+                                        check_byte(seq, src));
+            if (ok || !s_retry) break;
+            sched_yield();
+        }
+    }
+    atomic_fetch_add(&s_producers_done, 1);
+    return NULL;
+}
+
+typedef struct {
+    uint32_t received[SRCS];
+    uint32_t bad;                    /* Torn or from an unknown source */
+    uint32_t out_of_order;           /* Lost (lossless), duplicated or reordered */
+} consumer_result_t;
+
+/* Drain until both producers are done and the rings are empty. With
+ * bursts, pause after every few commands so the rings fill up. */
+static void consume(bool bursty, consumer_result_t *res)
+{
+    int64_t next[SRCS] = {0};
+    uint32_t n = 0;
+    *res = (consumer_result_t){0};
+
+    for (;;) {
+        bool done = atomic_load(&s_producers_done) == SRCS;
+        light_cmd_t c;
+        if (!light_cmd_pop(&c)) {
+            if (done) break;
+            sched_yield();
+            continue;
+        }
+        if (c.seg >= SRCS) {
+            res->bad++;
+            continue;
+        }
+        int src = c.seg;
+        uint32_t seq = c.value | ((uint32_t)c.transition_ms << 16);
+        if (c.type != seq % 23 || c.flags != check_byte(seq, src) || c.reserved != 0) {
+            res->bad++;
+        }
+        /* Lossless: exactly the next one. Overflow: later than the last. */
+        if (s_retry ? (int64_t)seq != next[src] : (int64_t)seq < next[src]) {
+            res->out_of_order++;
+        }
+        next[src] = (int64_t)seq + 1;
+        res->received[src]++;
+
+        if (bursty && ++n % 16 == 0) {
+            struct timespec ts = { 0, 20000 };
+            nanosleep(&ts, NULL);
+        }
+    }
+}
+
+static void run_phase(uint32_t count, bool retry, bool bursty, consumer_result_t *res)
+{
+    s_count = count;
+    s_retry = retry;
+    atomic_store(&s_producers_done, 0);
+
+    pthread_t th[SRCS];
+    for (int i = 0; i < SRCS; i++) {
+        pthread_create(&th[i], NULL, producer, (void *)(intptr_t)i);
+    }
+    consume(bursty, res);
+    for (int i = 0; i < SRCS; i++) {
+        pthread_join(th[i], NULL);
+    }
+}
+
+static light_cmd_stats_t s_before;
+
+static void test_lossless(uint32_t count)
+{
+    consumer_result_t res;
+    light_cmd_get_stats(&s_before);
+    run_phase(count, true, false, &res);
+
+    light_cmd_stats_t st;
+    light_cmd_get_stats(&st);
+    printf("  %u commands per producer\n", count);
+    for (int i = 0; i < SRCS; i++) {
+        printf("  src %d: received %u, high water %u\n", i, res.received[i],
+               st.src[i].high_water);
+        CHECK_EQ(res.received[i], count);
+        CHECK_EQ(st.src[i].posted - s_before.src[i].posted, count);
+        CHECK(st.src[i].high_water <= LIGHT_CMD_QUEUE_LEN);
+    }
+    CHECK_EQ(res.bad, 0);
+    CHECK_EQ(res.out_of_order, 0);
+}
+
+static void test_overflow(uint32_t count)
+{
+    consumer_result_t res;
+    light_cmd_get_stats(&s_before);
+    run_phase(count, false, true, &res);
+
+    light_cmd_stats_t st;
+    light_cmd_get_stats(&st);
+    printf("  %u attempts per producer\n", count);
+    for (int i = 0; i < SRCS; i++) {
+        uint32_t posted  = st.src[i].posted - s_before.src[i].posted;
+        uint32_t dropped = st.src[i].dropped - s_before.src[i].dropped;
+        printf("  src %d: posted %u, dropped %u, received %u, high water %u\n", i, posted,
+               dropped, res.received[i], st.src[i].high_water);
+        CHECK_EQ(posted + dropped, count);
+        CHECK_EQ(res.received[i], posted);
+        CHECK(dropped > 0);
+        CHECK_EQ(st.src[i].high_water, LIGHT_CMD_QUEUE_LEN);
+    }
+    /* The rings kept draining while they overflowed */
+    CHECK(res.received[LIGHT_CMD_SRC_ZIGBEE] > 4 * LIGHT_CMD_QUEUE_LEN);
+    CHECK_EQ(res.bad, 0);
+    CHECK_EQ(res.out_of_order, 0);
+}
+
+/* Single-threaded: Zigbee drains before CLI, each in posting order */
+static void test_drain_order(void)
+{
+    light_cmd_post(LIGHT_CMD_SRC_CLI, LIGHT_CMD_LEVEL, 1, 10, 0);
+    light_cmd_post(LIGHT_CMD_SRC_ZIGBEE, LIGHT_CMD_LEVEL, 0, 20, 0);
+    light_cmd_post(LIGHT_CMD_SRC_CLI, LIGHT_CMD_LEVEL, 1, 11, 0);
+    light_cmd_post(LIGHT_CMD_SRC_ZIGBEE, LIGHT_CMD_HUE, 0, 21, 0);
+
+    static const uint16_t want[] = { 20, 21, 10, 11 };
+    light_cmd_t c;
+    for (size_t i = 0; i < sizeof(want) / sizeof(want[0]); i++) {
+        CHECK(light_cmd_pop(&c));
+        CHECK_EQ(c.value, want[i]);
+    }
+    CHECK(!light_cmd_pop(&c));
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    RUN(test_drain_order);
+    printf("- test_lossless\n");
+    test_lossless(1000000u * (uint32_t)scale);
+    printf("- test_overflow\n");
+    test_overflow(50000u * (uint32_t)scale);
+    return test_summary("test_light_cmd");
+}
@@ -0,0 +1,495 @@
+/**
+ * @file test_render_sim.c
+ * @brief The render task against a synthetic Zigbee workload on a virtual
+ * clock: render jitter percentiles, Zigbee task time per frame, and the
+ * latency of commands and of Zigbee frames, checked against fixed bounds.
+ *
+ * One ESP32-H2 core is simulated 1 us at a time with FreeRTOS fixed
+ * priorities: ISRs (1 kHz tick, radio RX, SPI done), the esp_timer task,
+ * the render task (6) and the Zigbee task (5). The render task follows
+ * render_task(): vTaskDelayUntil() on the 5 ms cadence, lateness recorded
+ * with frame_jitter, commands drained from the light_cmd rings, the cadence
+ * restarted after an overrun, and a sleep on a static scene until notified.
+ * The Zigbee task handles received frames (random arrivals plus a burst of
+ * group commands every 2 s), some of which post light commands, and runs
+ * the 5 ms ZCL poll. CPU costs are a model of the H2 at 96 MHz (the
+ * constants below); the scheduling rules, the command rings and the jitter
+ * statistics are the firmware's.
+ *
+ * For comparison the same workload also runs with rendering done the old
+ * way, as a 5 ms scheduler alarm in the Zigbee task with blocking SPI. Its
+ * figures are printed, not checked.
+ *
+ * Bounds, for 2 x 30, 2 x 150 and 2 x 500 LEDs, static and animated:
+ *  - render jitter p50 <= 50 us and p99 <= 100 us;
+ *  - Zigbee task time on LED work <= 200 us in every 5 ms frame;
+ *  - light command posted to applied: p99 <= 5.5 ms, max <= 10 ms;
+ *  - Zigbee frame received to handled: p99 <= 2.5 ms;
+ *  - no render overruns.
+ *
+ * Run with an argument to scale the simulated time (default 20 s).
+ */
+
+#include "board_config.h"
+#include "frame_jitter.h"
+#include "light_cmd.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Firmware timing (led_renderer.c, sdkconfig.defaults) */
+#define TICK_US             1000    /* CONFIG_FREERTOS_HZ=1000 */
+#define RENDER_PERIOD_US    5000
+#define RENDER_PERIOD_TICKS 5
+#define ZCL_POLL_TICKS      5
+
+/* Cost model, us unless noted */
+#define TICK_ISR_US         3
+#define RADIO_ISR_US        20
+#define SPI_ISR_US          5
+#define TIMER_CB_PERIOD_US  10000   /* esp_timer callbacks (stack timers, save timer) */
+#define TIMER_CB_US         15
+#define ZB_FRAME_MIN_US     150     /* Stack processing per received frame */
+#define ZB_FRAME_MAX_US     700
+#define ZB_POLL_US          30      /* Snapshot and compare of 9 endpoints */
+#define ZB_POST_US          3       /* Per command posted by the poll */
+#define CMD_APPLY_US        6
+#define FRAME_FIXED_US      40      /* Transition, timeline and effect sampling */
+#define LED_COMPOSE_NS      600     /* Per LED: effect pixels into the strip */
+#define LED_ENCODE_NS       400     /* Per LED: SPI encode */
+#define WIRE_NS_PER_LED     30000   /* 24 bits at 800 kHz */
+#define WIRE_RESET_US       80
+
+/* Workload */
+#define ZB_FRAME_MEAN_US    20000   /* 50 frames/s */
+#define BURST_PERIOD_US     2000000
+#define BURST_FRAMES        9       /* A group command reaching every endpoint */
+#define BURST_GAP_US        3000
+#define CMD_FADE_MAX_MS     250
+
+/* Bounds */
+#define JITTER_P50_MAX_US   50
+#define JITTER_P99_MAX_US   100
+#define ZB_LED_MAX_US       200
+#define CMD_P99_MAX_US      5500
+#define CMD_MAX_US          10000
+#define ZB_FRAME_P99_MAX_US 2500
+
+#define NEVER               INT64_MAX
+#define ZB_QUEUE_MAX        64
+
+/* Latency samples, for exact percentiles */
+typedef struct {
+    uint32_t *v;
+    size_t    n, cap;
+} samples_t;
+
+static void samples_add(samples_t *s, int64_t us)
+{
+    if (s->n == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 1024;
+        s->v = realloc(s->v, s->cap * sizeof(s->v[0]));
+    }
+    s->v[s->n++] = (uint32_t)us;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Sorts in place; permille 1000 = max */
+static uint32_t samples_pct(samples_t *s, uint32_t permille)
+{
+    if (s->n == 0) return 0;
+    qsort(s->v, s->n, sizeof(s->v[0]), cmp_u32);
+    size_t i = (s->n * permille + 999) / 1000;
+    return s->v[i ? i - 1 : 0];
+}
+
+typedef struct {
+    uint16_t leds_per_strip;
+    bool     effects;       /* A moving effect keeps the render task busy */
+    bool     legacy;        /* Render as a Zigbee task alarm, blocking SPI */
+} scenario_t;
+
+typedef enum { JOB_FRAME, JOB_POLL, JOB_RENDER } job_kind_t;
+
+/* What a received frame leads to once handled */
+typedef enum { FRAME_OTHER, FRAME_CMD, FRAME_MOVE } frame_kind_t;
+
+typedef struct {
+    job_kind_t   kind;
+    frame_kind_t frame;
+    bool         started;
+    int64_t      arrival_us;  /* Frame received, or alarm due */
+    int64_t      cpu_left;
+    int64_t      blocked_to;  /* JOB_RENDER: waiting for the SPI transfer */
+} job_t;
+
+typedef enum { R_DELAYED, R_WAIT_NOTIFY, R_READY } render_state_t;
+
+static struct {
+    const scenario_t *sc;
+    uint32_t seed;
+    int64_t  now;           /* us */
+    int64_t  tick;
+
+    /* Higher-priority work pending, us of CPU */
+    int64_t  isr_us;
+    int64_t  timer_us;
+    int64_t  next_timer_cb;
+
+    /* SPI */
+    int64_t  dma_end;
+
+    /* Render task (render_task()) */
+    render_state_t rstate;
+    bool     notified;
+    bool     idle_wake;
+    bool     in_frame;
+    int64_t  wake_tick, last_wake, deadline_us;
+    int64_t  work_left;
+    bool     changed;       /* This frame applied commands */
+    bool     frame_dirty;   /* Pixels changed since the last frame sent */
+    int64_t  anim_end;
+
+    /* Zigbee task: FIFO of jobs, alarms rearmed on completion */
+    job_t    zq[ZB_QUEUE_MAX];
+    int      zq_head, zq_count;
+    int64_t  poll_due_tick, render_due_tick;
+    int      poll_dirty;    /* Endpoints the SDK changed since the last poll */
+    int64_t  next_frame;
+
+    /* Command post times, by sequence number in value */
+    uint16_t cmd_seq;
+    int64_t  cmd_posted[65536];
+
+    /* Zigbee task time on LED work in the current 5 ms frame */
+    int64_t  zb_led_window, zb_led_us, zb_led_max;
+
+    /* Results */
+    frame_jitter_t jitter;
+    samples_t cmd_lat, zb_lat;
+    uint32_t  frames, overruns, idle_entries, dropped;
+} S;
+
+static int64_t rand_between(int64_t lo, int64_t hi)
+{
+    return lo + (int64_t)(test_rand(&S.seed) % (uint32_t)(hi - lo + 1));
+}
+
+static int64_t compose_us(int cmds)
+{
+    int64_t leds = 2 * (int64_t)S.sc->leds_per_strip;
+    return FRAME_FIXED_US + cmds * CMD_APPLY_US + leds * (LED_COMPOSE_NS + LED_ENCODE_NS) / 1000;
+}
+
+static int64_t wire_us(void)
+{
+    return 2 * ((int64_t)S.sc->leds_per_strip * WIRE_NS_PER_LED / 1000 + WIRE_RESET_US);
+}
+
+static void zb_push(job_kind_t kind, frame_kind_t frame, int64_t cpu)
+{
+    CHECK(S.zq_count < ZB_QUEUE_MAX);
+    if (S.zq_count == ZB_QUEUE_MAX) return;
+    S.zq[(S.zq_head + S.zq_count++) % ZB_QUEUE_MAX] = (job_t){
+        .kind = kind, .frame = frame, .arrival_us = S.now, .cpu_left = cpu,
+    };
+}
+
+/* led_renderer_request_update() */
+static void notify_render(void)
+{
+    S.notified = true;
+    if (S.rstate == R_WAIT_NOTIFY) {
+        S.rstate = R_READY;
+        S.idle_wake = true;
+    }
+}
+
+static void post_cmd(light_cmd_type_t type)
+{
+    uint16_t seq = S.cmd_seq++;
+    uint8_t seg = (uint8_t)(test_rand(&S.seed) % MAX_SEGMENTS);
+    if (light_cmd_post(LIGHT_CMD_SRC_ZIGBEE, type, seg, seq, (uint16_t)rand_between(0, CMD_FADE_MAX_MS))) {
+        S.cmd_posted[seq] = S.now;
+    } else {
+        S.dropped++;
+    }
+    notify_render();
+}
+
+/* Drain the rings at the start of a frame, as apply_light_cmds() does */
+static int apply_cmds(void)
+{
+    light_cmd_t c;
+    int n = 0;
+    while (light_cmd_pop(&c)) {
+        samples_add(&S.cmd_lat, S.now - S.cmd_posted[c.value]);
+        int64_t end = S.now + (int64_t)c.transition_ms * 1000;
+        if (end > S.anim_end) S.anim_end = end;
+        n++;
+    }
+    if (n) S.frame_dirty = true;
+    return n;
+}
+
+/* A frame arrives: the radio ISR, then the Zigbee task handles it. Some
+ * are light commands (attribute handlers post them), some are SDK-driven
+ * moves that change attributes for the ZCL poll to pick up. */
+static void receive_frame(bool group_cmd)
+{
+    S.isr_us += RADIO_ISR_US;
+    uint32_t r = test_rand(&S.seed) % 10;
+    frame_kind_t kind = (group_cmd || r < 4) ? FRAME_CMD : (r == 4) ? FRAME_MOVE : FRAME_OTHER;
+    zb_push(JOB_FRAME, kind, rand_between(ZB_FRAME_MIN_US, ZB_FRAME_MAX_US));
+}
+
+static bool is_burst_frame(int64_t t)
+{
+    int64_t phase = (t + 777321) % BURST_PERIOD_US;
+    return phase % BURST_GAP_US == 0 && phase / BURST_GAP_US < BURST_FRAMES;
+}
+
+static void events(void)
+{
+    if (S.now % TICK_US == 0) {
+        S.tick = S.now / TICK_US;
+        S.isr_us += TICK_ISR_US;
+        if (S.rstate == R_DELAYED && S.tick >= S.wake_tick) S.rstate = R_READY;
+        if (S.tick >= S.poll_due_tick) {
+            zb_push(JOB_POLL, FRAME_OTHER, ZB_POLL_US + S.poll_dirty * ZB_POST_US);
+            S.poll_due_tick = NEVER;
+        }
+        if (S.tick >= S.render_due_tick) {
+            zb_push(JOB_RENDER, FRAME_OTHER, 0);
+            S.render_due_tick = NEVER;
+        }
+    }
+    if (S.now == S.next_timer_cb) {
+        S.timer_us += TIMER_CB_US;
+        S.next_timer_cb += TIMER_CB_PERIOD_US;
+    }
+    if (S.now == S.dma_end) S.isr_us += SPI_ISR_US;
+    if (S.now == S.next_frame) {
+        receive_frame(false);
+        S.next_frame = S.now + rand_between(1, 2 * ZB_FRAME_MEAN_US);
+    }
+    if (is_burst_frame(S.now)) receive_frame(true);
+
+    /* Zigbee task time on LED work, per 5 ms frame; blocked on SPI counts */
+    int64_t window = S.now / RENDER_PERIOD_US;
+    if (window != S.zb_led_window) {
+        if (S.zb_led_us > S.zb_led_max) S.zb_led_max = S.zb_led_us;
+        S.zb_led_window = window;
+        S.zb_led_us = 0;
+    }
+    if (S.zq_count) {
+        job_t *j = &S.zq[S.zq_head];
+        if (j->kind == JOB_RENDER && j->blocked_to) {
+            if (S.now < j->blocked_to) {
+                S.zb_led_us++;
+            } else {
+                S.zq_head = (S.zq_head + 1) % ZB_QUEUE_MAX;
+                S.zq_count--;
+                S.render_due_tick = S.tick + RENDER_PERIOD_TICKS;
+            }
+        }
+    }
+}
+
+/* One us of the render task (render_task()) */
+static void render_us(void)
+{
+    if (!S.in_frame) {
+        S.in_frame = true;
+        if (S.idle_wake) {
+            S.idle_wake   = false;
+            S.last_wake   = S.tick;
+            S.deadline_us = S.now + RENDER_PERIOD_US;
+        } else {
+            int64_t late = S.now - S.deadline_us;
+            frame_jitter_record(&S.jitter, late > 0 ? (uint32_t)late : 0);
+            S.deadline_us += RENDER_PERIOD_US;
+        }
+        S.notified  = false;
+        int cmds    = apply_cmds();
+        S.changed   = cmds > 0;
+        S.work_left = compose_us(cmds);
+    }
+    if (--S.work_left > 0) return;
+
+    /* update_leds(): queue the frame unless the last is still on the wire */
+    int64_t end = S.now + 1;
+    bool animating = end < S.anim_end;
+    if (animating || S.sc->effects) S.frame_dirty = true;
+    bool pending = S.frame_dirty && end < S.dma_end;
+    if (S.frame_dirty && !pending) {
+        S.dma_end = end + wire_us();
+        S.frame_dirty = false;
+    }
+    bool busy = S.changed || animating || S.sc->effects || pending;
+    S.frames++;
+    S.in_frame = false;
+
+    if (end >= S.deadline_us) {
+        S.overruns++;
+        S.last_wake   = S.tick;
+        S.deadline_us = end + RENDER_PERIOD_US;
+    }
+    if (busy) {
+        /* vTaskDelayUntil(): returns at once if the wake time has passed */
+        S.last_wake += RENDER_PERIOD_TICKS;
+        S.wake_tick = S.last_wake;
+        S.rstate = (S.wake_tick <= S.tick) ? R_READY : R_DELAYED;
+    } else if (S.notified) {
+        S.rstate = R_READY;
+        S.idle_wake = true;
+        S.idle_entries++;
+    } else {
+        S.rstate = R_WAIT_NOTIFY;
+        S.idle_entries++;
+    }
+}
+
+/* One us of the Zigbee task */
+static void zigbee_us(void)
+{
+    if (S.zq_count == 0) return;
+    job_t *j = &S.zq[S.zq_head];
+    if (j->blocked_to) return;
+
+    if (!j->started) {
+        j->started = true;
+        if (j->kind == JOB_RENDER) {
+            /* The old led_render_cb: poll, apply and compose inline */
+            int64_t late = S.now - j->arrival_us;
+            frame_jitter_record(&S.jitter, (uint32_t)late);
+            j->cpu_left = ZB_POLL_US + compose_us(apply_cmds());
+            S.frames++;
+        }
+    }
+    if (j->kind != JOB_FRAME) S.zb_led_us++;
+    if (--j->cpu_left > 0) return;
+
+    switch (j->kind) {
+    case JOB_FRAME:
+        samples_add(&S.zb_lat, S.now + 1 - j->arrival_us);
+        if (j->frame == FRAME_CMD) {
+            post_cmd(LIGHT_CMD_LEVEL);
+        } else if (j->frame == FRAME_MOVE) {
+            S.poll_dirty++;
+        }
+        break;
+    case JOB_POLL:
+        for (; S.poll_dirty > 0; S.poll_dirty--) post_cmd(LIGHT_CMD_LEVEL);
+        S.poll_due_tick = S.tick + ZCL_POLL_TICKS;
+        break;
+    case JOB_RENDER: {
+        /* Blocking transmit: the task waits for the wire */
+        int64_t start = (S.dma_end > S.now + 1) ? S.dma_end : S.now + 1;
+        S.dma_end = start + wire_us();
+        j->blocked_to = S.dma_end;
+        /* In the old design attribute moves were applied by the render */
+        S.poll_dirty = 0;
+        return;
+    }
+    }
+    S.zq_head = (S.zq_head + 1) % ZB_QUEUE_MAX;
+    S.zq_count--;
+}
+
+static void simulate(const scenario_t *sc, int64_t duration_us)
+{
+    free(S.cmd_lat.v);
+    free(S.zb_lat.v);
+    memset(&S, 0, sizeof(S));
+    S.sc = sc;
+    S.seed = 6;
+    S.next_timer_cb = TIMER_CB_PERIOD_US / 2 + 7;
+    S.next_frame = 1234;
+    S.dma_end = -1;
+    S.zb_led_window = 0;
+    if (sc->legacy) {
+        S.rstate = R_WAIT_NOTIFY;   /* No render task */
+        S.poll_due_tick = NEVER;
+        S.render_due_tick = RENDER_PERIOD_TICKS;
+    } else {
+        /* render_task() starts busy and waits for the first deadline */
+        S.rstate = R_DELAYED;
+        S.wake_tick = S.last_wake = RENDER_PERIOD_TICKS;
+        S.deadline_us = RENDER_PERIOD_US;
+        S.poll_due_tick = ZCL_POLL_TICKS;
+        S.render_due_tick = NEVER;
+    }
+
+    light_cmd_t c;
+    while (light_cmd_pop(&c)) {}
+
+    for (S.now = 0; S.now < duration_us; S.now++) {
+        events();
+        if (S.isr_us) {
+            S.isr_us--;
+        } else if (S.timer_us) {
+            S.timer_us--;
+        } else if (!sc->legacy && S.rstate == R_READY) {
+            render_us();
+        } else {
+            zigbee_us();
+        }
+    }
+    if (S.zb_led_us > S.zb_led_max) S.zb_led_max = S.zb_led_us;
+}
+
+static void report_and_check(const scenario_t *sc)
+{
+    uint32_t p50  = frame_jitter_percentile(&S.jitter, 500);
+    uint32_t p99  = frame_jitter_percentile(&S.jitter, 990);
+    uint32_t p999 = frame_jitter_percentile(&S.jitter, 999);
+    uint32_t cmd99 = samples_pct(&S.cmd_lat, 990), cmd_max = samples_pct(&S.cmd_lat, 1000);
+    uint32_t zb99  = samples_pct(&S.zb_lat, 990),  zb_max  = samples_pct(&S.zb_lat, 1000);
+
+    printf("  %-6s %2s %5u | %5u %5u %5u %6u | %6lld | %6u %6u | %6u %6u | %6u %5u %4u\n",
+           sc->legacy ? "old" : "task", sc->effects ? "fx" : "-", 2 * sc->leds_per_strip,
+           p50, p99, p999, S.jitter.max_us, (long long)S.zb_led_max, cmd99, cmd_max,
+           zb99, zb_max, S.frames, S.idle_entries, S.overruns);
+    if (sc->legacy) return;
+
+    CHECK(p50 <= JITTER_P50_MAX_US);
+    CHECK(p99 <= JITTER_P99_MAX_US);
+    CHECK(S.zb_led_max <= ZB_LED_MAX_US);
+    CHECK(S.cmd_lat.n > 0);
+    CHECK(cmd99 <= CMD_P99_MAX_US);
+    CHECK(cmd_max <= CMD_MAX_US);
+    CHECK(zb99 <= ZB_FRAME_P99_MAX_US);
+    CHECK_EQ(S.overruns, 0);
+    CHECK_EQ(S.dropped, 0);
+    /* A static scene sleeps between commands; an effect never does */
+    CHECK(sc->effects ? S.idle_entries == 0 : S.idle_entries > 0);
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+    int64_t duration_us = 20000000LL * scale;
+
+    static const uint16_t leds[] = { 30, 150, 500 };
+    printf("- %lld s simulated per run, per-frame figures in us\n", (long long)(duration_us / 1000000));
+    printf("  %-6s %2s %5s | %5s %5s %5s %6s | %6s | %6s %6s | %6s %6s | %6s %5s %4s\n",
+           "render", "", "LEDs", "p50", "p99", "p99.9", "max", "zb LED", "cmd99", "cmdmax",
+           "zb99", "zbmax", "frames", "idle", "over");
+    for (int legacy = 0; legacy < 2; legacy++) {
+        for (int fx = legacy; fx < 2; fx++) {
+            for (size_t i = 0; i < sizeof(leds) / sizeof(leds[0]); i++) {
+                scenario_t sc = { .leds_per_strip = leds[i], .effects = fx, .legacy = legacy };
+                simulate(&sc, duration_us);
+                report_and_check(&sc);
+            }
+        }
+    }
+    return test_summary("test_render_sim");
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_segment_spans.c
+ * @brief segment_spans_build() against the painter's algorithm it replaced:
+ * clear each strip, then paint segments 0-7 in order, each pixel keeping
+ * the segments composited there down to the first opaque one.
+ *
+ * Random geometries, pixel for pixel over random strip lengths, in four
+ * shapes: everything on strip 0, both strips, starts and counts anywhere
+ * up to 65535, and segments sharing a few edges. Each also gets a random
+ * set of blending (non-opaque) segments. The span lists must be ascending,
+ * non-overlapping, owned by the top layer, and report exactly the visible
+ * segments.
+ *
+ * Run with an argument to scale the geometry count (default 1).
+ */
+
+#include "segment_spans.h"
+#include "test_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LEDS  LED_STRIP_MAX_COUNT
+
+/* Per pixel: owning segment + 1 (0 = black) and the layers shown */
+typedef struct {
+    uint8_t owner;
+    uint8_t layers;
+} pixel_t;
+
+static pixel_t s_paint[MAX_STRIPS][MAX_LEDS];
+static pixel_t s_spans[MAX_STRIPS][MAX_LEDS];
+
+static void paint(const segment_geom_t *geom, uint32_t opaque, const uint16_t *len)
+{
+    memset(s_paint, 0, sizeof(s_paint));
+    for (int n = 0; n < MAX_SEGMENTS; n++) {
+        const segment_geom_t *g = &geom[n];
+        if (g->count == 0 || g->strip_id >= MAX_STRIPS) continue;
+        uint32_t end = (uint32_t)g->start + g->count;
+        for (uint32_t i = g->start; i < end && i < len[g->strip_id]; i++) {
+            pixel_t *p = &s_paint[g->strip_id][i];
+            p->layers = (opaque & (1u << n)) ? (uint8_t)(1u << n) : (uint8_t)(p->layers | 1u << n);
+            p->owner = (uint8_t)(n + 1);
+        }
+    }
+}
+
+/* Fill from the span lists, checking their shape; returns the layers of
+ * every span, clipped or not */
+static uint32_t fill_spans(const segment_span_list_t *sl, const uint16_t *len)
+{
+    uint32_t seen = 0;
+    memset(s_spans, 0, sizeof(s_spans));
+    for (int s = 0; s < MAX_STRIPS; s++) {
+        CHECK(sl[s].count <= SEGMENT_SPANS_MAX);
+        uint32_t prev_end = 0;
+        for (int k = 0; k < sl[s].count; k++) {
+            const segment_span_t *sp = &sl[s].spans[k];
+            CHECK(sp->count > 0);
+            CHECK(sp->start >= prev_end);
+            CHECK(sp->layers & (1u << sp->seg));
+            CHECK(sp->layers >> sp->seg == 1);      /* seg is the top layer */
+            prev_end = (uint32_t)sp->start + sp->count;
+            seen |= sp->layers;
+            for (uint32_t i = sp->start; i < prev_end && i < len[s]; i++) {
+                s_spans[s][i] = (pixel_t){ (uint8_t)(sp->seg + 1), sp->layers };
+            }
+        }
+    }
+    return seen;
+}
+
+/* What painting the whole 16-bit LED range would show: the layers of
+ * segments that are not fully covered by opaque ones above */
+static uint32_t visible_ref(const segment_geom_t *geom, uint32_t opaque)
+{
+    uint32_t vis = 0;
+    for (int n = 0; n < MAX_SEGMENTS; n++) {
+        const segment_geom_t *g = &geom[n];
+        if (g->count == 0 || g->strip_id >= MAX_STRIPS) continue;
+        uint32_t end = (uint32_t)g->start + g->count;
+        if (end > UINT16_MAX) end = UINT16_MAX;
+        for (uint32_t i = g->start; i < end; i++) {
+            bool hidden = false;
+            for (int m = n + 1; m < MAX_SEGMENTS && !hidden; m++) {
+                const segment_geom_t *h = &geom[m];
+                hidden = (opaque & (1u << m)) && h->count && h->strip_id == g->strip_id &&
+                         h->start <= i && i < (uint32_t)h->start + h->count;
+            }
+            if (!hidden) {
+                vis |= 1u << n;
+                break;
+            }
+        }
+    }
+    return vis;
+}
+
+static void random_geom(int shape, uint32_t *seed, segment_geom_t *geom, uint16_t *len)
+{
+    len[0] = (uint16_t)(1 + test_rand(seed) % MAX_LEDS);
+    len[1] = (test_rand(seed) % 3) ? (uint16_t)(1 + test_rand(seed) % 300) : 0;
+    for (int n = 0; n < MAX_SEGMENTS; n++) {
+        segment_geom_t *g = &geom[n];
+        g->strip_id = (shape == 0) ? 0 : (uint8_t)(test_rand(seed) % (MAX_STRIPS + 1) % MAX_STRIPS);
+        if (test_rand(seed) % 5 == 0) {
+            g->count = 0;
+        } else if (shape == 2) {
+            g->count = (uint16_t)test_rand(seed);
+        } else {
+            g->count = (uint16_t)(1 + test_rand(seed) % (len[0] + 50));
+        }
+        if (shape == 2) {
+            g->start = (uint16_t)test_rand(seed);
+        } else if (shape == 3) {
+            g->start = (uint16_t)(test_rand(seed) % 8 * 10);
+        } else {
+            g->start = (uint16_t)(test_rand(seed) % (len[0] + 20));
+        }
+    }
+}
+
+static void test_random_geometries(int count)
+{
+    uint32_t seed = 21;
+    int max_spans = 0;
+    long long mismatches = 0;
+
+    for (int it = 0; it < count; it++) {
+        segment_geom_t geom[MAX_SEGMENTS];
+        uint16_t len[MAX_STRIPS];
+        random_geom(it % 4, &seed, geom, len);
+        /* Half all opaque, half with random blending segments */
+        uint32_t opaque = (it & 4) ? test_rand(&seed) & 0xFF : 0xFF;
+
+        segment_span_list_t sl[MAX_STRIPS];
+        uint32_t vis = segment_spans_build(geom, opaque, sl);
+        paint(geom, opaque, len);
+        uint32_t seen = fill_spans(sl, len);
+
+        CHECK_EQ(vis, seen);
+        CHECK_EQ(vis, visible_ref(geom, opaque));
+        if (memcmp(s_paint, s_spans, sizeof(s_paint)) != 0) {
+            mismatches++;
+            CHECK(false);
+        }
+        for (int s = 0; s < MAX_STRIPS; s++) {
+            if (sl[s].count > max_spans) max_spans = sl[s].count;
+        }
+    }
+    printf("  %d geometries, %lld mismatches, max %d spans per strip\n", count, mismatches,
+           max_spans);
+}
+
+/* Fixed cases: full cover, a nested overlay, touching and past-the-end */
+static void test_layouts(void)
+{
+    segment_span_list_t sl[MAX_STRIPS];
+    segment_geom_t geom[MAX_SEGMENTS] = {0};
+
+    /* Segment 0 over 100 LEDs, segment 1 on 40-60: three runs */
+    geom[0] = (segment_geom_t){ .start = 0, .count = 100 };
+    geom[1] = (segment_geom_t){ .start = 40, .count = 20 };
+    CHECK_EQ(segment_spans_build(geom, 0xFF, sl), 0x03);
+    CHECK_EQ(sl[0].count, 3);
+    CHECK(sl[0].spans[1].start == 40 && sl[0].spans[1].count == 20 && sl[0].spans[1].seg == 1);
+    CHECK_EQ(sl[1].count, 0);
+
+    /* The overlay blends: the middle run composites both */
+    segment_spans_build(geom, 0x01, sl);
+    CHECK_EQ(sl[0].spans[1].layers, 0x03);
+
+    /* Segment 2 hides segment 1 completely */
+    geom[2] = (segment_geom_t){ .start = 30, .count = 40 };
+    CHECK_EQ(segment_spans_build(geom, 0xFF, sl), 0x05);
+
+    /* Running past 65535 clips to the index range */
+    memset(geom, 0, sizeof(geom));
+    geom[0] = (segment_geom_t){ .start = 65000, .count = 60000, .strip_id = 1 };
+    CHECK_EQ(segment_spans_build(geom, 0xFF, sl), 0x01);
+    CHECK(sl[1].count == 1 && sl[1].spans[0].count == UINT16_MAX - 65000);
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    RUN(test_layouts);
+    printf("- test_random_geometries\n");
+    test_random_geometries(100000 * scale);
+    return test_summary("test_segment_spans");
+}
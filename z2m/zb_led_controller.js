@@ -12,6 +12,12 @@
  * Custom clusters (on EP1):
  *   0xFC00: Device config (strip1_count, strip2_count — reboot required after change)
  *   0xFC01: Segment geometry (start + count + strip per segment, 3 attrs × 8 = 24 total)
+ *   0xFC02: Presets (slot-based save/recall/delete)
+ *   0xFC03: Keyframe timelines (MQTT only, see the `timeline` converter below)
+ *
+ * Custom clusters on each segment endpoint (EP1-EP8):
+ *   0xFC04: Segment effect and blend (effect, speed, intensity, blend, opacity)
+ *   0xFC05: Segment gradient (MQTT only, see the `gradient` converter below)
  *
  * Installation:
  * 1. Copy this file to your Zigbee2MQTT external converters directory
@@ -29,6 +35,7 @@ const {light} = require('zigbee-herdsman-converters/lib/modernExtend');
 const ZCL_UINT8  = 0x20;
 const ZCL_UINT16 = 0x21;
 const ZCL_UINT32 = 0x23;
+const ZCL_OCTET_STRING = 0x41;
 const ZCL_CHAR_STRING = 0x42;
 
 // ---- Expose access flags ----
@@ -40,6 +47,9 @@ const ACCESS_WRITE = 0b010;
 const CLUSTER_DEVICE_CONFIG  = 0xFC00;
 const CLUSTER_SEGMENT_CONFIG = 0xFC01;
 const CLUSTER_PRESET_CONFIG  = 0xFC02;
+const CLUSTER_TIMELINE       = 0xFC03;
+const CLUSTER_EFFECT         = 0xFC04;
+const CLUSTER_GRADIENT       = 0xFC05;
 const MAX_SEGMENTS = 8;
 const MAX_PRESETS = 8;
 const ZB_ALL_EP = MAX_SEGMENTS + 1;  /* EP9: "all segments" master */
@@ -108,10 +118,66 @@ const presetConfigCluster = {
     commandsResponse: {},
 };
 
+// Timeline attributes: target segment/channel/mode, then a keyframes write starts it
+const timelineCluster = {
+    ID: CLUSTER_TIMELINE,
+    attributes: {
+        segment:   {ID: 0x0000, type: ZCL_UINT8, write: true},
+        channel:   {ID: 0x0001, type: ZCL_UINT8, write: true},
+        mode:      {ID: 0x0002, type: ZCL_UINT8, write: true},
+        keyframes: {ID: 0x0003, type: ZCL_OCTET_STRING, write: true},
+        stop:      {ID: 0x0004, type: ZCL_UINT8, write: true},
+    },
+    commands: {},
+    commandsResponse: {},
+};
+const TIMELINE_CHANNELS = {level: 0, hue: 1, saturation: 2, color_temp: 3};
+const TIMELINE_MODES = {once: 0, loop: 1, pingpong: 2};
+const TIMELINE_MAX_KEYS = 16;
+
+// Effect and blend attributes, one cluster per segment endpoint
+const effectCluster = {
+    ID: CLUSTER_EFFECT,
+    attributes: {
+        effect:    {ID: 0x0000, type: ZCL_UINT8, write: true},
+        speed:     {ID: 0x0001, type: ZCL_UINT8, write: true},
+        intensity: {ID: 0x0002, type: ZCL_UINT8, write: true},
+        blend:     {ID: 0x0003, type: ZCL_UINT8, write: true},
+        opacity:   {ID: 0x0004, type: ZCL_UINT8, write: true},
+    },
+    commands: {},
+    commandsResponse: {},
+};
+const EFFECT_NAMES = ['none', 'rainbow', 'chase', 'twinkle', 'comet', 'breathe'];
+const BLEND_NAMES  = ['replace', 'add', 'max', 'multiply', 'alpha'];
+
+// Gradient stops, one cluster per segment endpoint: hue/sat/pos of stop k at
+// 0x0010/0x0020/0x0030 + k
+const GRADIENT_MAX_STOPS = 4;
+const gradientAttrs = {
+    stops: {ID: 0x0000, type: ZCL_UINT8, write: true},
+    space: {ID: 0x0001, type: ZCL_UINT8, write: true},
+};
+for (let k = 0; k < GRADIENT_MAX_STOPS; k++) {
+    gradientAttrs[`hue${k}`] = {ID: 0x0010 + k, type: ZCL_UINT16, write: true};
+    gradientAttrs[`sat${k}`] = {ID: 0x0020 + k, type: ZCL_UINT8, write: true};
+    gradientAttrs[`pos${k}`] = {ID: 0x0030 + k, type: ZCL_UINT8, write: true};
+}
+const gradientCluster = {
+    ID: CLUSTER_GRADIENT,
+    attributes: gradientAttrs,
+    commands: {},
+    commandsResponse: {},
+};
+const GRADIENT_SPACES = ['rgb', 'hue'];
+
 function registerCustomClusters(device) {
     device.addCustomCluster('ledCtrlConfig', ledCtrlConfigCluster);
     device.addCustomCluster('segmentConfig', segmentConfigCluster);
     device.addCustomCluster('presetConfig', presetConfigCluster);
+    device.addCustomCluster('timeline', timelineCluster);
+    device.addCustomCluster('segmentEffect', effectCluster);
+    device.addCustomCluster('segmentGradient', gradientCluster);
 }
 
 // ---- Expose helpers ----
@@ -158,6 +224,21 @@ const fzLocal = {
             return result;
         },
     },
+    effects: {
+        cluster: 'segmentEffect',
+        type: ['attributeReport', 'readResponse'],
+        convert: (model, msg, publish, options, meta) => {
+            const s = msg.endpoint.ID;
+            if (s < 1 || s > MAX_SEGMENTS) return;
+            const result = {};
+            if (msg.data.effect    !== undefined) result[`seg${s}_effect`]           = EFFECT_NAMES[msg.data.effect] || 'none';
+            if (msg.data.speed     !== undefined) result[`seg${s}_effect_speed`]     = msg.data.speed;
+            if (msg.data.intensity !== undefined) result[`seg${s}_effect_intensity`] = msg.data.intensity;
+            if (msg.data.blend     !== undefined) result[`seg${s}_blend`]            = BLEND_NAMES[msg.data.blend] || 'replace';
+            if (msg.data.opacity   !== undefined) result[`seg${s}_opacity`]          = msg.data.opacity;
+            return result;
+        },
+    },
     presets: {
         cluster: 'presetConfig',
         type: ['attributeReport', 'readResponse'],
@@ -184,6 +265,17 @@ const fzLocal = {
     },
 };
 
+// Keyframes [[time_ms, value, easing], ...] -> 7 bytes per key, little-endian
+function encodeKeyframes(keys) {
+    const buf = Buffer.alloc(keys.length * 7);
+    keys.forEach((k, i) => {
+        buf.writeUInt32LE(k[0], i * 7);
+        buf.writeUInt16LE(k[1], i * 7 + 4);
+        buf.writeUInt8(k[2] || 0, i * 7 + 6);
+    });
+    return buf;
+}
+
 // ---- toZigbee ----
 const tzLocal = {
     strip_counts: {
@@ -270,6 +362,48 @@ const tzLocal = {
             await ep.read('segmentConfig', [attrMap[field]]);
         },
     },
+    effects: {
+        key: [],
+        convertSet: async (entity, key, value, meta) => {
+            registerCustomClusters(meta.device);
+            const b = key.match(/^seg(\d+)_(blend|opacity)$/);
+            if (b) {
+                const ep = meta.device.getEndpoint(parseInt(b[1]));
+                if (b[2] === 'blend') {
+                    const mode = BLEND_NAMES.indexOf(value);
+                    if (mode < 0) throw new Error(`blend must be one of ${BLEND_NAMES.join(', ')}`);
+                    await ep.write('segmentEffect', {blend: mode});
+                } else {
+                    await ep.write('segmentEffect', {opacity: value});
+                }
+                return {state: {[key]: value}};
+            }
+            const m = key.match(/^seg(\d+)_effect(_speed|_intensity)?$/);
+            if (!m) return;
+            const ep = meta.device.getEndpoint(parseInt(m[1]));
+            if (!m[2]) {
+                const id = EFFECT_NAMES.indexOf(value);
+                if (id < 0) throw new Error(`effect must be one of ${EFFECT_NAMES.join(', ')}`);
+                await ep.write('segmentEffect', {effect: id});
+            } else {
+                await ep.write('segmentEffect', {[m[2] === '_speed' ? 'speed' : 'intensity']: value});
+            }
+            return {state: {[key]: value}};
+        },
+        convertGet: async (entity, key, meta) => {
+            registerCustomClusters(meta.device);
+            const b = key.match(/^seg(\d+)_(blend|opacity)$/);
+            if (b) {
+                await meta.device.getEndpoint(parseInt(b[1])).read('segmentEffect', [b[2]]);
+                return;
+            }
+            const m = key.match(/^seg(\d+)_effect(_speed|_intensity)?$/);
+            if (!m) return;
+            const ep = meta.device.getEndpoint(parseInt(m[1]));
+            const attr = !m[2] ? 'effect' : (m[2] === '_speed' ? 'speed' : 'intensity');
+            await ep.read('segmentEffect', [attr]);
+        },
+    },
     presets: {
         key: ['preset_slot', 'new_preset_name', 'apply_preset', 'save_preset', 'delete_preset'],
         convertSet: async (entity, key, value, meta) => {
@@ -359,10 +493,76 @@ const tzLocal = {
             // No GET operations needed for slot-based system
         },
     },
+    timeline: {
+        // {"timeline": {"segment": 1, "channel": "level", "mode": "loop",
+        //               "keyframes": [[0, 0], [1000, 254, 3], [2000, 0, 3]]}}
+        // {"timeline_stop": 1} or {"timeline_stop": "all"}
+        key: ['timeline', 'timeline_stop'],
+        convertSet: async (entity, key, value, meta) => {
+            registerCustomClusters(meta.device);
+            const ep = meta.device.getEndpoint(1);
+
+            if (key === 'timeline_stop') {
+                const seg = (value === 'all') ? 0xFF : parseInt(value) - 1;
+                if (seg !== 0xFF && !(seg >= 0 && seg < MAX_SEGMENTS)) {
+                    throw new Error('timeline_stop must be a segment 1-8 or "all"');
+                }
+                await ep.write('timeline', {stop: seg});
+                return;
+            }
+
+            const seg = parseInt(value.segment) - 1;
+            const channel = TIMELINE_CHANNELS[value.channel || 'level'];
+            const mode = TIMELINE_MODES[value.mode || 'once'];
+            const keys = value.keyframes || [];
+            if (!(seg >= 0 && seg < MAX_SEGMENTS) || channel === undefined || mode === undefined ||
+                keys.length > TIMELINE_MAX_KEYS) {
+                throw new Error('timeline needs segment 1-8, channel (level|hue|saturation|color_temp), ' +
+                    'mode (once|loop|pingpong) and up to 16 keyframes');
+            }
+            await ep.write('timeline', {segment: seg, channel, mode});
+            await ep.write('timeline', {keyframes: encodeKeyframes(keys)});
+        },
+    },
+    gradient: {
+        // {"gradient": {"segment": 2, "space": "hue",
+        //               "stops": [[0, 30, 200], [255, 210, 254]]}}   ([pos, hue, sat])
+        // {"gradient": {"segment": 2, "stops": []}} turns it off
+        key: ['gradient'],
+        convertSet: async (entity, key, value, meta) => {
+            registerCustomClusters(meta.device);
+            const seg = parseInt(value.segment);
+            const space = GRADIENT_SPACES.indexOf(value.space || 'rgb');
+            const stops = value.stops || [];
+            const valid = (s) => Array.isArray(s) && s.length === 3 &&
+                s[0] >= 0 && s[0] <= 255 && s[1] >= 0 && s[1] <= 359 && s[2] >= 0 && s[2] <= 254;
+            if (!(seg >= 1 && seg <= MAX_SEGMENTS) || space < 0 || stops.length === 1 ||
+                stops.length > GRADIENT_MAX_STOPS || !stops.every(valid)) {
+                throw new Error('gradient needs segment 1-8, space (rgb|hue) and 0 or 2-4 stops ' +
+                    '[pos 0-255, hue 0-359, sat 0-254]');
+            }
+            const ep = meta.device.getEndpoint(seg);
+            if (stops.length === 0) {
+                await ep.write('segmentGradient', {stops: 0});
+                return;
+            }
+            // Stop count goes last so the gradient switches on with every stop in place
+            const attrs = {space};
+            stops.forEach((s, k) => {
+                attrs[`pos${k}`] = s[0];
+                attrs[`hue${k}`] = s[1];
+                attrs[`sat${k}`] = s[2];
+            });
+            await ep.write('segmentGradient', attrs);
+            await ep.write('segmentGradient', {stops: stops.length});
+        },
+    },
 };
 
 for (let n = 1; n <= MAX_SEGMENTS; n++) {
     tzLocal.segments.key.push(`seg${n}_start`, `seg${n}_count`, `seg${n}_strip`);
+    tzLocal.effects.key.push(`seg${n}_effect`, `seg${n}_effect_speed`, `seg${n}_effect_intensity`,
+        `seg${n}_blend`, `seg${n}_opacity`);
 }
 
 // No additional keys needed - all handled in main key array
@@ -418,6 +618,24 @@ for (let n = 1; n <= MAX_SEGMENTS; n++) {
     );
 }
 
+// ---- Segment effect and blend exposes ----
+const effectExposes = [];
+for (let n = 1; n <= MAX_SEGMENTS; n++) {
+    effectExposes.push(
+        enumExpose(`seg${n}_effect`, `Seg${n} effect`, ACCESS_ALL,
+            `Segment ${n} pixel effect, animating its current color`, EFFECT_NAMES),
+        numericExpose(`seg${n}_effect_speed`, `Seg${n} effect speed`, ACCESS_ALL,
+            `Segment ${n} effect speed (0 = frozen, 255 = ~4 cycles/s)`, {value_min: 0, value_max: 255, value_step: 1}),
+        numericExpose(`seg${n}_effect_intensity`, `Seg${n} effect intensity`, ACCESS_ALL,
+            `Segment ${n} effect intensity (rainbow spread, chase band width, twinkle density, ` +
+            `comet tail, breathe depth)`, {value_min: 0, value_max: 255, value_step: 1}),
+        enumExpose(`seg${n}_blend`, `Seg${n} blend`, ACCESS_ALL,
+            `How segment ${n} combines with lower-numbered segments it overlaps (replace covers them)`, BLEND_NAMES),
+        numericExpose(`seg${n}_opacity`, `Seg${n} opacity`, ACCESS_ALL,
+            `Segment ${n} opacity for the alpha blend (0-255)`, {value_min: 0, value_max: 255, value_step: 1}),
+    );
+}
+
 // ---- 8 segment light extends (EP1-EP8) + EP9 "all segments" master ----
 // Each segment is a Color Dimmable Light with enhanced hue (16-bit precision) and color_temp (CT=white)
 // CT range extended to 500 mired (2000K) so Z2M auto-generates 5 distinct presets:
@@ -453,17 +671,18 @@ const definition = {
 
     extend: segLightExtends,
 
-    fromZigbee: [fzLocal.config, fzLocal.segments, fzLocal.presets],
-    toZigbee: [tzLocal.strip_counts, tzLocal.restart, tzLocal.factory_reset, tzLocal.segments, tzLocal.presets],
+    fromZigbee: [fzLocal.config, fzLocal.segments, fzLocal.presets, fzLocal.effects],
+    toZigbee: [tzLocal.strip_counts, tzLocal.restart, tzLocal.factory_reset, tzLocal.segments, tzLocal.presets,
+               tzLocal.timeline, tzLocal.effects, tzLocal.gradient],
     ota: true,  // Enable OTA update support
 
     exposes: [
         numericExpose('strip1_count', 'Strip 1 count', ACCESS_ALL,
             'Number of LEDs on strip 1 (reboot required after change)',
-            {value_min: 1, value_max: 500, value_step: 1}),
+            {value_min: 1, value_max: 2000, value_step: 1}),
         numericExpose('strip2_count', 'Strip 2 count', ACCESS_ALL,
             'Number of LEDs on strip 2 (0 = disabled, reboot required after change)',
-            {value_min: 0, value_max: 500, value_step: 1}),
+            {value_min: 0, value_max: 2000, value_step: 1}),
         numericExpose('global_transition_ms', 'Global transition time', ACCESS_ALL,
             'Default transition duration in milliseconds for color and brightness changes',
             {value_min: 0, value_max: 65535, value_step: 100, unit: 'ms'}),
@@ -492,6 +711,7 @@ const definition = {
         numericExpose('min_free_heap', 'Min free heap', ACCESS_READ,
             'Minimum free heap memory since boot (bytes)', {unit: 'B'}),
         ...segExposes,
+        ...effectExposes,
         ...presetExposes,
     ],
 
@@ -547,6 +767,11 @@ const definition = {
             presetNameAttrs.push(`preset${n}Name`);
         }
         await ep1.read('presetConfig', presetNameAttrs);
+
+        // Read each segment's effect and blend mode
+        for (let n = 1; n <= MAX_SEGMENTS; n++) {
+            await device.getEndpoint(n).read('segmentEffect', ['effect', 'speed', 'intensity', 'blend', 'opacity']);
+        }
     },
 };
 